@@ -28,6 +28,9 @@
 #define MOD_AUTHZ_SVN_H
 
 #include <httpd.h>
+#include <apr_tables.h>
+
+#include "svn_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,6 +57,30 @@ typedef int (*authz_svn__subreq_bypass_func_t)(request_rec *r,
                                               const char *repos_path,
                                               const char *repos_name);
 
+/** Provider name for the batched subrequest bypass */
+#define AUTHZ_SVN__SUBREQ_BYPASS_MANY_PROV_NAME \
+  "mod_authz_svn_subreq_bypass_many"
+/** Provider to allow mod_dav_svn to check read access to many paths at
+ * once, e.g. for all the changed paths of a revision reported by log.
+ * It is registered in the #AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP group using
+ * #AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER.
+ *
+ * Uses @a r and @a repos_name to determine whether the user making the
+ * request may read each of the <tt>const char *</tt> fspaths in
+ * @a repos_paths and sets the corresponding element of @a allowed
+ * accordingly.  @a allowed must provide room for
+ * <tt>repos_paths->nelts</tt> elements.
+ *
+ * Returns @c OK if the check has been performed or @c HTTP_FORBIDDEN
+ * if it could not be, in which case all elements of @a allowed are
+ * @c FALSE.
+ */
+typedef int (*authz_svn__subreq_bypass_many_func_t)(
+  request_rec *r,
+  const apr_array_header_t *repos_paths,
+  const char *repos_name,
+  svn_boolean_t *allowed);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
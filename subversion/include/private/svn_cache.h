@@ -293,6 +293,13 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * (no data being written to the cache) if some reader or another writer
  * currently holds the segment lock.
  *
+ * If @a shared_memory is set, the cache will be allocated in an anonymous
+ * shared memory region and all segments will be protected by global
+ * (cross-process) mutexes, regardless of @a thread_safe.  All processes
+ * forked from the current one after this call will then share the cache
+ * contents.  Returns #SVN_ERR_UNSUPPORTED_FEATURE if the platform does not
+ * support shared memory.
+ *
  * Allocations will be made in @a result_pool, in particular the data buffers.
  */
 svn_error_t *
@@ -302,8 +309,20 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t segment_count,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_boolean_t shared_memory,
                                   apr_pool_t *result_pool);
 
+/**
+ * Prepare the shared memory @a cache for use in a process that has been
+ * forked after the cache had been created.  Every such child process must
+ * call this before accessing the cache.  This is a no-op for caches that
+ * have not been allocated in shared memory.  Use @a pool for allocations
+ * that must live as long as the child process uses the cache.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_child_init(svn_membuffer_t *cache,
+                                      apr_pool_t *pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -527,6 +546,32 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Set whether the process-global membuffer cache shall be allocated in
+ * shared memory (see svn_cache__membuffer_cache_create).  All processes
+ * forked after the cache has been created will then use the same cache.
+ * This must be called before the first call to
+ * svn_cache__get_global_membuffer_cache, i.e. the parent process should
+ * call it, then create the cache and then fork.  It defaults to @c FALSE.
+ */
+void
+svn_cache__set_global_membuffer_shared(svn_boolean_t shared);
+
+/**
+ * Return whether the process-global membuffer cache will be or has been
+ * allocated in shared memory.
+ */
+svn_boolean_t
+svn_cache__get_global_membuffer_shared(void);
+
+/**
+ * Call svn_cache__membuffer_cache_child_init for the process-global
+ * membuffer cache if it has been allocated in shared memory.  Pre-fork
+ * servers must call this in every worker process right after the fork.
+ */
+svn_error_t *
+svn_cache__global_membuffer_child_init(apr_pool_t *pool);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
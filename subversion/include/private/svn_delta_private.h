@@ -101,6 +101,34 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
                              struct svn_delta__extra_baton *exb,
                              apr_pool_t *pool);
 
+/* Files smaller than this will hardly benefit from
+ * svn_delta__txdelta_large_window(). */
+#define SVN_DELTA__LARGE_WINDOW_THRESHOLD 0x100000
+
+/* Like svn_txdelta2() but don't only look for matching data in the
+ * source window at the same offset.  Instead, locate the content of each
+ * target window in SOURCE and use the window-sized range that covers most
+ * of it.  This keeps deltas small even if more than a window's worth of
+ * data has been inserted or removed, e.g. in large binary files.
+ *
+ * Since svn_txdelta_apply() requires source views to only move forward,
+ * once a target window used some part of SOURCE, later windows cannot
+ * refer to data before it.  Content that has been moved towards the
+ * start of the file will therefore usually not be found.
+ *
+ * INDEX_SOURCE must return the same contents as SOURCE.  It will be read
+ * and closed when the first window is requested.  The windows produced
+ * can be consumed by svn_txdelta_apply() and svndiff as usual, but do
+ * not follow the window layout that FSFS and FSX require for storage.
+ */
+void
+svn_delta__txdelta_large_window(svn_txdelta_stream_t **stream,
+                                svn_stream_t *index_source,
+                                svn_stream_t *source,
+                                svn_stream_t *target,
+                                svn_boolean_t calculate_checksum,
+                                apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -127,6 +127,24 @@ typedef apr_uint32_t apr_uintptr_t;
 #define APR_OPENINFO  0x00100000
 #endif
 
+/**
+ * Indicate whether SSE2 vector instructions may be used.  SSE2 is part
+ * of the x64 base line and therefore available wherever the compiler
+ * targets it, so there is no need to check the CPU at runtime.
+ * Define SVN_DISABLE_SSE2 to force the portable code paths.
+ *
+ * @since New in 1.9.
+ */
+#ifndef SVN__SSE2_ENABLED
+# if !defined(SVN_DISABLE_SSE2) \
+     && (defined(__SSE2__) || defined(_M_X64) \
+         || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define SVN__SSE2_ENABLED 1
+# else
+#  define SVN__SSE2_ENABLED 0
+# endif
+#endif
+
 /**
  * Check at compile time if the Serf version is at least a certain
  * level.
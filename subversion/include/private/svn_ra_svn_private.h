@@ -42,6 +42,14 @@ svn_error_t *
 svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
                                svn_delta_shim_callbacks_t *shim_callbacks);
 
+/**
+ * Return the svndiff version to use when sending deltas over @a conn.
+ * That is the fastest compressing version supported by the other side
+ * or 0 if compression has been disabled for @a conn.
+ */
+int
+svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
+
 /**
  * @defgroup ra_svn_deprecated ra_svn low-level functions
  * @{
@@ -74,6 +82,20 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
                           const char *s);
 
+/** Write the @a len bytes starting at @a offset in @a file over the net
+ * as a single string.
+ *
+ * If the connection writes to a plain socket, the data will be sent
+ * directly from @a file using sendfile().  Otherwise, it will be read
+ * from @a file and written like any other string.
+ */
+svn_error_t *
+svn_ra_svn__write_file_string(svn_ra_svn_conn_t *conn,
+                              apr_pool_t *pool,
+                              apr_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t len);
+
 /** Write a word over the net.
  *
  * Writes will be buffered until the next read or flush.
@@ -121,6 +143,15 @@ svn_error_t *
 svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
                   apr_pool_t *pool);
 
+/** Flush the write buffer of @a conn and compress all data sent or
+ * received over @a conn from now on.  Both sides must call this at the
+ * same point of the protocol exchange.  Use @a pool for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *pool);
+
 /** Write a tuple, using a printf-like interface.
  *
  * The format string @a fmt may contain:
@@ -271,6 +302,50 @@ svn_ra_svn__handle_commands2(svn_ra_svn_conn_t *conn,
                              void *baton,
                              svn_boolean_t error_on_disconnect);
 
+/** Accept a single command over the network and handle it according to
+ * @a cmd_hash, which maps command names to their
+ * #svn_ra_svn_cmd_entry_t.  Set @a *terminate if the command was a
+ * terminating one or, unless @a error_on_disconnect is set, the other
+ * side closed the connection.  Otherwise, errors are handled as in
+ * svn_ra_svn__handle_commands2().  Use @a pool for all allocations.
+ *
+ * This allows servers to interleave the commands of many connections.
+ */
+svn_error_t *
+svn_ra_svn__handle_command(svn_boolean_t *terminate,
+                           apr_hash_t *cmd_hash,
+                           void *baton,
+                           svn_ra_svn_conn_t *conn,
+                           svn_boolean_t error_on_disconnect,
+                           apr_pool_t *pool);
+
+/** Flush any pending output on @a conn and add whatever input is
+ * available without blocking to its read buffer.  Then set
+ * @a *has_command to TRUE if the buffer contains a complete command
+ * that svn_ra_svn__handle_command() could process without waiting for
+ * further input.  Commands that don't fit into the read buffer get
+ * buffered separately, up to a limit of 1 MB.  Only beyond that,
+ * a command counts as complete before all of it has been received.
+ * Set @a *terminated to TRUE if the other side closed the connection.
+ * Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__has_command(svn_boolean_t *has_command,
+                        svn_boolean_t *terminated,
+                        svn_ra_svn_conn_t *conn,
+                        apr_pool_t *pool);
+
+/** Limit the time that reading from @a conn may wait for the other side
+ * to send data to @a timeout.  Once that limit has been exceeded, the
+ * read fails.  Negative values, which are the default, disable the limit.
+ * Writes may block indefinitely, so slow clients still receive large
+ * responses.  Connections that are not backed by a socket are not
+ * affected.
+ */
+void
+svn_ra_svn__set_read_timeout(svn_ra_svn_conn_t *conn,
+                             apr_interval_time_t timeout);
+
 /** Write a successful command response over the network, using the
  * same format string notation as svn_ra_svn_write_tuple().  Do not use
  * partial tuples with this function; if you need to use partial
@@ -127,6 +127,54 @@ svn_repos__replay_ev2(svn_fs_root_t *root,
                       void *authz_read_baton,
                       apr_pool_t *scratch_pool);
 
+/* Like svn_repos_authz_check_access() but check the REQUIRED_ACCESS to
+ * every fspath in PATHS, an array of const char *, at once and set
+ * ACCESS_GRANTED[i] for the i-th path.  This is much cheaper than
+ * checking the paths individually, in particular if paths in the same
+ * directory are adjacent in PATHS.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_repos__authz_check_access_many(svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const apr_array_header_t *paths,
+                                  const char *user,
+                                  svn_repos_authz_access_t required_access,
+                                  svn_boolean_t *access_granted,
+                                  apr_pool_t *scratch_pool);
+
+/* Callback type for checking read authorization on many paths at once.
+ *
+ * Set ALLOWED[i] to TRUE if the i-th element of PATHS, an array of
+ * const char * fspaths in ROOT, may be read and to FALSE otherwise.
+ * Parents come before their children in PATHS and entries of the same
+ * directory are adjacent as far as possible, so implementations can
+ * share work between neighboring paths.  BATON is the baton given to
+ * svn_repos__authz_read_many_wrap().  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+typedef svn_error_t *
+(*svn_repos__authz_read_many_func_t)(svn_boolean_t *allowed,
+                                     svn_fs_root_t *root,
+                                     const apr_array_header_t *paths,
+                                     void *baton,
+                                     apr_pool_t *scratch_pool);
+
+/* Set *AUTHZ_READ_FUNC and *AUTHZ_READ_BATON to a read authorization
+ * callback that checks single paths using READ_FUNC.  Functions of this
+ * library that need to check many paths at once, such as
+ * svn_repos_get_logs5() and the reporter, will recognize it and use
+ * READ_MANY_FUNC instead.  Both callbacks will be called with
+ * READ_BATON.  Allocate the result in RESULT_POOL.
+ */
+void
+svn_repos__authz_read_many_wrap(svn_repos_authz_func_t *authz_read_func,
+                                void **authz_read_baton,
+                                svn_repos_authz_func_t read_func,
+                                svn_repos__authz_read_many_func_t read_many_func,
+                                void *read_baton,
+                                apr_pool_t *result_pool);
+
 /* Given a PATH which might be a relative repo URL (^/), an absolute
  * local repo URL (file://), an absolute path outside of the repo
  * or a location in the Windows registry.
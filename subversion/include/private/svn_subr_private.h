@@ -219,8 +219,55 @@ svn_stream_t *
 svn_stream__from_spillbuf(svn_spillbuf_t *buf,
                           apr_pool_t *result_pool);
 
+/* Return a stream that wraps @a stream and calculates both the MD5 and
+   the SHA1 checksum of the data read from and / or written to it in a
+   single pass.  Otherwise, this behaves like two nested streams created
+   by svn_stream_checksummed2() for the respective checksum kinds.  Any
+   of the checksum output parameters may be NULL.  Allocate the result
+   and the checksums in @a pool. */
+svn_stream_t *
+svn_stream__checksummed_md5_sha1(svn_stream_t *stream,
+                                 svn_checksum_t **read_md5_checksum,
+                                 svn_checksum_t **read_sha1_checksum,
+                                 svn_checksum_t **write_md5_checksum,
+                                 svn_checksum_t **write_sha1_checksum,
+                                 svn_boolean_t read_all,
+                                 apr_pool_t *pool);
+
 /** @} */
 
+/**
+ * Update both checksum contexts @a ctx1 and @a ctx2 with the @a len
+ * bytes at @a data.  This is equivalent to calling svn_checksum_update()
+ * for each of them but only needs to fetch the data from memory once.
+ *
+ * @since New in 1.9
+ */
+svn_error_t *
+svn_checksum__update2(svn_checksum_ctx_t *ctx1,
+                      svn_checksum_ctx_t *ctx2,
+                      const void *data,
+                      apr_size_t len);
+
+/**
+ * Return a writable stream that updates both checksum contexts @a ctx1
+ * and @a ctx2 with all data written to it, like svn_checksum__update2()
+ * does.  If possible, the checksums get calculated by a separate thread
+ * such that the writer may continue with other work in the meantime.
+ *
+ * The contexts must not be used by the caller until the stream has been
+ * closed.  Closing the stream waits for the checksum calculation to
+ * complete and returns any error it encountered.  Clearing @a pool stops
+ * the checksum thread without waiting for it.  Allocate the stream in
+ * @a pool.
+ *
+ * @since New in 1.9
+ */
+svn_stream_t *
+svn_checksum__update2_stream(svn_checksum_ctx_t *ctx1,
+                             svn_checksum_ctx_t *ctx2,
+                             apr_pool_t *pool);
+
 /**
  * Internal function for creating a MD5 checksum from a binary digest.
  *
@@ -428,6 +475,22 @@ svn__decompress(svn_stringbuf_t *in,
                 svn_stringbuf_t *out,
                 apr_size_t limit);
 
+/* Get the data from IN, compress it using the fast LZ4 block format and
+ * write the result to OUT.  Like svn__compress, prepend the original size
+ * and store the data uncompressed if that is shorter.
+ */
+svn_error_t *
+svn__compress_lz4(svn_stringbuf_t *in,
+                  svn_stringbuf_t *out);
+
+/* Get the LZ4 compressed data from IN, decompress it and write the result
+ * to OUT.  Return an error if the decompressed size is larger than LIMIT.
+ */
+svn_error_t *
+svn__decompress_lz4(svn_stringbuf_t *in,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit);
+
 /** @} */
 
 /**
@@ -507,6 +507,11 @@ svn_txdelta_apply(svn_stream_t *source,
  * version is @a svndiff_version. @a compression_level is the zlib
  * compression level from 0 (no compression) and 9 (maximum compression).
  *
+ * Version 0 is not compressed, version 1 uses zlib and version 2 uses a
+ * much faster LZ4 compression.  For version 2, any @a compression_level
+ * other than 0 selects the one LZ4 compression level available.
+ * Version 2 is only available since Subversion 1.9.
+ *
  * @since New in 1.7.
  */
 void
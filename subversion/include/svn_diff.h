@@ -459,6 +459,14 @@ typedef struct svn_diff_file_options_t
     * @c FALSE.
     */
   svn_boolean_t show_c_function;
+
+  /** Whether to use the histogram diff algorithm instead of the default
+   * one.  It is much faster for large files with many changes but the
+   * result is not always the minimal diff.  The default is @c FALSE.
+   *
+   * @since New in 1.9.
+   */
+  svn_boolean_t histogram;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -481,6 +489,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-all-space, -w
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
+ * - --histogram @since New in 1.9.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
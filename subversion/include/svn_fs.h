@@ -2084,6 +2084,30 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                                  void* baton,
                                  apr_pool_t *pool);
 
+/** Try to locate the contents of the file @a path in @a root as a single
+ * range of uncompressed bytes in an on-disk file.  If that succeeds, set
+ * @a *file to that file, opened read-only and unbuffered with
+ * @c APR_SENDFILE_ENABLED, and set @a *offset and @a *length to the range
+ * within @a *file.  Otherwise, set @a *file to @c NULL.  Allocate
+ * @a *file in @a result_pool and use @a scratch_pool for temporaries.
+ *
+ * This function is intended to allow servers to pass file contents to
+ * sendfile() or similar zero-copy mechanisms.  It may not be implemented
+ * for all data backends or not be applicable for certain content.  Note
+ * that, unlike svn_fs_file_contents(), the data will not be verified
+ * against the file's checksum.  @a root must be a revision root.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_fs_file_fulltext_location(apr_file_t **file,
+                              apr_off_t *offset,
+                              svn_filesize_t *length,
+                              svn_fs_root_t *root,
+                              const char *path,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /** Create a new file named @a path in @a root.  The file's initial contents
  * are the empty string, and it has no properties.  @a root must be the
  * root of a transaction, not a revision.
@@ -2609,8 +2633,31 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
  * Possibly update the filesystem located in the directory @a path
  * to use disk space more efficiently.
  *
+ * If @a jobs is larger than 1, the backend may process up to @a jobs
+ * units of work (e.g. FSFS shards) concurrently in separate threads.
+ * In that case, the global cache should be thread-safe; see
+ * #svn_cache_config_t.  @a notify_func will still be called from the
+ * calling thread only, in the same order as for single-threaded
+ * operation.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             int jobs,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Similar to svn_fs_pack2() with @a jobs set to 1.
+ *
  * @since New in 1.6.
+ * @deprecated Provided for backward compatibility with the 1.8 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
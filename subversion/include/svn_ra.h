@@ -1695,6 +1695,53 @@ svn_ra_stat(svn_ra_session_t *session,
             svn_dirent_t **dirent,
             apr_pool_t *pool);
 
+/**
+ * Like svn_ra_stat(), but for all @a paths (an array of <tt>const
+ * char *</tt>, each relative to the @a session's parent's URL) at once.
+ * Set @a *dirents to a hash mapping each path that exists in @a
+ * revision to its @c svn_dirent_t.  Paths that do not exist are not
+ * in the hash.
+ *
+ * Depending on the RA layer, this may be much faster than calling
+ * svn_ra_stat() for each path, e.g. because ra_svn will send several
+ * requests before waiting for the responses.
+ *
+ * Allocate @a *dirents in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool);
+
+/**
+ * Set @a *props to a hash mapping each of the @a paths (an array of
+ * <tt>const char *</tt>, each relative to the @a session's parent's
+ * URL) to the properties of that node in @a revision, in the form
+ * returned by svn_ra_get_file() and svn_ra_get_dir2().  It is an error
+ * if any of the paths does not exist.
+ *
+ * Depending on the RA layer, this may be much faster than fetching the
+ * properties of each path individually.
+ *
+ * Allocate @a *props in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_ra_get_props_many(svn_ra_session_t *session,
+                      apr_hash_t **props,
+                      const apr_array_header_t *paths,
+                      svn_revnum_t revision,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
 
 /**
  * Set @a *uuid to the repository's UUID, allocated in @a pool.
@@ -608,8 +608,28 @@ svn_repos_hotcopy(const char *src_path,
  * Possibly update the repository, @a repos, to use a more efficient
  * filesystem representation.  Use @a pool for allocations.
  *
+ * If @a jobs is larger than 1, let the filesystem backend process up to
+ * @a jobs units of work concurrently; see svn_fs_pack2().  Notifications
+ * will still be sent from the calling thread only.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_repos_fs_pack3(svn_repos_t *repos,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_fs_pack3() with @a jobs set to 1.
+ *
  * @since New in 1.7.
+ * @deprecated Provided for backward compatibility with the 1.8 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_fs_pack2(svn_repos_t *repos,
                    svn_repos_notify_func_t notify_func,
@@ -2659,6 +2679,14 @@ svn_repos_info_format(int *repos_format,
  * not notified. Finally, return an error if there were any failures during
  * verification, or SVN_NO_ERROR if there were no failures.
  *
+ * If @a jobs is larger than 1, up to @a jobs revisions will be verified
+ * concurrently, each worker thread using its own connection to the
+ * repository.  Notifications will still be sent from the calling thread
+ * and in the same order as for a single job, but @a cancel_func may be
+ * called from any of the worker threads.  The number of jobs will be
+ * silently reduced to 1 if threads are not supported or if the cache
+ * configuration is set to single-threaded.
+ *
  * @since New in 1.9.
  */
 svn_error_t *
@@ -2666,6 +2694,7 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t keep_going,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_cancel_func_t cancel,
@@ -2737,8 +2766,39 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the dump.
  *
+ * If @a jobs is larger than 1, up to @a jobs revisions will be dumped
+ * concurrently, each worker thread using its own connection to the
+ * repository and buffering its output in memory or, for larger revisions,
+ * in temporary files.  The revisions will still be written to
+ * @a dumpstream and notifications be sent from the calling thread in the
+ * same order as for a single job, but @a cancel_func may be called from
+ * any of the worker threads.  The number of jobs will be silently reduced
+ * to 1 if threads are not supported or if the cache configuration is set
+ * to single-threaded.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_repos_dump_fs4(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Similar to svn_repos_dump_fs4(), but with @a jobs always set to 1.
+ *
  * @since New in 1.7.
+ * @deprecated Provided for backward compatibility with the 1.8 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_dump_fs3(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
@@ -2835,9 +2895,39 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the load.
+ *
+ * If @a jobs is larger than 1, @a dumpstream will be read and parsed
+ * in a separate thread while the calling thread commits the data parsed
+ * so far to @a repos.  Notifications will still be sent from the calling
+ * thread, but @a cancel_func may be called from the parser thread.  The
+ * load uses no more than 2 threads, regardless of the value of @a jobs.
+ * If threads are not supported, @a jobs will be silently ignored.
+ *
+ * @since New in 1.9.
+ */
+svn_error_t *
+svn_repos_load_fs5(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/** Similar to svn_repos_load_fs5(), but with @a jobs always set to 1.
  *
  * @since New in 1.8.
+ * @deprecated Provided for backward compatibility with the 1.8 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_load_fs4(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
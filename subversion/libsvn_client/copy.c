@@ -1291,26 +1291,41 @@ wc_to_repos_copy(const apr_array_header_t *copy_pairs,
     }
 
   /* Figure out the basename that will result from each copy and check to make
-     sure it doesn't exist already. */
-  for (i = 0; i < copy_pairs->nelts; i++)
-    {
-      svn_node_kind_t dst_kind;
-      const char *dst_rel;
-      svn_client__copy_pair_t *pair =
-        APR_ARRAY_IDX(copy_pairs, i, svn_client__copy_pair_t *);
-
-      svn_pool_clear(iterpool);
-      dst_rel = svn_uri_skip_ancestor(top_dst_url, pair->dst_abspath_or_url,
-                                      iterpool);
-      SVN_ERR(svn_ra_check_path(ra_session, dst_rel, SVN_INVALID_REVNUM,
-                                &dst_kind, iterpool));
-      if (dst_kind != svn_node_none)
-        {
-          return svn_error_createf(SVN_ERR_FS_ALREADY_EXISTS, NULL,
-                                   _("Path '%s' already exists"),
-                                   pair->dst_abspath_or_url);
-        }
-    }
+     sure it doesn't exist already.  Ask for all of them at once, so that
+     RA layers that can batch requests don't need a round trip per copy. */
+  {
+    apr_array_header_t *dst_rels = apr_array_make(scratch_pool,
+                                                  copy_pairs->nelts,
+                                                  sizeof(const char *));
+    apr_hash_t *dst_dirents;
+
+    for (i = 0; i < copy_pairs->nelts; i++)
+      {
+        svn_client__copy_pair_t *pair =
+          APR_ARRAY_IDX(copy_pairs, i, svn_client__copy_pair_t *);
+
+        APR_ARRAY_PUSH(dst_rels, const char *)
+          = svn_uri_skip_ancestor(top_dst_url, pair->dst_abspath_or_url,
+                                  scratch_pool);
+      }
+
+    SVN_ERR(svn_ra_stat_many(ra_session, &dst_dirents, dst_rels,
+                             SVN_INVALID_REVNUM, scratch_pool, scratch_pool));
+
+    for (i = 0; i < copy_pairs->nelts; i++)
+      {
+        svn_client__copy_pair_t *pair =
+          APR_ARRAY_IDX(copy_pairs, i, svn_client__copy_pair_t *);
+
+        if (svn_hash_gets(dst_dirents, APR_ARRAY_IDX(dst_rels, i,
+                                                     const char *)))
+          {
+            return svn_error_createf(SVN_ERR_FS_ALREADY_EXISTS, NULL,
+                                     _("Path '%s' already exists"),
+                                     pair->dst_abspath_or_url);
+          }
+      }
+  }
 
   if (SVN_CLIENT__HAS_LOG_MSG_FUNC(ctx))
     {
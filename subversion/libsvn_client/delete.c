@@ -269,6 +269,10 @@ struct repos_deletables_t
 {
   svn_ra_session_t *ra_session;
   apr_array_header_t *target_uris;
+
+  /* The paths of TARGET_URIS relative to the repository root, in the
+     same order. */
+  apr_array_header_t *target_relpaths;
 };
 
 
@@ -292,7 +296,6 @@ delete_urls_multi_repos(const apr_array_header_t *uris,
       const char *uri = APR_ARRAY_IDX(uris, i, const char *);
       struct repos_deletables_t *repos_deletables = NULL;
       const char *repos_relpath;
-      svn_node_kind_t kind;
 
       for (hi = apr_hash_first(pool, deletables); hi; hi = apr_hash_next(hi))
         {
@@ -338,6 +341,8 @@ delete_urls_multi_repos(const apr_array_header_t *uris,
           repos_deletables = apr_pcalloc(pool, sizeof(*repos_deletables));
           repos_deletables->ra_session = ra_session;
           repos_deletables->target_uris = target_uris;
+          repos_deletables->target_relpaths
+            = apr_array_make(pool, 1, sizeof(const char *));
           svn_hash_sets(deletables, repos_root, repos_deletables);
         }
 
@@ -348,17 +353,42 @@ delete_urls_multi_repos(const apr_array_header_t *uris,
         return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
                                  "URL '%s' not within a repository", uri);
 
-      /* Now, test to see if the thing actually exists in HEAD. */
-      SVN_ERR(svn_ra_check_path(repos_deletables->ra_session, repos_relpath,
-                                SVN_INVALID_REVNUM, &kind, pool));
-      if (kind == svn_node_none)
-        return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
-                                 "URL '%s' does not exist", uri);
+      APR_ARRAY_PUSH(repos_deletables->target_relpaths, const char *)
+        = apr_pstrdup(pool, repos_relpath);
+    }
+
+  /* Now, test to see if the things actually exist in HEAD.  Ask for all
+     targets in a repository at once, so that RA layers that can batch
+     requests don't need a round trip per target. */
+  iterpool = svn_pool_create(pool);
+  for (hi = apr_hash_first(pool, deletables); hi; hi = apr_hash_next(hi))
+    {
+      struct repos_deletables_t *repos_deletables = svn__apr_hash_index_val(hi);
+      apr_hash_t *dirents;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_ra_stat_many(repos_deletables->ra_session, &dirents,
+                               repos_deletables->target_relpaths,
+                               SVN_INVALID_REVNUM, iterpool, iterpool));
+
+      for (i = 0; i < repos_deletables->target_uris->nelts; i++)
+        {
+          const char *repos_relpath
+            = APR_ARRAY_IDX(repos_deletables->target_relpaths, i,
+                            const char *);
+
+          if (! svn_hash_gets(dirents, repos_relpath))
+            return svn_error_createf(
+                     SVN_ERR_FS_NOT_FOUND, NULL,
+                     "URL '%s' does not exist",
+                     APR_ARRAY_IDX(repos_deletables->target_uris, i,
+                                   const char *));
+        }
     }
 
   /* Now we iterate over the DELETABLES hash, issuing a commit for
      each repository with its associated collected targets. */
-  iterpool = svn_pool_create(pool);
   for (hi = apr_hash_first(pool, deletables); hi; hi = apr_hash_next(hi))
     {
       const char *repos_root = svn__apr_hash_index_key(hi);
@@ -0,0 +1,575 @@
+/*
+ * large_window.c:  text deltas that follow shifted content in the source
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include "svn_delta.h"
+#include "svn_pools.h"
+#include "svn_checksum.h"
+#include "svn_sorts.h"
+#include "private/svn_delta_private.h"
+
+#include "delta.h"
+
+#include "svn_private_config.h"
+
+/* The standard delta stream (see text_delta.c) compares every target
+ * window with the source window at the same offset only.  In large
+ * binary files, inserting or removing more than a window's worth of data
+ * will shift all following content out of view and the delta degenerates
+ * into a fulltext.
+ *
+ * Here, we first split the whole source into content-defined chunks and
+ * remember their fingerprints and offsets.  Chunk boundaries depend on the
+ * data only, so the same content produces the same chunks in the target
+ * no matter where it is located.  For each target window, we then select
+ * the source view that the chunks of that window point to and let xdelta
+ * do the byte-level matching within that view.
+ *
+ * The windows we produce must still be usable by svn_txdelta_apply,
+ * the svndiff parser and every client out there.  Hence, source views
+ * may not exceed SVN_DELTA_WINDOW_SIZE, may not slide backwards and may
+ * not skip any source data.  To move the view forward by more than a
+ * window, we send windows that don't produce any target data.
+ */
+
+/* Content-defined chunks will be at least MIN_CHUNK_SIZE and at most
+ * MAX_CHUNK_SIZE bytes long.  On average, the chunk size will be about
+ * MIN_CHUNK_SIZE + 2^CHUNK_BITS.
+ */
+#define MIN_CHUNK_SIZE 256
+#define MAX_CHUNK_SIZE 8192
+#define CHUNK_BITS 11
+
+/* The rolling hash value has a chunk boundary if all these bits are 0. */
+#define CHUNK_MASK ((((apr_uint32_t)1 << CHUNK_BITS) - 1) \
+                    << (32 - CHUNK_BITS))
+
+/* Maximum number of chunks in a single target window. */
+#define MAX_CHUNKS_PER_WINDOW (SVN_DELTA_WINDOW_SIZE / MIN_CHUNK_SIZE + 1)
+
+/* Buffer size used while indexing the source. */
+#define INDEX_BUFFER_SIZE (16 * MAX_CHUNK_SIZE)
+
+/* Offset value marking fingerprints that occur more than once in the
+ * source.  Those don't tell us where to look and will be ignored. */
+#define AMBIGUOUS_OFFSET ((svn_filesize_t)-1)
+
+/* An entry in the source index. */
+typedef struct chunk_t
+{
+  /* Fingerprint of the chunk contents.  0 marks unused entries. */
+  apr_uint64_t fingerprint;
+
+  /* Offset of the chunk within the source or AMBIGUOUS_OFFSET. */
+  svn_filesize_t offset;
+} chunk_t;
+
+/* A hash table, using open addressing, of all chunks in the source. */
+typedef struct chunk_index_t
+{
+  /* Table size - 1.  The table size is a power of two. */
+  apr_size_t mask;
+
+  /* Number of entries used. */
+  apr_size_t used;
+
+  /* The entries. */
+  chunk_t *chunks;
+} chunk_index_t;
+
+/* A chunk of the current target window that has been found in the
+ * source. */
+typedef struct candidate_t
+{
+  /* Offset of the chunk in the source. */
+  svn_filesize_t source_offset;
+
+  /* Offset of the chunk relative to the start of the target window. */
+  apr_size_t target_offset;
+
+  /* Length of the chunk. */
+  apr_size_t len;
+} candidate_t;
+
+/* Our delta stream baton. */
+typedef struct large_window_baton_t
+{
+  /* Stream to read the source from for indexing.  Will be set to NULL
+     once the index has been built. */
+  svn_stream_t *index_source;
+
+  /* Source stream to read the source views from. */
+  svn_stream_t *source;
+
+  /* Target data stream. */
+  svn_stream_t *target;
+
+  /* Lookup table for the rolling hash. */
+  apr_uint32_t gear[256];
+
+  /* Fingerprints of all chunks in the source. */
+  chunk_index_t index;
+
+  /* Total length of the source. */
+  svn_filesize_t source_size;
+
+  /* The current source view.  SOURCE has been read up to VIEW_END and
+     the view contents are at the start of BUF. */
+  svn_filesize_t view_start;
+  svn_filesize_t view_end;
+
+  /* Buffer containing the source view followed by the target window. */
+  char *buf;
+
+  /* The current target window.  TARGET_LEN is 0 if the next window still
+     needs to be read. */
+  char *target_buf;
+  apr_size_t target_len;
+
+  /* Start of the source view selected for the current target window. */
+  svn_filesize_t desired_start;
+
+  /* Chunks of the current target window found in the source. */
+  candidate_t candidates[MAX_CHUNKS_PER_WINDOW];
+
+  /* FALSE, once we returned the final NULL window. */
+  svn_boolean_t more;
+
+  /* If not NULL, the context for computing the target checksum. */
+  svn_checksum_ctx_t *context;
+
+  /* If not NULL, the MD5 checksum of TARGET. */
+  svn_checksum_t *checksum;
+
+  /* For the results and the index. */
+  apr_pool_t *pool;
+} large_window_baton_t;
+
+
+/* Fill the GEAR table with pseudo-random values.  Only their distribution
+ * matters; they just need to be the same for the source and the target.
+ */
+static void
+init_gear(apr_uint32_t *gear)
+{
+  apr_uint64_t state = APR_UINT64_C(0x853c49e6748fea9b);
+  int i;
+
+  for (i = 0; i < 256; ++i)
+    {
+      state = state * APR_UINT64_C(6364136223846793005)
+            + APR_UINT64_C(1442695040888963407);
+      gear[i] = (apr_uint32_t)(state >> 32);
+    }
+}
+
+/* Return the length of the content-defined chunk starting at DATA, using
+ * the GEAR hash table.  The chunk will not extend beyond the LEN bytes
+ * available at DATA.
+ */
+static apr_size_t
+chunk_length(const apr_uint32_t *gear,
+             const unsigned char *data,
+             apr_size_t len)
+{
+  apr_uint32_t hash = 0;
+  apr_size_t limit = MIN(len, MAX_CHUNK_SIZE);
+  apr_size_t i;
+
+  if (limit <= MIN_CHUNK_SIZE)
+    return limit;
+
+  /* Only the last 32 bytes contribute to the hash value. */
+  for (i = MIN_CHUNK_SIZE - 32; i < MIN_CHUNK_SIZE; ++i)
+    hash = (hash << 1) + gear[data[i]];
+
+  for (; i < limit; ++i)
+    {
+      hash = (hash << 1) + gear[data[i]];
+      if ((hash & CHUNK_MASK) == 0)
+        return i + 1;
+    }
+
+  return limit;
+}
+
+/* Return the fingerprint of the LEN bytes at DATA.  It is never 0. */
+static apr_uint64_t
+fingerprint(const unsigned char *data,
+            apr_size_t len)
+{
+  /* 64 bit FNV-1a */
+  apr_uint64_t hash = APR_UINT64_C(0xcbf29ce484222325);
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    hash = (hash ^ data[i]) * APR_UINT64_C(0x100000001b3);
+
+  return hash ? hash : 1;
+}
+
+/* Return the slot in INDEX for FINGERPRINT, i.e. either the matching
+ * entry or the empty one where it should be added. */
+static chunk_t *
+find_slot(const chunk_index_t *index,
+          apr_uint64_t fingerprint)
+{
+  apr_size_t i = (apr_size_t)(fingerprint ^ (fingerprint >> 32))
+               & index->mask;
+
+  /* This will terminate, since we never fill the table completely. */
+  while (   index->chunks[i].fingerprint
+         && index->chunks[i].fingerprint != fingerprint)
+    i = (i + 1) & index->mask;
+
+  return &index->chunks[i];
+}
+
+/* Allocate an empty INDEX with SIZE slots in POOL.  SIZE must be a power
+ * of two. */
+static void
+init_index(chunk_index_t *index,
+           apr_size_t size,
+           apr_pool_t *pool)
+{
+  index->mask = size - 1;
+  index->used = 0;
+  index->chunks = apr_pcalloc(pool, size * sizeof(*index->chunks));
+}
+
+/* Add the chunk with FINGERPRINT at OFFSET to INDEX.  Allocate a larger
+ * table from POOL when necessary. */
+static void
+add_chunk(chunk_index_t *index,
+          apr_uint64_t fingerprint,
+          svn_filesize_t offset,
+          apr_pool_t *pool)
+{
+  chunk_t *chunk;
+
+  /* Keep the load factor below 50%. */
+  if (2 * (index->used + 1) > index->mask + 1)
+    {
+      chunk_index_t old_index = *index;
+      apr_size_t i;
+
+      init_index(index, 2 * (old_index.mask + 1), pool);
+      for (i = 0; i <= old_index.mask; ++i)
+        if (old_index.chunks[i].fingerprint)
+          *find_slot(index, old_index.chunks[i].fingerprint)
+            = old_index.chunks[i];
+
+      index->used = old_index.used;
+    }
+
+  chunk = find_slot(index, fingerprint);
+  if (chunk->fingerprint)
+    {
+      chunk->offset = AMBIGUOUS_OFFSET;
+    }
+  else
+    {
+      chunk->fingerprint = fingerprint;
+      chunk->offset = offset;
+      ++index->used;
+    }
+}
+
+/* Read all of B->INDEX_SOURCE and fill B->INDEX and B->SOURCE_SIZE.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+build_index(large_window_baton_t *b,
+            apr_pool_t *scratch_pool)
+{
+  unsigned char *buffer = apr_palloc(scratch_pool, INDEX_BUFFER_SIZE);
+  apr_size_t buffer_len = 0;
+  svn_boolean_t eof = FALSE;
+
+  init_index(&b->index, 1024, b->pool);
+  b->source_size = 0;
+
+  while (!eof || buffer_len)
+    {
+      apr_size_t pos = 0;
+      apr_size_t len = INDEX_BUFFER_SIZE - buffer_len;
+
+      if (!eof)
+        {
+          SVN_ERR(svn_stream_read(b->index_source,
+                                  (char *)buffer + buffer_len, &len));
+          eof = buffer_len + len < INDEX_BUFFER_SIZE;
+          buffer_len += len;
+        }
+
+      /* Chunks may only end at the buffer end at EOF. */
+      while (buffer_len - pos >= MAX_CHUNK_SIZE || (eof && pos < buffer_len))
+        {
+          apr_size_t chunk_len = chunk_length(b->gear, buffer + pos,
+                                              buffer_len - pos);
+          add_chunk(&b->index, fingerprint(buffer + pos, chunk_len),
+                    b->source_size + pos, b->pool);
+          pos += chunk_len;
+        }
+
+      memmove(buffer, buffer + pos, buffer_len - pos);
+      buffer_len -= pos;
+      b->source_size += pos;
+    }
+
+  return svn_error_trace(svn_stream_close(b->index_source));
+}
+
+/* Return the sum of the lengths of all COUNT CANDIDATES that fall into
+ * the source range [START, START + SVN_DELTA_WINDOW_SIZE). */
+static apr_size_t
+score(const candidate_t *candidates,
+      int count,
+      svn_filesize_t start)
+{
+  apr_size_t result = 0;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    if (   candidates[i].source_offset >= start
+        && (  candidates[i].source_offset + candidates[i].len
+            <= start + SVN_DELTA_WINDOW_SIZE))
+      result += candidates[i].len;
+
+  return result;
+}
+
+/* Select the source view for the current target window in B and store
+ * its start in B->DESIRED_START.
+ */
+static void
+select_view(large_window_baton_t *b)
+{
+  const unsigned char *data = (const unsigned char *)b->target_buf;
+  apr_size_t pos = 0;
+  apr_size_t best_score = 0;
+  int count = 0;
+  int pass, i;
+
+  /* Find the target chunks in the source. */
+  while (pos < b->target_len)
+    {
+      apr_size_t len = chunk_length(b->gear, data + pos,
+                                    b->target_len - pos);
+      chunk_t *chunk = find_slot(&b->index, fingerprint(data + pos, len));
+
+      if (chunk->fingerprint && chunk->offset != AMBIGUOUS_OFFSET)
+        {
+          b->candidates[count].source_offset = chunk->offset;
+          b->candidates[count].target_offset = pos;
+          b->candidates[count].len = len;
+          ++count;
+        }
+
+      pos += len;
+    }
+
+  /* Without any evidence, stay where we are.  Moving on could skip source
+     data that later target windows will need. */
+  b->desired_start = b->view_start;
+
+  /* Each candidate suggests a view start that aligns target window and
+     source view.  The view may not move backwards, though.  Only skip
+     source data if a significant part of the target window supports
+     that.  Otherwise, try again without skipping. */
+  for (pass = 0; pass < 2 && best_score == 0; ++pass)
+    for (i = 0; i < count; ++i)
+      {
+        const candidate_t *candidate = &b->candidates[i];
+        svn_filesize_t start = candidate->source_offset
+                             - (svn_filesize_t)candidate->target_offset;
+        apr_size_t current_score;
+
+        if (start < b->view_start)
+          start = b->view_start;
+        if (pass == 1 && start > b->view_end)
+          continue;
+
+        current_score = score(b->candidates, count, start);
+        if (   pass == 0 && start > b->view_end
+            && current_score < b->target_len / 4)
+          continue;
+
+        /* On ties, prefer the smaller step forward. */
+        if (   current_score > best_score
+            || (current_score == best_score && start < b->desired_start))
+          {
+            best_score = current_score;
+            b->desired_start = start;
+          }
+      }
+
+  /* Don't skip beyond the end of the source. */
+  if (b->desired_start > b->source_size)
+    b->desired_start = b->source_size;
+}
+
+/* Read exactly LEN bytes from the source in B into BUFFER. */
+static svn_error_t *
+read_source(large_window_baton_t *b,
+            char *buffer,
+            apr_size_t len)
+{
+  apr_size_t read = len;
+  SVN_ERR(svn_stream_read(b->source, buffer, &read));
+  if (read != len)
+    return svn_error_create(SVN_ERR_INCOMPLETE_DATA, NULL,
+                            _("Delta source ended unexpectedly"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_next_window_fn_t. */
+static svn_error_t *
+large_window_next_window(svn_txdelta_window_t **window,
+                         void *baton,
+                         apr_pool_t *pool)
+{
+  large_window_baton_t *b = baton;
+  apr_size_t view_len;
+
+  if (b->index_source)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(pool);
+      SVN_ERR(build_index(b, scratch_pool));
+      svn_pool_destroy(scratch_pool);
+
+      b->index_source = NULL;
+    }
+
+  /* Fetch the next target window. */
+  if (b->target_len == 0)
+    {
+      b->target_len = SVN_DELTA_WINDOW_SIZE;
+      SVN_ERR(svn_stream_read(b->target, b->target_buf, &b->target_len));
+
+      if (b->target_len == 0)
+        {
+          /* No target data?  We're done; return the final window. */
+          if (b->context != NULL)
+            SVN_ERR(svn_checksum_final(&b->checksum, b->context, b->pool));
+
+          *window = NULL;
+          b->more = FALSE;
+          return SVN_NO_ERROR;
+        }
+      else if (b->context != NULL)
+        SVN_ERR(svn_checksum_update(b->context, b->target_buf,
+                                    b->target_len));
+
+      select_view(b);
+    }
+
+  /* Skip source data by sending windows that don't produce any target
+     data. */
+  if (b->desired_start > b->view_end)
+    {
+      svn_txdelta__ops_baton_t build_baton = { 0 };
+
+      view_len = (apr_size_t)MIN(b->desired_start - b->view_end,
+                                 SVN_DELTA_WINDOW_SIZE);
+      SVN_ERR(read_source(b, b->buf, view_len));
+
+      build_baton.new_data = svn_stringbuf_create_empty(pool);
+      *window = svn_txdelta__make_window(&build_baton, pool);
+      (*window)->sview_offset = b->view_end;
+      (*window)->sview_len = view_len;
+      (*window)->tview_len = 0;
+
+      b->view_start = b->view_end;
+      b->view_end += view_len;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Move the source view to [DESIRED_START, DESIRED_START + window size).
+     Since DESIRED_START is within the current view or at its end, we
+     only need to read the data following the current view. */
+  view_len = (apr_size_t)MIN(b->source_size - b->desired_start,
+                             SVN_DELTA_WINDOW_SIZE);
+  memmove(b->buf, b->buf + (b->desired_start - b->view_start),
+          (apr_size_t)(b->view_end - b->desired_start));
+  SVN_ERR(read_source(b, b->buf + (b->view_end - b->desired_start),
+                      (apr_size_t)(b->desired_start + view_len
+                                   - b->view_end)));
+
+  b->view_start = b->desired_start;
+  b->view_end = b->desired_start + view_len;
+
+  /* Delta the target window against the view. */
+  memcpy(b->buf + view_len, b->target_buf, b->target_len);
+  *window = svn_txdelta__compute_window(b->buf, view_len, b->target_len,
+                                        b->view_start, pool);
+
+  b->target_len = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t. */
+static const unsigned char *
+large_window_md5_digest(void *baton)
+{
+  large_window_baton_t *b = baton;
+
+  /* If there are more windows for this stream, the digest has not yet
+     been calculated.  */
+  if (b->more || b->checksum == NULL)
+    return NULL;
+
+  return b->checksum->digest;
+}
+
+void
+svn_delta__txdelta_large_window(svn_txdelta_stream_t **stream,
+                                svn_stream_t *index_source,
+                                svn_stream_t *source,
+                                svn_stream_t *target,
+                                svn_boolean_t calculate_checksum,
+                                apr_pool_t *pool)
+{
+  large_window_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+
+  b->index_source = index_source;
+  b->source = source;
+  b->target = target;
+  b->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  b->target_buf = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  b->more = TRUE;
+  b->context = calculate_checksum
+             ? svn_checksum_ctx_create(svn_checksum_md5, pool)
+             : NULL;
+  b->pool = pool;
+
+  init_gear(b->gear);
+
+  *stream = svn_txdelta_stream_create(b, large_window_next_window,
+                                      large_window_md5_digest, pool);
+}
@@ -49,6 +49,21 @@ struct encoder_baton {
   apr_pool_t *pool;
 };
 
+/* Compress IN into OUT as required by the svndiff VERSION, using
+   COMPRESSION_LEVEL where applicable.  svndiff0 data must not be
+   passed in here. */
+static svn_error_t *
+compress_data(svn_stringbuf_t *in,
+              svn_stringbuf_t *out,
+              int version,
+              int compression_level)
+{
+  if (version == 2 && compression_level != SVN_DELTA_COMPRESSION_LEVEL_NONE)
+    return svn_error_trace(svn__compress_lz4(in, out));
+
+  return svn_error_trace(svn__compress(in, out, compression_level));
+}
+
 /* This is at least as big as the largest size for a single instruction. */
 #define MAX_INSTRUCTION_LEN (2*SVN__MAX_ENCODED_UINT_LEN+1)
 /* This is at least as big as the largest possible instructions
@@ -213,13 +228,14 @@ window_handler(svn_txdelta_window_t *window, void *baton)
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (eb->version == 1)
+  if (eb->version > 0)
     {
-      SVN_ERR(svn__compress(instructions, i1, eb->compression_level));
+      SVN_ERR(compress_data(instructions, i1, eb->version,
+                            eb->compression_level));
       instructions = i1;
     }
   append_encoded_int(header, instructions->len);
-  if (eb->version == 1)
+  if (eb->version > 0)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
@@ -227,7 +243,8 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       original->len = window->new_data->len;
       original->blocksize = window->new_data->len + 1;
 
-      SVN_ERR(svn__compress(original, compressed, eb->compression_level));
+      SVN_ERR(compress_data(original, compressed, eb->version,
+                            eb->compression_level));
       newdata = svn_stringbuf__morph_into_string(compressed);
     }
   else
@@ -498,6 +515,20 @@ zlib_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
   return svn__decompress(&compressed, out, limit);
 }
 
+/* Like zlib_decode but for LZ4 compressed data as used by svndiff2. */
+static svn_error_t *
+lz4_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
+           apr_size_t limit)
+{
+  svn_stringbuf_t compressed;
+  compressed.pool = NULL;
+  compressed.data = (char *)in;
+  compressed.len = inLen;
+  compressed.blocksize = inLen + 1;
+
+  return svn__decompress_lz4(&compressed, out, limit);
+}
+
 /* Given the five integer fields of a window header and a pointer to
    the remainder of the window contents, fill in a delta window
    structure *WINDOW.  New allocations will be performed in POOL;
@@ -521,17 +552,27 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 1)
+  if (version == 1 || version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
 
       /* these may in fact simply return references to insend */
 
-      SVN_ERR(zlib_decode(insend, newlen, ndout,
-                          SVN_DELTA_WINDOW_SIZE));
-      SVN_ERR(zlib_decode(data, insend - data, instout,
-                          MAX_INSTRUCTION_SECTION_LEN));
+      if (version == 1)
+        {
+          SVN_ERR(zlib_decode(insend, newlen, ndout,
+                              SVN_DELTA_WINDOW_SIZE));
+          SVN_ERR(zlib_decode(data, insend - data, instout,
+                              MAX_INSTRUCTION_SECTION_LEN));
+        }
+      else
+        {
+          SVN_ERR(lz4_decode(insend, newlen, ndout,
+                             SVN_DELTA_WINDOW_SIZE));
+          SVN_ERR(lz4_decode(data, insend - data, instout,
+                             MAX_INSTRUCTION_SECTION_LEN));
+        }
 
       newlen = ndout->len;
       data = (unsigned char *)instout->data;
@@ -595,6 +636,8 @@ write_handler(void *baton,
         db->version = 0;
       else if (memcmp(buffer, "SVN\1" + db->header_bytes, nheader) == 0)
         db->version = 1;
+      else if (memcmp(buffer, "SVN\2" + db->header_bytes, nheader) == 0)
+        db->version = 2;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -649,7 +692,7 @@ write_handler(void *baton,
 
       if (tview_len > SVN_DELTA_WINDOW_SIZE ||
           sview_len > SVN_DELTA_WINDOW_SIZE ||
-          /* for svndiff1, newlen includes the original length */
+          /* for svndiff1/2, newlen includes the original length */
           newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
           inslen > MAX_INSTRUCTION_SECTION_LEN)
         return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
@@ -831,7 +874,7 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
 
   if (*tview_len > SVN_DELTA_WINDOW_SIZE ||
       *sview_len > SVN_DELTA_WINDOW_SIZE ||
-      /* for svndiff1, newlen includes the original length */
+      /* for svndiff1/2, newlen includes the original length */
       *newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
       *inslen > MAX_INSTRUCTION_SECTION_LEN)
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
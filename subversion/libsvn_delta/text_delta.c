@@ -139,13 +139,12 @@ svn_txdelta__make_window(const svn_txdelta__ops_baton_t *build_baton,
 }
 
 
-/* Compute and return a delta window using the xdelta algorithm on
-   DATA, which contains SOURCE_LEN bytes of source data and TARGET_LEN
-   bytes of target data.  SOURCE_OFFSET gives the offset of the source
-   data, and is simply copied into the window's sview_offset field. */
-static svn_txdelta_window_t *
-compute_window(const char *data, apr_size_t source_len, apr_size_t target_len,
-               svn_filesize_t source_offset, apr_pool_t *pool)
+svn_txdelta_window_t *
+svn_txdelta__compute_window(const char *data,
+                            apr_size_t source_len,
+                            apr_size_t target_len,
+                            svn_filesize_t source_offset,
+                            apr_pool_t *pool)
 {
   svn_txdelta__ops_baton_t build_baton = { 0 };
   svn_txdelta_window_t *window;
@@ -389,8 +388,8 @@ txdelta_next_window(svn_txdelta_window_t **window,
   else if (b->context != NULL)
     SVN_ERR(svn_checksum_update(b->context, b->buf + source_len, target_len));
 
-  *window = compute_window(b->buf, source_len, target_len,
-                           b->pos - source_len, pool);
+  *window = svn_txdelta__compute_window(b->buf, source_len, target_len,
+                                       b->pos - source_len, pool);
 
   /* That's it. */
   return SVN_NO_ERROR;
@@ -539,8 +538,9 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       /* If we're full of target data, compute and fire off a window. */
       if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
         {
-          window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                                  tb->source_offset, pool);
+          window = svn_txdelta__compute_window(tb->buf, tb->source_len,
+                                               tb->target_len,
+                                               tb->source_offset, pool);
           SVN_ERR(tb->wh(window, tb->whb));
           tb->source_offset += tb->source_len;
           tb->source_len = 0;
@@ -565,8 +565,9 @@ tpush_close_handler(void *baton)
   /* Send a final window if we have any residual target data. */
   if (tb->target_len > 0)
     {
-      window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                              tb->source_offset, tb->pool);
+      window = svn_txdelta__compute_window(tb->buf, tb->source_len,
+                                           tb->target_len,
+                                           tb->source_offset, tb->pool);
       SVN_ERR(tb->wh(window, tb->whb));
     }
 
@@ -30,8 +30,14 @@
 #include "svn_private_config.h"
 #include "svn_hash.h"
 #include "svn_delta.h"
+#include "svn_sorts.h"
 #include "private/svn_string_private.h"
+#include "private/svn_dep_compat.h"
 #include "delta.h"
+
+#if SVN__SSE2_ENABLED
+#include <emmintrin.h>
+#endif
 
 /* This is pseudo-adler32. It is adler32 without the prime modulus.
    The idea is borrowed from monotone, and is a translation of the C++
@@ -71,6 +77,51 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 /* Calculate an pseudo-adler32 checksum for MATCH_BLOCKSIZE bytes starting
    at DATA.  Return the checksum value.  */
 
+#if SVN__SSE2_ENABLED
+
+/* SSE2 variant of init_adler32.  Each 16 byte chunk contributes its byte
+   sum to S1 and, weighted 16 .. 1 by position, to S2.  Since every byte
+   also gets counted once more in S2 for each chunk that follows, adding
+   16 * S1 before each chunk yields the same weights as the scalar code.
+ */
+static APR_INLINE apr_uint32_t
+init_adler32(const char *data)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i weights_lo = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+  const __m128i weights_hi = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+  __m128i weighted = zero;
+  apr_uint32_t s1 = 0;
+  apr_uint32_t s2 = 0;
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE / 16; ++i)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)data + i);
+      __m128i sums = _mm_sad_epu8(chunk, zero);
+
+      weighted = _mm_add_epi32(weighted,
+                   _mm_madd_epi16(_mm_unpacklo_epi8(chunk, zero),
+                                  weights_lo));
+      weighted = _mm_add_epi32(weighted,
+                   _mm_madd_epi16(_mm_unpackhi_epi8(chunk, zero),
+                                  weights_hi));
+
+      s2 += 16 * s1;
+      s1 += _mm_cvtsi128_si32(sums)
+          + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+
+  /* Add the 4 partial weighted sums. */
+  weighted = _mm_add_epi32(weighted, _mm_srli_si128(weighted, 8));
+  weighted = _mm_add_epi32(weighted, _mm_srli_si128(weighted, 4));
+  s2 += _mm_cvtsi128_si32(weighted);
+
+  return s2 * 0x10000 + s1;
+}
+
+#else
+
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
 {
@@ -95,6 +146,8 @@ init_adler32(const char *data)
   return s2 * 0x10000 + s1;
 }
 
+#endif
+
 /* Information for a block of the delta source.  The length of the
    block is the smaller of MATCH_BLOCKSIZE and the difference between
    the size of the source data and the position of this block. */
@@ -246,7 +299,7 @@ find_match(const struct blocks *blocks,
            apr_size_t pending_insert_start)
 {
   apr_size_t apos, bpos = *bposp;
-  apr_size_t delta, max_delta;
+  apr_size_t delta, max_delta, back_delta;
 
   apos = find_block(blocks, rolling, b + bpos);
 
@@ -264,12 +317,11 @@ find_match(const struct blocks *blocks,
 
   /* See if we can extend backwards (max MATCH_BLOCKSIZE-1 steps because A's
      content has been sampled only every MATCH_BLOCKSIZE positions).  */
-  while (apos > 0 && bpos > pending_insert_start && a[apos-1] == b[bpos-1])
-    {
-      --apos;
-      --bpos;
-      ++delta;
-    }
+  back_delta = svn_cstring__reverse_match_length(a + apos, b + bpos,
+                    MIN(apos, bpos - pending_insert_start));
+  apos -= back_delta;
+  bpos -= back_delta;
+  delta += back_delta;
 
   *aposp = apos;
   *bposp = bpos;
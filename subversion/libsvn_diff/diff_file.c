@@ -50,6 +50,10 @@
 #include "private/svn_adler32.h"
 #include "private/svn_diff_private.h"
 
+#if SVN__SSE2_ENABLED
+#include <emmintrin.h>
+#endif
+
 /* A token, i.e. a line read from a file. */
 typedef struct svn_diff__file_token_t
 {
@@ -370,6 +374,29 @@ static svn_boolean_t contains_eol(apr_uintptr_t chunk)
 }
 #endif
 
+#if SVN__SSE2_ENABLED
+/* Return TRUE if the 16 bytes at DATA contain an eol char. */
+static APR_INLINE svn_boolean_t
+block_contains_eol(const char *data)
+{
+  __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+  __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                               _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+
+  return _mm_movemask_epi8(found) != 0;
+}
+
+/* Return TRUE if the 16 bytes at LHS and RHS are identical. */
+static APR_INLINE svn_boolean_t
+blocks_equal(const char *lhs, const char *rhs)
+{
+  __m128i lhs_chunk = _mm_loadu_si128((const __m128i *)lhs);
+  __m128i rhs_chunk = _mm_loadu_si128((const __m128i *)rhs);
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(lhs_chunk, rhs_chunk)) == 0xffff;
+}
+#endif
+
 /* Find the prefix which is identical between all elements of the FILE array.
  * Return the number of prefix lines in PREFIX_LINES.  REACHED_ONE_EOF will be
  * set to TRUE if one of the FILEs reached its end while scanning prefix,
@@ -433,7 +460,27 @@ find_identical_prefix(svn_boolean_t *reached_one_eof, apr_off_t *prefix_lines,
         }
 
       is_match = TRUE;
-      for (delta = 0; delta < max_delta; delta += sizeof(apr_uintptr_t))
+      delta = 0;
+
+#if SVN__SSE2_ENABLED
+      /* Skip 16 bytes at a time while there is no eol and all files match.
+       * The word-wise loop below will find the exact position.  Just like
+       * that loop, we must stop short of endp because curp may only reach
+       * endp at the actual end of a file. */
+      for (; delta + 16 <= max_delta; delta += 16)
+        {
+          svn_boolean_t block_match = !block_contains_eol(file[0].curp
+                                                          + delta);
+          for (i = 1; block_match && i < file_len; i++)
+            block_match = blocks_equal(file[0].curp + delta,
+                                       file[i].curp + delta);
+
+          if (! block_match)
+            break;
+        }
+#endif
+
+      for (; delta < max_delta; delta += sizeof(apr_uintptr_t))
         {
           apr_uintptr_t chunk = *(const apr_uintptr_t *)(file[0].curp + delta);
           if (contains_eol(chunk))
@@ -614,6 +661,9 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
       /* Initialize the minimum pointer positions. */
       const char *min_curp[4];
       svn_boolean_t can_read_word;
+#if SVN__SSE2_ENABLED
+      svn_boolean_t can_read_block;
+#endif
 #endif /* SVN_UNALIGNED_ACCESS_IS_OK */
 
       /* ### TODO: see if we can take advantage of
@@ -645,6 +695,41 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
       if (file_for_suffix[0].chunk == suffix_min_chunk0)
         min_curp[0] += suffix_min_offset0;
 
+#if SVN__SSE2_ENABLED
+      /* Skip 16 bytes at a time first.  The word-wise loop below will find
+         the exact position of the eol or mismatch. */
+      for (i = 0, can_read_block = TRUE; can_read_block && i < file_len; i++)
+        can_read_block = can_read_block
+                         && (file_for_suffix[i].curp + 1 - 16 > min_curp[i]);
+      while (can_read_block)
+        {
+          if (block_contains_eol(file_for_suffix[0].curp + 1 - 16))
+            break;
+
+          for (i = 1, is_match = TRUE; is_match && i < file_len; i++)
+            is_match = blocks_equal(file_for_suffix[0].curp + 1 - 16,
+                                    file_for_suffix[i].curp + 1 - 16);
+
+          if (! is_match)
+            {
+              is_match = TRUE;
+              break;
+            }
+
+          for (i = 0; i < file_len; i++)
+            {
+              file_for_suffix[i].curp -= 16;
+              can_read_block = can_read_block
+                               && (file_for_suffix[i].curp + 1 - 16
+                                   > min_curp[i]);
+            }
+
+          /* We skipped some bytes, so there are no closing EOLs */
+          had_nl = FALSE;
+          had_cr = FALSE;
+        }
+#endif
+
       /* Scan quickly by reading with machine-word granularity. */
       for (i = 0, can_read_word = TRUE; can_read_word && i < file_len; i++)
         can_read_word = can_read_word
@@ -1183,8 +1268,10 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
   token_discard_all
 };
 
-/* Id for the --ignore-eol-style option, which doesn't have a short name. */
+/* Ids for the --ignore-eol-style and --histogram options, which don't
+   have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+#define SVN_DIFF__OPT_HISTOGRAM 257
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1280,7 @@ static const apr_getopt_option_t diff_options[] =
   { "ignore-all-space", 'w', 0, NULL },
   { "ignore-eol-style", SVN_DIFF__OPT_IGNORE_EOL_STYLE, 0, NULL },
   { "show-c-function", 'p', 0, NULL },
+  { "histogram", SVN_DIFF__OPT_HISTOGRAM, 0, NULL },
   /* ### For compatibility; we don't support the argument to -u, because
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
@@ -1291,6 +1379,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'p':
           options->show_c_function = TRUE;
           break;
+        case SVN_DIFF__OPT_HISTOGRAM:
+          options->histogram = TRUE;
+          break;
         default:
           break;
         }
@@ -1319,7 +1410,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->histogram, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1341,7 +1433,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->histogram, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1365,7 +1458,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.files[3].path = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4_2(diff, &baton, &svn_diff__file_vtable,
+                            options->histogram, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -22,10 +22,14 @@
  */
 
 
+#include <stdlib.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+
 #include "diff.h"
 
 
@@ -228,6 +232,515 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
+/* Return the complete LCS given its EOF element EOF_LCS and the chain of
+ * matches REVERSED_LCS in reverse order.  Add PREFIX_LINES and SUFFIX_LINES
+ * identical lines at the start and the end, respectively. */
+static svn_diff__lcs_t *
+complete_lcs(svn_diff__lcs_t *eof_lcs,
+             svn_diff__lcs_t *reversed_lcs,
+             apr_off_t prefix_lines,
+             apr_off_t suffix_lines,
+             apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs;
+
+  if (suffix_lines)
+    eof_lcs->next = prepend_lcs(reversed_lcs, suffix_lines,
+                                eof_lcs->position[0]->offset - suffix_lines,
+                                eof_lcs->position[1]->offset - suffix_lines,
+                                pool);
+  else
+    eof_lcs->next = reversed_lcs;
+
+  lcs = svn_diff__lcs_reverse(eof_lcs);
+
+  if (prefix_lines)
+    return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+  else
+    return lcs;
+}
+
+
+/*
+ * The histogram diff algorithm.
+ *
+ * The algorithm above finds a minimal diff but its run time grows with
+ * the product of the file size and the number of differences.  For large
+ * files with many changes, that can take minutes.  The alternative
+ * implemented below is a variant of the "patience diff" algorithm:
+ *
+ * Within a region to compare, the lines that occur exactly once in both
+ * sequences are used as anchors.  The longest subsequence of anchors that
+ * has the same order in both sequences gets matched and splits the region
+ * into smaller ones, which are then processed the same way.  Identical
+ * lines at the start and end of each region get matched as well, which
+ * extends the anchors to the surrounding lines.  If a region contains no
+ * unique lines, we look for the longest match containing the least
+ * frequent common line instead (the "histogram" part), looking at no more
+ * than HISTOGRAM_MAX_CHAIN occurrences of each line.
+ *
+ * Processing a region takes time roughly linear in its size.  To bound the
+ * total run time for pathological input, we stop looking for matches once
+ * the work done exceeds HISTOGRAM_WORK_PER_TOKEN per token.  The remaining
+ * regions will then be reported as changed.  So, the result is always a
+ * valid diff but not necessarily a minimal one.
+ */
+
+/* Maximum number of occurrences of a line to try as match candidates. */
+#define HISTOGRAM_MAX_CHAIN 64
+
+/* Average work per token, after which we stop looking for matches. */
+#define HISTOGRAM_WORK_PER_TOKEN 64
+
+/* LENGTH matching tokens starting at index A in the first and index B in
+ * the second sequence. */
+typedef struct histogram_match_t
+{
+  svn_diff__token_index_t a;
+  svn_diff__token_index_t b;
+  svn_diff__token_index_t length;
+} histogram_match_t;
+
+/* The tokens [A_START, A_END) of the first sequence and [B_START, B_END)
+ * of the second sequence still to be compared. */
+typedef struct histogram_region_t
+{
+  svn_diff__token_index_t a_start;
+  svn_diff__token_index_t a_end;
+  svn_diff__token_index_t b_start;
+  svn_diff__token_index_t b_end;
+} histogram_region_t;
+
+/* State of the histogram diff. */
+typedef struct histogram_baton_t
+{
+  /* Token index and position of each element in both sequences. */
+  svn_diff__token_index_t *tokens[2];
+  svn_diff__position_t **positions[2];
+
+  /* Number of occurrences of each token within the current region of
+   * both sequences and the index of its last occurrence there.  The counts
+   * are all 0 between regions. */
+  svn_diff__token_index_t *counts[2];
+  svn_diff__token_index_t *last[2];
+
+  /* For each element of the first sequence, the index of the previous
+   * occurrence of the same token within the current region or -1. */
+  svn_diff__token_index_t *previous;
+
+  /* Scratch arrays used to select anchors. */
+  histogram_match_t *anchors;
+  svn_diff__token_index_t *tails;
+  svn_diff__token_index_t *predecessors;
+
+  /* Matches found so far (histogram_match_t) in no particular order and
+   * the regions still to process (histogram_region_t). */
+  apr_array_header_t *matches;
+  apr_array_header_t *regions;
+
+  /* Work done so far and the limit for it. */
+  apr_size_t work;
+  apr_size_t max_work;
+} histogram_baton_t;
+
+/* Record a match of LENGTH tokens at A and B in HB. */
+static void
+add_match(histogram_baton_t *hb,
+          svn_diff__token_index_t a,
+          svn_diff__token_index_t b,
+          svn_diff__token_index_t length)
+{
+  histogram_match_t *match = apr_array_push(hb->matches);
+
+  match->a = a;
+  match->b = b;
+  match->length = length;
+}
+
+/* Add the region [A_START, A_END) x [B_START, B_END) to be processed by
+ * HB, unless there is nothing to match in it. */
+static void
+add_region(histogram_baton_t *hb,
+           svn_diff__token_index_t a_start,
+           svn_diff__token_index_t a_end,
+           svn_diff__token_index_t b_start,
+           svn_diff__token_index_t b_end)
+{
+  if (a_start < a_end && b_start < b_end)
+    {
+      histogram_region_t *region = apr_array_push(hb->regions);
+
+      region->a_start = a_start;
+      region->a_end = a_end;
+      region->b_start = b_start;
+      region->b_end = b_end;
+    }
+}
+
+/* Count the occurrences of all tokens in REGION and link the occurrences
+ * in the first sequence, updating HB. */
+static void
+count_tokens(histogram_baton_t *hb,
+             const histogram_region_t *region)
+{
+  svn_diff__token_index_t i;
+
+  for (i = region->a_start; i < region->a_end; i++)
+    {
+      svn_diff__token_index_t token = hb->tokens[0][i];
+
+      hb->previous[i] = hb->counts[0][token] ? hb->last[0][token] : -1;
+      hb->last[0][token] = i;
+      hb->counts[0][token]++;
+    }
+
+  for (i = region->b_start; i < region->b_end; i++)
+    {
+      svn_diff__token_index_t token = hb->tokens[1][i];
+
+      hb->last[1][token] = i;
+      hb->counts[1][token]++;
+    }
+
+  hb->work += (region->a_end - region->a_start)
+            + (region->b_end - region->b_start);
+}
+
+/* Reset the token counts in HB for REGION to 0. */
+static void
+reset_counts(histogram_baton_t *hb,
+             const histogram_region_t *region)
+{
+  svn_diff__token_index_t i;
+
+  for (i = region->a_start; i < region->a_end; i++)
+    hb->counts[0][hb->tokens[0][i]] = 0;
+
+  for (i = region->b_start; i < region->b_end; i++)
+    hb->counts[1][hb->tokens[1][i]] = 0;
+
+  hb->work += (region->a_end - region->a_start)
+            + (region->b_end - region->b_start);
+}
+
+/* Match the longest subsequence of tokens that are unique in both
+ * sequences of REGION and have the same order in both.  Add the regions
+ * between them to HB.  Return FALSE if there are no such tokens. */
+static svn_boolean_t
+split_at_unique_tokens(histogram_baton_t *hb,
+                       const histogram_region_t *region)
+{
+  svn_diff__token_index_t anchor_count = 0;
+  svn_diff__token_index_t length = 0;
+  svn_diff__token_index_t a_end = region->a_end;
+  svn_diff__token_index_t b_end = region->b_end;
+  svn_diff__token_index_t i;
+
+  /* Collect the candidates in the order of the second sequence. */
+  for (i = region->b_start; i < region->b_end; i++)
+    {
+      svn_diff__token_index_t token = hb->tokens[1][i];
+
+      if (hb->counts[0][token] == 1 && hb->counts[1][token] == 1)
+        {
+          hb->anchors[anchor_count].a = hb->last[0][token];
+          hb->anchors[anchor_count].b = i;
+          anchor_count++;
+        }
+    }
+
+  if (anchor_count == 0)
+    return FALSE;
+
+  /* Find the longest subsequence with increasing indexes in the first
+   * sequence by patience sorting.  TAILS[K] is the candidate that ends
+   * the increasing subsequence of length K+1 with the smallest end index
+   * found so far. */
+  for (i = 0; i < anchor_count; i++)
+    {
+      svn_diff__token_index_t lower = 0;
+      svn_diff__token_index_t upper = length;
+
+      while (lower < upper)
+        {
+          svn_diff__token_index_t middle = lower + (upper - lower) / 2;
+          if (hb->anchors[hb->tails[middle]].a < hb->anchors[i].a)
+            lower = middle + 1;
+          else
+            upper = middle;
+        }
+
+      hb->predecessors[i] = lower ? hb->tails[lower - 1] : -1;
+      hb->tails[lower] = i;
+      if (lower == length)
+        length++;
+    }
+
+  hb->work += anchor_count;
+
+  /* Match the anchors, starting with the last one. */
+  for (i = hb->tails[length - 1]; i >= 0; i = hb->predecessors[i])
+    {
+      const histogram_match_t *anchor = &hb->anchors[i];
+
+      add_match(hb, anchor->a, anchor->b, 1);
+      add_region(hb, anchor->a + 1, a_end, anchor->b + 1, b_end);
+
+      a_end = anchor->a;
+      b_end = anchor->b;
+    }
+
+  add_region(hb, region->a_start, a_end, region->b_start, b_end);
+
+  return TRUE;
+}
+
+/* Find the longest sequence of matching tokens in REGION that contains the
+ * least frequent common token and match it.  Add the regions before and
+ * after it to HB.  Do nothing if there are no common tokens. */
+static void
+split_at_rare_tokens(histogram_baton_t *hb,
+                     const histogram_region_t *region)
+{
+  const svn_diff__token_index_t *tokens[2];
+  svn_diff__token_index_t best_a = 0;
+  svn_diff__token_index_t best_b = 0;
+  svn_diff__token_index_t best_length = 0;
+  svn_diff__token_index_t best_count = 0;
+  svn_diff__token_index_t b, b_next;
+
+  tokens[0] = hb->tokens[0];
+  tokens[1] = hb->tokens[1];
+
+  for (b = region->b_start; b < region->b_end; b = b_next)
+    {
+      svn_diff__token_index_t token = tokens[1][b];
+      svn_diff__token_index_t count = hb->counts[0][token];
+      svn_diff__token_index_t a;
+      int chain;
+
+      b_next = b + 1;
+      if (count == 0 || (best_length && count > best_count))
+        continue;
+
+      for (a = hb->last[0][token], chain = 0;
+           a >= 0 && chain < HISTOGRAM_MAX_CHAIN;
+           a = hb->previous[a], chain++)
+        {
+          svn_diff__token_index_t a_start = a;
+          svn_diff__token_index_t b_start = b;
+          svn_diff__token_index_t a_end = a + 1;
+          svn_diff__token_index_t b_end = b + 1;
+          svn_diff__token_index_t min_count = count;
+
+          /* Extend the match in both directions, keeping track of the
+           * least frequent token in it. */
+          while (a_start > region->a_start && b_start > region->b_start
+                 && tokens[0][a_start - 1] == tokens[1][b_start - 1])
+            {
+              a_start--;
+              b_start--;
+              if (hb->counts[0][tokens[0][a_start]] < min_count)
+                min_count = hb->counts[0][tokens[0][a_start]];
+            }
+
+          while (a_end < region->a_end && b_end < region->b_end
+                 && tokens[0][a_end] == tokens[1][b_end])
+            {
+              if (hb->counts[0][tokens[0][a_end]] < min_count)
+                min_count = hb->counts[0][tokens[0][a_end]];
+              a_end++;
+              b_end++;
+            }
+
+          hb->work += a_end - a_start;
+
+          /* Don't look for matches starting within this one. */
+          if (b_end > b_next)
+            b_next = b_end;
+
+          if (best_length == 0
+              || min_count < best_count
+              || (min_count == best_count && a_end - a_start > best_length))
+            {
+              best_a = a_start;
+              best_b = b_start;
+              best_length = a_end - a_start;
+              best_count = min_count;
+            }
+        }
+    }
+
+  if (best_length)
+    {
+      add_match(hb, best_a, best_b, best_length);
+      add_region(hb, region->a_start, best_a, region->b_start, best_b);
+      add_region(hb, best_a + best_length, region->a_end,
+                 best_b + best_length, region->b_end);
+    }
+}
+
+/* qsort-compatible comparison function ordering histogram_match_t
+ * elements by their position. */
+static int
+compare_matches(const void *lhs,
+                const void *rhs)
+{
+  const histogram_match_t *lhs_match = lhs;
+  const histogram_match_t *rhs_match = rhs;
+
+  if (lhs_match->a < rhs_match->a)
+    return -1;
+
+  return lhs_match->a > rhs_match->a ? 1 : 0;
+}
+
+/* Return the chain of matches between the non-empty position rings
+ * POSITION_LIST1 and POSITION_LIST2 as found by the histogram diff, in
+ * reverse order.  NUM_TOKENS is the number of different tokens.
+ * Allocate the result in POOL. */
+static svn_diff__lcs_t *
+histogram_lcs(svn_diff__position_t *position_list1,
+              svn_diff__position_t *position_list2,
+              svn_diff__token_index_t num_tokens,
+              apr_pool_t *pool)
+{
+  histogram_baton_t hb;
+  svn_diff__position_t *position_list[2];
+  svn_diff__token_index_t length[2];
+  svn_diff__lcs_t *lcs = NULL;
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  int i;
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+
+  /* Flatten both rings. */
+  for (i = 0; i < 2; i++)
+    {
+      svn_diff__position_t *position = position_list[i]->next;
+      svn_diff__token_index_t k = 0;
+
+      do
+        {
+          k++;
+          position = position->next;
+        }
+      while (position != position_list[i]->next);
+
+      length[i] = k;
+      hb.tokens[i] = apr_palloc(scratch_pool, k * sizeof(*hb.tokens[i]));
+      hb.positions[i] = apr_palloc(scratch_pool,
+                                   k * sizeof(*hb.positions[i]));
+
+      for (k = 0; k < length[i]; k++, position = position->next)
+        {
+          hb.tokens[i][k] = position->token_index;
+          hb.positions[i][k] = position;
+        }
+
+      hb.counts[i] = apr_pcalloc(scratch_pool,
+                                 num_tokens * sizeof(*hb.counts[i]));
+      hb.last[i] = apr_palloc(scratch_pool,
+                              num_tokens * sizeof(*hb.last[i]));
+    }
+
+  hb.previous = apr_palloc(scratch_pool, length[0] * sizeof(*hb.previous));
+  hb.anchors = apr_palloc(scratch_pool, length[1] * sizeof(*hb.anchors));
+  hb.tails = apr_palloc(scratch_pool, length[1] * sizeof(*hb.tails));
+  hb.predecessors = apr_palloc(scratch_pool,
+                               length[1] * sizeof(*hb.predecessors));
+  hb.matches = apr_array_make(scratch_pool, 16, sizeof(histogram_match_t));
+  hb.regions = apr_array_make(scratch_pool, 16, sizeof(histogram_region_t));
+  hb.work = 0;
+  hb.max_work = (apr_size_t)(length[0] + length[1])
+              * HISTOGRAM_WORK_PER_TOKEN;
+
+  add_region(&hb, 0, length[0], 0, length[1]);
+  while (hb.regions->nelts)
+    {
+      histogram_region_t region = APR_ARRAY_IDX(hb.regions,
+                                                hb.regions->nelts - 1,
+                                                histogram_region_t);
+      svn_diff__token_index_t common = 0;
+
+      apr_array_pop(hb.regions);
+
+      /* Match identical tokens at the start and the end of the region. */
+      while (region.a_start + common < region.a_end
+             && region.b_start + common < region.b_end
+             && hb.tokens[0][region.a_start + common]
+                == hb.tokens[1][region.b_start + common])
+        common++;
+
+      if (common)
+        {
+          add_match(&hb, region.a_start, region.b_start, common);
+          region.a_start += common;
+          region.b_start += common;
+          common = 0;
+        }
+
+      while (region.a_start < region.a_end - common
+             && region.b_start < region.b_end - common
+             && hb.tokens[0][region.a_end - common - 1]
+                == hb.tokens[1][region.b_end - common - 1])
+        common++;
+
+      if (common)
+        {
+          region.a_end -= common;
+          region.b_end -= common;
+          add_match(&hb, region.a_end, region.b_end, common);
+        }
+
+      /* Anything left to match? */
+      if (   region.a_start == region.a_end
+          || region.b_start == region.b_end
+          || hb.work > hb.max_work)
+        continue;
+
+      count_tokens(&hb, &region);
+      if (! split_at_unique_tokens(&hb, &region))
+        split_at_rare_tokens(&hb, &region);
+      reset_counts(&hb, &region);
+    }
+
+  /* Chain the matches in reverse order, combining adjacent ones. */
+  qsort(hb.matches->elts, hb.matches->nelts, hb.matches->elt_size,
+        compare_matches);
+
+  for (i = 0; i < hb.matches->nelts; )
+    {
+      const histogram_match_t *match = &APR_ARRAY_IDX(hb.matches, i,
+                                                      histogram_match_t);
+      svn_diff__lcs_t *new_lcs = apr_palloc(pool, sizeof(*new_lcs));
+
+      new_lcs->position[0] = hb.positions[0][match->a];
+      new_lcs->position[1] = hb.positions[1][match->b];
+      new_lcs->length = match->length;
+      new_lcs->refcount = 1;
+      new_lcs->next = lcs;
+      lcs = new_lcs;
+
+      for (i++; i < hb.matches->nelts; i++)
+        {
+          const histogram_match_t *next = &APR_ARRAY_IDX(hb.matches, i,
+                                                         histogram_match_t);
+          if (   next->a != match->a + lcs->length
+              || next->b != match->b + lcs->length)
+            break;
+
+          lcs->length += next->length;
+        }
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return lcs;
+}
+
+
 svn_diff__lcs_t *
 svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__position_t *position_list2, /* pointer to tail (ring) */
@@ -236,6 +749,7 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__token_index_t num_tokens,
               apr_off_t prefix_lines,
               apr_off_t suffix_lines,
+              svn_boolean_t histogram,
               apr_pool_t *pool)
 {
   apr_off_t length[2];
@@ -279,6 +793,11 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
       return lcs;
     }
 
+  if (histogram)
+    return complete_lcs(lcs, histogram_lcs(position_list1, position_list2,
+                                           num_tokens, pool),
+                        prefix_lines, suffix_lines, pool);
+
   unique_count[1] = unique_count[0] = 0;
   for (token_index = 0; token_index < num_tokens; token_index++)
     {
@@ -355,21 +874,8 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
     }
   while (fp[0].position[1] != &sentinel_position[1]);
 
-  if (suffix_lines)
-    lcs->next = prepend_lcs(fp[0].lcs, suffix_lines,
-                            lcs->position[0]->offset - suffix_lines,
-                            lcs->position[1]->offset - suffix_lines,
-                            pool);
-  else
-    lcs->next = fp[0].lcs;
-
-  lcs = svn_diff__lcs_reverse(lcs);
-
   position_list1->next = sentinel_position[0].next;
   position_list2->next = sentinel_position[1].next;
 
-  if (prefix_lines)
-    return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
-  else
-    return lcs;
+  return complete_lcs(lcs, fp[0].lcs, prefix_lines, suffix_lines, pool);
 }
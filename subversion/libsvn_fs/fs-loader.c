@@ -653,12 +653,13 @@ svn_fs_hotcopy(const char *src_path, const char *dest_path,
 }
 
 svn_error_t *
-svn_fs_pack(const char *path,
-            svn_fs_pack_notify_t notify_func,
-            void *notify_baton,
-            svn_cancel_func_t cancel_func,
-            void *cancel_baton,
-            apr_pool_t *pool)
+svn_fs_pack2(const char *path,
+             int jobs,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
@@ -666,12 +667,24 @@ svn_fs_pack(const char *path,
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
   fs = fs_new(NULL, pool);
 
-  SVN_ERR(vtable->pack_fs(fs, path, notify_func, notify_baton,
+  SVN_ERR(vtable->pack_fs(fs, path, jobs, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
                           pool, common_pool));
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_pack(const char *path,
+            svn_fs_pack_notify_t notify_func,
+            void *notify_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *pool)
+{
+  return svn_error_trace(svn_fs_pack2(path, 1, notify_func, notify_baton,
+                                      cancel_func, cancel_baton, pool));
+}
+
 svn_error_t *
 svn_fs_recover(const char *path,
                svn_cancel_func_t cancel_func, void *cancel_baton,
@@ -839,7 +852,7 @@ svn_fs_commit_txn2(const char **conflict_p, svn_revnum_t *new_rev,
   {
     svn_fs_t *fs = txn->fs;
     const char *fs_path = svn_fs_path(fs, pool);
-    err = svn_fs_pack(fs_path, NULL, NULL, NULL, NULL, pool);
+    err = svn_fs_pack2(fs_path, 1, NULL, NULL, NULL, NULL, pool);
     if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
       /* Pre-1.6 filesystem. */
       svn_error_clear(err);
@@ -1324,6 +1337,28 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                          processor, baton, pool));
 }
 
+svn_error_t *
+svn_fs_file_fulltext_location(apr_file_t **file,
+                              apr_off_t *offset,
+                              svn_filesize_t *length,
+                              svn_fs_root_t *root,
+                              const char *path,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  /* if the FS doesn't implement this function, there is no such file */
+  if (root->vtable->file_fulltext_location == NULL || root->is_txn_root)
+    {
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(root->vtable->file_fulltext_location(
+                         file, offset, length,
+                         root, path,
+                         result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -26,10 +26,14 @@
 
 #include "svn_hash.h"
 #include "svn_ctype.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+#include "private/svn_delta_private.h"
 #include "private/svn_temp_serializer.h"
 
 #include "fs_fs.h"
 #include "id.h"
+#include "index.h"
 #include "low_level.h"
 #include "pack.h"
 #include "util.h"
@@ -43,11 +47,31 @@
 #define SVN_FS_FS__LOG_ACCESS
  */
 
-/* Data / item types.
+/* Only delta chains of at least this many reps that had to be combined
+   while reading will get a fulltext checkpoint. */
+#define CHECKPOINT_MIN_CHAIN_LENGTH 4
+
+/* Suffix of checkpoint files that are still being written. */
+#define CHECKPOINT_TMP_SUFFIX ".tmp"
+
+/* Checkpoint files contain the fulltext followed by a footer of this many
+   bytes: the MD5 digest that the fulltext has been verified against and
+   the length of the fulltext as an 8 byte big-endian number.  That way,
+   checkpoints of delta bases can be checked as well, although their MD5
+   and expanded size are not known to the reader. */
+#define CHECKPOINT_FOOTER_SIZE (APR_MD5_DIGESTSIZE + 8)
+
+/* Forward declaration.
  */
-#define SVN_FS_FS__ITEM_TYPE_ANY_REP    1  /* item is a representation. */
-#define SVN_FS_FS__ITEM_TYPE_NODEREV    2  /* item is a noderev */
-#define SVN_FS_FS__ITEM_TYPE_CHANGES    3  /* item is a changed paths list */
+static svn_error_t *
+block_read(void **result,
+           svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_uint64_t item_index,
+           apr_file_t *revision_file,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool);
+
 
 /* When SVN_FS_FS__LOG_ACCESS has been defined, write a line to console
  * showing where REVISION, ITEM_INDEX is located in FS and use ITEM to
@@ -68,14 +92,15 @@ dbg_log_access(svn_fs_t *fs,
   /* no-op if this macro is not defined */
 #ifdef SVN_FS_FS__LOG_ACCESS
   fs_fs_data_t *ffd = fs->fsap_data;
-  static const char *types[] = {"<n/a>", "rep ", "node ", "chgs "};
+  static const char *types[] = {"<n/a>", "frep ", "drep ", "fprop", "dprop",
+                                "node ", "chgs ", "rep  "};
   const char *description = "";
   const char *type = types[item_type];
   const char *pack = "";
   apr_off_t offset_in_rev = offset;
 
   /* determine rev / pack file offset */
-  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, revision, offset,
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, revision, NULL, offset,
                                  scratch_pool));
 
   /* constructing the pack file description */
@@ -169,7 +194,7 @@ open_and_seek_revision(apr_file_t **file,
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, pool));
 
   SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool));
-  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev, offset, pool));
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev, NULL, offset, pool));
   SVN_ERR(aligned_seek(rev_file, offset, pool));
 
   *file = rev_file;
@@ -187,13 +212,16 @@ open_and_seek_transaction(apr_file_t **file,
                           apr_pool_t *pool)
 {
   apr_file_t *rev_file;
+  apr_off_t offset;
 
   SVN_ERR(svn_io_file_open(&rev_file,
                            svn_fs_fs__path_txn_proto_rev(fs, &rep->txn_id,
                                                          pool),
                            APR_READ | APR_BUFFERED, APR_OS_DEFAULT, pool));
 
-  SVN_ERR(aligned_seek(rev_file, rep->offset, pool));
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, SVN_INVALID_REVNUM,
+                                 &rep->txn_id, rep->offset, pool));
+  SVN_ERR(aligned_seek(rev_file, offset, pool));
 
   *file = rev_file;
 
@@ -288,26 +316,44 @@ get_node_revision_body(node_revision_t **noderev_p,
             return SVN_NO_ERROR;
         }
 
-      /* read the data from disk */
-      SVN_ERR(open_and_seek_revision(&revision_file, fs,
-                                     rev_item->revision,
-                                     rev_item->number,
-                                     pool));
-      SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
-                                      svn_stream_from_aprfile2(revision_file,
-                                                                FALSE,
-                                                                pool),
-                                      pool));
+      if (svn_fs_fs__use_log_addressing(fs))
+        {
+          /* 'block-read' will also provide us with the desired data and
+             put it into the cache, along with its neighbours. */
+          SVN_ERR(svn_fs_fs__ensure_revision_exists(rev_item->revision, fs,
+                                                    pool));
+          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&revision_file, fs,
+                                                   rev_item->revision,
+                                                   pool));
+          SVN_ERR(block_read((void **)noderev_p, fs,
+                             rev_item->revision, rev_item->number,
+                             revision_file, pool, pool));
+          SVN_ERR(svn_io_file_close(revision_file, pool));
+        }
+      else
+        {
+          /* read the data from disk */
+          SVN_ERR(open_and_seek_revision(&revision_file, fs,
+                                         rev_item->revision,
+                                         rev_item->number,
+                                         pool));
+          SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
+                                  svn_stream_from_aprfile2(revision_file,
+                                                           FALSE,
+                                                           pool),
+                                  pool));
 
-      /* Workaround issue #4031: is-fresh-txn-root in revision files. */
-      (*noderev_p)->is_fresh_txn_root = FALSE;
+          /* Workaround issue #4031: is-fresh-txn-root in revision files. */
+          (*noderev_p)->is_fresh_txn_root = FALSE;
 
-      /* The noderev is not in cache, yet. Add it, if caching has been enabled. */
-      if (ffd->node_revision_cache)
-        SVN_ERR(svn_cache__set(ffd->node_revision_cache,
-                                &key,
-                                *noderev_p,
-                                pool));
+          /* The noderev is not in cache, yet. Add it, if caching has been
+             enabled. */
+          if (ffd->node_revision_cache)
+            SVN_ERR(svn_cache__set(ffd->node_revision_cache,
+                                   &key,
+                                   *noderev_p,
+                                   pool));
+        }
     }
 
   return SVN_NO_ERROR;
@@ -469,6 +515,21 @@ svn_fs_fs__rev_get_root(svn_fs_id_t **root_id_p,
   svn_boolean_t is_cached;
 
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, pool));
+
+  /* With logical addressing, the root node has a fixed item index. */
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      svn_fs_fs__id_part_t node_id = { 0, 0 };
+      svn_fs_fs__id_part_t copy_id = { 0, 0 };
+      svn_fs_fs__id_part_t rev_item;
+      rev_item.revision = rev;
+      rev_item.number = SVN_FS_FS__ITEM_INDEX_ROOT_NODE;
+
+      *root_id_p = svn_fs_fs__id_rev_create(&node_id, &copy_id, &rev_item,
+                                            pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(svn_cache__get((void **) root_id_p, &is_cached,
                          ffd->rev_root_id_cache, &rev, pool));
   if (is_cached)
@@ -563,7 +624,7 @@ auto_set_start_offset(rep_state_t *rs, apr_pool_t *pool)
   if (rs->start == -1)
     {
       SVN_ERR(svn_fs_fs__item_offset(&rs->start, rs->file->fs, rs->revision,
-                                     rs->offset, pool));
+                                     NULL, rs->offset, pool));
       rs->start += rs->header_size;
     }
 
@@ -677,10 +738,9 @@ create_rep_state_body(rep_state_t **rep_state,
            */
           rs->file = *shared_file;
           SVN_ERR(auto_open_shared_file(rs->file));
-          SVN_ERR(svn_fs_fs__get_packed_offset(&offset, fs, rep->revision,
-                                               pool));
-          SVN_ERR(aligned_seek((*shared_file)->file, offset + rep->offset,
-                               pool));
+          SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rep->revision, NULL,
+                                         rep->offset, pool));
+          SVN_ERR(aligned_seek((*shared_file)->file, offset, pool));
         }
       else
         {
@@ -876,6 +936,16 @@ struct rep_read_baton
   /* The text we've been reading, if we're going to cache it. */
   svn_stringbuf_t *current_fulltext;
 
+  /* Temporary file receiving the text we've been reading, if it is going
+     to become a fulltext checkpoint, and the path of that file.  NULL if
+     no checkpoint shall be written. */
+  apr_file_t *checkpoint_file;
+  const char *checkpoint_tmp_path;
+
+  /* Revision and item index of the rep we are reading. */
+  svn_revnum_t revision;
+  apr_uint64_t item_index;
+
   /* Used for temporary allocations during the read. */
   apr_pool_t *pool;
 
@@ -1026,10 +1096,383 @@ set_cached_combined_window(svn_stringbuf_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Read the footer of the checkpoint FILE of FILE_SIZE bytes.  If it is
+ * consistent with FILE_SIZE and matches MD5_DIGEST and EXPANDED_SIZE, set
+ * *LENGTH to the length of the fulltext in FILE.  Otherwise, set it to -1.
+ * MD5_DIGEST may be NULL and EXPANDED_SIZE may be -1 if they are unknown.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+check_checkpoint(svn_filesize_t *length,
+                 apr_file_t *file,
+                 apr_off_t file_size,
+                 const unsigned char *md5_digest,
+                 svn_filesize_t expanded_size,
+                 apr_pool_t *scratch_pool)
+{
+  unsigned char footer[CHECKPOINT_FOOTER_SIZE];
+  apr_off_t offset = file_size - CHECKPOINT_FOOTER_SIZE;
+  apr_uint64_t size = 0;
+  int i;
+
+  *length = -1;
+  if (offset < 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, footer, sizeof(footer), NULL, NULL,
+                                 scratch_pool));
+
+  for (i = APR_MD5_DIGESTSIZE; i < CHECKPOINT_FOOTER_SIZE; ++i)
+    size = (size << 8) | footer[i];
+
+  if (   size != (apr_uint64_t)offset
+      || (expanded_size >= 0 && size != (apr_uint64_t)expanded_size)
+      || (md5_digest && memcmp(footer, md5_digest, APR_MD5_DIGESTSIZE)))
+    return SVN_NO_ERROR;
+
+  *length = (svn_filesize_t)size;
+  return SVN_NO_ERROR;
+}
+
+/* If there is a fulltext checkpoint for the rep at ITEM_INDEX in REVISION
+ * of FS, set *REP_STATE to a pseudo plaintext rep_state reading from it.
+ * Otherwise, set it to NULL.  MD5_DIGEST and EXPANDED_SIZE are the rep's
+ * checksum and fulltext length, if known, and NULL and -1 otherwise.
+ * Allocate the result in POOL.
+ *
+ * Checkpoints are a cache only.  So, failing to open one is not an error.
+ * Checkpoints that don't pass check_checkpoint() get removed.
+ */
+static svn_error_t *
+open_checkpoint(rep_state_t **rep_state,
+                svn_fs_t *fs,
+                svn_revnum_t revision,
+                apr_uint64_t item_index,
+                const unsigned char *md5_digest,
+                svn_filesize_t expanded_size,
+                apr_pool_t *pool)
+{
+  const char *path = svn_fs_fs__path_checkpoint(fs, revision, item_index,
+                                                pool);
+  shared_file_t *file;
+  rep_state_t *rs;
+  apr_finfo_t finfo;
+  apr_file_t *apr_file;
+  svn_filesize_t length = -1;
+  svn_error_t *err;
+
+  *rep_state = NULL;
+
+  err = svn_io_file_open(&apr_file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  err = svn_io_file_info_get(&finfo, APR_FINFO_SIZE, apr_file, pool);
+  if (!err)
+    err = check_checkpoint(&length, apr_file, finfo.size, md5_digest,
+                           expanded_size, pool);
+  if (err || length < 0)
+    {
+      svn_error_clear(svn_io_file_close(apr_file, pool));
+
+      /* A truncated or otherwise damaged checkpoint would make reading
+         the rep fail.  Remove it, so the caller falls back to the delta
+         chain, which will also write a new checkpoint if appropriate. */
+      if (!err)
+        svn_error_clear(svn_io_remove_file2(path, TRUE, pool));
+
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Mark the checkpoint as recently used. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(), path,
+                                                pool));
+
+  file = apr_pcalloc(pool, sizeof(*file));
+  file->file = apr_file;
+  file->stream = svn_stream_from_aprfile2(apr_file, TRUE, pool);
+  file->fs = fs;
+  file->revision = revision;
+  file->pool = pool;
+
+  rs = apr_pcalloc(pool, sizeof(*rs));
+  rs->file = file;
+  rs->revision = revision;
+  rs->offset = item_index;
+  rs->start = 0;
+  rs->current = 0;
+  rs->size = length;
+  rs->ver = -1;
+
+  *rep_state = rs;
+  return SVN_NO_ERROR;
+}
+
+/* Compare the modification times of the svn_io_dirent2_t values in A
+ * and B.  To be used with svn_sort__hash. */
+static int
+compare_dirent_mtime(const svn_sort__item_t *a,
+                     const svn_sort__item_t *b)
+{
+  const svn_io_dirent2_t *lhs = a->value;
+  const svn_io_dirent2_t *rhs = b->value;
+
+  return lhs->mtime < rhs->mtime ? -1 : (lhs->mtime > rhs->mtime ? 1 : 0);
+}
+
+/* Remove the least recently used checkpoints from the checkpoint folder
+ * of FS until their total size is at most TARGET_SIZE.  Set *TOTAL_SIZE
+ * to the total size of the remaining checkpoints.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+shrink_checkpoints(apr_int64_t *total_size,
+                   svn_fs_t *fs,
+                   apr_int64_t target_size,
+                   apr_pool_t *scratch_pool)
+{
+  const char *dir = svn_dirent_join(fs->path, PATH_CHECKPOINTS_DIR,
+                                    scratch_pool);
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_array_header_t *sorted;
+  apr_int64_t size = 0;
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, FALSE, scratch_pool,
+                              scratch_pool));
+
+  /* Files still being written by other readers don't count. */
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const svn_io_dirent2_t *dirent = svn__apr_hash_index_val(hi);
+      apr_size_t len = strlen(name);
+
+      if (   dirent->kind != svn_node_file
+          || (len > 4 && strcmp(name + len - 4, CHECKPOINT_TMP_SUFFIX) == 0))
+        svn_hash_sets(dirents, name, NULL);
+      else
+        size += dirent->filesize;
+    }
+
+  if (size > target_size)
+    {
+      sorted = svn_sort__hash(dirents, compare_dirent_mtime, scratch_pool);
+      for (i = 0; i < sorted->nelts && size > target_size; ++i)
+        {
+          const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                        svn_sort__item_t);
+          const svn_io_dirent2_t *dirent = item->value;
+
+          SVN_ERR(svn_io_remove_file2(svn_dirent_join(dir, item->key,
+                                                      scratch_pool),
+                                      TRUE, scratch_pool));
+          size -= dirent->filesize;
+        }
+    }
+
+  *total_size = size;
+  return SVN_NO_ERROR;
+}
+
+/* Add SIZE bytes for a new checkpoint to the checkpoint size accounting
+ * in FFSD for FS.  If that exceeds the configured limit, remove the least
+ * recently used checkpoints.  Use SCRATCH_POOL for temporary allocations.
+ *
+ * To be called while holding FFSD->CHECKPOINTS_LOCK.
+ */
+static svn_error_t *
+update_checkpoints_total(fs_fs_shared_data_t *ffsd,
+                         svn_fs_t *fs,
+                         apr_int64_t size,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Only scan the checkpoint folder the first time and whenever the
+     limit has been exceeded.  Then, make some extra room such that we
+     won't have to scan it again for the next few checkpoints. */
+  if (ffsd->checkpoints_total < 0)
+    err = shrink_checkpoints(&ffsd->checkpoints_total, fs,
+                             ffd->checkpoints_size, scratch_pool);
+  else if (ffsd->checkpoints_total + size > ffd->checkpoints_size)
+    err = shrink_checkpoints(&ffsd->checkpoints_total, fs,
+                             ffd->checkpoints_size
+                               - ffd->checkpoints_size / 8,
+                             scratch_pool);
+  else
+    ffsd->checkpoints_total += size;
+
+  /* Start over with a fresh scan next time. */
+  if (err)
+    ffsd->checkpoints_total = -1;
+
+  return svn_error_trace(err);
+}
+
+/* Account for a new checkpoint of SIZE bytes in FS and make room for it,
+ * if necessary.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_checkpoint_size(svn_fs_t *fs,
+                    apr_int64_t size,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+
+  SVN_MUTEX__WITH_LOCK(ffsd->checkpoints_lock,
+                       update_checkpoints_total(ffsd, fs, size,
+                                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup handler removing the unfinished checkpoint file of the
+ * rep_read_baton given as DATA, if there is one. */
+static apr_status_t
+remove_checkpoint_tmp(void *data)
+{
+  struct rep_read_baton *rb = data;
+
+  if (rb->checkpoint_tmp_path)
+    svn_error_clear(svn_io_remove_file2(rb->checkpoint_tmp_path, TRUE,
+                                        rb->filehandle_pool));
+
+  return APR_SUCCESS;
+}
+
+/* If the checkpoints are enabled for the FS in RB, start writing a
+ * checkpoint for REP if reading REP requires a long delta chain to be
+ * combined.  Checkpoints are a cache only, i.e. errors will be ignored. */
+static void
+begin_checkpoint(struct rep_read_baton *rb,
+                 representation_t *rep)
+{
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
+  const char *dir;
+  svn_error_t *err;
+
+  if (   ffd->checkpoints_size == 0
+      || rb->rs_list->nelts < CHECKPOINT_MIN_CHAIN_LENGTH
+      || rb->len > ffd->checkpoints_size
+      || !SVN_IS_VALID_REVNUM(rep->revision)
+      || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return;
+
+  dir = svn_dirent_join(rb->fs->path, PATH_CHECKPOINTS_DIR, rb->pool);
+  err = svn_fs_fs__ensure_dir_exists(dir, rb->fs->path, rb->pool);
+
+  /* Register the cleanup before opening the file, so that the file gets
+     closed before we try to remove it. */
+  apr_pool_cleanup_register(rb->filehandle_pool, rb, remove_checkpoint_tmp,
+                            apr_pool_cleanup_null);
+
+  if (!err)
+    err = svn_io_open_uniquely_named(&rb->checkpoint_file,
+                                     &rb->checkpoint_tmp_path, dir,
+                                     apr_psprintf(rb->pool,
+                                                  "%ld.%" APR_UINT64_T_FMT,
+                                                  rep->revision,
+                                                  rep->offset),
+                                     CHECKPOINT_TMP_SUFFIX,
+                                     svn_io_file_del_none,
+                                     rb->filehandle_pool, rb->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      rb->checkpoint_file = NULL;
+      rb->checkpoint_tmp_path = NULL;
+    }
+
+  rb->revision = rep->revision;
+  rb->item_index = rep->offset;
+}
+
+/* Give up on the checkpoint being written for RB and remove the
+ * unfinished file. */
+static void
+abort_checkpoint(struct rep_read_baton *rb)
+{
+  svn_error_clear(svn_io_file_close(rb->checkpoint_file, rb->pool));
+  remove_checkpoint_tmp(rb);
+
+  rb->checkpoint_file = NULL;
+  rb->checkpoint_tmp_path = NULL;
+}
+
+/* Append the LEN bytes at DATA to the checkpoint being written for RB. */
+static void
+write_checkpoint(struct rep_read_baton *rb,
+                 const char *data,
+                 apr_size_t len)
+{
+  svn_error_t *err = svn_io_file_write_full(rb->checkpoint_file, data, len,
+                                            NULL, rb->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      abort_checkpoint(rb);
+    }
+}
+
+/* The checkpoint being written for RB is complete and its contents have
+ * been verified.  Add the footer, move it into place and make room for it.
+ */
+static void
+finish_checkpoint(struct rep_read_baton *rb)
+{
+  const char *path = svn_fs_fs__path_checkpoint(rb->fs, rb->revision,
+                                                rb->item_index, rb->pool);
+  unsigned char footer[CHECKPOINT_FOOTER_SIZE];
+  apr_uint64_t size = rb->len;
+  svn_error_t *err;
+  int i;
+
+  memcpy(footer, rb->md5_digest, APR_MD5_DIGESTSIZE);
+  for (i = CHECKPOINT_FOOTER_SIZE - 1; i >= APR_MD5_DIGESTSIZE; --i)
+    {
+      footer[i] = (unsigned char)(size & 0xff);
+      size >>= 8;
+    }
+
+  err = svn_io_file_write_full(rb->checkpoint_file, footer, sizeof(footer),
+                               NULL, rb->pool);
+  err = svn_error_compose_create(err,
+                                 svn_io_file_close(rb->checkpoint_file,
+                                                   rb->pool));
+
+  rb->checkpoint_file = NULL;
+  if (!err)
+    err = svn_io_file_rename(rb->checkpoint_tmp_path, path, rb->pool);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      remove_checkpoint_tmp(rb);
+    }
+  else
+    {
+      svn_error_clear(add_checkpoint_size(rb->fs,
+                                          rb->len + CHECKPOINT_FOOTER_SIZE,
+                                          rb->pool));
+    }
+
+  rb->checkpoint_tmp_path = NULL;
+}
+
 /* Build an array of rep_state structures in *LIST giving the delta
    reps from first_rep to a plain-text or self-compressed rep.  Set
    *SRC_STATE to the plain-text rep we find at the end of the chain,
    or to NULL if the final delta representation is self-compressed.
+   A rep that has a fulltext checkpoint ends the chain as well and
+   *SRC_STATE will read from that checkpoint.
    The representation to start from is designated by filesystem FS, id
    ID, and representation REP.
    Also, set *WINDOW_P to the base window content for *LIST, if it
@@ -1052,6 +1495,7 @@ build_rep_list(apr_array_header_t **list,
   svn_fs_fs__rep_header_t *rep_header;
   svn_boolean_t is_cached = FALSE;
   shared_file_t *shared_file = NULL;
+  fs_fs_data_t *ffd = fs->fsap_data;
 
   *list = apr_array_make(pool, 1, sizeof(rep_state_t *));
   rep = *first_rep;
@@ -1092,14 +1536,14 @@ build_rep_list(apr_array_header_t **list,
           rs->current = 0;
           rs->size = (*window_p)->len;
           *src_state = rs;
-          return SVN_NO_ERROR;
+          break;
         }
 
       if (rep_header->type == svn_fs_fs__rep_plain)
         {
           /* This is a plaintext, so just return the current rep_state. */
           *src_state = rs;
-          return SVN_NO_ERROR;
+          break;
         }
 
       /* Push this rep onto the list.  If it's self-compressed, we're done. */
@@ -1107,7 +1551,7 @@ build_rep_list(apr_array_header_t **list,
       if (rep_header->type == svn_fs_fs__rep_self_delta)
         {
           *src_state = NULL;
-          return SVN_NO_ERROR;
+          break;
         }
 
       rep.revision = rep_header->base_revision;
@@ -1117,6 +1561,41 @@ build_rep_list(apr_array_header_t **list,
 
       rs = NULL;
     }
+
+  /* A fulltext checkpoint is as good as a plaintext.  Checkpoints only get
+     written for reps that required at least CHECKPOINT_MIN_CHAIN_LENGTH
+     deltas to be combined.  So, don't look for any if the chain is shorter
+     and only for the reps where that many deltas remain.  The MD5 and
+     expanded size are only known for the first rep.  Checkpoints of its
+     delta bases can only be checked against their footer. */
+  if (ffd->checkpoints_size)
+    {
+      int i;
+      for (i = 0; i + CHECKPOINT_MIN_CHAIN_LENGTH <= (*list)->nelts; ++i)
+        {
+          rep_state_t *checkpoint;
+          rs = APR_ARRAY_IDX(*list, i, rep_state_t *);
+
+          /* Only the first rep may be part of a txn. */
+          if (i == 0 && svn_fs_fs__id_txn_used(&first_rep->txn_id))
+            continue;
+
+          SVN_ERR(open_checkpoint(&checkpoint, fs, rs->revision, rs->offset,
+                                  i == 0 ? first_rep->md5_digest : NULL,
+                                  i == 0 ? *expanded_size : -1, pool));
+          if (checkpoint)
+            {
+              /* Cut the chain.  Any cached window we found belonged to
+                 the end of the chain and is no longer needed. */
+              (*list)->nelts = i;
+              *window_p = NULL;
+              *src_state = checkpoint;
+              break;
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1152,6 +1631,8 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
                          &b->src_state, &b->len, fs, rep,
                          b->filehandle_pool));
 
+  begin_checkpoint(b, rep);
+
   if (SVN_IS_VALID_REVNUM(fulltext_cache_key.revision))
     b->current_fulltext = svn_stringbuf_create_ensure
                             ((apr_size_t)b->len,
@@ -1476,6 +1957,9 @@ rep_read_contents(void *baton,
   if (rb->current_fulltext)
     svn_stringbuf_appendbytes(rb->current_fulltext, buf, *len);
 
+  if (rb->checkpoint_file)
+    write_checkpoint(rb, buf, *len);
+
   /* Perform checksumming.  We want to check the checksum as soon as
      the last byte of data is read, in case the caller never performs
      a short read, but we don't want to finalize the MD5 context
@@ -1500,6 +1984,9 @@ rep_read_contents(void *baton,
                         rb->pool,
                         _("Checksum mismatch while reading representation")),
                     NULL);
+
+          if (rb->checkpoint_file)
+            finish_checkpoint(rb);
         }
     }
 
@@ -1629,6 +2116,91 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
   return SVN_NO_ERROR;
 }
 
+/* Flags to open files with that are going to be passed to sendfile(). */
+#define SENDFILE_OPEN_FLAGS (APR_READ | APR_BINARY | APR_SENDFILE_ENABLED)
+
+svn_error_t *
+svn_fs_fs__get_fulltext_location(apr_file_t **file,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_state_t *rs;
+  svn_fs_fs__rep_header_t *rep_header;
+  svn_error_t *err;
+
+  *file = NULL;
+
+  /* Contents of txn reps may still change. */
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_rep_state(&rs, &rep_header, NULL, rep, fs, scratch_pool));
+  if (rep_header->type == svn_fs_fs__rep_plain)
+    {
+      /* Determine the location before opening the file.  If the rev
+         gets packed in between, opening the rev file will fail and we
+         simply report the contents as not available. */
+      SVN_ERR(svn_fs_fs__item_offset(offset, fs, rep->revision, NULL,
+                                     rep->offset, scratch_pool));
+      *offset += rep_header->header_size;
+      *length = rep->size;
+
+      err = svn_io_file_open(file,
+                             svn_fs_fs__path_rev_absolute(fs, rep->revision,
+                                                          scratch_pool),
+                             SENDFILE_OPEN_FLAGS, APR_OS_DEFAULT,
+                             result_pool);
+    }
+  else if (ffd->checkpoints_size && rep->expanded_size)
+    {
+      apr_finfo_t finfo;
+
+      *offset = 0;
+
+      err = svn_io_file_open(file,
+                             svn_fs_fs__path_checkpoint(fs, rep->revision,
+                                                        rep->offset,
+                                                        scratch_pool),
+                             SENDFILE_OPEN_FLAGS, APR_OS_DEFAULT,
+                             result_pool);
+
+      /* The checkpoint's footer records the MD5 its contents have been
+         verified against when it was written.  Only use checkpoints
+         verified against REP that also have the expected size. */
+      if (!err)
+        {
+          err = svn_io_file_info_get(&finfo, APR_FINFO_SIZE, *file,
+                                     scratch_pool);
+          if (!err)
+            err = check_checkpoint(length, *file, finfo.size,
+                                   rep->md5_digest, rep->expanded_size,
+                                   scratch_pool);
+          if (!err && *length < 0)
+            err = svn_error_create(SVN_ERR_FS_CORRUPT, NULL, NULL);
+          if (err)
+            svn_error_clear(svn_io_file_close(*file, scratch_pool));
+        }
+    }
+  else
+    {
+      return SVN_NO_ERROR;
+    }
+
+  /* The file is optional. */
+  if (err)
+    {
+      svn_error_clear(err);
+      *file = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Baton used when reading delta windows. */
 struct delta_read_baton
@@ -1711,8 +2283,24 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 
   /* Because source and target stream will already verify their content,
    * there is no need to do this once more.  In particular if the stream
-   * content is being fetched from cache. */
-  svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
+   * content is being fetched from cache.
+   *
+   * For large sources, index the whole source text such that moved and
+   * shifted content will still be found.  That requires a second pass
+   * over the source contents. */
+  if (source && source->data_rep
+      && (source->data_rep->expanded_size
+            ? source->data_rep->expanded_size
+            : source->data_rep->size) >= SVN_DELTA__LARGE_WINDOW_THRESHOLD)
+    {
+      svn_stream_t *index_stream;
+      SVN_ERR(svn_fs_fs__get_contents(&index_stream, fs, source->data_rep,
+                                      pool));
+      svn_delta__txdelta_large_window(stream_p, index_stream, source_stream,
+                                      target_stream, FALSE, pool);
+    }
+  else
+    svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
 
   return SVN_NO_ERROR;
 }
@@ -2043,24 +2631,324 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, pool));
   SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&revision_file, fs, rev, pool));
 
-  SVN_ERR(get_root_changes_offset(NULL, &changes_offset, revision_file, fs,
-                                  rev, pool));
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      /* 'block-read' will also provide us with the desired data
+         and put it into the cache. */
+      changes_offset = SVN_FS_FS__ITEM_INDEX_CHANGES;
+      SVN_ERR(block_read((void **)changes, fs, rev, changes_offset,
+                         revision_file, pool, pool));
+    }
+  else
+    {
+      SVN_ERR(get_root_changes_offset(NULL, &changes_offset, revision_file,
+                                      fs, rev, pool));
 
-  SVN_ERR(aligned_seek(revision_file, changes_offset, pool));
-  SVN_ERR(svn_fs_fs__read_changes(changes,
-                      svn_stream_from_aprfile2(revision_file, TRUE, pool),
-                                  pool));
+      SVN_ERR(aligned_seek(revision_file, changes_offset, pool));
+      SVN_ERR(svn_fs_fs__read_changes(changes,
+                          svn_stream_from_aprfile2(revision_file, TRUE, pool),
+                                      pool));
+
+      /* cache for future reference */
+
+      if (ffd->changes_cache)
+        SVN_ERR(svn_cache__set(ffd->changes_cache, &rev, *changes, pool));
+    }
 
   SVN_ERR(svn_io_file_close(revision_file, pool));
 
+  SVN_ERR(dbg_log_access(fs, rev, changes_offset, *changes,
+                         SVN_FS_FS__ITEM_TYPE_CHANGES, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Read the representation header at the current position in STREAM,
+ * which is the start of the representation described by ENTRY in FS.
+ * Put it into the rep header cache, if caching has been enabled and the
+ * header has not been cached, yet.  Use POOL for allocations.
+ */
+static svn_error_t *
+block_read_contents(svn_fs_t *fs,
+                    svn_stream_t *stream,
+                    svn_fs_fs__p2l_entry_t *entry,
+                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_cache_key_t key = { 0 };
+  svn_fs_fs__rep_header_t *rep_header;
+  svn_boolean_t is_cached = FALSE;
+
+  if (!ffd->rep_header_cache)
+    return SVN_NO_ERROR;
+
+  key.revision = (apr_uint32_t)entry->item.revision;
+  key.is_packed = svn_fs_fs__is_packed_rev(fs, entry->item.revision);
+  key.offset = entry->item.number;
+
+  SVN_ERR(svn_cache__has_key(&is_cached, ffd->rep_header_cache, &key, pool));
+  if (is_cached)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__read_rep_header(&rep_header, stream, pool));
+  SVN_ERR(svn_cache__set(ffd->rep_header_cache, &key, rep_header, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* For the item described by ENTRY, return a stream to read it from in
+ * *STREAM.  If the item crosses a block boundary of FILE in FS, read the
+ * whole item into memory in one go and return a stream reading from that
+ * buffer.  Otherwise, return FILE_STREAM.  Use POOL for allocations.
+ */
+static svn_error_t *
+auto_select_stream(svn_stream_t **stream,
+                   svn_fs_t *fs,
+                   apr_file_t *file,
+                   svn_stream_t *file_stream,
+                   svn_fs_fs__p2l_entry_t* entry,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (((entry->offset + entry->size) ^ entry->offset) >= ffd->block_size)
+    {
+      svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
+      text->len = entry->size;
+      text->data[text->len] = 0;
+      SVN_ERR(svn_io_file_read_full2(file, text->data, text->len, NULL,
+                                     NULL, pool));
+      *stream = svn_stream_from_stringbuf(text, pool);
+    }
+  else
+    {
+      *stream = file_stream;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the changed paths list described by ENTRY in FS from FILE and
+ * put it into the changes cache.  If MUST_READ is not set, skip items
+ * that can't be cached or already are.  Otherwise, return the list in
+ * *CHANGES.  Use FILE_STREAM to read from FILE, if the item lies within
+ * a single block.  Allocate the result in POOL.
+ */
+static svn_error_t *
+block_read_changes(apr_array_header_t **changes,
+                   svn_fs_t *fs,
+                   apr_file_t *file,
+                   svn_stream_t *file_stream,
+                   svn_fs_fs__p2l_entry_t *entry,
+                   svn_boolean_t must_read,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stream_t *stream;
+  if (!must_read && !ffd->changes_cache)
+    return SVN_NO_ERROR;
+
+  /* already in cache? */
+  if (!must_read && ffd->changes_cache)
+    {
+      svn_boolean_t is_cached = FALSE;
+      SVN_ERR(svn_cache__has_key(&is_cached, ffd->changes_cache,
+                                 &entry->item.revision, pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(auto_select_stream(&stream, fs, file, file_stream, entry, pool));
+
+  /* read changes from revision file */
+
+  SVN_ERR(svn_fs_fs__read_changes(changes, stream, pool));
+
   /* cache for future reference */
 
   if (ffd->changes_cache)
-    SVN_ERR(svn_cache__set(ffd->changes_cache, &rev, *changes, pool));
+    SVN_ERR(svn_cache__set(ffd->changes_cache, &entry->item.revision,
+                           *changes, pool));
 
-  SVN_ERR(dbg_log_access(fs, rev, changes_offset, *changes,
-                         SVN_FS_FS__ITEM_TYPE_CHANGES, pool));
+  return SVN_NO_ERROR;
+}
+
+/* Read the node revision described by ENTRY in FS from FILE and put it
+ * into the node revision cache under KEY.  If MUST_READ is not set, skip
+ * items that can't be cached or already are.  Otherwise, return the
+ * noderev in *NODEREV_P.  Use FILE_STREAM to read from FILE, if the item
+ * lies within a single block.  Allocate the result in POOL.
+ */
+static svn_error_t *
+block_read_noderev(node_revision_t **noderev_p,
+                   svn_fs_t *fs,
+                   apr_file_t *file,
+                   svn_stream_t *file_stream,
+                   svn_fs_fs__p2l_entry_t *entry,
+                   pair_cache_key_t *key,
+                   svn_boolean_t must_read,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stream_t *stream;
+  if (!must_read && !ffd->node_revision_cache)
+    return SVN_NO_ERROR;
+
+  /* already in cache? */
+  if (!must_read && ffd->node_revision_cache)
+    {
+      svn_boolean_t is_cached = FALSE;
+      SVN_ERR(svn_cache__has_key(&is_cached, ffd->node_revision_cache, key,
+                                 pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(auto_select_stream(&stream, fs, file, file_stream, entry, pool));
+
+  /* read node rev from revision file */
+
+  SVN_ERR(svn_fs_fs__read_noderev(noderev_p, stream, pool));
+
+  /* Workaround issue #4031: is-fresh-txn-root in revision files. */
+  (*noderev_p)->is_fresh_txn_root = FALSE;
+
+  if (ffd->node_revision_cache)
+    SVN_ERR(svn_cache__set(ffd->node_revision_cache, key, *noderev_p, pool));
 
   return SVN_NO_ERROR;
 }
 
+/* Read the item ITEM_INDEX of REVISION in FS from REVISION_FILE and return
+ * it in *RESULT, allocated in RESULT_POOL.  Only noderevs and changed
+ * path lists can be requested this way.  If RESULT is NULL, don't return
+ * anything.
+ *
+ * Since reading any data from disk has a minimum granularity of one block,
+ * parse all other items that start within that block as well and put them
+ * into the respective caches.  Items crossing the end of the block will be
+ * completed by reading the next block as well.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+block_read(void **result,
+           svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_uint64_t item_index,
+           apr_file_t *revision_file,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t offset, wanted_offset = 0;
+  apr_off_t block_start = 0;
+  apr_array_header_t *entries;
+  int run_count = 0;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stream_t *stream = svn_stream_from_aprfile2(revision_file, TRUE,
+                                                  scratch_pool);
+
+  /* don't try this on transaction protorev files */
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(revision));
+
+  /* index lookup: find the OFFSET of the item we *must* read plus (in the
+   * "do-while" block) the list of items in the same block. */
+  SVN_ERR(svn_fs_fs__item_offset(&wanted_offset, fs, revision, NULL,
+                                 item_index, iterpool));
+
+  offset = wanted_offset;
+  do
+    {
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, revision, offset,
+                                          scratch_pool));
+      SVN_ERR(svn_io_file_aligned_seek(revision_file, ffd->block_size,
+                                       &block_start, offset, iterpool));
+
+      /* read all items from the block */
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_boolean_t is_result;
+          apr_pool_t *pool;
+
+          svn_fs_fs__p2l_entry_t* entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+          /* skip empty sections */
+          if (entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED)
+            continue;
+
+          /* the item we were looking for? */
+          is_result =    result
+                      && entry->offset == wanted_offset
+                      && entry->item.revision == revision
+                      && entry->item.number == item_index;
+
+          /* select the pool that we want the item to be allocated in */
+          pool = is_result ? result_pool : iterpool;
+
+          /* handle all items that start within this block and are relatively
+           * small (i.e. < block size).  Always read the item we need to return.
+           */
+          if (is_result || (   entry->offset >= block_start
+                            && entry->size < ffd->block_size))
+            {
+              void *item = NULL;
+              pair_cache_key_t key = { 0 };
+              key.revision = entry->item.revision;
+              key.second = entry->item.number;
+
+              SVN_ERR(svn_io_file_seek(revision_file, APR_SET,
+                                       &entry->offset, iterpool));
+              switch (entry->type)
+                {
+                  case SVN_FS_FS__ITEM_TYPE_FILE_REP:
+                  case SVN_FS_FS__ITEM_TYPE_DIR_REP:
+                  case SVN_FS_FS__ITEM_TYPE_FILE_PROPS:
+                  case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:
+                    SVN_ERR(block_read_contents(fs, stream, entry, pool));
+                    break;
+
+                  case SVN_FS_FS__ITEM_TYPE_NODEREV:
+                    if (ffd->node_revision_cache || is_result)
+                      SVN_ERR(block_read_noderev((node_revision_t **)&item,
+                                                 fs, revision_file, stream,
+                                                 entry, &key, is_result,
+                                                 pool));
+                    break;
+
+                  case SVN_FS_FS__ITEM_TYPE_CHANGES:
+                    SVN_ERR(block_read_changes((apr_array_header_t **)&item,
+                                               fs, revision_file, stream,
+                                               entry, is_result, pool));
+                    break;
+
+                  default:
+                    break;
+                }
+
+              if (is_result)
+                *result = item;
+
+              /* if we crossed a block boundary, read the remainder of
+               * the last block as well */
+              offset = entry->offset + entry->size;
+              if (offset > block_start + ffd->block_size)
+                ++run_count;
+
+              svn_pool_clear(iterpool);
+            }
+        }
+    }
+  while(run_count++ == 1); /* can only be true once and only if a block
+                            * boundary got crossed */
+
+  /* if the caller requested a result, we must have provided one by now */
+  assert(!result || *result);
+  SVN_ERR(svn_stream_close(stream));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
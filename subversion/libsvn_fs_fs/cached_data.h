@@ -88,6 +88,24 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* Attempt to locate the text representation REP as seen in filesystem FS
+   as an uncompressed byte range in an on-disk file.  That is the case for
+   PLAIN reps in the revision or pack file and reps that have a fulltext
+   checkpoint whose contents have been verified against REP's MD5 checksum
+   when it was written.  If successful, set *FILE to that file, opened
+   unbuffered and with APR_SENDFILE_ENABLED, as well as *OFFSET and *LENGTH
+   to the byte range in it.  Otherwise, set *FILE to NULL.
+   Allocate *FILE in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__get_fulltext_location(apr_file_t **file,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
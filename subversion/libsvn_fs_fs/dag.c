@@ -981,6 +981,31 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_file_fulltext_location(apr_file_t **file_p,
+                                      apr_off_t *offset,
+                                      svn_filesize_t *length,
+                                      dag_node_t *file,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (file->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get fulltext location of a *non*-file node");
+
+  /* Go get a fresh node-revision for FILE. */
+  SVN_ERR(get_node_revision(&noderev, file));
+
+  return svn_fs_fs__get_fulltext_location(file_p, offset, length, file->fs,
+                                          noderev->data_rep,
+                                          result_pool, scratch_pool);
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_file_length(svn_filesize_t *length,
                            dag_node_t *file,
@@ -420,6 +420,20 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          void* baton,
                                          apr_pool_t *pool);
 
+/* Attempt to locate the contents of FILE as an uncompressed byte range
+   in an on-disk file.  See svn_fs_fs__get_fulltext_location() for the
+   meaning of *FILE_P, *OFFSET and *LENGTH.
+
+   Allocate *FILE_P in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__dag_file_fulltext_location(apr_file_t **file_p,
+                                      apr_off_t *offset,
+                                      svn_filesize_t *length,
+                                      dag_node_t *file,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
 
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
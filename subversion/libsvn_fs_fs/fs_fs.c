@@ -34,6 +34,7 @@
 
 #include "cached_data.h"
 #include "id.h"
+#include "index.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "transaction.h"
@@ -209,6 +210,25 @@ svn_fs_fs__with_write_lock(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__with_pack_lock(svn_fs_t *fs,
+                          svn_error_t *(*body)(void *baton,
+                                               apr_pool_t *pool),
+                          void *baton,
+                          apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+
+  SVN_MUTEX__WITH_LOCK(ffsd->fs_pack_lock,
+                       with_some_lock_file(fs, body, baton,
+                               svn_fs_fs__path_pack_lock(fs, pool),
+                               FALSE,
+                               pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Run BODY (with BATON and POOL) while the txn-current file
    of FS is locked. */
 svn_error_t *
@@ -276,11 +296,16 @@ check_format(int format)
 
    *MAX_FILES_PER_DIR is obtained from the 'layout' format option, and
    will be set to zero if a linear scheme should be used.
+   *USE_LOG_ADDRESSING is obtained from the 'addressing' format option,
+   and will be set to FALSE for physical addressing.
 
    Use POOL for temporary allocation. */
 static svn_error_t *
-read_format(int *pformat, int *max_files_per_dir,
-            const char *path, apr_pool_t *pool)
+read_format(int *pformat,
+            int *max_files_per_dir,
+            svn_boolean_t *use_log_addressing,
+            const char *path,
+            apr_pool_t *pool)
 {
   svn_error_t *err;
   svn_stream_t *stream;
@@ -301,6 +326,7 @@ read_format(int *pformat, int *max_files_per_dir,
       svn_error_clear(err);
       *pformat = 1;
       *max_files_per_dir = 0;
+      *use_log_addressing = FALSE;
 
       return SVN_NO_ERROR;
     }
@@ -325,6 +351,7 @@ read_format(int *pformat, int *max_files_per_dir,
 
   /* Set the default values for anything that can be set via an option. */
   *max_files_per_dir = 0;
+  *use_log_addressing = FALSE;
 
   /* Read any options. */
   while (!eos)
@@ -351,6 +378,22 @@ read_format(int *pformat, int *max_files_per_dir,
             }
         }
 
+      if (*pformat >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT &&
+          strncmp(buf->data, "addressing ", 11) == 0)
+        {
+          if (strcmp(buf->data + 11, "physical") == 0)
+            {
+              *use_log_addressing = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 11, "logical") == 0)
+            {
+              *use_log_addressing = TRUE;
+              continue;
+            }
+        }
+
       return svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
          _("'%s' contains invalid filesystem format option '%s'"),
          svn_dirent_local_style(path, pool), buf->data);
@@ -359,9 +402,9 @@ read_format(int *pformat, int *max_files_per_dir,
   return SVN_NO_ERROR;
 }
 
-/* Write the format number and maximum number of files per directory
-   to a new format file in PATH, possibly expecting to overwrite a
-   previously existing file.
+/* Write the format number, maximum number of files per directory and
+   the addressing scheme to a new format file in PATH, possibly expecting
+   to overwrite a previously existing file.
 
    Use POOL for temporary allocation. */
 svn_error_t *
@@ -387,6 +430,14 @@ svn_fs_fs__write_format(svn_fs_t *fs,
         svn_stringbuf_appendcstr(sb, "layout linear\n");
     }
 
+  if (ffd->format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
+    {
+      if (ffd->use_log_addressing)
+        svn_stringbuf_appendcstr(sb, "addressing logical\n");
+      else
+        svn_stringbuf_appendcstr(sb, "addressing physical\n");
+    }
+
   /* svn_io_write_version_file() does a load of magic to allow it to
      replace version files that already exist.  We only need to do
      that when we're allowed to overwrite an existing file. */
@@ -432,6 +483,14 @@ read_config(fs_fs_data_t *ffd,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  /* Initialize the fulltext checkpoint limit.  The option is in MB. */
+  SVN_ERR(svn_config_get_int64(ffd->config, &ffd->checkpoints_size,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_CHECKPOINTS_SIZE, 0));
+  if (ffd->checkpoints_size < 0)
+    ffd->checkpoints_size = 0;
+  ffd->checkpoints_size *= 0x100000;
+
   /* Initialize deltification settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -460,6 +519,29 @@ read_config(fs_fs_data_t *ffd,
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
     }
 
+  /* Select the svndiff version for new deltas. */
+  if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT)
+    {
+      const char *compression;
+      svn_config_get(ffd->config, &compression,
+                     CONFIG_SECTION_DELTIFICATION,
+                     CONFIG_OPTION_DELTA_COMPRESSION, "zlib");
+
+      if (svn_cstring_casecmp(compression, "zlib") == 0)
+        ffd->delta_svndiff_version = 1;
+      else if (svn_cstring_casecmp(compression, "lz4") == 0)
+        ffd->delta_svndiff_version = 2;
+      else
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("Invalid value '%s' for option '%s'"),
+                                 compression,
+                                 CONFIG_OPTION_DELTA_COMPRESSION);
+    }
+  else if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT)
+    ffd->delta_svndiff_version = 1;
+  else
+    ffd->delta_svndiff_version = 0;
+
   /* Initialize revprop packing settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
     {
@@ -482,6 +564,33 @@ read_config(fs_fs_data_t *ffd,
       ffd->compress_packed_revprops = FALSE;
     }
 
+  /* Initialize index and block I/O settings in ffd. */
+  if (ffd->format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
+    {
+      SVN_ERR(svn_config_get_int64(ffd->config, &ffd->block_size,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_BLOCK_SIZE,
+                                   64));
+      SVN_ERR(svn_config_get_int64(ffd->config, &ffd->l2p_page_size,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_L2P_PAGE_SIZE,
+                                   0x2000));
+      SVN_ERR(svn_config_get_int64(ffd->config, &ffd->p2l_page_size,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_P2L_PAGE_SIZE,
+                                   0x400));
+
+      ffd->block_size *= 0x400;
+      ffd->p2l_page_size *= 0x400;
+    }
+  else
+    {
+      /* should be irrelevant but we initialize them anyway */
+      ffd->block_size = 0x1000;
+      ffd->l2p_page_size = 0x2000;
+      ffd->p2l_page_size = 0x100000;
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -514,6 +623,17 @@ write_config(svn_fs_t *fs,
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"###"                                                                        NL
+"### Reading a file that is stored as a long chain of deltas requires all"   NL
+"### of these deltas to be read and combined.  FSFS can keep fulltext"       NL
+"### copies of such files in the '" PATH_CHECKPOINTS_DIR "' folder of the"   NL
+"### repository, so that later reads of them, or of newer versions"          NL
+"### deltified against them, only need to apply a single delta."            NL
+"### This parameter limits the total size of all checkpoints in MB."         NL
+"### Once the limit is reached, the least recently used ones get removed."   NL
+"### The folder may be deleted at any time.  The default is 0, i.e."         NL
+"### no checkpoints are kept."                                               NL
+"# " CONFIG_OPTION_CHECKPOINTS_SIZE " = 0"                                   NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -591,6 +711,14 @@ write_config(svn_fs_t *fs,
 "### exclusive use of skip-deltas (as in pre-1.8)."                          NL
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
+"###"                                                                        NL
+"### In format 7+ repositories, deltas may be compressed either with zlib"   NL
+"### (svndiff1) or with the much faster, LZ4-style svndiff2 format.  The"    NL
+"### latter typically needs 10-20% more disk space but makes reading and"    NL
+"### reconstructing file contents several times faster.  Only new deltas"    NL
+"### are affected; existing data remains readable in either case."          NL
+"### Possible values are 'zlib' and 'lz4'.  The default is 'zlib'."          NL
+"# " CONFIG_OPTION_DELTA_COMPRESSION " = zlib"                               NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -616,6 +744,34 @@ write_config(svn_fs_t *fs,
 "### unless you often modify revprops after packing."                        NL
 "### Compressing packed revprops is disabled by default."                    NL
 "# " CONFIG_OPTION_COMPRESS_PACKED_REVPROPS " = false"                       NL
+""                                                                           NL
+"[" CONFIG_SECTION_IO "]"                                                    NL
+"### Parameters in this section control the data access granularity in"     NL
+"### format 7+ repositories using logical addressing and the indexes that"   NL
+"### map item locations.  They have no effect on physically addressed rev"   NL
+"### files."                                                                 NL
+"###"                                                                        NL
+"### Block size is the maximum amount of data read in one go from a rev"    NL
+"### or pack file and the unit in which neighbouring items get prefetched"   NL
+"### into the caches.  Values must be a power of two.  Very small values"    NL
+"### increase the number of I/O requests while very large ones waste I/O"    NL
+"### bandwidth if little of the data is needed.  Default is 64 kBytes."     NL
+"# " CONFIG_OPTION_BLOCK_SIZE " = 64"                                        NL
+"###"                                                                        NL
+"### The log-to-phys index maps data item numbers to offsets within the"     NL
+"### rev or pack file.  This index is organized in pages of a fixed maximum" NL
+"### capacity.  To access an item, the page table and the respective page"   NL
+"### must be read.  This parameter only affects revisions with thousands"    NL
+"### of changed paths.  The default is 8192 entries per page."               NL
+"# " CONFIG_OPTION_L2P_PAGE_SIZE " = 8192"                                   NL
+"###"                                                                        NL
+"### The phys-to-log index maps positions within the rev or pack file to"    NL
+"### the data items, i.e. describes what piece of information is being"      NL
+"### stored at any particular offset.  The index describes the rev file"     NL
+"### in chunks (pages) and keeps a global list of all those pages.  Large"   NL
+"### pages mean a shorter page table but a larger per-page description of"   NL
+"### data items in it.  Default is 64 kBytes."                               NL
+"# " CONFIG_OPTION_P2L_PAGE_SIZE " = 64"                                     NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG, pool),
@@ -628,18 +784,20 @@ svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_file_t *uuid_file;
   int format, max_files_per_dir;
+  svn_boolean_t use_log_addressing;
   char buf[APR_UUID_FORMATTED_LENGTH + 2];
   apr_size_t limit;
 
   fs->path = apr_pstrdup(fs->pool, path);
 
   /* Read the FS format number. */
-  SVN_ERR(read_format(&format, &max_files_per_dir,
+  SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
                       path_format(fs, pool), pool));
 
   /* Now we've got a format number no matter what. */
   ffd->format = format;
   ffd->max_files_per_dir = max_files_per_dir;
+  ffd->use_log_addressing = use_log_addressing;
 
   /* Read in and cache the repository uuid. */
   SVN_ERR(svn_io_file_open(&uuid_file, path_uuid(fs, pool),
@@ -694,12 +852,14 @@ upgrade_body(void *baton, apr_pool_t *pool)
   svn_fs_t *fs = upgrade_baton->fs;
   fs_fs_data_t *ffd = fs->fsap_data;
   int format, max_files_per_dir;
+  svn_boolean_t use_log_addressing;
   const char *format_path = path_format(fs, pool);
   svn_node_kind_t kind;
   svn_boolean_t needs_revprop_shard_cleanup = FALSE;
 
   /* Read the FS format number and max-files-per-dir setting. */
-  SVN_ERR(read_format(&format, &max_files_per_dir, format_path, pool));
+  SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
+                      format_path, pool));
 
   /* If the config file does not exist, create one. */
   SVN_ERR(svn_io_check_path(svn_dirent_join(fs->path, PATH_CONFIG, pool),
@@ -767,9 +927,11 @@ upgrade_body(void *baton, apr_pool_t *pool)
                                                pool));
     }
 
-  /* Bump the format file. */
+  /* Bump the format file.  Existing revisions have been written using
+     physical addressing, so keep using that. */
   ffd->format = SVN_FS_FS__FORMAT_NUMBER;
   ffd->max_files_per_dir = max_files_per_dir;
+  ffd->use_log_addressing = use_log_addressing;
   SVN_ERR(svn_fs_fs__write_format(fs, TRUE, pool));
   if (upgrade_baton->notify_func)
     SVN_ERR(upgrade_baton->notify_func(upgrade_baton->notify_baton,
@@ -948,6 +1110,77 @@ svn_fs_fs__rep_copy(representation_t *rep,
 }
 
 
+/* Write the log-to-phys and phys-to-log index files for the logically
+   addressed revision 0 of filesystem FS.  Use POOL for allocations. */
+static svn_error_t *
+write_revision_zero_indexes(svn_fs_t *fs,
+                            apr_pool_t *pool)
+{
+  const char *l2p_proto_path
+    = apr_pstrcat(pool, svn_fs_fs__path_l2p_index(fs, 0, pool), ".tmp",
+                  SVN_VA_NULL);
+  const char *p2l_proto_path
+    = apr_pstrcat(pool, svn_fs_fs__path_p2l_index(fs, 0, pool), ".tmp",
+                  SVN_VA_NULL);
+  apr_file_t *proto_index;
+  svn_fs_fs__p2l_entry_t entry;
+
+  /* Map the three items of revision 0 to their rev file offsets. */
+  SVN_ERR(svn_fs_fs__l2p_proto_index_open(&proto_index, l2p_proto_path,
+                                          pool));
+  SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry(proto_index, 0,
+                                          SVN_FS_FS__ITEM_INDEX_FIRST_USER,
+                                          pool));
+  SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry(proto_index, 17,
+                                          SVN_FS_FS__ITEM_INDEX_ROOT_NODE,
+                                          pool));
+  SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry(proto_index, 106,
+                                          SVN_FS_FS__ITEM_INDEX_CHANGES,
+                                          pool));
+  SVN_ERR(svn_io_file_close(proto_index, pool));
+
+  /* Describe the same rev file sections in the reverse direction. */
+  SVN_ERR(svn_fs_fs__p2l_proto_index_open(&proto_index, p2l_proto_path,
+                                          pool));
+
+  entry.offset = 0;
+  entry.size = 17;
+  entry.type = SVN_FS_FS__ITEM_TYPE_DIR_REP;
+  entry.item.revision = 0;
+  entry.item.number = SVN_FS_FS__ITEM_INDEX_FIRST_USER;
+  SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(proto_index, &entry, pool));
+
+  entry.offset = 17;
+  entry.size = 89;
+  entry.type = SVN_FS_FS__ITEM_TYPE_NODEREV;
+  entry.item.number = SVN_FS_FS__ITEM_INDEX_ROOT_NODE;
+  SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(proto_index, &entry, pool));
+
+  entry.offset = 106;
+  entry.size = 1;
+  entry.type = SVN_FS_FS__ITEM_TYPE_CHANGES;
+  entry.item.number = SVN_FS_FS__ITEM_INDEX_CHANGES;
+  SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(proto_index, &entry, pool));
+  SVN_ERR(svn_io_file_close(proto_index, pool));
+
+  /* Create the final index files and get rid of the proto indexes. */
+  SVN_ERR(svn_fs_fs__l2p_index_create(fs,
+                                      svn_fs_fs__path_l2p_index(fs, 0, pool),
+                                      l2p_proto_path, 0, pool));
+  SVN_ERR(svn_fs_fs__p2l_index_create(fs,
+                                      svn_fs_fs__path_p2l_index(fs, 0, pool),
+                                      p2l_proto_path, 0, pool));
+  SVN_ERR(svn_io_remove_file2(l2p_proto_path, FALSE, pool));
+  SVN_ERR(svn_io_remove_file2(p2l_proto_path, FALSE, pool));
+
+  SVN_ERR(svn_io_set_file_read_only(svn_fs_fs__path_l2p_index(fs, 0, pool),
+                                    FALSE, pool));
+  SVN_ERR(svn_io_set_file_read_only(svn_fs_fs__path_p2l_index(fs, 0, pool),
+                                    FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Write out the zeroth revision for filesystem FS. */
 static svn_error_t *
 write_revision_zero(svn_fs_t *fs)
@@ -957,15 +1190,32 @@ write_revision_zero(svn_fs_t *fs)
   svn_string_t date;
 
   /* Write out a rev file for revision 0. */
-  SVN_ERR(svn_io_file_create(path_revision_zero,
-                             "PLAIN\nEND\nENDREP\n"
-                             "id: 0.0.r0/17\n"
-                             "type: dir\n"
-                             "count: 0\n"
-                             "text: 0 0 4 4 "
-                             "2d2977d1c96f487abe4a1e202dd03b4e\n"
-                             "cpath: /\n"
-                             "\n\n17 107\n", fs->pool));
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      /* Items are being addressed by item index.  Item 3 is the empty
+         directory rep (0..16), item 2 the root noderev (17..105) and
+         item 1 the empty changed paths list (106).  There is no trailer. */
+      SVN_ERR(svn_io_file_create(path_revision_zero,
+                                 "PLAIN\nEND\nENDREP\n"
+                                 "id: 0.0.r0/2\n"
+                                 "type: dir\n"
+                                 "count: 0\n"
+                                 "text: 0 3 4 4 "
+                                 "2d2977d1c96f487abe4a1e202dd03b4e\n"
+                                 "cpath: /\n"
+                                 "\n\n", fs->pool));
+      SVN_ERR(write_revision_zero_indexes(fs, fs->pool));
+    }
+  else
+    SVN_ERR(svn_io_file_create(path_revision_zero,
+                               "PLAIN\nEND\nENDREP\n"
+                               "id: 0.0.r0/17\n"
+                               "type: dir\n"
+                               "count: 0\n"
+                               "text: 0 0 4 4 "
+                               "2d2977d1c96f487abe4a1e202dd03b4e\n"
+                               "cpath: /\n"
+                               "\n\n17 107\n", fs->pool));
   SVN_ERR(svn_io_set_file_read_only(path_revision_zero, FALSE, fs->pool));
 
   /* Set a date on revision 0. */
@@ -988,6 +1238,13 @@ svn_fs_fs__create(svn_fs_t *fs,
   /* See if compatibility with older versions was explicitly requested. */
   if (fs->config)
     {
+      svn_version_t *compatible_version = NULL;
+      const char *compatible;
+      compatible = svn_hash_gets(fs->config, SVN_FS_CONFIG_COMPATIBLE_VERSION);
+      if (compatible)
+        SVN_ERR(svn_version__parse_version_string(&compatible_version,
+                                                  compatible, pool));
+
       if (svn_hash_gets(fs->config, SVN_FS_CONFIG_PRE_1_4_COMPATIBLE))
         format = 1;
       else if (svn_hash_gets(fs->config, SVN_FS_CONFIG_PRE_1_5_COMPATIBLE))
@@ -996,6 +1253,9 @@ svn_fs_fs__create(svn_fs_t *fs,
         format = 3;
       else if (svn_hash_gets(fs->config, SVN_FS_CONFIG_PRE_1_8_COMPATIBLE))
         format = 4;
+      else if (compatible && compatible_version->major == SVN_VER_MAJOR
+               && compatible_version->minor <= 8)
+        format = 6;
     }
   ffd->format = format;
 
@@ -1003,6 +1263,10 @@ svn_fs_fs__create(svn_fs_t *fs,
   if (format >= SVN_FS_FS__MIN_LAYOUT_FORMAT_OPTION_FORMAT)
     ffd->max_files_per_dir = SVN_FS_FS_DEFAULT_MAX_FILES_PER_DIR;
 
+  /* Use logical addressing if supported. */
+  if (format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
+    ffd->use_log_addressing = TRUE;
+
   /* Create the revision data directories. */
   if (ffd->max_files_per_dir)
     SVN_ERR(svn_io_make_dir_recursively(svn_fs_fs__path_rev_shard(fs, 0,
@@ -1043,12 +1307,14 @@ svn_fs_fs__create(svn_fs_t *fs,
   SVN_ERR(svn_io_file_create_empty(path_lock(fs, pool), pool));
   SVN_ERR(svn_fs_fs__set_uuid(fs, NULL, pool));
 
-  SVN_ERR(write_revision_zero(fs));
-
+  /* The index parameters used to write revision 0 are read from the
+     configuration. */
   SVN_ERR(write_config(fs, pool));
 
   SVN_ERR(read_config(ffd, fs->path, pool));
 
+  SVN_ERR(write_revision_zero(fs));
+
   /* Create the min unpacked rev file. */
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     SVN_ERR(svn_io_file_create(svn_fs_fs__path_min_unpacked_rev(fs, pool),
@@ -1379,8 +1645,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 6:
       (*supports_version)->minor = 8;
       break;
+    case 7:
+      (*supports_version)->minor = 9;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 6
+# if SVN_FS_FS__FORMAT_NUMBER != 7
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -34,6 +34,15 @@ svn_error_t *svn_fs_fs__open(svn_fs_t *fs,
                              const char *path,
                              apr_pool_t *pool);
 
+/* Open another filesystem object for the repository that FS has been
+   opened for and return it in *CLONE_P.  The clone uses the same
+   configuration and shares the process-global data (lock mutexes etc.)
+   with FS but has its own cache instances and per-object state.  Hence, it
+   may be used in a different thread than FS.  Allocate it in POOL. */
+svn_error_t *svn_fs_fs__open_clone(svn_fs_t **clone_p,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *pool);
+
 /* Upgrade the fsfs filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
@@ -127,6 +136,17 @@ svn_fs_fs__with_write_lock(svn_fs_t *fs,
                            void *baton,
                            apr_pool_t *pool);
 
+/* Obtain the pack lock on the filesystem FS in a subpool of POOL, call
+   BODY with BATON and that subpool, destroy the subpool (releasing the
+   pack lock) and return what BODY returned.  The pack lock serializes
+   pack operations only; it does not block commits or readers. */
+svn_error_t *
+svn_fs_fs__with_pack_lock(svn_fs_t *fs,
+                          svn_error_t *(*body)(void *baton,
+                                               apr_pool_t *pool),
+                          void *baton,
+                          apr_pool_t *pool);
+
 /* Run BODY (with BATON and POOL) while the txn-current file
    of FS is locked. */
 svn_error_t *
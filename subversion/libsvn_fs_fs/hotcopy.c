@@ -228,12 +228,14 @@ hotcopy_io_copy_dir_recursively(const char *src,
 
 /* Copy an un-packed revision or revprop file for revision REV from SRC_SUBDIR
  * to DST_SUBDIR. Assume a sharding layout based on MAX_FILES_PER_DIR.
+ * If INCLUDE_INDEXES is set, copy the revision's index files as well.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_shard_file(const char *src_subdir,
                         const char *dst_subdir,
                         svn_revnum_t rev,
                         int max_files_per_dir,
+                        svn_boolean_t include_indexes,
                         apr_pool_t *scratch_pool)
 {
   const char *src_subdir_shard = src_subdir,
@@ -257,6 +259,20 @@ hotcopy_copy_shard_file(const char *src_subdir,
   SVN_ERR(hotcopy_io_dir_file_copy(src_subdir_shard, dst_subdir_shard,
                                    apr_psprintf(scratch_pool, "%ld", rev),
                                    scratch_pool));
+  if (include_indexes)
+    {
+      SVN_ERR(hotcopy_io_dir_file_copy(src_subdir_shard, dst_subdir_shard,
+                                       apr_psprintf(scratch_pool,
+                                                    "%ld" PATH_EXT_L2P_INDEX,
+                                                    rev),
+                                       scratch_pool));
+      SVN_ERR(hotcopy_io_dir_file_copy(src_subdir_shard, dst_subdir_shard,
+                                       apr_psprintf(scratch_pool,
+                                                    "%ld" PATH_EXT_P2L_INDEX,
+                                                    rev),
+                                       scratch_pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -312,7 +328,7 @@ hotcopy_copy_packed_shard(svn_revnum_t *dst_min_unpacked_rev,
 
           SVN_ERR(hotcopy_copy_shard_file(src_subdir, dst_subdir,
                                           revprop_rev, max_files_per_dir,
-                                          iterpool));
+                                          FALSE, iterpool));
         }
       svn_pool_destroy(iterpool);
     }
@@ -321,7 +337,7 @@ hotcopy_copy_packed_shard(svn_revnum_t *dst_min_unpacked_rev,
       /* revprop for revision 0 will never be packed */
       if (rev == 0)
         SVN_ERR(hotcopy_copy_shard_file(src_subdir, dst_subdir,
-                                        0, max_files_per_dir,
+                                        0, max_files_per_dir, FALSE,
                                         scratch_pool));
 
       /* packed revprops folder */
@@ -382,7 +398,8 @@ hotcopy_update_current(svn_revnum_t *dst_youngest,
 
 /* Remove revision or revprop files between START_REV (inclusive) and
  * END_REV (non-inclusive) from folder DST_SUBDIR in DST_FS.  Assume
- * sharding as per MAX_FILES_PER_DIR.
+ * sharding as per MAX_FILES_PER_DIR.  If INCLUDE_INDEXES is set, remove
+ * the revisions' index files as well.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_remove_files(svn_fs_t *dst_fs,
@@ -390,6 +407,7 @@ hotcopy_remove_files(svn_fs_t *dst_fs,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      int max_files_per_dir,
+                     svn_boolean_t include_indexes,
                      apr_pool_t *scratch_pool)
 {
   const char *shard;
@@ -422,6 +440,22 @@ hotcopy_remove_files(svn_fs_t *dst_fs,
       /* Make the rev file writable and remove it. */
       SVN_ERR(svn_io_set_file_read_write(path, TRUE, iterpool));
       SVN_ERR(svn_io_remove_file2(path, TRUE, iterpool));
+
+      /* Same for the index files. */
+      if (include_indexes)
+        {
+          const char *index_path;
+
+          index_path = apr_pstrcat(iterpool, path, PATH_EXT_L2P_INDEX,
+                                   SVN_VA_NULL);
+          SVN_ERR(svn_io_set_file_read_write(index_path, TRUE, iterpool));
+          SVN_ERR(svn_io_remove_file2(index_path, TRUE, iterpool));
+
+          index_path = apr_pstrcat(iterpool, path, PATH_EXT_P2L_INDEX,
+                                   SVN_VA_NULL);
+          SVN_ERR(svn_io_set_file_read_write(index_path, TRUE, iterpool));
+          SVN_ERR(svn_io_remove_file2(index_path, TRUE, iterpool));
+        }
     }
 
   svn_pool_destroy(iterpool);
@@ -444,8 +478,9 @@ hotcopy_remove_rev_files(svn_fs_t *dst_fs,
                                svn_dirent_join(dst_fs->path,
                                                PATH_REVS_DIR,
                                                scratch_pool),
-                               start_rev, end_rev,
-                               max_files_per_dir, scratch_pool));
+                               start_rev, end_rev, max_files_per_dir,
+                               svn_fs_fs__use_log_addressing(dst_fs),
+                               scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -469,7 +504,7 @@ hotcopy_remove_revprop_files(svn_fs_t *dst_fs,
                                                PATH_REVPROPS_DIR,
                                                scratch_pool),
                                start_rev ? start_rev : 1, end_rev,
-                               max_files_per_dir, scratch_pool));
+                               max_files_per_dir, FALSE, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -507,6 +542,13 @@ hotcopy_incremental_check_preconditions(svn_fs_t *src_fs,
                               "of the hotcopy source does not match "
                               "the sharding layout configuration of "
                               "the hotcopy destination"));
+
+  /* ... and the same addressing mode. */
+  if (src_ffd->use_log_addressing != dst_ffd->use_log_addressing)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The addressing mode of the hotcopy source "
+                              "does not match the addressing mode of the "
+                              "hotcopy destination"));
   return SVN_NO_ERROR;
 }
 
@@ -772,6 +814,7 @@ hotcopy_body(void *baton, apr_pool_t *pool)
       /* Copy the rev file. */
       err = hotcopy_copy_shard_file(src_subdir, dst_subdir,
                                     rev, max_files_per_dir,
+                                    svn_fs_fs__use_log_addressing(src_fs),
                                     iterpool);
       if (err)
         {
@@ -822,7 +865,7 @@ hotcopy_body(void *baton, apr_pool_t *pool)
       /* Copy the revprop file. */
       SVN_ERR(hotcopy_copy_shard_file(revprop_src_subdir,
                                       revprop_dst_subdir,
-                                      rev, max_files_per_dir,
+                                      rev, max_files_per_dir, FALSE,
                                       iterpool));
 
       /* After completing a full shard, update 'current'. */
@@ -914,12 +957,25 @@ hotcopy_setup_shared_fs_data(svn_fs_t *src_fs, svn_fs_t *dst_fs)
   fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
 
   /* The common pool and mutexes are shared between src and dst filesystems.
-   * During hotcopy we only grab the mutexes for the destination, so there
+   * During hotcopy we only grab the pack mutex for the source and the write
+   * mutex for the destination, in the same order as pack does.  So, there
    * is no risk of dead-lock. We don't write to the src filesystem. Shared
    * data for the src_fs has already been initialised in fs_hotcopy(). */
   dst_ffd->shared = src_ffd->shared;
 }
 
+/* Run hotcopy_body with the write lock on the destination held.
+ * This implements the svn_fs_fs__with_pack_lock() 'body' callback type for
+ * the source filesystem.  BATON is a 'struct hotcopy_body_baton *'.
+ */
+static svn_error_t *
+hotcopy_locked_body(void *baton, apr_pool_t *pool)
+{
+  struct hotcopy_body_baton *hbb = baton;
+
+  return svn_fs_fs__with_write_lock(hbb->dst_fs, hotcopy_body, hbb, pool);
+}
+
 /* Create an empty filesystem at DST_FS at DST_PATH with the same
  * configuration as SRC_FS (uuid, format, and other parameters).
  * After creation DST_FS has no revisions, not even revision zero. */
@@ -935,6 +991,10 @@ hotcopy_create_empty_dest(svn_fs_t *src_fs,
   dst_fs->path = apr_pstrdup(pool, dst_path);
 
   dst_ffd->max_files_per_dir = src_ffd->max_files_per_dir;
+  dst_ffd->use_log_addressing = src_ffd->use_log_addressing;
+  dst_ffd->block_size = src_ffd->block_size;
+  dst_ffd->l2p_page_size = src_ffd->l2p_page_size;
+  dst_ffd->p2l_page_size = src_ffd->p2l_page_size;
   dst_ffd->config = src_ffd->config;
   dst_ffd->format = src_ffd->format;
 
@@ -1016,11 +1076,13 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
                    apr_pool_t *pool)
 {
   struct hotcopy_body_baton hbb;
+  fs_fs_data_t *src_ffd;
 
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
   SVN_ERR(svn_fs_fs__open(src_fs, src_path, pool));
+  src_ffd = src_fs->fsap_data;
 
   if (incremental)
     {
@@ -1062,7 +1124,14 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
   hbb.incremental = incremental;
   hbb.cancel_func = cancel_func;
   hbb.cancel_baton = cancel_baton;
-  SVN_ERR(svn_fs_fs__with_write_lock(dst_fs, hotcopy_body, &hbb, pool));
+
+  /* Keep pack from building and removing shards in the source while we
+   * copy them.  Take the locks in the same order as pack does. */
+  if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(svn_fs_fs__with_pack_lock(src_fs, hotcopy_locked_body, &hbb,
+                                      pool));
+  else
+    SVN_ERR(svn_fs_fs__with_write_lock(dst_fs, hotcopy_body, &hbb, pool));
 
   return SVN_NO_ERROR;
 }
@@ -21,9 +21,14 @@
  */
 #include <assert.h>
 
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -32,6 +37,7 @@
 #include "pack.h"
 #include "util.h"
 #include "id.h"
+#include "index.h"
 #include "low_level.h"
 #include "revprops.h"
 #include "transaction.h"
@@ -41,6 +47,11 @@
 #include "svn_private_config.h"
 #include "temp_serializer.h"
 
+/* Try to limit the temporary memory used while packing a single shard to
+ * this many bytes.  Concurrent pack operations use that much per thread.
+ */
+#define PACK_MAX_MEM (64 * 1024 * 1024)
+
 /* Directories entries sorted by revision (decreasing - to max cache hits)
  * and offset (increasing - to max benefit from APR file buffering).
  */
@@ -67,13 +78,31 @@ compare_dir_entries_format6(const svn_sort__item_t *a,
   return 0;
 }
 
+/* Directories entries sorted by name in reverse lexicographic order.
+ * This matches the path order in which format 7 pack files store the
+ * node revisions (see compare_path_order).
+ */
+static int
+compare_dir_entries_format7(const svn_sort__item_t *a,
+                            const svn_sort__item_t *b)
+{
+  const svn_fs_dirent_t *lhs = (const svn_fs_dirent_t *) a->value;
+  const svn_fs_dirent_t *rhs = (const svn_fs_dirent_t *) b->value;
+
+  return strcmp(rhs->name, lhs->name);
+}
+
 apr_array_header_t *
 svn_fs_fs__order_dir_entries(svn_fs_t *fs,
                              apr_hash_t *directory,
                              apr_pool_t *pool)
 {
   apr_array_header_t *ordered
-    = svn_sort__hash(directory, compare_dir_entries_format6, pool);
+    = svn_sort__hash(directory,
+                     svn_fs_fs__use_log_addressing(fs)
+                       ? compare_dir_entries_format7
+                       : compare_dir_entries_format6,
+                     pool);
 
   apr_array_header_t *result
     = apr_array_make(pool, ordered->nelts, sizeof(svn_fs_dirent_t *));
@@ -226,240 +255,1617 @@ pack_phys_addressed(const char *pack_file_dir,
   return SVN_NO_ERROR;
 }
 
-/* In filesystem FS, pack the revision SHARD containing exactly
- * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
- * using POOL for allocations.  Try to limit the amount of temporary
- * memory needed to MAX_MEM bytes.  CANCEL_FUNC and CANCEL_BATON are what
- * you think they are.
+/* Format 7 packing logic:
  *
- * If for some reason we detect a partial packing already performed, we
- * remove the pack file and start again.
+ * We pack files on a pack file basis (e.g. 1000 revs) without changing
+ * existing pack files nor the revision files outside the range to pack.
  *
- * The actual packing will be done in a format-specific sub-function.
+ * First, we will scan the revision file indexes to determine the number
+ * of items to "place" (i.e. determine their optimal position within the
+ * future pack file).  For each item, we will need a constant amount of
+ * memory to track it.  A MAX_MEM parameter sets a limit to the number of
+ * items we may place in one go.  That means, we may not be able to add
+ * all revisions at once.  Instead, we will run the placement for a subset
+ * of revisions at a time.  The very unlikely worst case will simply append
+ * all revision data with just a little reshuffling inside each revision.
+ *
+ * In a second step, we read all revisions in the selected range, build
+ * the item tracking information and copy the items themselves from the
+ * revision files to temporary files.  The latter serve as buckets for a
+ * very coarse bucket presort:  Separate change lists, file properties,
+ * directory properties and noderevs + representations from one another.
+ *
+ * The third step will determine an optimized placement for the items in
+ * each of the 4 buckets separately.  The first three will simply order
+ * their items by revision, starting with the newest once.  Placing rep
+ * and noderev items is a more elaborate process documented in the code.
+ *
+ * Step 4 copies the items from the temporary buckets into the final
+ * pack file and writes the temporary index files.
+ *
+ * Finally, after the last range of revisions, create the final indexes.
+ *
+ * Since all references between items use (revision, item index) pairs,
+ * no item needs to be modified when moving it to its new location.
  */
-static svn_error_t *
-pack_rev_shard(svn_fs_t *fs,
-               const char *pack_file_dir,
-               const char *shard_path,
-               apr_int64_t shard,
-               int max_files_per_dir,
-               apr_size_t max_mem,
-               svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *pool)
+
+/* Data structure describing a node change at PATH, REVISION.
+ * We will sort these instances by PATH and NODE_ID such that we can
+ * place all items belonging to the same path next to each other.
+ */
+typedef struct path_order_t
+{
+  /* changed path */
+  svn_prefix_string__t *path;
+
+  /* node ID for this PATH in REVISION */
+  svn_fs_fs__id_part_t node_id;
+
+  /* when this change happened */
+  svn_revnum_t revision;
+
+  /* item ID of the noderev linked to the change. May be (0, 0). */
+  svn_fs_fs__id_part_t noderev_id;
+
+  /* item ID of the representation containing the new data. May be (0, 0). */
+  svn_fs_fs__id_part_t rep_id;
+} path_order_t;
+
+/* Represents a reference from representation FROM to its delta base TO.
+ * We will sort them by FROM which allows us to follow delta chains.
+ */
+typedef struct reference_t
 {
+  svn_fs_fs__id_part_t from;
+  svn_fs_fs__id_part_t to;
+} reference_t;
+
+/* This structure keeps track of all the temporary data and status that
+ * needs to be kept around during the creation of one pack file.  After
+ * each revision range (in case we can't process all revs at once due to
+ * memory restrictions), parts of the data will get re-initialized.
+ */
+typedef struct pack_context_t
+{
+  /* file system that we operate on */
+  svn_fs_t *fs;
+
+  /* cancel function to invoke at regular intervals. May be NULL */
+  svn_cancel_func_t cancel_func;
+
+  /* baton to pass to CANCEL_FUNC */
+  void *cancel_baton;
+
+  /* first revision in the shard (and future pack file) */
+  svn_revnum_t shard_rev;
+
+  /* first revision in the range to process (>= SHARD_REV) */
+  svn_revnum_t start_rev;
+
+  /* first revision after the range to process (<= SHARD_END_REV) */
+  svn_revnum_t end_rev;
+
+  /* first revision after the current shard */
+  svn_revnum_t shard_end_rev;
+
+  /* log-to-phys proto index for the whole pack file */
+  apr_file_t *proto_l2p_index;
+
+  /* phys-to-log proto index for the whole pack file */
+  apr_file_t *proto_p2l_index;
+
+  /* full shard directory path (containing the unpacked revisions) */
+  const char *shard_dir;
+
+  /* full packed shard directory path (containing the pack file + indexes) */
+  const char *pack_file_dir;
+
+  /* full pack file path (including PACK_FILE_DIR) */
   const char *pack_file_path;
-  svn_revnum_t shard_rev = (svn_revnum_t) (shard * max_files_per_dir);
 
-  /* Some useful paths. */
-  pack_file_path = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
+  /* current write position (i.e. file length) in the pack file */
+  apr_off_t pack_offset;
 
-  /* Remove any existing pack file for this shard, since it is incomplete. */
-  SVN_ERR(svn_io_remove_dir2(pack_file_dir, TRUE, cancel_func, cancel_baton,
-                             pool));
+  /* the pack file to ultimately write all data to */
+  apr_file_t *pack_file;
 
-  /* Create the new directory and pack file. */
-  SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, pool));
+  /* array of svn_fs_fs__p2l_entry_t *, all referring to change lists.
+   * Will be filled in phase 2 and be cleared after each revision range. */
+  apr_array_header_t *changes;
 
-  /* Index information files */
-  SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
-                              max_files_per_dir, cancel_func,
-                              cancel_baton, pool));
-  
-  SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
-  SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
+  /* temp file receiving all change list items (referenced by CHANGES).
+   * Will be filled in phase 2 and be cleared after each revision range. */
+  apr_file_t *changes_file;
 
-  return SVN_NO_ERROR;
-}
+  /* array of svn_fs_fs__p2l_entry_t *, all referring to file properties.
+   * Will be filled in phase 2 and be cleared after each revision range. */
+  apr_array_header_t *file_props;
 
-/* In the file system at FS_PATH, pack the SHARD in REVS_DIR and
- * REVPROPS_DIR containing exactly MAX_FILES_PER_DIR revisions, using POOL
- * for allocations.  REVPROPS_DIR will be NULL if revprop packing is not
- * supported.  COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that
- * case.
- *
- * CANCEL_FUNC and CANCEL_BATON are what you think they are; similarly
- * NOTIFY_FUNC and NOTIFY_BATON.
+  /* temp file receiving all file prop items (referenced by FILE_PROPS).
+   * Will be filled in phase 2 and be cleared after each revision range.*/
+  apr_file_t *file_props_file;
+
+  /* array of svn_fs_fs__p2l_entry_t *, all referring to directory properties.
+   * Will be filled in phase 2 and be cleared after each revision range. */
+  apr_array_header_t *dir_props;
+
+  /* temp file receiving all directory prop items (referenced by DIR_PROPS).
+   * Will be filled in phase 2 and be cleared after each revision range.*/
+  apr_file_t *dir_props_file;
+
+  /* container for all PATH members in PATH_ORDER. */
+  svn_prefix_tree__t *paths;
+
+  /* array of path_order_t *.  Will be filled in phase 2 and be cleared
+   * after each revision range.  Sorted by PATH, NODE_ID. */
+  apr_array_header_t *path_order;
+
+  /* array of reference_t *.  Will be filled in phase 2 and be cleared
+   * after each revision range.  It will be sorted by the FROM members. */
+  apr_array_header_t *references;
+
+  /* array of svn_fs_fs__p2l_entry_t*.  Will be filled in phase 2 and be
+   * cleared after each revision range.  During phase 3, we will set items
+   * to NULL that we already processed. */
+  apr_array_header_t *reps;
+
+  /* array of int, marking for each revision, the which offset their items
+   * begin in REPS.  Will be filled in phase 2 and be cleared after
+   * each revision range. */
+  apr_array_header_t *rev_offsets;
+
+  /* temp file receiving all items referenced by REPS.
+   * Will be filled in phase 2 and be cleared after each revision range.*/
+  apr_file_t *reps_file;
+
+  /* pool used for temporary data structures that will be cleaned up when
+   * the next range of revisions is being processed */
+  apr_pool_t *info_pool;
+} pack_context_t;
+
+/* Create and initialize a new pack context for packing shard SHARD_REV in
+ * SHARD_DIR into PACK_FILE_DIR within filesystem FS.  Allocate it in POOL
+ * and return the structure in *CONTEXT.
  *
- * If for some reason we detect a partial packing already performed, we
- * remove the pack file and start again.
+ * Limit the number of items being copied per iteration to MAX_ITEMS.
+ * Set CANCEL_FUNC and CANCEL_BATON as well.
  */
 static svn_error_t *
-pack_shard(const char *revs_dir,
-           const char *revsprops_dir,
-           svn_fs_t *fs,
-           apr_int64_t shard,
-           int max_files_per_dir,
-           apr_off_t max_pack_size,
-           int compression_level,
-           svn_fs_pack_notify_t notify_func,
-           void *notify_baton,
-           svn_cancel_func_t cancel_func,
-           void *cancel_baton,
-           apr_pool_t *pool)
+initialize_pack_context(pack_context_t *context,
+                        svn_fs_t *fs,
+                        const char *pack_file_dir,
+                        const char *shard_dir,
+                        svn_revnum_t shard_rev,
+                        apr_size_t max_items,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  const char *rev_shard_path, *rev_pack_file_dir;
-  const char *revprops_shard_path, *revprops_pack_file_dir;
+  const char *temp_dir;
+  apr_size_t max_revs = MIN(ffd->max_files_per_dir, (int)max_items);
 
-  /* Notify caller we're starting to pack this shard. */
-  if (notify_func)
-    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
-                        pool));
+  SVN_ERR_ASSERT(shard_rev % ffd->max_files_per_dir == 0);
 
-  /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               shard),
-                  pool);
-  rev_shard_path = svn_dirent_join(revs_dir,
-                           apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
-                           pool);
+  /* where we will place our various temp files */
+  SVN_ERR(svn_io_temp_dir(&temp_dir, pool));
 
-  /* pack the revision content */
-  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
-                         shard, max_files_per_dir, 64 * 1024 * 1024,
-                         cancel_func, cancel_baton, pool));
+  /* store parameters */
+  context->fs = fs;
+  context->cancel_func = cancel_func;
+  context->cancel_baton = cancel_baton;
 
-  /* if enabled, pack the revprops in an equivalent way */
-  if (revsprops_dir)
-    {
-      revprops_pack_file_dir = svn_dirent_join(revsprops_dir,
-                   apr_psprintf(pool,
-                                "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                                shard),
-                   pool);
-      revprops_shard_path = svn_dirent_join(revsprops_dir,
-                           apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
-                           pool);
+  context->shard_rev = shard_rev;
+  context->start_rev = shard_rev;
+  context->end_rev = shard_rev;
+  context->shard_end_rev = shard_rev + ffd->max_files_per_dir;
 
-      SVN_ERR(svn_fs_fs__pack_revprops_shard(revprops_pack_file_dir,
-                                             revprops_shard_path,
-                                             shard, max_files_per_dir,
-                                             (int)(0.9 * max_pack_size),
-                                             compression_level,
-                                             cancel_func, cancel_baton,
-                                             pool));
-    }
+  /* Create the new directory and pack file. */
+  context->shard_dir = shard_dir;
+  context->pack_file_dir = pack_file_dir;
+  context->pack_file_path
+    = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
+  SVN_ERR(svn_io_file_open(&context->pack_file, context->pack_file_path,
+                           APR_WRITE | APR_BUFFERED | APR_BINARY | APR_EXCL
+                             | APR_CREATE, APR_OS_DEFAULT, pool));
+
+  /* Proto index files */
+  SVN_ERR(svn_fs_fs__l2p_proto_index_open
+            (&context->proto_l2p_index,
+             svn_dirent_join(pack_file_dir,
+                             PATH_INDEX PATH_EXT_L2P_INDEX,
+                             pool),
+             pool));
+  SVN_ERR(svn_fs_fs__p2l_proto_index_open
+            (&context->proto_p2l_index,
+             svn_dirent_join(pack_file_dir,
+                             PATH_INDEX PATH_EXT_P2L_INDEX,
+                             pool),
+             pool));
+
+  /* item buckets: one item info array and one temp file per bucket */
+  context->changes = apr_array_make(pool, max_items,
+                                    sizeof(svn_fs_fs__p2l_entry_t *));
+  SVN_ERR(svn_io_open_unique_file3(&context->changes_file, NULL, temp_dir,
+                                   svn_io_file_del_on_close, pool, pool));
+  context->file_props = apr_array_make(pool, max_items,
+                                       sizeof(svn_fs_fs__p2l_entry_t *));
+  SVN_ERR(svn_io_open_unique_file3(&context->file_props_file, NULL, temp_dir,
+                                   svn_io_file_del_on_close, pool, pool));
+  context->dir_props = apr_array_make(pool, max_items,
+                                      sizeof(svn_fs_fs__p2l_entry_t *));
+  SVN_ERR(svn_io_open_unique_file3(&context->dir_props_file, NULL, temp_dir,
+                                   svn_io_file_del_on_close, pool, pool));
+
+  /* noderev and representation item bucket */
+  context->rev_offsets = apr_array_make(pool, max_revs, sizeof(int));
+  context->path_order = apr_array_make(pool, max_items,
+                                       sizeof(path_order_t *));
+  context->references = apr_array_make(pool, max_items,
+                                       sizeof(reference_t *));
+  context->reps = apr_array_make(pool, max_items,
+                                 sizeof(svn_fs_fs__p2l_entry_t *));
+  SVN_ERR(svn_io_open_unique_file3(&context->reps_file, NULL, temp_dir,
+                                   svn_io_file_del_on_close, pool, pool));
+
+  /* the pool used for temp structures */
+  context->info_pool = svn_pool_create(pool);
+  context->paths = svn_prefix_tree__create(context->info_pool);
 
-  /* Update the min-unpacked-rev file to reflect our newly packed shard. */
-  SVN_ERR(svn_fs_fs__write_min_unpacked_rev(fs,
-                          (svn_revnum_t)((shard + 1) * max_files_per_dir),
-                          pool));
-  ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
+  return SVN_NO_ERROR;
+}
 
-  /* Finally, remove the existing shard directories.
-   * For revprops, clean up older obsolete shards as well as they might
-   * have been left over from an interrupted FS upgrade. */
-  SVN_ERR(svn_io_remove_dir2(rev_shard_path, TRUE,
-                             cancel_func, cancel_baton, pool));
-  if (revsprops_dir)
+/* Clean up / free all revision range specific data and files in CONTEXT.
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+reset_pack_context(pack_context_t *context,
+                   apr_pool_t *pool)
+{
+  apr_array_clear(context->changes);
+  SVN_ERR(svn_io_file_trunc(context->changes_file, 0, pool));
+  apr_array_clear(context->file_props);
+  SVN_ERR(svn_io_file_trunc(context->file_props_file, 0, pool));
+  apr_array_clear(context->dir_props);
+  SVN_ERR(svn_io_file_trunc(context->dir_props_file, 0, pool));
+
+  apr_array_clear(context->rev_offsets);
+  apr_array_clear(context->path_order);
+  apr_array_clear(context->references);
+  apr_array_clear(context->reps);
+  SVN_ERR(svn_io_file_trunc(context->reps_file, 0, pool));
+
+  svn_pool_clear(context->info_pool);
+  context->paths = svn_prefix_tree__create(context->info_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Call this after the last revision range.  It will finalize all index files
+ * for CONTEXT and close any open files.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+close_pack_context(pack_context_t *context,
+                   apr_pool_t *pool)
+{
+  const char *l2p_index_path
+    = apr_pstrcat(pool, context->pack_file_path, PATH_EXT_L2P_INDEX,
+                  SVN_VA_NULL);
+  const char *p2l_index_path
+    = apr_pstrcat(pool, context->pack_file_path, PATH_EXT_P2L_INDEX,
+                  SVN_VA_NULL);
+  const char *proto_l2p_index_path;
+  const char *proto_p2l_index_path;
+
+  /* need the file names for the actual index creation call further down */
+  SVN_ERR(svn_io_file_name_get(&proto_l2p_index_path,
+                               context->proto_l2p_index, pool));
+  SVN_ERR(svn_io_file_name_get(&proto_p2l_index_path,
+                               context->proto_p2l_index, pool));
+
+  /* finalize proto index files */
+  SVN_ERR(svn_io_file_close(context->proto_l2p_index, pool));
+  SVN_ERR(svn_io_file_close(context->proto_p2l_index, pool));
+
+  /* Create the actual index files*/
+  SVN_ERR(svn_fs_fs__l2p_index_create(context->fs, l2p_index_path,
+                                      proto_l2p_index_path,
+                                      context->shard_rev, pool));
+  SVN_ERR(svn_fs_fs__p2l_index_create(context->fs, p2l_index_path,
+                                      proto_p2l_index_path,
+                                      context->shard_rev, pool));
+
+  /* remove proto index files and disallow write access to the final
+     index files */
+  SVN_ERR(svn_io_remove_file2(proto_l2p_index_path, FALSE, pool));
+  SVN_ERR(svn_io_remove_file2(proto_p2l_index_path, FALSE, pool));
+  SVN_ERR(svn_io_set_file_read_only(l2p_index_path, FALSE, pool));
+  SVN_ERR(svn_io_set_file_read_only(p2l_index_path, FALSE, pool));
+
+  SVN_ERR(svn_io_file_close(context->pack_file, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Efficiently copy SIZE bytes from SOURCE to DEST.  Invoke the CANCEL_FUNC
+ * from CONTEXT at regular intervals.  Use POOL for allocations.
+ */
+static svn_error_t *
+copy_file_data(pack_context_t *context,
+               apr_file_t *dest,
+               apr_file_t *source,
+               apr_off_t size,
+               apr_pool_t *pool)
+{
+  /* most non-representation items will be small.  Minimize the buffer
+   * and infrastructure overhead in that case. */
+  enum { STACK_BUFFER_SIZE = 1024 };
+
+  if (size < STACK_BUFFER_SIZE)
     {
-      svn_node_kind_t kind = svn_node_dir;
-      apr_int64_t to_cleanup = shard;
-      do
+      /* copy small data using a fixed-size buffer on stack */
+      char buffer[STACK_BUFFER_SIZE];
+      SVN_ERR(svn_io_file_read_full2(source, buffer, (apr_size_t)size,
+                                     NULL, NULL, pool));
+      SVN_ERR(svn_io_file_write_full(dest, buffer, (apr_size_t)size,
+                                     NULL, pool));
+    }
+  else
+    {
+      /* use streaming copies for larger data blocks.  That may require
+       * the allocation of larger buffers and we should make sure that
+       * this extra memory is released asap. */
+      fs_fs_data_t *ffd = context->fs->fsap_data;
+      apr_pool_t *copypool = svn_pool_create(pool);
+      char *buffer = apr_palloc(copypool, (apr_size_t)ffd->block_size);
+
+      while (size)
         {
-          SVN_ERR(svn_fs_fs__delete_revprops_shard(revprops_shard_path,
-                                                   to_cleanup,
-                                                   max_files_per_dir,
-                                                   cancel_func,
-                                                   cancel_baton,
-                                                   pool));
+          apr_size_t to_copy = (apr_size_t)(MIN(size, ffd->block_size));
+          if (context->cancel_func)
+            SVN_ERR(context->cancel_func(context->cancel_baton));
 
-          /* If the previous shard exists, clean it up as well.
-             Don't try to clean up shard 0 as it we can't tell quickly
-             whether it actually needs cleaning up. */
-          revprops_shard_path = svn_dirent_join(revsprops_dir,
-                      apr_psprintf(pool, "%" APR_INT64_T_FMT, --to_cleanup),
-                      pool);
-          SVN_ERR(svn_io_check_path(revprops_shard_path, &kind, pool));
+          SVN_ERR(svn_io_file_read_full2(source, buffer, to_copy,
+                                         NULL, NULL, pool));
+          SVN_ERR(svn_io_file_write_full(dest, buffer, to_copy,
+                                         NULL, pool));
+
+          size -= to_copy;
         }
-      while (kind == svn_node_dir && to_cleanup > 0);
-    }
 
-  /* Notify caller we're starting to pack this shard. */
-  if (notify_func)
-    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_end,
-                        pool));
+      svn_pool_destroy(copypool);
+    }
 
   return SVN_NO_ERROR;
 }
 
-struct pack_baton
+/* Writes SIZE bytes, all 0, to DEST.  Uses POOL for allocations.
+ */
+static svn_error_t *
+write_null_bytes(apr_file_t *dest,
+                 apr_off_t size,
+                 apr_pool_t *pool)
 {
-  svn_fs_t *fs;
-  svn_fs_pack_notify_t notify_func;
-  void *notify_baton;
-  svn_cancel_func_t cancel_func;
-  void *cancel_baton;
-};
+  /* Have a collection of high-quality, easy to access NUL bytes handy. */
+  enum { BUFFER_SIZE = 1024 };
+  static const char buffer[BUFFER_SIZE] = { 0 };
 
+  /* copy SIZE of them into the file's buffer */
+  while (size)
+    {
+      apr_size_t to_write = MIN(size, BUFFER_SIZE);
+      SVN_ERR(svn_io_file_write_full(dest, buffer, to_write, NULL, pool));
+      size -= to_write;
+    }
 
-/* The work-horse for svn_fs_fs__pack, called with the FS write lock.
-   This implements the svn_fs_fs__with_write_lock() 'body' callback
-   type.  BATON is a 'struct pack_baton *'.
+  return SVN_NO_ERROR;
+}
 
-   WARNING: if you add a call to this function, please note:
-     The code currently assumes that any piece of code running with
-     the write-lock set can rely on the ffd->min_unpacked_rev and
-     ffd->min_unpacked_revprop caches to be up-to-date (and, by
-     extension, on not having to use a retry when calling
-     svn_fs_fs__path_rev_absolute() and friends).  If you add a call
-     to this function, consider whether you have to call
-     svn_fs_fs__update_min_unpacked_rev().
-     See this thread: http://thread.gmane.org/1291206765.3782.3309.camel@edith
+/* Copy the "simple" item (changed paths list or property representation)
+ * from the current position in REV_FILE to TEMP_FILE using CONTEXT.  Add
+ * a copy of ENTRY to ENTRIES but with an updated offset value that points
+ * to the copy destination in TEMP_FILE.  Use POOL for allocations.
  */
 static svn_error_t *
-pack_body(void *baton,
-          apr_pool_t *pool)
+copy_item_to_temp(pack_context_t *context,
+                  apr_array_header_t *entries,
+                  apr_file_t *temp_file,
+                  apr_file_t *rev_file,
+                  svn_fs_fs__p2l_entry_t *entry,
+                  apr_pool_t *pool)
 {
-  struct pack_baton *pb = baton;
-  fs_fs_data_t *ffd = pb->fs->fsap_data;
-  apr_int64_t completed_shards;
-  apr_int64_t i;
-  svn_revnum_t youngest;
-  apr_pool_t *iterpool;
-  const char *rev_data_path;
-  const char *revprops_data_path = NULL;
+  svn_fs_fs__p2l_entry_t *new_entry
+    = apr_pmemdup(context->info_pool, entry, sizeof(*entry));
+  new_entry->offset = 0;
+  SVN_ERR(svn_io_file_seek(temp_file, SEEK_CUR, &new_entry->offset, pool));
+  APR_ARRAY_PUSH(entries, svn_fs_fs__p2l_entry_t *) = new_entry;
 
-  /* If the repository isn't a new enough format, we don't support packing.
-     Return a friendly error to that effect. */
-  if (ffd->format < SVN_FS_FS__MIN_PACKED_FORMAT)
-    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
-      _("FSFS format (%d) too old to pack; please upgrade the filesystem."),
-      ffd->format);
-
-  /* If we aren't using sharding, we can't do any packing, so quit. */
-  if (!ffd->max_files_per_dir)
-    return SVN_NO_ERROR;
+  SVN_ERR(copy_file_data(context, temp_file, rev_file, entry->size, pool));
 
-  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, pb->fs,
-                                           pool));
+  return SVN_NO_ERROR;
+}
 
-  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, pb->fs, pool));
-  completed_shards = (youngest + 1) / ffd->max_files_per_dir;
+/* Return the offset within CONTEXT->REPS that corresponds to item
+ * ITEM_INDEX in  REVISION.
+ */
+static int
+get_item_array_index(pack_context_t *context,
+                     svn_revnum_t revision,
+                     apr_int64_t item_index)
+{
+  assert(revision >= context->start_rev);
+  return (int)item_index + APR_ARRAY_IDX(context->rev_offsets,
+                                         revision - context->start_rev,
+                                         int);
+}
 
-  /* See if we've already completed all possible shards thus far. */
-  if (ffd->min_unpacked_rev == (completed_shards * ffd->max_files_per_dir))
-    return SVN_NO_ERROR;
+/* Write ENTRY to the correct position in CONTEXT->REPS.  The latter
+ * may need auto-expanding.  Overwriting an array element is not allowed.
+ */
+static void
+add_item_rep_mapping(pack_context_t *context,
+                     svn_fs_fs__p2l_entry_t *entry)
+{
+  int idx;
 
-  rev_data_path = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
-  if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-    revprops_data_path = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
-                                         pool);
+  /* index of INFO */
+  idx = get_item_array_index(context,
+                             entry->item.revision,
+                             entry->item.number);
 
-  iterpool = svn_pool_create(pool);
-  for (i = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       i < completed_shards;
-       i++)
-    {
-      svn_pool_clear(iterpool);
+  /* make sure the index exists in the array */
+  while (context->reps->nelts <= idx)
+    APR_ARRAY_PUSH(context->reps, void *) = NULL;
 
-      if (pb->cancel_func)
-        SVN_ERR(pb->cancel_func(pb->cancel_baton));
+  /* set the element.  If there is already an entry, there are probably
+   * two items claiming to be the same -> bail out */
+  assert(!APR_ARRAY_IDX(context->reps, idx, void *));
+  APR_ARRAY_IDX(context->reps, idx, void *) = entry;
+}
 
-      SVN_ERR(pack_shard(rev_data_path, revprops_data_path,
+/* Return the P2L entry from CONTEXT->REPS for the given ID.  If there is
+ * none (or not anymore), return NULL.  If RESET has been specified, set
+ * the array entry to NULL after returning the entry.
+ */
+static svn_fs_fs__p2l_entry_t *
+get_item(pack_context_t *context,
+         const svn_fs_fs__id_part_t *id,
+         svn_boolean_t reset)
+{
+  svn_fs_fs__p2l_entry_t *result = NULL;
+  if (   id->number
+      && id->revision >= context->start_rev
+      && id->revision < context->end_rev)
+    {
+      int idx = get_item_array_index(context, id->revision, id->number);
+      if (context->reps->nelts > idx)
+        {
+          result = APR_ARRAY_IDX(context->reps, idx, void *);
+          if (result && reset)
+            APR_ARRAY_IDX(context->reps, idx, void *) = NULL;
+        }
+    }
+
+  return result;
+}
+
+/* Copy representation item identified by ENTRY from the current position
+ * in REV_FILE into CONTEXT->REPS_FILE.  Add all tracking into needed by
+ * our placement algorithm to CONTEXT.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+copy_rep_to_temp(pack_context_t *context,
+                 apr_file_t *rev_file,
+                 svn_fs_fs__p2l_entry_t *entry,
+                 apr_pool_t *pool)
+{
+  svn_fs_fs__rep_header_t *rep_header;
+  svn_stream_t *stream;
+  apr_off_t source_offset = entry->offset;
+
+  /* create a copy of ENTRY, make it point to the copy destination and
+   * store it in CONTEXT */
+  entry = apr_pmemdup(context->info_pool, entry, sizeof(*entry));
+  entry->offset = 0;
+  SVN_ERR(svn_io_file_seek(context->reps_file, SEEK_CUR, &entry->offset,
+                           pool));
+  add_item_rep_mapping(context, entry);
+
+  /* read & parse the representation header */
+  stream = svn_stream_from_aprfile2(rev_file, TRUE, pool);
+  SVN_ERR(svn_fs_fs__read_rep_header(&rep_header, stream, pool));
+  svn_stream_close(stream);
+
+  /* if the representation is a delta against some other rep, link the two */
+  if (   rep_header->type == svn_fs_fs__rep_delta
+      && rep_header->base_revision >= context->start_rev)
+    {
+      reference_t *reference = apr_pcalloc(context->info_pool,
+                                           sizeof(*reference));
+      reference->from = entry->item;
+      reference->to.revision = rep_header->base_revision;
+      reference->to.number = rep_header->base_offset;
+      APR_ARRAY_PUSH(context->references, reference_t *) = reference;
+    }
+
+  /* copy the whole rep (including header!) to our temp file */
+  SVN_ERR(svn_io_file_seek(rev_file, SEEK_SET, &source_offset, pool));
+  SVN_ERR(copy_file_data(context, context->reps_file, rev_file, entry->size,
+                         pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy node revision item identified by ENTRY from the current position
+ * in REV_FILE into CONTEXT->REPS_FILE.  Add all tracking into needed by
+ * our placement algorithm to CONTEXT.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+copy_node_to_temp(pack_context_t *context,
+                  apr_file_t *rev_file,
+                  svn_fs_fs__p2l_entry_t *entry,
+                  apr_pool_t *pool)
+{
+  path_order_t *path_order = apr_pcalloc(context->info_pool,
+                                         sizeof(*path_order));
+  node_revision_t *noderev;
+  svn_stream_t *stream;
+  apr_off_t source_offset = entry->offset;
+
+  /* read & parse noderev */
+  stream = svn_stream_from_aprfile2(rev_file, TRUE, pool);
+  SVN_ERR(svn_fs_fs__read_noderev(&noderev, stream, pool));
+  svn_stream_close(stream);
+
+  /* create a copy of ENTRY, make it point to the copy destination and
+   * store it in CONTEXT */
+  entry = apr_pmemdup(context->info_pool, entry, sizeof(*entry));
+  entry->offset = 0;
+  SVN_ERR(svn_io_file_seek(context->reps_file, SEEK_CUR,
+                           &entry->offset, pool));
+  add_item_rep_mapping(context, entry);
+
+  /* copy the noderev to our temp file */
+  SVN_ERR(svn_io_file_seek(rev_file, SEEK_SET, &source_offset, pool));
+  SVN_ERR(copy_file_data(context, context->reps_file, rev_file, entry->size,
+                         pool));
+
+  /* if the node has a data representation, make that the node's "base".
+   * This will (often) cause the noderev to be placed right in front of
+   * its data representation. */
+  if (noderev->data_rep && noderev->data_rep->revision >= context->start_rev)
+    {
+      path_order->rep_id.revision = noderev->data_rep->revision;
+      path_order->rep_id.number = noderev->data_rep->offset;
+    }
+
+  path_order->path = svn_prefix_string__create(context->paths,
+                                               noderev->created_path);
+  path_order->node_id = *svn_fs_fs__id_node_id(noderev->id);
+  path_order->revision = svn_fs_fs__id_rev(noderev->id);
+  path_order->noderev_id = *svn_fs_fs__id_rev_offset(noderev->id);
+  APR_ARRAY_PUSH(context->path_order, path_order_t *) = path_order;
+
+  return SVN_NO_ERROR;
+}
+
+/* implements compare_fn_t. Place LHS before RHS, if the latter is older.
+ */
+static int
+compare_p2l_info(const svn_fs_fs__p2l_entry_t * const * lhs,
+                 const svn_fs_fs__p2l_entry_t * const * rhs)
+{
+  assert(*lhs != *rhs);
+
+  if ((*lhs)->item.revision == (*rhs)->item.revision)
+    return (*lhs)->item.number > (*rhs)->item.number ? -1 : 1;
+
+  return (*lhs)->item.revision > (*rhs)->item.revision ? -1 : 1;
+}
+
+/* Sort svn_fs_fs__p2l_entry_t * array ENTRIES by age.  Place the latest
+ * items first.
+ */
+static void
+sort_items(apr_array_header_t *entries)
+{
+  qsort(entries->elts, entries->nelts, entries->elt_size,
+        (int (*)(const void *, const void *))compare_p2l_info);
+}
+
+/* implements compare_fn_t.  Sort descending by PATH, NODE_ID and REVISION.
+ */
+static int
+compare_path_order(const path_order_t * const * lhs_p,
+                   const path_order_t * const * rhs_p)
+{
+  const path_order_t * lhs = *lhs_p;
+  const path_order_t * rhs = *rhs_p;
+
+  /* reverse lexicographic order on path and node (i.e. latest first) */
+  int diff = svn_prefix_string__compare(rhs->path, lhs->path);
+  if (diff)
+    return diff;
+
+  /* reverse order on node (i.e. latest first) */
+  diff = svn_fs_fs__id_part_compare(&rhs->node_id, &lhs->node_id);
+  if (diff)
+    return diff;
+
+  /* reverse order on revision (i.e. latest first) */
+  if (lhs->revision != rhs->revision)
+    return lhs->revision < rhs->revision ? 1 : -1;
+
+  return 0;
+}
+
+/* implements compare_fn_t.  Sort ascending by FROM, TO.
+ */
+static int
+compare_references(const reference_t * const * lhs_p,
+                   const reference_t * const * rhs_p)
+{
+  const reference_t * lhs = *lhs_p;
+  const reference_t * rhs = *rhs_p;
+
+  int diff = svn_fs_fs__id_part_compare(&lhs->from, &rhs->from);
+  return diff ? diff : svn_fs_fs__id_part_compare(&lhs->to, &rhs->to);
+}
+
+/* Order the data collected in CONTEXT such that we can place them in the
+ * desired order.
+ */
+static void
+sort_reps(pack_context_t *context)
+{
+  qsort(context->path_order->elts, context->path_order->nelts,
+        context->path_order->elt_size,
+        (int (*)(const void *, const void *))compare_path_order);
+  qsort(context->references->elts, context->references->nelts,
+        context->references->elt_size,
+        (int (*)(const void *, const void *))compare_references);
+}
+
+/* Return the remaining unused bytes in the current block in CONTEXT's
+ * pack file.
+ */
+static apr_off_t
+get_block_left(pack_context_t *context)
+{
+  fs_fs_data_t *ffd = context->fs->fsap_data;
+  return ffd->block_size - (context->pack_offset % ffd->block_size);
+}
+
+/* To prevent items from overlapping a block boundary, we will usually
+ * put them into the next block and top up the old one with NUL bytes.
+ * Pad CONTEXT's pack file to the end of the current block, if that padding
+ * is short enough.  Use POOL for allocations.
+ */
+static svn_error_t *
+auto_pad_block(pack_context_t *context,
+               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = context->fs->fsap_data;
+
+  /* This is the maximum number of bytes "wasted" that way per block.
+   * Larger items will cross the block boundaries. */
+  const apr_off_t max_padding = MAX(ffd->block_size / 50, 512);
+
+  /* Is wasted space small enough to align the current item to the next
+   * block? */
+  apr_off_t padding = get_block_left(context);
+
+  if (padding < max_padding)
+    {
+      /* Yes. To up with NUL bytes and don't forget to create
+       * an P2L index entry marking this section as unused. */
+      svn_fs_fs__p2l_entry_t null_entry;
+
+      null_entry.offset = context->pack_offset;
+      null_entry.size = padding;
+      null_entry.type = SVN_FS_FS__ITEM_TYPE_UNUSED;
+      null_entry.item.revision = SVN_INVALID_REVNUM;
+      null_entry.item.number = SVN_FS_FS__ITEM_INDEX_UNUSED;
+
+      SVN_ERR(write_null_bytes(context->pack_file, padding, pool));
+      SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry
+                  (context->proto_p2l_index, &null_entry, pool));
+      context->pack_offset += padding;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the index of the first entry in CONTEXT->REFERENCES that
+ * originates from ITEM->ITEM if such entries exist.  All matching items
+ * will be consecutive.
+ */
+static int
+find_first_reference(pack_context_t *context,
+                     svn_fs_fs__p2l_entry_t *item)
+{
+  int lower = 0;
+  int upper = context->references->nelts - 1;
+
+  while (lower <= upper)
+    {
+      int current = lower + (upper - lower) / 2;
+      reference_t *reference
+        = APR_ARRAY_IDX(context->references, current, reference_t *);
+
+      if (svn_fs_fs__id_part_compare(&reference->from, &item->item) < 0)
+        lower = current + 1;
+      else
+        upper = current - 1;
+    }
+
+  return lower;
+}
+
+/* Check whether entry number IDX in CONTEXT->REFERENCES originates from
+ * ITEM.
+ */
+static svn_boolean_t
+is_reference_match(pack_context_t *context,
+                   int idx,
+                   svn_fs_fs__p2l_entry_t *item)
+{
+  reference_t *reference;
+  if (context->references->nelts <= idx)
+    return FALSE;
+
+  reference = APR_ARRAY_IDX(context->references, idx, reference_t *);
+  return svn_fs_fs__id_part_eq(&reference->from, &item->item);
+}
+
+/* Read the contents of the item described by ENTRY from TEMP_FILE and
+ * write it to CONTEXT->PACK_FILE.  Unless the item is very large, make
+ * sure it does not cross a block boundary.  Update ENTRY to reflect its
+ * location in the pack file and append it to CONTEXT->REPS.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+store_item(pack_context_t *context,
+           apr_file_t *temp_file,
+           svn_fs_fs__p2l_entry_t *entry,
+           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = context->fs->fsap_data;
+
+  /* don't let small items cross block boundaries */
+  if (entry->size < ffd->block_size && entry->size > get_block_left(context))
+    SVN_ERR(auto_pad_block(context, pool));
+
+  /* select the item in the source file and copy it into the target
+   * pack file */
+  SVN_ERR(svn_io_file_seek(temp_file, SEEK_SET, &entry->offset, pool));
+  SVN_ERR(copy_file_data(context, context->pack_file, temp_file,
+                         entry->size, pool));
+
+  /* write index entry and update current position */
+  entry->offset = context->pack_offset;
+  context->pack_offset += entry->size;
+
+  SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(context->proto_p2l_index,
+                                               entry, pool));
+
+  APR_ARRAY_PUSH(context->reps, svn_fs_fs__p2l_entry_t *) = entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the contents of the non-empty items in ITEMS from TEMP_FILE and
+ * write them to CONTEXT->PACK_FILE.  Use POOL for allocations.
+ */
+static svn_error_t *
+store_items(pack_context_t *context,
+            apr_file_t *temp_file,
+            apr_array_header_t *items,
+            apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* copy all items in strict order */
+  for (i = 0; i < items->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(items, i, svn_fs_fs__p2l_entry_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(store_item(context, temp_file, entry, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the noderevs and representations collected in CONTEXT from
+ * TEMP_FILE into CONTEXT->PACK_FILE.  Use POOL for temporary allocations.
+ *
+ * Items are placed in path order: for every node change, we place the
+ * noderev, immediately followed by its data representation and then all
+ * delta bases of that representation within the current revision range.
+ * Reading any node's contents thus becomes a mostly sequential operation.
+ * Items not reached that way will be appended in revision order.
+ */
+static svn_error_t *
+copy_reps_from_temp(pack_context_t *context,
+                    apr_file_t *temp_file,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_array_header_t *path_order = context->path_order;
+  apr_array_header_t *reps = context->reps;
+  int initial_reps_count = reps->nelts;
+  int i, k;
+
+  /* copy items in path order */
+  for (i = 0; i < path_order->nelts; ++i)
+    {
+      path_order_t *current_path
+        = APR_ARRAY_IDX(path_order, i, path_order_t *);
+      svn_fs_fs__p2l_entry_t *node_part;
+      svn_fs_fs__p2l_entry_t *rep_part;
+      svn_fs_fs__id_part_t rep_id = current_path->rep_id;
+
+      svn_pool_clear(iterpool);
+
+      node_part = get_item(context, &current_path->noderev_id, TRUE);
+      if (node_part)
+        SVN_ERR(store_item(context, temp_file, node_part, iterpool));
+
+      /* follow the delta chain as long as its elements have not been
+       * placed yet */
+      while ((rep_part = get_item(context, &rep_id, TRUE)))
+        {
+          SVN_ERR(store_item(context, temp_file, rep_part, iterpool));
+
+          k = find_first_reference(context, rep_part);
+          if (!is_reference_match(context, k, rep_part))
+            break;
+
+          rep_id = APR_ARRAY_IDX(context->references, k, reference_t *)->to;
+        }
+
+      if (context->cancel_func)
+        SVN_ERR(context->cancel_func(context->cancel_baton));
+    }
+
+  /* copy all remaining items in strict order */
+  for (i = 0; i < initial_reps_count; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(reps, i, svn_fs_fs__p2l_entry_t *);
+      if (!entry)
+        continue;
+
+      svn_pool_clear(iterpool);
+      APR_ARRAY_IDX(reps, i, svn_fs_fs__p2l_entry_t *) = NULL;
+      SVN_ERR(store_item(context, temp_file, entry, iterpool));
+    }
+
+  /* vaccum REPS array: eliminate NULL entries */
+  for (i = 0, k = 0; i < reps->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(reps, i, svn_fs_fs__p2l_entry_t *);
+      if (entry)
+        {
+          APR_ARRAY_IDX(reps, k, svn_fs_fs__p2l_entry_t *) = entry;
+          ++k;
+        }
+    }
+  reps->nelts = k;
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append all entries of svn_fs_fs__p2l_entry_t * array TO_APPEND to
+ * svn_fs_fs__p2l_entry_t * array DEST.
+ */
+static void
+append_entries(apr_array_header_t *dest,
+               apr_array_header_t *to_append)
+{
+  int i;
+  for (i = 0; i < to_append->nelts; ++i)
+    APR_ARRAY_PUSH(dest, svn_fs_fs__p2l_entry_t *)
+      = APR_ARRAY_IDX(to_append, i, svn_fs_fs__p2l_entry_t *);
+}
+
+/* implements compare_fn_t.  Sort ascending by revision and item index.
+ */
+static int
+compare_p2l_info_rev(const svn_fs_fs__p2l_entry_t * const * lhs,
+                     const svn_fs_fs__p2l_entry_t * const * rhs)
+{
+  return svn_fs_fs__id_part_compare(&(*lhs)->item, &(*rhs)->item);
+}
+
+/* Write the log-to-phys proto index file for CONTEXT and use POOL for
+ * temporary allocations.  All items in all buckets must have been placed
+ * by now.
+ */
+static svn_error_t *
+write_l2p_index(pack_context_t *context,
+                apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t prev_rev = SVN_INVALID_REVNUM;
+  int i;
+
+  /* lump all items into one bucket.  As target, use the bucket that
+   * probably has the most entries already. */
+  append_entries(context->reps, context->changes);
+  append_entries(context->reps, context->file_props);
+  append_entries(context->reps, context->dir_props);
+
+  /* we need to write the index in ascending revision order */
+  qsort(context->reps->elts, context->reps->nelts, context->reps->elt_size,
+        (int (*)(const void *, const void *))compare_p2l_info_rev);
+
+  /* write index entries */
+  for (i = 0; i < context->reps->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(context->reps, i, svn_fs_fs__p2l_entry_t *);
+
+      /* next revision? */
+      if (prev_rev != entry->item.revision)
+        {
+          prev_rev = entry->item.revision;
+          SVN_ERR(svn_fs_fs__l2p_proto_index_add_revision
+                      (context->proto_l2p_index, iterpool));
+        }
+
+      /* add entry */
+      SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry
+                  (context->proto_l2p_index, entry->offset,
+                   entry->item.number, iterpool));
+
+      /* keep memory usage in check */
+      if (i % 256 == 0)
+        svn_pool_clear(iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pack the current revision range of CONTEXT, i.e. this covers phases 2
+ * to 4.  Use POOL for allocations.
+ */
+static svn_error_t *
+pack_range(pack_context_t *context,
+           apr_pool_t *pool)
+{
+  apr_pool_t *revpool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Phase 2: Copy items into various buckets and build tracking info */
+  svn_revnum_t revision;
+  for (revision = context->start_rev; revision < context->end_rev; ++revision)
+    {
+      apr_off_t offset = 0;
+      apr_finfo_t finfo;
+      apr_file_t *rev_file;
+
+      /* Get the size of the file. */
+      const char *path = svn_dirent_join(context->shard_dir,
+                                         apr_psprintf(revpool, "%ld",
+                                                      revision),
+                                         revpool);
+      SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, revpool));
+
+      SVN_ERR(svn_io_file_open(&rev_file, path,
+                               APR_READ | APR_BUFFERED | APR_BINARY,
+                               APR_OS_DEFAULT, revpool));
+
+      /* store the indirect array index */
+      APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
+
+      /* read the phys-to-log index file until we covered the whole rev file.
+       * That index contains enough info to build both target indexes from it. */
+      while (offset < finfo.size)
+        {
+          /* read one cluster */
+          int i;
+          apr_array_header_t *entries;
+          SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, context->fs,
+                                              revision, offset,
+                                              iterpool));
+
+          for (i = 0; i < entries->nelts; ++i)
+            {
+              svn_fs_fs__p2l_entry_t *entry
+                = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+              /* skip first entry if that was duplicated due crossing a
+                 cluster boundary */
+              if (offset > entry->offset)
+                continue;
+
+              /* process entry while inside the rev file */
+              offset = entry->offset;
+              if (offset < finfo.size)
+                {
+                  SVN_ERR(svn_io_file_seek(rev_file, SEEK_SET, &offset,
+                                           iterpool));
+
+                  if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
+                    SVN_ERR(copy_item_to_temp(context,
+                                              context->changes,
+                                              context->changes_file,
+                                              rev_file, entry, iterpool));
+                  else if (entry->type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
+                    SVN_ERR(copy_item_to_temp(context,
+                                              context->file_props,
+                                              context->file_props_file,
+                                              rev_file, entry, iterpool));
+                  else if (entry->type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS)
+                    SVN_ERR(copy_item_to_temp(context,
+                                              context->dir_props,
+                                              context->dir_props_file,
+                                              rev_file, entry, iterpool));
+                  else if (   entry->type == SVN_FS_FS__ITEM_TYPE_FILE_REP
+                           || entry->type == SVN_FS_FS__ITEM_TYPE_DIR_REP)
+                    SVN_ERR(copy_rep_to_temp(context, rev_file, entry,
+                                             iterpool));
+                  else if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
+                    SVN_ERR(copy_node_to_temp(context, rev_file, entry,
+                                              iterpool));
+                  else
+                    SVN_ERR_ASSERT(entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED);
+
+                  offset += entry->size;
+                }
+            }
+
+          if (context->cancel_func)
+            SVN_ERR(context->cancel_func(context->cancel_baton));
+
+          svn_pool_clear(iterpool);
+        }
+
+      svn_pool_clear(revpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* phase 3: placement.
+   * Use "newest first" placement for simple items. */
+  sort_items(context->changes);
+  sort_items(context->file_props);
+  sort_items(context->dir_props);
+
+  /* follow dependencies recursively for noderevs and data representations */
+  sort_reps(context);
+
+  /* phase 4: copy bucket data to pack file.  Write P2L index. */
+  SVN_ERR(store_items(context, context->changes_file, context->changes,
+                      revpool));
+  svn_pool_clear(revpool);
+  SVN_ERR(store_items(context, context->file_props_file,
+                      context->file_props, revpool));
+  svn_pool_clear(revpool);
+  SVN_ERR(store_items(context, context->dir_props_file, context->dir_props,
+                      revpool));
+  svn_pool_clear(revpool);
+  SVN_ERR(copy_reps_from_temp(context, context->reps_file, revpool));
+  svn_pool_clear(revpool);
+
+  /* write L2P index as well (now that we know all target offsets) */
+  SVN_ERR(write_l2p_index(context, revpool));
+
+  svn_pool_destroy(revpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append CONTEXT->START_REV to the context's pack file with no re-ordering.
+ * This function will only be used for very large revisions (>>100k changes).
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+append_revision(pack_context_t *context,
+                apr_pool_t *pool)
+{
+  apr_off_t offset = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_file_t *rev_file;
+  apr_finfo_t finfo;
+
+  /* Get the size of the file. */
+  const char *path = svn_dirent_join(context->shard_dir,
+                                     apr_psprintf(iterpool, "%ld",
+                                                  context->start_rev),
+                                     pool);
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool));
+
+  /* Copy all the bits from the rev file to the end of the pack file. */
+  SVN_ERR(svn_io_file_open(&rev_file, path,
+                           APR_READ | APR_BUFFERED | APR_BINARY,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(copy_file_data(context, context->pack_file, rev_file, finfo.size,
+                         iterpool));
+
+  /* mark the start of a new revision */
+  SVN_ERR(svn_fs_fs__l2p_proto_index_add_revision(context->proto_l2p_index,
+                                                  pool));
+
+  /* read the phys-to-log index file until we covered the whole rev file.
+   * That index contains enough info to build both target indexes from it. */
+  while (offset < finfo.size)
+    {
+      /* read one cluster */
+      int i;
+      apr_array_header_t *entries;
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, context->fs,
+                                          context->start_rev, offset,
+                                          iterpool));
+
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+          /* skip first entry if that was duplicated due crossing a
+             cluster boundary */
+          if (offset > entry->offset)
+            continue;
+
+          /* process entry while inside the rev file */
+          offset = entry->offset;
+          if (offset < finfo.size)
+            {
+              entry->offset += context->pack_offset;
+              offset += entry->size;
+              SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry
+                        (context->proto_p2l_index, entry, iterpool));
+              if (entry->type != SVN_FS_FS__ITEM_TYPE_UNUSED)
+                SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry
+                          (context->proto_l2p_index, entry->offset,
+                           entry->item.number, iterpool));
+            }
+        }
+
+      svn_pool_clear(iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+  context->pack_offset += finfo.size;
+
+  SVN_ERR(svn_io_file_close(rev_file, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Format 7 packing logic.
+ *
+ * Pack the revision shard starting at SHARD_REV in filesystem FS from
+ * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  Limit
+ * the extra memory consumption to MAX_MEM bytes.  CANCEL_FUNC and
+ * CANCEL_BATON are what you think they are.
+ */
+static svn_error_t *
+pack_log_addressed(svn_fs_t *fs,
+                   const char *pack_file_dir,
+                   const char *shard_dir,
+                   svn_revnum_t shard_rev,
+                   apr_size_t max_mem,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  enum
+    {
+      /* estimated amount of memory used to represent one item in memory
+       * during rev file packing */
+      PER_ITEM_MEM = APR_ALIGN_DEFAULT(sizeof(path_order_t))
+                   + APR_ALIGN_DEFAULT(2 *sizeof(void*))
+                   + APR_ALIGN_DEFAULT(sizeof(reference_t))
+                   + APR_ALIGN_DEFAULT(sizeof(svn_fs_fs__p2l_entry_t))
+                   + 6 * sizeof(void*)
+    };
+
+  apr_size_t max_items = max_mem / PER_ITEM_MEM;
+  apr_array_header_t *max_ids;
+  pack_context_t context = { 0 };
+  int i;
+  apr_size_t item_count = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* set up a pack context */
+  SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
+                                  shard_rev, max_items, cancel_func,
+                                  cancel_baton, pool));
+
+  /* phase 1: determine the size of the revisions to pack */
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, shard_rev,
+                                     context.shard_end_rev - shard_rev,
+                                     pool));
+
+  /* pack revisions in ranges that don't exceed MAX_MEM */
+  for (i = 0; i < max_ids->nelts; ++i)
+    if (APR_ARRAY_IDX(max_ids, i, apr_uint64_t) + item_count <= max_items)
+      {
+        item_count += (apr_size_t)APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
+        context.end_rev++;
+      }
+    else
+      {
+        /* some unpacked revisions before this one? */
+        if (context.start_rev < context.end_rev)
+          {
+            /* pack them intelligently (might be just 1 rev but still ...) */
+            SVN_ERR(pack_range(&context, iterpool));
+            SVN_ERR(reset_pack_context(&context, iterpool));
+            item_count = 0;
+          }
+
+        /* next revision range is to start with the current revision */
+        context.start_rev = i + context.shard_rev;
+        context.end_rev = context.start_rev + 1;
+
+        /* if this is a very large revision, we must place it as is */
+        if (APR_ARRAY_IDX(max_ids, i, apr_uint64_t) > max_items)
+          {
+            SVN_ERR(append_revision(&context, iterpool));
+            context.start_rev++;
+          }
+        else
+          item_count += (apr_size_t)APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
+
+        svn_pool_clear(iterpool);
+      }
+
+  /* non-empty revision range at the end? */
+  if (context.start_rev < context.end_rev)
+    SVN_ERR(pack_range(&context, iterpool));
+
+  /* last phase: finalize indexes and clean up */
+  SVN_ERR(reset_pack_context(&context, iterpool));
+  SVN_ERR(close_pack_context(&context, iterpool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* In filesystem FS, pack the revision SHARD containing exactly
+ * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
+ * using POOL for allocations.  Try to limit the amount of temporary
+ * memory needed to MAX_MEM bytes.  CANCEL_FUNC and CANCEL_BATON are what
+ * you think they are.
+ *
+ * If for some reason we detect a partial packing already performed, we
+ * remove the pack file and start again.
+ *
+ * The actual packing will be done in a format-specific sub-function.
+ */
+static svn_error_t *
+pack_rev_shard(svn_fs_t *fs,
+               const char *pack_file_dir,
+               const char *shard_path,
+               apr_int64_t shard,
+               int max_files_per_dir,
+               apr_size_t max_mem,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *pool)
+{
+  const char *pack_file_path;
+  svn_revnum_t shard_rev = (svn_revnum_t) (shard * max_files_per_dir);
+
+  /* Some useful paths. */
+  pack_file_path = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
+
+  /* Remove any existing pack file for this shard, since it is incomplete. */
+  SVN_ERR(svn_io_remove_dir2(pack_file_dir, TRUE, cancel_func, cancel_baton,
+                             pool));
+
+  /* Create the new directory and pack file. */
+  SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, pool));
+
+  /* Index information files */
+  if (svn_fs_fs__use_log_addressing(fs))
+    SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path, shard_rev,
+                               max_mem, cancel_func, cancel_baton, pool));
+  else
+    SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
+                                max_files_per_dir, cancel_func,
+                                cancel_baton, pool));
+
+  SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
+  SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PACK_FILE_DIR and *SHARD_PATH to the packed and the non-packed
+ * directory, respectively, of SHARD within DIR.  Allocate them in POOL.
+ */
+static void
+get_shard_paths(const char **pack_file_dir,
+                const char **shard_path,
+                const char *dir,
+                apr_int64_t shard,
+                apr_pool_t *pool)
+{
+  *pack_file_dir = svn_dirent_join(dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  pool);
+  *shard_path = svn_dirent_join(dir,
+                           apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
+                           pool);
+}
+
+/* In the file system FS, make SHARD in REVPROPS_DIR containing exactly
+ * MAX_FILES_PER_DIR revisions use its pack files.  The revision pack file
+ * must already have been built.  Pack the revprops of that shard and
+ * update the min-unpacked-rev file accordingly.  Use POOL for allocations.
+ *
+ * REVPROPS_DIR will be NULL if revprop packing is not supported.
+ * COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that case.
+ *
+ * Revprops may be modified at any time, so this requires the FS write lock.
+ */
+static svn_error_t *
+switch_to_packed_shard(const char *revsprops_dir,
+                       svn_fs_t *fs,
+                       apr_int64_t shard,
+                       int max_files_per_dir,
+                       apr_off_t max_pack_size,
+                       int compression_level,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *revprops_shard_path, *revprops_pack_file_dir;
+
+  /* if enabled, pack the revprops in an equivalent way */
+  if (revsprops_dir)
+    {
+      get_shard_paths(&revprops_pack_file_dir, &revprops_shard_path,
+                      revsprops_dir, shard, pool);
+
+      SVN_ERR(svn_fs_fs__pack_revprops_shard(revprops_pack_file_dir,
+                                             revprops_shard_path,
+                                             shard, max_files_per_dir,
+                                             (int)(0.9 * max_pack_size),
+                                             compression_level,
+                                             cancel_func, cancel_baton,
+                                             pool));
+    }
+
+  /* Update the min-unpacked-rev file to reflect our newly packed shard. */
+  SVN_ERR(svn_fs_fs__write_min_unpacked_rev(fs,
+                          (svn_revnum_t)((shard + 1) * max_files_per_dir),
+                          pool));
+  ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the non-packed directories of SHARD containing exactly
+ * MAX_FILES_PER_DIR revisions from REVS_DIR and REVPROPS_DIR after
+ * switch_to_packed_shard() has been called for it.  For revprops, clean
+ * up older obsolete shards as well as they might have been left over from
+ * an interrupted FS upgrade.  REVPROPS_DIR will be NULL if revprop packing
+ * is not supported.  Use POOL for allocations.
+ *
+ * Readers will retry with the pack file if the non-packed revision file
+ * they are looking for has disappeared, so this does not require the FS
+ * write lock.
+ */
+static svn_error_t *
+remove_unpacked_shard(const char *revs_dir,
+                      const char *revsprops_dir,
+                      apr_int64_t shard,
+                      int max_files_per_dir,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *pool)
+{
+  const char *rev_shard_path, *rev_pack_file_dir;
+  const char *revprops_shard_path, *revprops_pack_file_dir;
+
+  get_shard_paths(&rev_pack_file_dir, &rev_shard_path, revs_dir, shard,
+                  pool);
+  SVN_ERR(svn_io_remove_dir2(rev_shard_path, TRUE,
+                             cancel_func, cancel_baton, pool));
+  if (revsprops_dir)
+    {
+      svn_node_kind_t kind = svn_node_dir;
+      apr_int64_t to_cleanup = shard;
+
+      get_shard_paths(&revprops_pack_file_dir, &revprops_shard_path,
+                      revsprops_dir, shard, pool);
+      do
+        {
+          SVN_ERR(svn_fs_fs__delete_revprops_shard(revprops_shard_path,
+                                                   to_cleanup,
+                                                   max_files_per_dir,
+                                                   cancel_func,
+                                                   cancel_baton,
+                                                   pool));
+
+          /* If the previous shard exists, clean it up as well.
+             Don't try to clean up shard 0 as it we can't tell quickly
+             whether it actually needs cleaning up. */
+          revprops_shard_path = svn_dirent_join(revsprops_dir,
+                      apr_psprintf(pool, "%" APR_INT64_T_FMT, --to_cleanup),
+                      pool);
+          SVN_ERR(svn_io_check_path(revprops_shard_path, &kind, pool));
+        }
+      while (kind == svn_node_dir && to_cleanup > 0);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* In the file system at FS_PATH, pack the SHARD in REVS_DIR and
+ * REVPROPS_DIR containing exactly MAX_FILES_PER_DIR revisions, using POOL
+ * for allocations.  REVPROPS_DIR will be NULL if revprop packing is not
+ * supported.  COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that
+ * case.
+ *
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are; similarly
+ * NOTIFY_FUNC and NOTIFY_BATON.
+ *
+ * If for some reason we detect a partial packing already performed, we
+ * remove the pack file and start again.
+ */
+static svn_error_t *
+pack_shard(const char *revs_dir,
+           const char *revsprops_dir,
+           svn_fs_t *fs,
+           apr_int64_t shard,
+           int max_files_per_dir,
+           apr_off_t max_pack_size,
+           int compression_level,
+           svn_fs_pack_notify_t notify_func,
+           void *notify_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *pool)
+{
+  const char *rev_shard_path, *rev_pack_file_dir;
+
+  /* Notify caller we're starting to pack this shard. */
+  if (notify_func)
+    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
+                        pool));
+
+  /* Some useful paths. */
+  get_shard_paths(&rev_pack_file_dir, &rev_shard_path, revs_dir, shard,
+                  pool);
+
+  /* pack the revision content */
+  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
+                         shard, max_files_per_dir, PACK_MAX_MEM,
+                         cancel_func, cancel_baton, pool));
+
+  /* pack the revprops and make readers use the new pack files */
+  SVN_ERR(switch_to_packed_shard(revsprops_dir, fs, shard,
+                                 max_files_per_dir, max_pack_size,
+                                 compression_level,
+                                 cancel_func, cancel_baton, pool));
+
+  /* Finally, remove the existing shard directories. */
+  SVN_ERR(remove_unpacked_shard(revs_dir, revsprops_dir, shard,
+                                max_files_per_dir,
+                                cancel_func, cancel_baton, pool));
+
+  /* Notify caller we're starting to pack this shard. */
+  if (notify_func)
+    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_end,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+struct pack_baton
+{
+  svn_fs_t *fs;
+  int jobs;
+  svn_fs_pack_notify_t notify_func;
+  void *notify_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Set *FIRST_SHARD and *END_SHARD to the range of shards in FS that are
+ * complete but have not been packed, yet.  If there is nothing to pack,
+ * *FIRST_SHARD will be equal to *END_SHARD.  Use POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+get_shards_to_pack(apr_int64_t *first_shard,
+                   apr_int64_t *end_shard,
+                   svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+
+  /* If the repository isn't a new enough format, we don't support packing.
+     Return a friendly error to that effect. */
+  if (ffd->format < SVN_FS_FS__MIN_PACKED_FORMAT)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+      _("FSFS format (%d) too old to pack; please upgrade the filesystem."),
+      ffd->format);
+
+  /* If we aren't using sharding, we can't do any packing, so quit. */
+  if (!ffd->max_files_per_dir)
+    {
+      *first_shard = 0;
+      *end_shard = 0;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, fs,
+                                           pool));
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, pool));
+  *first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  *end_shard = (youngest + 1) / ffd->max_files_per_dir;
+
+  return SVN_NO_ERROR;
+}
+
+/* The work-horse for svn_fs_fs__pack, called with the FS write lock.
+   This implements the svn_fs_fs__with_write_lock() 'body' callback
+   type.  BATON is a 'struct pack_baton *'.
+
+   WARNING: if you add a call to this function, please note:
+     The code currently assumes that any piece of code running with
+     the write-lock set can rely on the ffd->min_unpacked_rev and
+     ffd->min_unpacked_revprop caches to be up-to-date (and, by
+     extension, on not having to use a retry when calling
+     svn_fs_fs__path_rev_absolute() and friends).  If you add a call
+     to this function, consider whether you have to call
+     svn_fs_fs__update_min_unpacked_rev().
+     See this thread: http://thread.gmane.org/1291206765.3782.3309.camel@edith
+ */
+static svn_error_t *
+pack_body(void *baton,
+          apr_pool_t *pool)
+{
+  struct pack_baton *pb = baton;
+  fs_fs_data_t *ffd = pb->fs->fsap_data;
+  apr_int64_t first_shard, end_shard;
+  apr_int64_t i;
+  apr_pool_t *iterpool;
+  const char *rev_data_path;
+  const char *revprops_data_path = NULL;
+
+  /* See if we've already completed all possible shards thus far. */
+  SVN_ERR(get_shards_to_pack(&first_shard, &end_shard, pb->fs, pool));
+  if (first_shard >= end_shard)
+    return SVN_NO_ERROR;
+
+  rev_data_path = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    revprops_data_path = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
+                                         pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = first_shard; i < end_shard; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      if (pb->cancel_func)
+        SVN_ERR(pb->cancel_func(pb->cancel_baton));
+
+      SVN_ERR(pack_shard(rev_data_path, revprops_data_path,
                          pb->fs, i, ffd->max_files_per_dir,
                          ffd->revprop_pack_size,
                          ffd->compress_packed_revprops
@@ -473,8 +1879,349 @@ pack_body(void *baton,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Outcome of building the revision pack file for a single shard in a
+   worker thread. */
+typedef struct pack_result_t
+{
+  /* Error returned by pack_rev_shard, if any. */
+  svn_error_t *err;
+
+  /* Set once the pack file has been built. */
+  svn_boolean_t done;
+} pack_result_t;
+
+/* State shared between the thread calling svn_fs_fs__pack and its
+   worker threads.  Unless noted otherwise, all members are protected by
+   MUTEX. */
+typedef struct pack_jobs_t
+{
+  /* Location and size of the shards.  Read-only. */
+  const char *revs_dir;
+  int max_files_per_dir;
+
+  /* Shards to pack are FIRST_SHARD up to but not including END_SHARD.
+     Read-only. */
+  apr_int64_t first_shard;
+  apr_int64_t end_shard;
+
+  /* Cancellation support.  Read-only. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Next shard to hand out to a worker. */
+  apr_int64_t next_shard;
+
+  /* Oldest shard that has not been switched to its pack file, yet. */
+  apr_int64_t first_pending;
+
+  /* Number of shards that may be in progress or waiting to be switched
+     at any given time.  Read-only. */
+  int window_size;
+
+  /* If set, workers must not pick up any further shards. */
+  svn_boolean_t stop;
+
+  /* Number of workers still running. */
+  int active_workers;
+
+  /* One result per shard, indexed by shard - FIRST_SHARD. */
+  pack_result_t *results;
+
+  /* Serializes access to the above and signals any change in state. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} pack_jobs_t;
+
+/* Per-thread data of a pack worker. */
+typedef struct pack_worker_t
+{
+  /* Shared state. */
+  pack_jobs_t *jobs;
+
+  /* FS object to be used by this thread only. */
+  svn_fs_t *fs;
+
+  /* Root pool containing FS. */
+  apr_pool_t *pool;
+} pack_worker_t;
+
+/* Worker thread function.  Build the revision pack files for the shards
+   handed out by the pack_jobs_t in the pack_worker_t DATA until there
+   are no more left. */
+static void * APR_THREAD_FUNC
+pack_worker(apr_thread_t *tid, void *data)
+{
+  pack_worker_t *worker = data;
+  pack_jobs_t *jobs = worker->jobs;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  apr_thread_mutex_lock(jobs->mutex);
+  while (!jobs->stop && jobs->next_shard < jobs->end_shard)
+    {
+      apr_int64_t shard;
+      pack_result_t *result;
+      const char *rev_shard_path, *rev_pack_file_dir;
+      svn_error_t *err;
+
+      /* Don't get too far ahead of the shards switched so far.  Every
+         shard waiting to be switched takes up disk space twice. */
+      if (jobs->next_shard - jobs->first_pending >= jobs->window_size)
+        {
+          apr_thread_cond_wait(jobs->changed, jobs->mutex);
+          continue;
+        }
+
+      shard = jobs->next_shard++;
+      result = &jobs->results[shard - jobs->first_shard];
+      apr_thread_mutex_unlock(jobs->mutex);
+
+      svn_pool_clear(iterpool);
+      get_shard_paths(&rev_pack_file_dir, &rev_shard_path, jobs->revs_dir,
+                      shard, iterpool);
+      err = pack_rev_shard(worker->fs, rev_pack_file_dir, rev_shard_path,
+                           shard, jobs->max_files_per_dir, PACK_MAX_MEM,
+                           jobs->cancel_func, jobs->cancel_baton,
+                           iterpool);
+
+      apr_thread_mutex_lock(jobs->mutex);
+      result->err = err;
+      result->done = TRUE;
+      apr_thread_cond_broadcast(jobs->changed);
+    }
+
+  --jobs->active_workers;
+  apr_thread_cond_broadcast(jobs->changed);
+  apr_thread_mutex_unlock(jobs->mutex);
+
+  svn_pool_destroy(iterpool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Baton type for switch_shard_body. */
+struct switch_shard_baton
+{
+  svn_fs_t *fs;
+  const char *revprops_dir;
+  apr_int64_t shard;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Call switch_to_packed_shard for the shard given in the
+   'struct switch_shard_baton *' BATON.  This implements the
+   svn_fs_fs__with_write_lock() 'body' callback type. */
+static svn_error_t *
+switch_shard_body(void *baton,
+                  apr_pool_t *pool)
+{
+  struct switch_shard_baton *sb = baton;
+  fs_fs_data_t *ffd = sb->fs->fsap_data;
+
+  return svn_error_trace(switch_to_packed_shard(sb->revprops_dir, sb->fs,
+                            sb->shard, ffd->max_files_per_dir,
+                            ffd->revprop_pack_size,
+                            ffd->compress_packed_revprops
+                              ? SVN__COMPRESSION_ZLIB_DEFAULT
+                              : SVN__COMPRESSION_NONE,
+                            sb->cancel_func, sb->cancel_baton, pool));
+}
+
+/* Like pack_body but build the revision pack files of up to PB->JOBS
+   shards concurrently in worker threads.  Only the switch from the
+   non-packed to the packed shard is done under the FS write lock, one
+   shard at a time and in shard order.  Notifications are being sent
+   from the calling thread only.  This implements the
+   svn_fs_fs__with_pack_lock() 'body' callback type.  BATON is a
+   'struct pack_baton *'.
+ */
+static svn_error_t *
+pack_concurrently_body(void *baton,
+                       apr_pool_t *pool)
+{
+  struct pack_baton *pb = baton;
+  fs_fs_data_t *ffd = pb->fs->fsap_data;
+  pack_jobs_t jobs = { 0 };
+  pack_worker_t *workers;
+  apr_thread_t **threads;
+  struct switch_shard_baton sb = { 0 };
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  apr_int64_t shard_count;
+  apr_int64_t shard;
+  int job_count = pb->jobs;
+  int thread_count = 0;
+  int i;
+
+  /* Revision contents are immutable and we hold the pack lock.  Hence,
+     the range of shards to pack can't change while we are building the
+     pack files. */
+  SVN_ERR(get_shards_to_pack(&jobs.first_shard, &jobs.end_shard, pb->fs,
+                             pool));
+  shard_count = jobs.end_shard - jobs.first_shard;
+  if (shard_count <= 0)
+    return SVN_NO_ERROR;
+
+  if (job_count > shard_count)
+    job_count = (int)shard_count;
+
+  jobs.revs_dir = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
+  jobs.max_files_per_dir = ffd->max_files_per_dir;
+  jobs.cancel_func = pb->cancel_func;
+  jobs.cancel_baton = pb->cancel_baton;
+  jobs.next_shard = jobs.first_shard;
+  jobs.first_pending = jobs.first_shard;
+  jobs.window_size = job_count;
+  jobs.results = apr_pcalloc(pool, shard_count * sizeof(*jobs.results));
+
+  sb.fs = pb->fs;
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    sb.revprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
+                                      pool);
+  sb.cancel_func = pb->cancel_func;
+  sb.cancel_baton = pb->cancel_baton;
+
+  status = apr_thread_mutex_create(&jobs.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&jobs.changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create pack lock"));
+
+  /* FS objects are not thread-safe.  Give each worker its own one. */
+  workers = apr_pcalloc(pool, job_count * sizeof(*workers));
+  for (i = 0; !err && i < job_count; ++i)
+    {
+      workers[i].jobs = &jobs;
+      workers[i].pool = svn_pool_create(NULL);
+      err = svn_fs_fs__open_clone(&workers[i].fs, pb->fs, workers[i].pool);
+    }
+
+  /* Start the workers. */
+  threads = apr_pcalloc(pool, job_count * sizeof(*threads));
+  apr_thread_mutex_lock(jobs.mutex);
+  for (i = 0; !err && i < job_count; ++i)
+    {
+      status = apr_thread_create(&threads[i], NULL, pack_worker,
+                                 &workers[i], pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create pack thread"));
+          jobs.stop = TRUE;
+          break;
+        }
+
+      ++thread_count;
+      ++jobs.active_workers;
+    }
+  apr_thread_mutex_unlock(jobs.mutex);
+
+  /* Switch shards in order as soon as their pack files are complete. */
+  iterpool = svn_pool_create(pool);
+  for (shard = jobs.first_shard; !err && shard < jobs.end_shard; ++shard)
+    {
+      pack_result_t *result = &jobs.results[shard - jobs.first_shard];
+      svn_boolean_t done;
+
+      svn_pool_clear(iterpool);
+
+      if (pb->cancel_func)
+        {
+          err = pb->cancel_func(pb->cancel_baton);
+          if (err)
+            break;
+        }
+
+      /* Notify caller we're starting to pack this shard. */
+      if (pb->notify_func)
+        {
+          err = pb->notify_func(pb->notify_baton, shard,
+                                svn_fs_pack_notify_start, iterpool);
+          if (err)
+            break;
+        }
+
+      apr_thread_mutex_lock(jobs.mutex);
+      while (!result->done && jobs.active_workers > 0)
+        apr_thread_cond_wait(jobs.changed, jobs.mutex);
+      done = result->done;
+      apr_thread_mutex_unlock(jobs.mutex);
+
+      /* All workers quit prematurely? */
+      if (!done)
+        break;
+
+      if (result->err)
+        {
+          err = result->err;
+          result->err = SVN_NO_ERROR;
+          break;
+        }
+
+      sb.shard = shard;
+      err = svn_fs_fs__with_write_lock(pb->fs, switch_shard_body, &sb,
+                                       iterpool);
+      if (!err)
+        err = remove_unpacked_shard(jobs.revs_dir, sb.revprops_dir, shard,
+                                    ffd->max_files_per_dir,
+                                    pb->cancel_func, pb->cancel_baton,
+                                    iterpool);
+      if (!err && pb->notify_func)
+        err = pb->notify_func(pb->notify_baton, shard,
+                              svn_fs_pack_notify_end, iterpool);
+
+      apr_thread_mutex_lock(jobs.mutex);
+      jobs.first_pending = shard + 1;
+      apr_thread_cond_broadcast(jobs.changed);
+      apr_thread_mutex_unlock(jobs.mutex);
+    }
+
+  /* Stop and wait for all workers. */
+  apr_thread_mutex_lock(jobs.mutex);
+  jobs.stop = TRUE;
+  apr_thread_cond_broadcast(jobs.changed);
+  apr_thread_mutex_unlock(jobs.mutex);
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+
+  /* Pack files that have been built but not switched to will simply be
+     rebuilt by the next pack run. */
+  for (shard = 0; shard < shard_count; ++shard)
+    svn_error_clear(jobs.results[shard].err);
+
+  for (i = 0; i < job_count; ++i)
+    if (workers[i].pool)
+      svn_pool_destroy(workers[i].pool);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Run pack_body with the FS write lock held.  This implements the
+   svn_fs_fs__with_pack_lock() 'body' callback type.  BATON is a
+   'struct pack_baton *'. */
+static svn_error_t *
+pack_serially_body(void *baton,
+                   apr_pool_t *pool)
+{
+  struct pack_baton *pb = baton;
+  return svn_fs_fs__with_write_lock(pb->fs, pack_body, pb, pool);
+}
+
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -483,9 +2230,21 @@ svn_fs_fs__pack(svn_fs_t *fs,
 {
   struct pack_baton pb = { 0 };
   pb.fs = fs;
+  pb.jobs = jobs;
   pb.notify_func = notify_func;
   pb.notify_baton = notify_baton;
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
-  return svn_fs_fs__with_write_lock(fs, pack_body, &pb, pool);
+
+  /* Worker threads would share the global cache.  That requires it to be
+     thread-safe. */
+  if (svn_cache_config_get()->single_threaded)
+    pb.jobs = 1;
+
+#if APR_HAS_THREADS
+  if (pb.jobs > 1)
+    return svn_fs_fs__with_pack_lock(fs, pack_concurrently_body, &pb, pool);
+#endif
+
+  return svn_fs_fs__with_pack_lock(fs, pack_serially_body, &pb, pool);
 }
@@ -30,9 +30,15 @@
    If given, NOTIFY_FUNC will be called with NOTIFY_BATON to report progress.
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
 
+   If JOBS is larger than 1 and the caches are thread-safe, build the pack
+   files for up to JOBS shards concurrently.  The FS write lock will then
+   only be taken briefly for each shard to pack its revprops and to bump
+   min-unpacked-rev.
+
    Existing filesystem references need not change.  */
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -52,6 +52,15 @@ WHERE revision >= ?1 AND revision <= ?2
 SELECT MAX(revision)
 FROM rep_cache
 
+-- STMT_GET_MAX_ROWID
+SELECT MAX(rowid)
+FROM rep_cache
+
+-- STMT_GET_HASHES_AFTER_ROWID
+SELECT rowid, hash
+FROM rep_cache
+WHERE rowid > ?1
+
 -- STMT_DEL_REPS_YOUNGER_THAN_REV
 DELETE FROM rep_cache
 WHERE revision > ?1
@@ -64,6 +64,248 @@ rep_has_been_born(representation_t *rep,
 }
 
 
+
+/** The rep-cache filter.
+ *
+ * Most contents being written is new, i.e. looking it up in the rep-cache
+ * is wasted effort.  This is expensive for large commits and when loading
+ * dump files.  Therefore, once we made enough lookups through the same FS
+ * object, we keep a Bloom filter of all keys in the rep-cache and use it
+ * to skip lookups that are certain to fail.
+ *
+ * The filter gets updated incrementally, based on the SQLite ROWID, every
+ * time we notice a change in the youngest revision.  Entries added by
+ * concurrent commits may therefore be missing for a while.  That only
+ * means that some contents won't be shared, which is never a correctness
+ * issue.
+ */
+
+/* Number of lookups through the same FS object before we consider
+   creating a filter, and the interval between further attempts. */
+#define FILTER_MIN_LOOKUPS 1024
+
+/* Only create a filter if the rep-cache contains no more than this many
+   entries per lookup made so far.  Otherwise, reading all keys would be
+   more expensive than the lookups that we might save. */
+#define FILTER_MAX_ENTRIES_PER_LOOKUP 16
+
+/* Number of filter bits per key and number of bits to test per key.
+   With these values, about 1 in 400 lookups of new contents will still
+   hit the database. */
+#define FILTER_BITS_PER_ENTRY 16
+#define FILTER_PROBES 4
+
+/* Minimum and maximum size of the filter in bits.  Powers of 2. */
+#define FILTER_MIN_BITS 0x10000
+#define FILTER_MAX_BITS 0x10000000
+
+/* A Bloom filter over the SHA1 keys in the rep-cache. */
+typedef struct rep_cache_filter_t
+{
+  /* The bit array. */
+  unsigned char *bits;
+
+  /* Number of bits in BITS minus 1. */
+  apr_uint32_t mask;
+
+  /* Number of keys added to BITS. */
+  apr_int64_t count;
+
+  /* Highest ROWID added to the filter so far. */
+  apr_int64_t last_rowid;
+
+  /* Youngest revision in FS when we last updated the filter. */
+  svn_revnum_t youngest;
+
+  /* Pool containing this structure. */
+  apr_pool_t *pool;
+} rep_cache_filter_t;
+
+/* Return the bit number for the PROBE'th test of the SHA1 DIGEST in
+   FILTER.  DIGEST is the output of a cryptographic hash function, i.e.
+   we can use its bytes as bit numbers directly. */
+static APR_INLINE apr_uint32_t
+filter_bit(const rep_cache_filter_t *filter,
+           const unsigned char *digest,
+           int probe)
+{
+  const unsigned char *p = digest + 4 * probe;
+  apr_uint32_t value = ((apr_uint32_t)p[0] << 24)
+                     + ((apr_uint32_t)p[1] << 16)
+                     + ((apr_uint32_t)p[2] << 8)
+                     + p[3];
+
+  return value & filter->mask;
+}
+
+/* Add the SHA1 DIGEST to FILTER. */
+static void
+filter_add(rep_cache_filter_t *filter,
+           const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_PROBES; ++i)
+    {
+      apr_uint32_t bit = filter_bit(filter, digest, i);
+      filter->bits[bit / 8] |= (unsigned char)(1 << (bit % 8));
+    }
+
+  ++filter->count;
+}
+
+/* Return FALSE, if the SHA1 DIGEST has certainly not been added to
+   FILTER. */
+static svn_boolean_t
+filter_may_contain(const rep_cache_filter_t *filter,
+                   const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_PROBES; ++i)
+    {
+      apr_uint32_t bit = filter_bit(filter, digest, i);
+      if ((filter->bits[bit / 8] & (1 << (bit % 8))) == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Return a new, empty filter large enough for ENTRIES keys.  Allocate it
+   in a sub-pool of FS->POOL. */
+static rep_cache_filter_t *
+create_filter(svn_fs_t *fs,
+              apr_int64_t entries)
+{
+  apr_pool_t *pool = svn_pool_create(fs->pool);
+  rep_cache_filter_t *filter = apr_pcalloc(pool, sizeof(*filter));
+  apr_uint32_t size = FILTER_MIN_BITS;
+
+  while (size < FILTER_MAX_BITS && size < entries * FILTER_BITS_PER_ENTRY)
+    size *= 2;
+
+  filter->bits = apr_pcalloc(pool, size / 8);
+  filter->mask = size - 1;
+  filter->youngest = SVN_INVALID_REVNUM;
+  filter->pool = pool;
+
+  return filter;
+}
+
+/* Add all keys to FILTER that have been added to the rep-cache in FS
+   since the last call.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+fill_filter(rep_cache_filter_t *filter,
+            svn_fs_t *fs,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int iterations = 0;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_HASHES_AFTER_ROWID));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, filter->last_rowid));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      apr_int64_t rowid;
+      const char *sha1_digest;
+      svn_checksum_t *checksum;
+      svn_error_t *err;
+
+      if (iterations++ % 1024 == 0)
+        svn_pool_clear(iterpool);
+
+      rowid = svn_sqlite__column_int64(stmt, 0);
+      sha1_digest = svn_sqlite__column_text(stmt, 1, iterpool);
+
+      /* Ignore keys that we can't parse.  We would never look them up. */
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   sha1_digest, iterpool);
+      if (err)
+        svn_error_clear(err);
+      else if (checksum)
+        filter_add(filter, checksum->digest);
+
+      if (rowid > filter->last_rowid)
+        filter->last_rowid = rowid;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Create, update or rebuild the rep-cache filter in FS as necessary.
+   Count this as another lookup.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+update_filter(svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_cache_filter_t *filter = ffd->rep_cache_filter;
+  svn_error_t *err;
+
+  if (filter == NULL)
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+      apr_int64_t max_rowid;
+
+      if (++ffd->rep_cache_lookups % FILTER_MIN_LOOKUPS)
+        return SVN_NO_ERROR;
+
+      /* The ROWID is a cheap upper limit to the number of entries. */
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                        STMT_GET_MAX_ROWID));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      max_rowid = svn_sqlite__column_int64(stmt, 0);
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (max_rowid > ffd->rep_cache_lookups * FILTER_MAX_ENTRIES_PER_LOOKUP)
+        return SVN_NO_ERROR;
+
+      filter = create_filter(fs, max_rowid);
+    }
+  else if (filter->youngest == ffd->youngest_rev_cache)
+    {
+      return SVN_NO_ERROR;
+    }
+  else if (   filter->count * FILTER_BITS_PER_ENTRY > 2 * (filter->mask + 1.0)
+           && filter->mask + 1 < FILTER_MAX_BITS)
+    {
+      /* The filter is getting too crowded to be effective.  Start over
+         with a larger one. */
+      apr_int64_t count = filter->count;
+
+      svn_pool_destroy(filter->pool);
+      ffd->rep_cache_filter = NULL;
+      filter = create_filter(fs, 2 * count);
+    }
+
+  err = fill_filter(filter, fs, scratch_pool);
+  if (err)
+    {
+      /* An incomplete filter would give false negatives. */
+      svn_pool_destroy(filter->pool);
+      ffd->rep_cache_filter = NULL;
+      return svn_error_trace(err);
+    }
+
+  filter->youngest = ffd->youngest_rev_cache;
+  ffd->rep_cache_filter = filter;
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /** Library-private API's. **/
 
@@ -223,29 +465,17 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
 }
 
 
-/* This function's caller ignores most errors it returns.
-   If you extend this function, check the callsite to see if you have
-   to make it not-ignore additional error codes.  */
-svn_error_t *
-svn_fs_fs__get_rep_reference(representation_t **rep,
-                             svn_fs_t *fs,
-                             svn_checksum_t *checksum,
-                             apr_pool_t *pool)
+/* Implement svn_fs_fs__get_rep_reference without consulting the filter. */
+static svn_error_t *
+lookup_rep_reference(representation_t **rep,
+                     svn_fs_t *fs,
+                     svn_checksum_t *checksum,
+                     apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
 
-  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
-  if (! ffd->rep_cache_db)
-    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-
-  /* We only allow SHA1 checksums in this table. */
-  if (checksum->kind != svn_checksum_sha1)
-    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
-                            _("Only SHA1 checksums can be used as keys in the "
-                              "rep_cache table.\n"));
-
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -274,6 +504,39 @@ svn_fs_fs__get_rep_reference(representation_t **rep,
   return SVN_NO_ERROR;
 }
 
+/* This function's caller ignores most errors it returns.
+   If you extend this function, check the callsite to see if you have
+   to make it not-ignore additional error codes.  */
+svn_error_t *
+svn_fs_fs__get_rep_reference(representation_t **rep,
+                             svn_fs_t *fs,
+                             svn_checksum_t *checksum,
+                             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+  /* We only allow SHA1 checksums in this table. */
+  if (checksum->kind != svn_checksum_sha1)
+    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
+                            _("Only SHA1 checksums can be used as keys in the "
+                              "rep_cache table.\n"));
+
+  /* New contents is the common case.  Don't bother the DB with it. */
+  SVN_ERR(update_filter(fs, pool));
+  if (   ffd->rep_cache_filter
+      && !filter_may_contain(ffd->rep_cache_filter, checksum->digest))
+    {
+      *rep = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(lookup_rep_reference(rep, fs, checksum, pool));
+}
+
 svn_error_t *
 svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
@@ -319,7 +582,7 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
          should exist.  If so, and the value is the same one we were
          about to write, that's cool -- just do nothing.  If, however,
          the value is *different*, that's a red flag!  */
-      SVN_ERR(svn_fs_fs__get_rep_reference(&old_rep, fs, &checksum, pool));
+      SVN_ERR(lookup_rep_reference(&old_rep, fs, &checksum, pool));
 
       if (old_rep)
         {
@@ -354,6 +617,52 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Body of svn_fs_fs__set_rep_references.  Set all reps in REPS in FS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+set_rep_references(svn_fs_t *fs,
+                   const apr_array_header_t *reps,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < reps->nelts; i++)
+    {
+      representation_t *rep = APR_ARRAY_IDX(reps, i, representation_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* FALSE because we don't care if another parallel commit happened to
+       * collide with us.  (Non-parallel collisions will not be detected.) */
+      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, FALSE, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+  /* We use an sqlite transaction to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>.
+   */
+  SVN_SQLITE__WITH_TXN(set_rep_references(fs, reps, pool),
+                       ffd->rep_cache_db);
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_fs_fs__del_rep_reference(svn_fs_t *fs,
@@ -81,6 +81,15 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              svn_boolean_t reject_dup,
                              apr_pool_t *pool);
 
+/* Set all representations in REPS in FS, as svn_fs_fs__set_rep_reference
+   with REJECT_DUP set to FALSE would do, but using a single database
+   transaction.  Elements of REPS are representation_t *.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
@@ -30,11 +30,13 @@
 #include "svn_sorts.h"
 #include "svn_time.h"
 #include "svn_dirent_uri.h"
+#include "svn_cache_config.h"
 
 #include "fs_fs.h"
 #include "tree.h"
 #include "util.h"
 #include "id.h"
+#include "index.h"
 #include "low_level.h"
 #include "temp_serializer.h"
 #include "cached_data.h"
@@ -1562,6 +1564,112 @@ svn_fs_fs__add_change(svn_fs_t *fs,
   return svn_io_file_close(file, pool);
 }
 
+/* If it is supported by the format of file system FS, store the (ITEM_INDEX,
+ * OFFSET) pair in the log-to-phys proto index file of transaction TXN_ID.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+store_l2p_index_entry(svn_fs_t *fs,
+                      const svn_fs_fs__id_part_t *txn_id,
+                      apr_off_t offset,
+                      apr_uint64_t item_index,
+                      apr_pool_t *pool)
+{
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      const char *path = svn_fs_fs__path_l2p_proto_index(fs, txn_id, pool);
+      apr_file_t *file;
+      SVN_ERR(svn_fs_fs__l2p_proto_index_open(&file, path, pool));
+      SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry(file, offset,
+                                                   item_index, pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* If it is supported by the format of file system FS, store ENTRY in the
+ * phys-to-log proto index file of transaction TXN_ID.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+store_p2l_index_entry(svn_fs_t *fs,
+                      const svn_fs_fs__id_part_t *txn_id,
+                      svn_fs_fs__p2l_entry_t *entry,
+                      apr_pool_t *pool)
+{
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      const char *path = svn_fs_fs__path_p2l_proto_index(fs, txn_id, pool);
+      apr_file_t *file;
+      SVN_ERR(svn_fs_fs__p2l_proto_index_open(&file, path, pool));
+      SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(file, entry, pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Allocate an item index for the given MY_OFFSET in the transaction TXN_ID
+ * of file system FS and return it in *ITEM_INDEX.  For physical addressing,
+ * it will simply return the offset as item index; with logical addressing,
+ * it will increment the txn's item index counter file and store the mapping
+ * in the proto index file.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+allocate_item_index(apr_uint64_t *item_index,
+                    svn_fs_t *fs,
+                    const svn_fs_fs__id_part_t *txn_id,
+                    apr_off_t my_offset,
+                    apr_pool_t *pool)
+{
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      apr_file_t *file;
+      char buffer[SVN_INT64_BUFFER_SIZE] = { 0 };
+      svn_boolean_t eof = FALSE;
+      apr_size_t to_write;
+      apr_size_t read;
+      apr_off_t offset = 0;
+
+      /* read number, increment it and write it back to disk */
+      SVN_ERR(svn_io_file_open(&file,
+                         svn_fs_fs__path_txn_item_index(fs, txn_id, pool),
+                         APR_READ | APR_WRITE | APR_CREATE | APR_BUFFERED,
+                         APR_OS_DEFAULT, pool));
+      SVN_ERR(svn_io_file_read_full2(file, buffer, sizeof(buffer)-1,
+                                     &read, &eof, pool));
+      if (read)
+        SVN_ERR(svn_cstring_atoui64(item_index, buffer));
+      else
+        *item_index = SVN_FS_FS__ITEM_INDEX_FIRST_USER;
+
+      to_write = svn__ui64toa(buffer, *item_index + 1);
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      SVN_ERR(svn_io_file_write_full(file, buffer, to_write, NULL, pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+
+      /* write log-to-phys index */
+      SVN_ERR(store_l2p_index_entry(fs, txn_id, my_offset, *item_index,
+                                    pool));
+    }
+  else
+    {
+      *item_index = (apr_uint64_t)my_offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Calculating the MD5 and SHA1 checksums takes about as long as
+   deltifying and compressing the contents.  For representations larger
+   than this, we therefore let a separate thread calculate the checksums
+   while the calling thread deltifies.  (The delta must stay in the
+   calling thread as reading the delta base uses the non-thread-safe
+   FS object.) */
+#define DIGEST_PIPELINE_THRESHOLD 0x80000
+
 /* This baton is used by the representation writing streams.  It keeps
    track of the checksum information as well as the total size of the
    representation so far. */
@@ -1598,6 +1706,10 @@ struct rep_write_baton
   svn_checksum_ctx_t *md5_checksum_ctx;
   svn_checksum_ctx_t *sha1_checksum_ctx;
 
+  /* If not NULL, the checksum contexts are being updated through this
+     stream, possibly by a separate thread. */
+  svn_stream_t *digests;
+
   apr_pool_t *pool;
 
   apr_pool_t *parent_pool;
@@ -1613,8 +1725,21 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  /* Large representation?  Then, calculate the checksums in parallel
+     to the delta.  Don't use threads in a process that asked us not to. */
+  if (   !b->digests
+      && b->rep_size + *len > DIGEST_PIPELINE_THRESHOLD
+      && !svn_cache_config_get()->single_threaded)
+    b->digests = svn_checksum__update2_stream(b->md5_checksum_ctx,
+                                              b->sha1_checksum_ctx,
+                                              b->pool);
+
+  if (b->digests)
+    SVN_ERR(svn_stream_write(b->digests, data, len));
+  else
+    SVN_ERR(svn_checksum__update2(b->md5_checksum_ctx,
+                                  b->sha1_checksum_ctx, data, *len));
+
   b->rep_size += *len;
 
   /* If we are writing a delta, use that stream. */
@@ -1784,7 +1909,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_txdelta_window_handler_t wh;
   void *whb;
   fs_fs_data_t *ffd = fs->fsap_data;
-  int diff_version = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+  int diff_version = ffd->delta_svndiff_version;
   svn_fs_fs__rep_header_t header = { 0 };
 
   b = apr_pcalloc(pool, sizeof(*b));
@@ -1982,13 +2107,16 @@ rep_write_contents_close(void *baton)
   apr_off_t offset;
 
   rep = apr_pcalloc(b->parent_pool, sizeof(*rep));
-  rep->offset = b->rep_offset;
 
   /* Close our delta stream so the last bits of svndiff are written
      out. */
   if (b->delta_stream)
     SVN_ERR(svn_stream_close(b->delta_stream));
 
+  /* Wait for the checksum thread to process the remaining data. */
+  if (b->digests)
+    SVN_ERR(svn_stream_close(b->digests));
+
   /* Determine the length of the svndiff data. */
   SVN_ERR(svn_fs_fs__get_file_offset(&offset, b->file, b->pool));
   rep->size = offset - b->delta_start;
@@ -2019,6 +2147,8 @@ rep_write_contents_close(void *baton)
     {
       /* Write out our cosmetic end marker. */
       SVN_ERR(svn_stream_puts(b->rep_stream, "ENDREP\n"));
+      SVN_ERR(allocate_item_index(&rep->offset, b->fs, &rep->txn_id,
+                                  b->rep_offset, b->pool));
 
       b->noderev->data_rep = rep;
     }
@@ -2030,7 +2160,19 @@ rep_write_contents_close(void *baton)
   SVN_ERR(svn_fs_fs__put_node_revision(b->fs, b->noderev->id, b->noderev,
                                        FALSE, b->pool));
   if (!old_rep)
-    SVN_ERR(store_sha1_rep_mapping(b->fs, b->noderev, b->pool));
+    {
+      svn_fs_fs__p2l_entry_t entry;
+
+      entry.offset = b->rep_offset;
+      SVN_ERR(svn_fs_fs__get_file_offset(&offset, b->file, b->pool));
+      entry.size = offset - b->rep_offset;
+      entry.type = SVN_FS_FS__ITEM_TYPE_FILE_REP;
+      entry.item.revision = SVN_INVALID_REVNUM;
+      entry.item.number = rep->offset;
+
+      SVN_ERR(store_sha1_rep_mapping(b->fs, b->noderev, b->pool));
+      SVN_ERR(store_p2l_index_entry(b->fs, &rep->txn_id, &entry, b->pool));
+    }
 
   SVN_ERR(svn_io_file_close(b->file, b->pool));
   SVN_ERR(unlock_proto_rev(b->fs, &rep->txn_id, b->lockcookie, b->pool));
@@ -2204,8 +2346,7 @@ write_hash_handler(void *baton,
 {
   struct write_hash_baton *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__update2(whb->md5_ctx, whb->sha1_ctx, data, *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2219,13 +2360,16 @@ write_hash_handler(void *baton,
    is not NULL, it will be used in addition to the on-disk cache to find
    earlier reps with the same content.  When such existing reps can be
    found, we will truncate the one just written from the file and return
-   the existing rep.  Perform temporary allocations in POOL. */
+   the existing rep.  The new rep is being indexed as an ITEM_TYPE item
+   in transaction TXN_ID.  Perform temporary allocations in POOL. */
 static svn_error_t *
 write_hash_rep(representation_t *rep,
                apr_file_t *file,
                apr_hash_t *hash,
                svn_fs_t *fs,
+               const svn_fs_fs__id_part_t *txn_id,
                apr_hash_t *reps_hash,
+               int item_type,
                apr_pool_t *pool)
 {
   svn_stream_t *stream;
@@ -2266,10 +2410,21 @@ write_hash_rep(representation_t *rep,
     }
   else
     {
+      svn_fs_fs__p2l_entry_t entry;
+
       /* Write out our cosmetic end marker. */
       SVN_ERR(svn_stream_puts(whb->stream, "ENDREP\n"));
 
-      rep->offset = offset;
+      SVN_ERR(allocate_item_index(&rep->offset, fs, txn_id, offset, pool));
+
+      entry.offset = offset;
+      SVN_ERR(svn_fs_fs__get_file_offset(&offset, file, pool));
+      entry.size = offset - entry.offset;
+      entry.type = item_type;
+      entry.item.revision = SVN_INVALID_REVNUM;
+      entry.item.number = rep->offset;
+
+      SVN_ERR(store_p2l_index_entry(fs, txn_id, &entry, pool));
 
       /* update the representation */
       rep->size = whb->size;
@@ -2285,16 +2440,19 @@ write_hash_rep(representation_t *rep,
    is not NULL, it will be used in addition to the on-disk cache to find
    earlier reps with the same content.  When such existing reps can be found,
    we will truncate the one just written from the file and return the existing
-   rep.  If IS_PROPS is set, assume that we want to a props representation as
-   the base for our delta.  Perform temporary allocations in POOL. */
+   rep.  If ITEM_TYPE is IS_PROPS equivalent, assume that we want to a props
+   representation as the base for our delta.  The new rep is being indexed
+   as an ITEM_TYPE item in transaction TXN_ID.  Perform temporary allocations
+   in POOL. */
 static svn_error_t *
 write_hash_delta_rep(representation_t *rep,
                      apr_file_t *file,
                      apr_hash_t *hash,
                      svn_fs_t *fs,
+                     const svn_fs_fs__id_part_t *txn_id,
                      node_revision_t *noderev,
                      apr_hash_t *reps_hash,
-                     svn_boolean_t is_props,
+                     int item_type,
                      apr_pool_t *pool)
 {
   svn_txdelta_window_handler_t diff_wh;
@@ -2313,7 +2471,9 @@ write_hash_delta_rep(representation_t *rep,
 
   struct write_hash_baton *whb;
   fs_fs_data_t *ffd = fs->fsap_data;
-  int diff_version = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+  int diff_version = ffd->delta_svndiff_version;
+  svn_boolean_t is_props = (item_type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
+                        || (item_type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS);
 
   /* Get the base for this delta. */
   SVN_ERR(choose_delta_base(&base_rep, fs, noderev, is_props, pool));
@@ -2376,11 +2536,22 @@ write_hash_delta_rep(representation_t *rep,
     }
   else
     {
+      svn_fs_fs__p2l_entry_t entry;
+
       /* Write out our cosmetic end marker. */
       SVN_ERR(svn_fs_fs__get_file_offset(&rep_end, file, pool));
       SVN_ERR(svn_stream_puts(file_stream, "ENDREP\n"));
 
-      rep->offset = offset;
+      SVN_ERR(allocate_item_index(&rep->offset, fs, txn_id, offset, pool));
+
+      entry.offset = offset;
+      SVN_ERR(svn_fs_fs__get_file_offset(&offset, file, pool));
+      entry.size = offset - entry.offset;
+      entry.type = item_type;
+      entry.item.revision = SVN_INVALID_REVNUM;
+      entry.item.number = rep->offset;
+
+      SVN_ERR(store_p2l_index_entry(fs, txn_id, &entry, pool));
 
       /* update the representation */
       rep->expanded_size = whb->size;
@@ -2519,8 +2690,10 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   node_revision_t *noderev;
   apr_off_t my_offset;
   const svn_fs_id_t *new_id;
-  svn_fs_fs__id_part_t node_id, copy_id, rev_offset;
+  svn_fs_fs__id_part_t node_id, copy_id, rev_item;
   fs_fs_data_t *ffd = fs->fsap_data;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__id_txn_id(id);
+  svn_fs_fs__p2l_entry_t entry;
   *new_id_p = NULL;
 
   /* Check to see if this is a transaction node. */
@@ -2571,11 +2744,13 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
           if (ffd->deltify_directories)
             SVN_ERR(write_hash_delta_rep(noderev->data_rep, file,
-                                         str_entries, fs, noderev, NULL,
-                                         FALSE, pool));
+                                         str_entries, fs, txn_id, noderev,
+                                         NULL, SVN_FS_FS__ITEM_TYPE_DIR_REP,
+                                         pool));
           else
             SVN_ERR(write_hash_rep(noderev->data_rep, file, str_entries,
-                                   fs, NULL, pool));
+                                   fs, txn_id, NULL,
+                                   SVN_FS_FS__ITEM_TYPE_DIR_REP, pool));
         }
     }
   else
@@ -2591,9 +2766,11 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
           /* See issue 3845.  Some unknown mechanism caused the
              protorev file to get truncated, so check for that
-             here.  */
-          if (noderev->data_rep->offset + noderev->data_rep->size
-              > initial_offset)
+             here.  With logical addressing, OFFSET is an item index
+             and this check does not apply. */
+          if (   !svn_fs_fs__use_log_addressing(fs)
+              && noderev->data_rep->offset + noderev->data_rep->size
+                 > initial_offset)
             return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                                     _("Truncated protorev file detected"));
         }
@@ -2603,6 +2780,9 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   if (noderev->prop_rep && is_txn_rep(noderev->prop_rep))
     {
       apr_hash_t *proplist;
+      int item_type = noderev->kind == svn_node_dir
+                    ? SVN_FS_FS__ITEM_TYPE_DIR_PROPS
+                    : SVN_FS_FS__ITEM_TYPE_FILE_PROPS;
       SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev, pool));
 
       reset_txn_in_rep(noderev->prop_rep);
@@ -2610,11 +2790,11 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
       if (ffd->deltify_properties)
         SVN_ERR(write_hash_delta_rep(noderev->prop_rep, file,
-                                     proplist, fs, noderev, reps_hash,
-                                     TRUE, pool));
+                                     proplist, fs, txn_id, noderev,
+                                     reps_hash, item_type, pool));
       else
         SVN_ERR(write_hash_rep(noderev->prop_rep, file, proplist,
-                               fs, reps_hash, pool));
+                               fs, txn_id, reps_hash, item_type, pool));
     }
 
   /* Convert our temporary ID into a permanent revision one. */
@@ -2627,10 +2807,19 @@ write_final_rev(const svn_fs_id_t **new_id_p,
     noderev->copyroot_rev = rev;
 
   SVN_ERR(svn_fs_fs__get_file_offset(&my_offset, file, pool));
-  rev_offset.number = my_offset;
+  if (at_root && svn_fs_fs__use_log_addressing(fs))
+    {
+      /* reference the root noderev from the log-to-phys index */
+      rev_item.number = SVN_FS_FS__ITEM_INDEX_ROOT_NODE;
+      SVN_ERR(store_l2p_index_entry(fs, txn_id, my_offset, rev_item.number,
+                                    pool));
+    }
+  else
+    SVN_ERR(allocate_item_index(&rev_item.number, fs, txn_id, my_offset,
+                                pool));
 
-  rev_offset.revision = rev;
-  new_id = svn_fs_fs__id_rev_create(&node_id, &copy_id, &rev_offset, pool);
+  rev_item.revision = rev;
+  new_id = svn_fs_fs__id_rev_create(&node_id, &copy_id, &rev_item, pool);
 
   noderev->id = new_id;
 
@@ -2681,20 +2870,31 @@ write_final_rev(const svn_fs_id_t **new_id_p,
                                    svn_fs_fs__fs_supports_mergeinfo(fs),
                                    pool));
 
+  /* reference the noderev from the phys-to-log index */
+  entry.offset = my_offset;
+  SVN_ERR(svn_fs_fs__get_file_offset(&my_offset, file, pool));
+  entry.size = my_offset - entry.offset;
+  entry.type = SVN_FS_FS__ITEM_TYPE_NODEREV;
+  entry.item.revision = SVN_INVALID_REVNUM;
+  entry.item.number = rev_item.number;
+
+  SVN_ERR(store_p2l_index_entry(fs, txn_id, &entry, pool));
+
   /* Return our ID that references the revision file. */
   *new_id_p = noderev->id;
 
   return SVN_NO_ERROR;
 }
 
-/* Write the changed path info CHANGED_PATHS to the permanent rev-file FILE
-   representing NEW_REV in filesystem FS.  *OFFSET_P is set the to offset in
-   the file of the beginning of this information.
+/* Write the changed path info CHANGED_PATHS of transaction TXN_ID to the
+   permanent rev-file FILE representing NEW_REV in filesystem FS.  *OFFSET_P
+   is set the to offset in the file of the beginning of this information.
    Perform temporary allocations in POOL. */
 static svn_error_t *
 write_final_changed_path_info(apr_off_t *offset_p,
                               apr_file_t *file,
                               svn_fs_t *fs,
+                              const svn_fs_fs__id_part_t *txn_id,
                               apr_hash_t *changed_paths,
                               svn_revnum_t new_rev,
                               apr_pool_t *pool)
@@ -2724,6 +2924,23 @@ write_final_changed_path_info(apr_off_t *offset_p,
 
   *offset_p = offset;
 
+  /* reference changes from the indexes */
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      svn_fs_fs__p2l_entry_t entry;
+
+      entry.offset = offset;
+      SVN_ERR(svn_fs_fs__get_file_offset(&offset, file, pool));
+      entry.size = offset - entry.offset;
+      entry.type = SVN_FS_FS__ITEM_TYPE_CHANGES;
+      entry.item.revision = SVN_INVALID_REVNUM;
+      entry.item.number = SVN_FS_FS__ITEM_INDEX_CHANGES;
+
+      SVN_ERR(store_p2l_index_entry(fs, txn_id, &entry, pool));
+      SVN_ERR(store_l2p_index_entry(fs, txn_id, entry.offset,
+                                    SVN_FS_FS__ITEM_INDEX_CHANGES, pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -3122,16 +3339,20 @@ commit_body(void *baton, apr_pool_t *pool)
 
   /* Write the changed-path information. */
   SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
-                                        cb->fs, changed_paths, new_rev,
-                                        pool));
+                                        cb->fs, txn_id, changed_paths,
+                                        new_rev, pool));
 
-  /* Write the final line. */
-  trailer = svn_fs_fs__unparse_revision_trailer
-               (svn_fs_fs__id_offset(new_root_id),
-                changed_path_offset,
-                pool);
-  SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
-                                 NULL, pool));
+  /* Write the final line.  Logically addressed revisions locate the root
+     noderev and the changed paths list through the indexes instead. */
+  if (!svn_fs_fs__use_log_addressing(cb->fs))
+    {
+      trailer = svn_fs_fs__unparse_revision_trailer
+                  (svn_fs_fs__id_offset(new_root_id),
+                   changed_path_offset,
+                   pool);
+      SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
+                                     NULL, pool));
+    }
 
   SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
   SVN_ERR(svn_io_file_close(proto_file, pool));
@@ -3197,6 +3418,20 @@ commit_body(void *baton, apr_pool_t *pool)
         }
     }
 
+  /* Convert the index files from the proto format into their form
+     in their final location */
+  if (svn_fs_fs__use_log_addressing(cb->fs))
+    {
+      SVN_ERR(svn_fs_fs__l2p_index_create(cb->fs,
+                      svn_fs_fs__path_l2p_index(cb->fs, new_rev, pool),
+                      svn_fs_fs__path_l2p_proto_index(cb->fs, txn_id, pool),
+                      new_rev, pool));
+      SVN_ERR(svn_fs_fs__p2l_index_create(cb->fs,
+                      svn_fs_fs__path_p2l_index(cb->fs, new_rev, pool),
+                      svn_fs_fs__path_p2l_proto_index(cb->fs, txn_id, pool),
+                      new_rev, pool));
+    }
+
   /* Move the finished rev file into place. */
   old_rev_filename = svn_fs_fs__path_rev_absolute(cb->fs, old_rev, pool);
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
@@ -3250,27 +3485,6 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
-static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
-{
-  int i;
-
-  for (i = 0; i < reps_to_cache->nelts; i++)
-    {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
-
-      /* FALSE because we don't care if another parallel commit happened to
-       * collide with us.  (Non-parallel collisions will not be detected.) */
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, FALSE, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
@@ -3308,17 +3522,11 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
     {
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
+      /* Write new entries to the rep-sharing database. */
       /* ### A commit that touches thousands of files will starve other
              (reader/writer) commits for the duration of the below call.
              Maybe write in batches? */
-      SVN_SQLITE__WITH_TXN(
-        write_reps_to_cache(fs, cb.reps_to_cache, pool),
-        ffd->rep_cache_db);
+      SVN_ERR(svn_fs_fs__set_rep_references(fs, cb.reps_to_cache, pool));
     }
 
   return SVN_NO_ERROR;
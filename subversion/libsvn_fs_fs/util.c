@@ -76,6 +76,13 @@ svn_fs_fs__path_lock(svn_fs_t *fs,
   return svn_dirent_join(fs->path, PATH_LOCK_FILE, pool);
 }
 
+const char *
+svn_fs_fs__path_pack_lock(svn_fs_t *fs,
+                          apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_PACK_LOCK_FILE, pool);
+}
+
 const char *
 svn_fs_fs__path_revprop_generation(svn_fs_t *fs,
                                    apr_pool_t *pool)
@@ -144,6 +151,24 @@ svn_fs_fs__path_rev_absolute(svn_fs_t *fs,
        : svn_fs_fs__path_rev_packed(fs, rev, PATH_PACKED, pool);
 }
 
+const char *
+svn_fs_fs__path_l2p_index(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%s" PATH_EXT_L2P_INDEX,
+                      svn_fs_fs__path_rev_absolute(fs, rev, pool));
+}
+
+const char *
+svn_fs_fs__path_p2l_index(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%s" PATH_EXT_P2L_INDEX,
+                      svn_fs_fs__path_rev_absolute(fs, rev, pool));
+}
+
 const char *
 svn_fs_fs__path_revprops_shard(svn_fs_t *fs,
                                svn_revnum_t rev,
@@ -247,6 +272,33 @@ svn_fs_fs__path_txn_proto_rev_lock(svn_fs_t *fs,
                            PATH_REV_LOCK, pool);
 }
 
+const char *
+svn_fs_fs__path_l2p_proto_index(svn_fs_t *fs,
+                                const svn_fs_fs__id_part_t *txn_id,
+                                apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_txn_dir(fs, txn_id, pool),
+                         PATH_INDEX PATH_EXT_L2P_INDEX, pool);
+}
+
+const char *
+svn_fs_fs__path_p2l_proto_index(svn_fs_t *fs,
+                                const svn_fs_fs__id_part_t *txn_id,
+                                apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_txn_dir(fs, txn_id, pool),
+                         PATH_INDEX PATH_EXT_P2L_INDEX, pool);
+}
+
+const char *
+svn_fs_fs__path_txn_item_index(svn_fs_t *fs,
+                               const svn_fs_fs__id_part_t *txn_id,
+                               apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_txn_dir(fs, txn_id, pool),
+                         PATH_TXN_ITEM_INDEX, pool);
+}
+
 const char *
 svn_fs_fs__path_txn_node_rev(svn_fs_t *fs,
                              const svn_fs_id_t *id,
@@ -295,6 +347,18 @@ svn_fs_fs__path_node_origin(svn_fs_t *fs,
                               buffer, SVN_VA_NULL);
 }
 
+const char *
+svn_fs_fs__path_checkpoint(svn_fs_t *fs,
+                           svn_revnum_t revision,
+                           apr_uint64_t item_index,
+                           apr_pool_t *pool)
+{
+  return svn_dirent_join_many(pool, fs->path, PATH_CHECKPOINTS_DIR,
+                              apr_psprintf(pool, "%ld.%" APR_UINT64_T_FMT,
+                                           revision, item_index),
+                              SVN_VA_NULL);
+}
+
 const char *
 svn_fs_fs__path_min_unpacked_rev(svn_fs_t *fs,
                                  apr_pool_t *pool)
@@ -619,31 +683,18 @@ svn_fs_fs__open_pack_or_rev_file(apr_file_t **file,
   return svn_error_trace(err);
 }
 
-svn_error_t *
-svn_fs_fs__item_offset(apr_off_t *absolute_position,
-                       svn_fs_t *fs,
-                       svn_revnum_t rev,
-                       apr_off_t offset,
-                       apr_pool_t *pool)
+svn_boolean_t
+svn_fs_fs__supports_move(svn_fs_t *fs)
 {
-  if (svn_fs_fs__is_packed_rev(fs, rev))
-    {
-      apr_off_t rev_offset;
-      SVN_ERR(svn_fs_fs__get_packed_offset(&rev_offset, fs, rev, pool));
-      *absolute_position = rev_offset + offset;
-    }
-  else
-    {
-      *absolute_position = offset;
-    }
+  fs_fs_data_t *ffd = fs->fsap_data;
 
-  return SVN_NO_ERROR;
+  return ffd->format >= SVN_FS_FS__MIN_MOVE_SUPPORT_FORMAT;
 }
 
 svn_boolean_t
-svn_fs_fs__supports_move(svn_fs_t *fs)
+svn_fs_fs__use_log_addressing(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
 
-  return ffd->format >= SVN_FS_FS__MIN_MOVE_SUPPORT_FORMAT;
+  return ffd->use_log_addressing;
 }
@@ -123,6 +123,13 @@ const char *
 svn_fs_fs__path_lock(svn_fs_t *fs,
                      apr_pool_t *pool);
 
+/* Return the full path of the pack operation lock file in FS.
+ * The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_pack_lock(svn_fs_t *fs,
+                          apr_pool_t *pool);
+
 /* Return the full path of the revprop generation file in FS.
  * Allocate the result in POOL.
  */
@@ -152,6 +159,24 @@ svn_fs_fs__path_rev_absolute(svn_fs_t *fs,
                              svn_revnum_t rev,
                              apr_pool_t *pool);
 
+/* Return the path of the file containing the log-to-phys index for the
+ * file containing revision REV in FS.  The result will be allocated
+ * in POOL.
+ */
+const char *
+svn_fs_fs__path_l2p_index(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *pool);
+
+/* Return the path of the file containing the phys-to-log index for the
+ * file containing revision REV in FS.  The result will be allocated
+ * in POOL.
+ */
+const char *
+svn_fs_fs__path_p2l_index(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *pool);
+
 /* Return the full path of the revision properties shard directory that
  * will contain the properties of revision REV in FS.
  * Allocate the result in POOL.
@@ -200,6 +225,31 @@ svn_fs_fs__path_txn_proto_rev_lock(svn_fs_t *fs,
                                    const svn_fs_fs__id_part_t *txn_id,
                                    apr_pool_t *pool);
 
+/* Return the path of the file containing the log-to-phys proto index for
+ * transaction TXN_ID in FS.  The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_l2p_proto_index(svn_fs_t *fs,
+                                const svn_fs_fs__id_part_t *txn_id,
+                                apr_pool_t *pool);
+
+/* Return the path of the file containing the phys-to-log proto index for
+ * transaction TXN_ID in FS.  The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_p2l_proto_index(svn_fs_t *fs,
+                                const svn_fs_fs__id_part_t *txn_id,
+                                apr_pool_t *pool);
+
+/* Return the path of the file containing item_index counter for
+ * the transaction identified by TXN_ID in FS.
+ * The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_txn_item_index(svn_fs_t *fs,
+                               const svn_fs_fs__id_part_t *txn_id,
+                               apr_pool_t *pool);
+
 /* Return the path of the file containing the in-transaction node revision
  * identified by ID in FS.  The result will be allocated in POOL.
  */
@@ -233,6 +283,15 @@ svn_fs_fs__path_node_origin(svn_fs_t *fs,
                             const svn_fs_fs__id_part_t *node_id,
                             apr_pool_t *pool);
 
+/* Return the path of the fulltext checkpoint file for the representation
+ * at ITEM_INDEX in REVISION of FS.  The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_checkpoint(svn_fs_t *fs,
+                           svn_revnum_t revision,
+                           apr_uint64_t item_index,
+                           apr_pool_t *pool);
+
 /* Set *MIN_UNPACKED_REV to the integer value read from the file returned
  * by #svn_fs_fs__path_min_unpacked_rev() for FS.
  * Use POOL for temporary allocations.
@@ -352,17 +411,13 @@ svn_fs_fs__open_pack_or_rev_file(apr_file_t **file,
                                  svn_revnum_t rev,
                                  apr_pool_t *pool);
 
-/* For OFFSET within REV in FS, return the position in the respective rev
-   or pack file in *ABSOLUTE_POSITION.  Use POOL for allocations. */
-svn_error_t *
-svn_fs_fs__item_offset(apr_off_t *absolute_position,
-                       svn_fs_t *fs,
-                       svn_revnum_t rev,
-                       apr_off_t offset,
-                       apr_pool_t *pool);
-
 /* Return TRUE if FS's format supports moves to be recorded natively. */
 svn_boolean_t
 svn_fs_fs__supports_move(svn_fs_t *fs);
 
+/* Return TRUE if FS uses logical addressing, i.e. if item offsets in its
+   rev / pack files have to be mapped through the log-to-phys index. */
+svn_boolean_t
+svn_fs_fs__use_log_addressing(svn_fs_t *fs);
+
 #endif
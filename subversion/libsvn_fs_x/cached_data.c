@@ -26,6 +26,7 @@
 
 #include "svn_hash.h"
 #include "svn_ctype.h"
+#include "private/svn_delta_private.h"
 #include "private/svn_temp_serializer.h"
 
 #include "fs_x.h"
@@ -1998,8 +1999,23 @@ svn_fs_x__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 
   /* Because source and target stream will already verify their content,
    * there is no need to do this once more.  In particular if the stream
-   * content is being fetched from cache. */
-  svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
+   * content is being fetched from cache.
+   *
+   * For large sources, index the whole source text such that moved and
+   * shifted content will still be found.  That requires a second pass
+   * over the source contents. */
+  if (source && source->data_rep
+      && source->data_rep->expanded_size
+         >= SVN_DELTA__LARGE_WINDOW_THRESHOLD)
+    {
+      svn_stream_t *index_stream;
+      SVN_ERR(svn_fs_x__get_contents(&index_stream, fs, source->data_rep,
+                                     pool));
+      svn_delta__txdelta_large_window(stream_p, index_stream, source_stream,
+                                      target_stream, FALSE, pool);
+    }
+  else
+    svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
 
   return SVN_NO_ERROR;
 }
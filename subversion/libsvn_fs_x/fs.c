@@ -99,6 +99,10 @@ x_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
       SVN_ERR(svn_mutex__init(&ffsd->fs_write_lock,
                               SVN_FS_X__USE_LOCK_MUTEX, common_pool));
 
+      /* ... the pack lock ... */
+      SVN_ERR(svn_mutex__init(&ffsd->fs_pack_lock,
+                              SVN_FS_X__USE_LOCK_MUTEX, common_pool));
+
       /* ... not to mention locking the txn-current file. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_current_lock,
                               SVN_FS_X__USE_LOCK_MUTEX, common_pool));
@@ -152,6 +156,19 @@ x_freeze_body(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Take the write lock and run x_freeze_body.  Pack builds new shards
+   and removes old ones while only holding the pack lock.  Hence, freeze
+   must hold both and take them in the same order as pack does.  This
+   implements the svn_fs_x__with_pack_lock() 'body' callback type.  BATON
+   is a 'struct x_freeze_baton_t *'. */
+static svn_error_t *
+x_freeze_pack_locked(void *baton,
+                     apr_pool_t *pool)
+{
+  struct x_freeze_baton_t *b = baton;
+  return svn_fs_x__with_write_lock(b->fs, x_freeze_body, b, pool);
+}
+
 static svn_error_t *
 x_freeze(svn_fs_t *fs,
          svn_fs_freeze_func_t freeze_func,
@@ -165,7 +182,7 @@ x_freeze(svn_fs_t *fs,
   b.freeze_baton = freeze_baton;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
-  SVN_ERR(svn_fs_x__with_write_lock(fs, x_freeze_body, &b, pool));
+  SVN_ERR(svn_fs_x__with_pack_lock(fs, x_freeze_pack_locked, &b, pool));
 
   return SVN_NO_ERROR;
 }
@@ -279,6 +296,34 @@ x_open(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__open_clone(svn_fs_t **clone_p,
+                      svn_fs_t *fs,
+                      apr_pool_t *pool)
+{
+  fs_x_data_t *ffd = fs->fsap_data;
+  fs_x_data_t *clone_ffd;
+  svn_fs_t *clone = apr_pcalloc(pool, sizeof(*clone));
+
+  clone->pool = pool;
+  clone->warning = fs->warning;
+  clone->warning_baton = fs->warning_baton;
+  clone->config = fs->config;
+
+  SVN_ERR(initialize_fs_struct(clone));
+  SVN_ERR(svn_fs_x__open(clone, fs->path, pool));
+  SVN_ERR(svn_fs_x__initialize_caches(clone, pool));
+
+  /* The process-global data has already been set up for FS and we don't
+     have access to the common pool here.  Simply share it. */
+  clone_ffd = clone->fsap_data;
+  clone_ffd->shared = ffd->shared;
+  clone_ffd->svn_fs_open_ = ffd->svn_fs_open_;
+
+  *clone_p = clone;
+  return SVN_NO_ERROR;
+}
+
 
 
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
@@ -347,6 +392,7 @@ x_verify(svn_fs_t *fs, const char *path,
 static svn_error_t *
 x_pack(svn_fs_t *fs,
        const char *path,
+       int jobs,
        svn_fs_pack_notify_t notify_func,
        void *notify_baton,
        svn_cancel_func_t cancel_func,
@@ -356,7 +402,7 @@ x_pack(svn_fs_t *fs,
        apr_pool_t *common_pool)
 {
   SVN_ERR(x_open(fs, path, common_pool_lock, pool, common_pool));
-  return svn_fs_x__pack(fs, notify_func, notify_baton,
+  return svn_fs_x__pack(fs, jobs, notify_func, notify_baton,
                         cancel_func, cancel_baton, pool);
 }
 
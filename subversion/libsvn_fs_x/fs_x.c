@@ -223,6 +223,23 @@ read_config(fs_x_data_t *ffd,
                                CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                SVN_FS_X_MAX_LINEAR_DELTIFICATION));
 
+  /* Select the svndiff version for new deltas. */
+  {
+    const char *compression;
+    svn_config_get(ffd->config, &compression,
+                   CONFIG_SECTION_DELTIFICATION,
+                   CONFIG_OPTION_DELTA_COMPRESSION, "zlib");
+
+    if (svn_cstring_casecmp(compression, "zlib") == 0)
+      ffd->delta_svndiff_version = 1;
+    else if (svn_cstring_casecmp(compression, "lz4") == 0)
+      ffd->delta_svndiff_version = 2;
+    else
+      return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                               _("Invalid value '%s' for option '%s'"),
+                               compression, CONFIG_OPTION_DELTA_COMPRESSION);
+  }
+
   /* Initialize revprop packing settings in ffd. */
   SVN_ERR(svn_config_get_bool(ffd->config, &ffd->compress_packed_revprops,
                               CONFIG_SECTION_PACKED_REVPROPS,
@@ -345,6 +362,14 @@ write_config(svn_fs_t *fs,
 "### exclusive use of skip-deltas."                                          NL
 "### For 1.8, the default value is 16."                                      NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
+"###"                                                                        NL
+"### Deltas may be compressed either with zlib (svndiff1) or with the much"  NL
+"### faster, LZ4-style svndiff2 format.  The latter typically needs 10-20%"   NL
+"### more disk space but makes reading and reconstructing file contents"     NL
+"### several times faster.  Only new deltas are affected; existing data"     NL
+"### remains readable in either case."                                       NL
+"### Possible values are 'zlib' and 'lz4'.  The default is 'zlib'."          NL
+"# " CONFIG_OPTION_DELTA_COMPRESSION " = zlib"                               NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -34,6 +34,15 @@ svn_error_t *svn_fs_x__open(svn_fs_t *fs,
                             const char *path,
                             apr_pool_t *pool);
 
+/* Open another filesystem object for the repository that FS has been
+   opened for and return it in *CLONE_P.  The clone uses the same
+   configuration and shares the process-global data (lock mutexes etc.)
+   with FS but has its own cache instances and per-object state.  Hence, it
+   may be used in a different thread than FS.  Allocate it in POOL. */
+svn_error_t *svn_fs_x__open_clone(svn_fs_t **clone_p,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *pool);
+
 /* Upgrade the fsx filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
@@ -843,12 +843,25 @@ hotcopy_setup_shared_fs_data(svn_fs_t *src_fs, svn_fs_t *dst_fs)
   fs_x_data_t *dst_ffd = dst_fs->fsap_data;
 
   /* The common pool and mutexes are shared between src and dst filesystems.
-   * During hotcopy we only grab the mutexes for the destination, so there
+   * During hotcopy we only grab the pack mutex for the source and the write
+   * mutex for the destination, in the same order as pack does.  So, there
    * is no risk of dead-lock. We don't write to the src filesystem. Shared
    * data for the src_fs has already been initialised in fs_hotcopy(). */
   dst_ffd->shared = src_ffd->shared;
 }
 
+/* Run hotcopy_body with the write lock on the destination held.
+ * This implements the svn_fs_x__with_pack_lock() 'body' callback type for
+ * the source filesystem.  BATON is a 'struct hotcopy_body_baton *'.
+ */
+static svn_error_t *
+hotcopy_locked_body(void *baton, apr_pool_t *pool)
+{
+  struct hotcopy_body_baton *hbb = baton;
+
+  return svn_fs_x__with_write_lock(hbb->dst_fs, hotcopy_body, hbb, pool);
+}
+
 /* Create an empty filesystem at DST_FS at DST_PATH with the same
  * configuration as SRC_FS (uuid, format, and other parameters).
  * After creation DST_FS has no revisions, not even revision zero. */
@@ -973,7 +986,10 @@ svn_fs_x__hotcopy(svn_fs_t *src_fs,
   hbb.incremental = incremental;
   hbb.cancel_func = cancel_func;
   hbb.cancel_baton = cancel_baton;
-  SVN_ERR(svn_fs_x__with_write_lock(dst_fs, hotcopy_body, &hbb, pool));
+
+  /* Keep pack from building and removing shards in the source while we
+   * copy them.  Take the locks in the same order as pack does. */
+  SVN_ERR(svn_fs_x__with_pack_lock(src_fs, hotcopy_locked_body, &hbb, pool));
 
   return SVN_NO_ERROR;
 }
@@ -21,9 +21,14 @@
  */
 #include <assert.h>
 
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -45,6 +50,11 @@
 #include "svn_private_config.h"
 #include "temp_serializer.h"
 
+/* Try to limit the temporary memory used while packing a single shard to
+ * this many bytes.  Concurrent pack operations use that much per thread.
+ */
+#define PACK_MAX_MEM (64 * 1024 * 1024)
+
 /* Format 7 packing logic:
  *
  * We pack files on a pack file basis (e.g. 1000 revs) without changing
@@ -2152,67 +2162,52 @@ pack_rev_shard(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* In the file system at FS_PATH, pack the SHARD in REVS_DIR and
- * REVPROPS_DIR containing exactly MAX_FILES_PER_DIR revisions, using POOL
- * for allocations.  REVPROPS_DIR will be NULL if revprop packing is not
- * supported.  COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that
- * case.
- *
- * CANCEL_FUNC and CANCEL_BATON are what you think they are; similarly
- * NOTIFY_FUNC and NOTIFY_BATON.
- *
- * If for some reason we detect a partial packing already performed, we
- * remove the pack file and start again.
+/* Set *PACK_FILE_DIR and *SHARD_PATH to the packed and the non-packed
+ * directory, respectively, of SHARD within DIR.  Allocate them in POOL.
  */
-static svn_error_t *
-pack_shard(const char *revs_dir,
-           const char *revsprops_dir,
-           svn_fs_t *fs,
-           apr_int64_t shard,
-           int max_files_per_dir,
-           apr_off_t max_pack_size,
-           int compression_level,
-           svn_fs_pack_notify_t notify_func,
-           void *notify_baton,
-           svn_cancel_func_t cancel_func,
-           void *cancel_baton,
-           apr_pool_t *pool)
+static void
+get_shard_paths(const char **pack_file_dir,
+                const char **shard_path,
+                const char *dir,
+                apr_int64_t shard,
+                apr_pool_t *pool)
 {
-  fs_x_data_t *ffd = fs->fsap_data;
-  const char *rev_shard_path, *rev_pack_file_dir;
-  const char *revprops_shard_path, *revprops_pack_file_dir;
-
-  /* Notify caller we're starting to pack this shard. */
-  if (notify_func)
-    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
-                        pool));
-
-  /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(revs_dir,
+  *pack_file_dir = svn_dirent_join(dir,
                   apr_psprintf(pool,
                                "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
                                shard),
                   pool);
-  rev_shard_path = svn_dirent_join(revs_dir,
+  *shard_path = svn_dirent_join(dir,
                            apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
                            pool);
+}
 
-  /* pack the revision content */
-  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
-                         shard, max_files_per_dir, 64 * 1024 * 1024,
-                         cancel_func, cancel_baton, pool));
+/* In the file system FS, make SHARD in REVPROPS_DIR containing exactly
+ * MAX_FILES_PER_DIR revisions use its pack files.  The revision pack file
+ * must already have been built.  Pack the revprops of that shard and
+ * update the min-unpacked-rev file accordingly.  Use POOL for allocations.
+ *
+ * Revprops may be modified at any time, so this requires the FS write lock.
+ */
+static svn_error_t *
+switch_to_packed_shard(const char *revsprops_dir,
+                       svn_fs_t *fs,
+                       apr_int64_t shard,
+                       int max_files_per_dir,
+                       apr_off_t max_pack_size,
+                       int compression_level,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  fs_x_data_t *ffd = fs->fsap_data;
+  const char *revprops_shard_path, *revprops_pack_file_dir;
 
   /* if enabled, pack the revprops in an equivalent way */
   if (revsprops_dir)
     {
-      revprops_pack_file_dir = svn_dirent_join(revsprops_dir,
-                   apr_psprintf(pool,
-                                "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                                shard),
-                   pool);
-      revprops_shard_path = svn_dirent_join(revsprops_dir,
-                           apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
-                           pool);
+      get_shard_paths(&revprops_pack_file_dir, &revprops_shard_path,
+                      revsprops_dir, shard, pool);
 
       SVN_ERR(svn_fs_x__pack_revprops_shard(revprops_pack_file_dir,
                                             revprops_shard_path,
@@ -2229,15 +2224,42 @@ pack_shard(const char *revs_dir,
                             pool));
   ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
 
-  /* Finally, remove the existing shard directories.
-   * For revprops, clean up older obsolete shards as well as they might
-   * have been left over from an interrupted FS upgrade. */
+  return SVN_NO_ERROR;
+}
+
+/* Remove the non-packed directories of SHARD containing exactly
+ * MAX_FILES_PER_DIR revisions from REVS_DIR and REVPROPS_DIR after
+ * switch_to_packed_shard() has been called for it.  For revprops, clean
+ * up older obsolete shards as well as they might have been left over from
+ * an interrupted FS upgrade.  Use POOL for allocations.
+ *
+ * Readers will retry with the pack file if the non-packed revision file
+ * they are looking for has disappeared, so this does not require the FS
+ * write lock.
+ */
+static svn_error_t *
+remove_unpacked_shard(const char *revs_dir,
+                      const char *revsprops_dir,
+                      apr_int64_t shard,
+                      int max_files_per_dir,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *pool)
+{
+  const char *rev_shard_path, *rev_pack_file_dir;
+  const char *revprops_shard_path, *revprops_pack_file_dir;
+
+  get_shard_paths(&rev_pack_file_dir, &rev_shard_path, revs_dir, shard,
+                  pool);
   SVN_ERR(svn_io_remove_dir2(rev_shard_path, TRUE,
                              cancel_func, cancel_baton, pool));
   if (revsprops_dir)
     {
       svn_node_kind_t kind = svn_node_dir;
       apr_int64_t to_cleanup = shard;
+
+      get_shard_paths(&revprops_pack_file_dir, &revprops_shard_path,
+                      revsprops_dir, shard, pool);
       do
         {
           SVN_ERR(svn_fs_x__delete_revprops_shard(revprops_shard_path,
@@ -2257,6 +2279,62 @@ pack_shard(const char *revs_dir,
       while (kind == svn_node_dir && to_cleanup > 0);
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* In the file system at FS_PATH, pack the SHARD in REVS_DIR and
+ * REVPROPS_DIR containing exactly MAX_FILES_PER_DIR revisions, using POOL
+ * for allocations.  REVPROPS_DIR will be NULL if revprop packing is not
+ * supported.  COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that
+ * case.
+ *
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are; similarly
+ * NOTIFY_FUNC and NOTIFY_BATON.
+ *
+ * If for some reason we detect a partial packing already performed, we
+ * remove the pack file and start again.
+ */
+static svn_error_t *
+pack_shard(const char *revs_dir,
+           const char *revsprops_dir,
+           svn_fs_t *fs,
+           apr_int64_t shard,
+           int max_files_per_dir,
+           apr_off_t max_pack_size,
+           int compression_level,
+           svn_fs_pack_notify_t notify_func,
+           void *notify_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *pool)
+{
+  const char *rev_shard_path, *rev_pack_file_dir;
+
+  /* Notify caller we're starting to pack this shard. */
+  if (notify_func)
+    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
+                        pool));
+
+  /* Some useful paths. */
+  get_shard_paths(&rev_pack_file_dir, &rev_shard_path, revs_dir, shard,
+                  pool);
+
+  /* pack the revision content */
+  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
+                         shard, max_files_per_dir, PACK_MAX_MEM,
+                         cancel_func, cancel_baton, pool));
+
+  /* pack the revprops and make readers use the new pack files */
+  SVN_ERR(switch_to_packed_shard(revsprops_dir, fs, shard,
+                                 max_files_per_dir, max_pack_size,
+                                 compression_level,
+                                 cancel_func, cancel_baton, pool));
+
+  /* Finally, remove the existing shard directories. */
+  SVN_ERR(remove_unpacked_shard(revs_dir, revsprops_dir, shard,
+                                max_files_per_dir,
+                                cancel_func, cancel_baton, pool));
+
   /* Notify caller we're starting to pack this shard. */
   if (notify_func)
     SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_end,
@@ -2268,12 +2346,36 @@ pack_shard(const char *revs_dir,
 struct pack_baton
 {
   svn_fs_t *fs;
+  int jobs;
   svn_fs_pack_notify_t notify_func;
   void *notify_baton;
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
 };
 
+/* Set *FIRST_SHARD and *END_SHARD to the range of shards in FS that are
+ * complete but have not been packed, yet.  If there is nothing to pack,
+ * *FIRST_SHARD will be equal to *END_SHARD.  Use POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+get_shards_to_pack(apr_int64_t *first_shard,
+                   apr_int64_t *end_shard,
+                   svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  fs_x_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_fs_x__read_min_unpacked_rev(&ffd->min_unpacked_rev, fs,
+                                          pool));
+
+  SVN_ERR(svn_fs_x__youngest_rev(&youngest, fs, pool));
+  *first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  *end_shard = (youngest + 1) / ffd->max_files_per_dir;
+
+  return SVN_NO_ERROR;
+}
 
 /* The work-horse for svn_fs_x__pack, called with the FS write lock.
    This implements the svn_fs_x__with_write_lock() 'body' callback
@@ -2295,22 +2397,15 @@ pack_body(void *baton,
 {
   struct pack_baton *pb = baton;
   fs_x_data_t *ffd = pb->fs->fsap_data;
-  apr_int64_t completed_shards;
+  apr_int64_t first_shard, end_shard;
   apr_int64_t i;
-  svn_revnum_t youngest;
   apr_pool_t *iterpool;
   const char *rev_data_path;
-  const char *revprops_data_path = NULL;
-
-  /* If we aren't using sharding, we can't do any packing, so quit. */
-  SVN_ERR(svn_fs_x__read_min_unpacked_rev(&ffd->min_unpacked_rev, pb->fs,
-                                          pool));
-
-  SVN_ERR(svn_fs_x__youngest_rev(&youngest, pb->fs, pool));
-  completed_shards = (youngest + 1) / ffd->max_files_per_dir;
+  const char *revprops_data_path;
 
   /* See if we've already completed all possible shards thus far. */
-  if (ffd->min_unpacked_rev == (completed_shards * ffd->max_files_per_dir))
+  SVN_ERR(get_shards_to_pack(&first_shard, &end_shard, pb->fs, pool));
+  if (first_shard >= end_shard)
     return SVN_NO_ERROR;
 
   rev_data_path = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
@@ -2318,9 +2413,7 @@ pack_body(void *baton,
                                         pool);
 
   iterpool = svn_pool_create(pool);
-  for (i = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       i < completed_shards;
-       i++)
+  for (i = first_shard; i < end_shard; i++)
     {
       svn_pool_clear(iterpool);
 
@@ -2341,8 +2434,347 @@ pack_body(void *baton,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Outcome of building the revision pack file for a single shard in a
+   worker thread. */
+typedef struct pack_result_t
+{
+  /* Error returned by pack_rev_shard, if any. */
+  svn_error_t *err;
+
+  /* Set once the pack file has been built. */
+  svn_boolean_t done;
+} pack_result_t;
+
+/* State shared between the thread calling svn_fs_x__pack and its
+   worker threads.  Unless noted otherwise, all members are protected by
+   MUTEX. */
+typedef struct pack_jobs_t
+{
+  /* Location and size of the shards.  Read-only. */
+  const char *revs_dir;
+  int max_files_per_dir;
+
+  /* Shards to pack are FIRST_SHARD up to but not including END_SHARD.
+     Read-only. */
+  apr_int64_t first_shard;
+  apr_int64_t end_shard;
+
+  /* Cancellation support.  Read-only. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Next shard to hand out to a worker. */
+  apr_int64_t next_shard;
+
+  /* Oldest shard that has not been switched to its pack file, yet. */
+  apr_int64_t first_pending;
+
+  /* Number of shards that may be in progress or waiting to be switched
+     at any given time.  Read-only. */
+  int window_size;
+
+  /* If set, workers must not pick up any further shards. */
+  svn_boolean_t stop;
+
+  /* Number of workers still running. */
+  int active_workers;
+
+  /* One result per shard, indexed by shard - FIRST_SHARD. */
+  pack_result_t *results;
+
+  /* Serializes access to the above and signals any change in state. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} pack_jobs_t;
+
+/* Per-thread data of a pack worker. */
+typedef struct pack_worker_t
+{
+  /* Shared state. */
+  pack_jobs_t *jobs;
+
+  /* FS object to be used by this thread only. */
+  svn_fs_t *fs;
+
+  /* Root pool containing FS. */
+  apr_pool_t *pool;
+} pack_worker_t;
+
+/* Worker thread function.  Build the revision pack files for the shards
+   handed out by the pack_jobs_t in the pack_worker_t DATA until there
+   are no more left. */
+static void * APR_THREAD_FUNC
+pack_worker(apr_thread_t *tid, void *data)
+{
+  pack_worker_t *worker = data;
+  pack_jobs_t *jobs = worker->jobs;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  apr_thread_mutex_lock(jobs->mutex);
+  while (!jobs->stop && jobs->next_shard < jobs->end_shard)
+    {
+      apr_int64_t shard;
+      pack_result_t *result;
+      const char *rev_shard_path, *rev_pack_file_dir;
+      svn_error_t *err;
+
+      /* Don't get too far ahead of the shards switched so far.  Every
+         shard waiting to be switched takes up disk space twice. */
+      if (jobs->next_shard - jobs->first_pending >= jobs->window_size)
+        {
+          apr_thread_cond_wait(jobs->changed, jobs->mutex);
+          continue;
+        }
+
+      shard = jobs->next_shard++;
+      result = &jobs->results[shard - jobs->first_shard];
+      apr_thread_mutex_unlock(jobs->mutex);
+
+      svn_pool_clear(iterpool);
+      get_shard_paths(&rev_pack_file_dir, &rev_shard_path, jobs->revs_dir,
+                      shard, iterpool);
+      err = pack_rev_shard(worker->fs, rev_pack_file_dir, rev_shard_path,
+                           shard, jobs->max_files_per_dir, PACK_MAX_MEM,
+                           jobs->cancel_func, jobs->cancel_baton,
+                           iterpool);
+
+      apr_thread_mutex_lock(jobs->mutex);
+      result->err = err;
+      result->done = TRUE;
+      apr_thread_cond_broadcast(jobs->changed);
+    }
+
+  --jobs->active_workers;
+  apr_thread_cond_broadcast(jobs->changed);
+  apr_thread_mutex_unlock(jobs->mutex);
+
+  svn_pool_destroy(iterpool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Baton type for switch_shard_body. */
+struct switch_shard_baton
+{
+  svn_fs_t *fs;
+  const char *revprops_dir;
+  apr_int64_t shard;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Call switch_to_packed_shard for the shard given in the
+   'struct switch_shard_baton *' BATON.  This implements the
+   svn_fs_x__with_write_lock() 'body' callback type. */
+static svn_error_t *
+switch_shard_body(void *baton,
+                  apr_pool_t *pool)
+{
+  struct switch_shard_baton *sb = baton;
+  fs_x_data_t *ffd = sb->fs->fsap_data;
+
+  return svn_error_trace(switch_to_packed_shard(sb->revprops_dir, sb->fs,
+                            sb->shard, ffd->max_files_per_dir,
+                            ffd->revprop_pack_size,
+                            ffd->compress_packed_revprops
+                              ? SVN__COMPRESSION_ZLIB_DEFAULT
+                              : SVN__COMPRESSION_NONE,
+                            sb->cancel_func, sb->cancel_baton, pool));
+}
+
+/* Like pack_body but build the revision pack files of up to PB->JOBS
+   shards concurrently in worker threads.  Only the switch from the
+   non-packed to the packed shard is done under the FS write lock, one
+   shard at a time and in shard order.  Notifications are being sent
+   from the calling thread only.  This implements the
+   svn_fs_x__with_pack_lock() 'body' callback type.  BATON is a
+   'struct pack_baton *'.
+ */
+static svn_error_t *
+pack_concurrently_body(void *baton,
+                       apr_pool_t *pool)
+{
+  struct pack_baton *pb = baton;
+  fs_x_data_t *ffd = pb->fs->fsap_data;
+  pack_jobs_t jobs = { 0 };
+  pack_worker_t *workers;
+  apr_thread_t **threads;
+  struct switch_shard_baton sb = { 0 };
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  apr_int64_t shard_count;
+  apr_int64_t shard;
+  int job_count = pb->jobs;
+  int thread_count = 0;
+  int i;
+
+  /* Revision contents are immutable and we hold the pack lock.  Hence,
+     the range of shards to pack can't change while we are building the
+     pack files. */
+  SVN_ERR(get_shards_to_pack(&jobs.first_shard, &jobs.end_shard, pb->fs,
+                             pool));
+  shard_count = jobs.end_shard - jobs.first_shard;
+  if (shard_count <= 0)
+    return SVN_NO_ERROR;
+
+  if (job_count > shard_count)
+    job_count = (int)shard_count;
+
+  jobs.revs_dir = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
+  jobs.max_files_per_dir = ffd->max_files_per_dir;
+  jobs.cancel_func = pb->cancel_func;
+  jobs.cancel_baton = pb->cancel_baton;
+  jobs.next_shard = jobs.first_shard;
+  jobs.first_pending = jobs.first_shard;
+  jobs.window_size = job_count;
+  jobs.results = apr_pcalloc(pool, shard_count * sizeof(*jobs.results));
+
+  sb.fs = pb->fs;
+  sb.revprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR, pool);
+  sb.cancel_func = pb->cancel_func;
+  sb.cancel_baton = pb->cancel_baton;
+
+  status = apr_thread_mutex_create(&jobs.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&jobs.changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create pack lock"));
+
+  /* FS objects are not thread-safe.  Give each worker its own one. */
+  workers = apr_pcalloc(pool, job_count * sizeof(*workers));
+  for (i = 0; !err && i < job_count; ++i)
+    {
+      workers[i].jobs = &jobs;
+      workers[i].pool = svn_pool_create(NULL);
+      err = svn_fs_x__open_clone(&workers[i].fs, pb->fs, workers[i].pool);
+    }
+
+  /* Start the workers. */
+  threads = apr_pcalloc(pool, job_count * sizeof(*threads));
+  apr_thread_mutex_lock(jobs.mutex);
+  for (i = 0; !err && i < job_count; ++i)
+    {
+      status = apr_thread_create(&threads[i], NULL, pack_worker,
+                                 &workers[i], pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create pack thread"));
+          jobs.stop = TRUE;
+          break;
+        }
+
+      ++thread_count;
+      ++jobs.active_workers;
+    }
+  apr_thread_mutex_unlock(jobs.mutex);
+
+  /* Switch shards in order as soon as their pack files are complete. */
+  iterpool = svn_pool_create(pool);
+  for (shard = jobs.first_shard; !err && shard < jobs.end_shard; ++shard)
+    {
+      pack_result_t *result = &jobs.results[shard - jobs.first_shard];
+      svn_boolean_t done;
+
+      svn_pool_clear(iterpool);
+
+      if (pb->cancel_func)
+        {
+          err = pb->cancel_func(pb->cancel_baton);
+          if (err)
+            break;
+        }
+
+      /* Notify caller we're starting to pack this shard. */
+      if (pb->notify_func)
+        {
+          err = pb->notify_func(pb->notify_baton, shard,
+                                svn_fs_pack_notify_start, iterpool);
+          if (err)
+            break;
+        }
+
+      apr_thread_mutex_lock(jobs.mutex);
+      while (!result->done && jobs.active_workers > 0)
+        apr_thread_cond_wait(jobs.changed, jobs.mutex);
+      done = result->done;
+      apr_thread_mutex_unlock(jobs.mutex);
+
+      /* All workers quit prematurely? */
+      if (!done)
+        break;
+
+      if (result->err)
+        {
+          err = result->err;
+          result->err = SVN_NO_ERROR;
+          break;
+        }
+
+      sb.shard = shard;
+      err = svn_fs_x__with_write_lock(pb->fs, switch_shard_body, &sb,
+                                      iterpool);
+      if (!err)
+        err = remove_unpacked_shard(jobs.revs_dir, sb.revprops_dir, shard,
+                                    ffd->max_files_per_dir,
+                                    pb->cancel_func, pb->cancel_baton,
+                                    iterpool);
+      if (!err && pb->notify_func)
+        err = pb->notify_func(pb->notify_baton, shard,
+                              svn_fs_pack_notify_end, iterpool);
+
+      apr_thread_mutex_lock(jobs.mutex);
+      jobs.first_pending = shard + 1;
+      apr_thread_cond_broadcast(jobs.changed);
+      apr_thread_mutex_unlock(jobs.mutex);
+    }
+
+  /* Stop and wait for all workers. */
+  apr_thread_mutex_lock(jobs.mutex);
+  jobs.stop = TRUE;
+  apr_thread_cond_broadcast(jobs.changed);
+  apr_thread_mutex_unlock(jobs.mutex);
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+
+  /* Pack files that have been built but not switched to will simply be
+     rebuilt by the next pack run. */
+  for (shard = 0; shard < shard_count; ++shard)
+    svn_error_clear(jobs.results[shard].err);
+
+  for (i = 0; i < job_count; ++i)
+    if (workers[i].pool)
+      svn_pool_destroy(workers[i].pool);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Run pack_body with the FS write lock held.  This implements the
+   svn_fs_x__with_pack_lock() 'body' callback type.  BATON is a
+   'struct pack_baton *'. */
+static svn_error_t *
+pack_serially_body(void *baton,
+                   apr_pool_t *pool)
+{
+  struct pack_baton *pb = baton;
+  return svn_fs_x__with_write_lock(pb->fs, pack_body, pb, pool);
+}
+
 svn_error_t *
 svn_fs_x__pack(svn_fs_t *fs,
+               int jobs,
                svn_fs_pack_notify_t notify_func,
                void *notify_baton,
                svn_cancel_func_t cancel_func,
@@ -2351,9 +2783,21 @@ svn_fs_x__pack(svn_fs_t *fs,
 {
   struct pack_baton pb = { 0 };
   pb.fs = fs;
+  pb.jobs = jobs;
   pb.notify_func = notify_func;
   pb.notify_baton = notify_baton;
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
-  return svn_fs_x__with_write_lock(fs, pack_body, &pb, pool);
+
+  /* Worker threads would share the global cache.  That requires it to be
+     thread-safe. */
+  if (svn_cache_config_get()->single_threaded)
+    pb.jobs = 1;
+
+#if APR_HAS_THREADS
+  if (pb.jobs > 1)
+    return svn_fs_x__with_pack_lock(fs, pack_concurrently_body, &pb, pool);
+#endif
+
+  return svn_fs_x__with_pack_lock(fs, pack_serially_body, &pb, pool);
 }
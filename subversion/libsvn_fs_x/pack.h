@@ -29,9 +29,15 @@
    combines all the revision files into a single one, with a manifest header.
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
 
+   If JOBS is larger than 1 and the caches are thread-safe, build the pack
+   files for up to JOBS shards concurrently.  The FS write lock will then
+   only be taken briefly for each shard to pack its revprops and to bump
+   min-unpacked-rev.
+
    Existing filesystem references need not change.  */
 svn_error_t *
 svn_fs_x__pack(svn_fs_t *fs,
+               int jobs,
                svn_fs_pack_notify_t notify_func,
                void *notify_baton,
                svn_cancel_func_t cancel_func,
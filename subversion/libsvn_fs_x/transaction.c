@@ -30,6 +30,7 @@
 #include "svn_sorts.h"
 #include "svn_time.h"
 #include "svn_dirent_uri.h"
+#include "svn_cache_config.h"
 
 #include "fs_x.h"
 #include "tree.h"
@@ -273,6 +274,25 @@ svn_fs_x__with_write_lock(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__with_pack_lock(svn_fs_t *fs,
+                         svn_error_t *(*body)(void *baton,
+                                              apr_pool_t *pool),
+                         void *baton,
+                         apr_pool_t *pool)
+{
+  fs_x_data_t *ffd = fs->fsap_data;
+  fs_x_shared_data_t *ffsd = ffd->shared;
+
+  SVN_MUTEX__WITH_LOCK(ffsd->fs_pack_lock,
+                       with_some_lock_file(fs, body, baton,
+                                svn_fs_x__path_pack_lock(fs, pool),
+                                FALSE,
+                                pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Run BODY (with BATON and POOL) while the txn-current file
    of FS is locked. */
 static svn_error_t *
@@ -1626,6 +1646,14 @@ allocate_item_index(apr_uint64_t *item_index,
   return SVN_NO_ERROR;
 }
 
+/* Calculating the MD5 and SHA1 checksums takes about as long as
+   deltifying and compressing the contents.  For representations larger
+   than this, we therefore let a separate thread calculate the checksums
+   while the calling thread deltifies.  (The delta must stay in the
+   calling thread as reading the delta base uses the non-thread-safe
+   FS object.) */
+#define DIGEST_PIPELINE_THRESHOLD 0x80000
+
 /* This baton is used by the representation writing streams.  It keeps
    track of the checksum information as well as the total size of the
    representation so far. */
@@ -1662,6 +1690,10 @@ struct rep_write_baton
   svn_checksum_ctx_t *md5_checksum_ctx;
   svn_checksum_ctx_t *sha1_checksum_ctx;
 
+  /* If not NULL, the checksum contexts are being updated through this
+     stream, possibly by a separate thread. */
+  svn_stream_t *digests;
+
   apr_pool_t *pool;
 
   apr_pool_t *parent_pool;
@@ -1677,8 +1709,21 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  /* Large representation?  Then, calculate the checksums in parallel
+     to the delta.  Don't use threads in a process that asked us not to. */
+  if (   !b->digests
+      && b->rep_size + *len > DIGEST_PIPELINE_THRESHOLD
+      && !svn_cache_config_get()->single_threaded)
+    b->digests = svn_checksum__update2_stream(b->md5_checksum_ctx,
+                                              b->sha1_checksum_ctx,
+                                              b->pool);
+
+  if (b->digests)
+    SVN_ERR(svn_stream_write(b->digests, data, len));
+  else
+    SVN_ERR(svn_checksum__update2(b->md5_checksum_ctx,
+                                  b->sha1_checksum_ctx, data, *len));
+
   b->rep_size += *len;
 
   /* If we are writing a delta, use that stream. */
@@ -1844,7 +1889,8 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_stream_t *source;
   svn_txdelta_window_handler_t wh;
   void *whb;
-  int diff_version = 1;
+  fs_x_data_t *ffd = fs->fsap_data;
+  int diff_version = ffd->delta_svndiff_version;
   svn_fs_x__rep_header_t header = { 0 };
 
   b = apr_pcalloc(pool, sizeof(*b));
@@ -2048,6 +2094,10 @@ rep_write_contents_close(void *baton)
   if (b->delta_stream)
     SVN_ERR(svn_stream_close(b->delta_stream));
 
+  /* Wait for the checksum thread to process the remaining data. */
+  if (b->digests)
+    SVN_ERR(svn_stream_close(b->digests));
+
   /* Determine the length of the svndiff data. */
   SVN_ERR(svn_fs_x__get_file_offset(&offset, b->file, b->pool));
   rep->size = offset - b->delta_start;
@@ -2241,8 +2291,7 @@ write_hash_handler(void *baton,
 {
   struct write_hash_baton *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__update2(whb->md5_ctx, whb->sha1_ctx, data, *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2284,7 +2333,8 @@ write_hash_delta_rep(representation_t *rep,
   apr_off_t offset = 0;
 
   struct write_hash_baton *whb;
-  int diff_version = 1;
+  fs_x_data_t *ffd = fs->fsap_data;
+  int diff_version = ffd->delta_svndiff_version;
   svn_boolean_t is_props = (item_type == SVN_FS_X__ITEM_TYPE_FILE_PROPS)
                         || (item_type == SVN_FS_X__ITEM_TYPE_DIR_PROPS);
 
@@ -3209,27 +3259,6 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
-static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
-{
-  int i;
-
-  for (i = 0; i < reps_to_cache->nelts; i++)
-    {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
-
-      /* FALSE because we don't care if another parallel commit happened to
-       * collide with us.  (Non-parallel collisions will not be detected.) */
-      SVN_ERR(svn_fs_x__set_rep_reference(fs, rep, FALSE, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_x__commit(svn_revnum_t *new_rev_p,
                  svn_fs_t *fs,
@@ -3267,17 +3296,11 @@ svn_fs_x__commit(svn_revnum_t *new_rev_p,
     {
       SVN_ERR(svn_fs_x__open_rep_cache(fs, pool));
 
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
+      /* Write new entries to the rep-sharing database. */
       /* ### A commit that touches thousands of files will starve other
              (reader/writer) commits for the duration of the below call.
              Maybe write in batches? */
-      SVN_SQLITE__WITH_TXN(
-        write_reps_to_cache(fs, cb.reps_to_cache, pool),
-        ffd->rep_cache_db);
+      SVN_ERR(svn_fs_x__set_rep_references(fs, cb.reps_to_cache, pool));
     }
 
   return SVN_NO_ERROR;
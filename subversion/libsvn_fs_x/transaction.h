@@ -40,6 +40,17 @@ svn_fs_x__with_write_lock(svn_fs_t *fs,
                           void *baton,
                           apr_pool_t *pool);
 
+/* Obtain the pack lock on the filesystem FS in a subpool of POOL, call
+   BODY with BATON and that subpool, destroy the subpool (releasing the
+   pack lock) and return what BODY returned.  The pack lock serializes
+   pack operations only; it does not block commits or readers. */
+svn_error_t *
+svn_fs_x__with_pack_lock(svn_fs_t *fs,
+                         svn_error_t *(*body)(void *baton,
+                                              apr_pool_t *pool),
+                         void *baton,
+                         apr_pool_t *pool);
+
 /* Store NODEREV as the node-revision for the node whose id is ID in
    FS, after setting its is_fresh_txn_root to FRESH_TXN_ROOT.  Do any
    necessary temporary allocation in POOL. */
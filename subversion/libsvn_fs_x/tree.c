@@ -4220,6 +4220,7 @@ static root_vtable_t root_vtable = {
   x_file_checksum,
   x_file_contents,
   x_try_process_file_contents,
+  NULL,
   x_make_file,
   x_apply_textdelta,
   x_apply_text,
@@ -107,6 +107,10 @@ const char *
 svn_fs_x__path_lock(svn_fs_t *fs,
                     apr_pool_t *pool);
 
+const char *
+svn_fs_x__path_pack_lock(svn_fs_t *fs,
+                         apr_pool_t *pool);
+
 const char *
 svn_fs_x__path_revprop_generation(svn_fs_t *fs,
                                   apr_pool_t *pool);
@@ -930,6 +930,100 @@ svn_error_t *svn_ra_stat(svn_ra_session_t *session,
   return session->vtable->stat(session, path, revision, dirent, pool);
 }
 
+svn_error_t *svn_ra_stat_many(svn_ra_session_t *session,
+                              apr_hash_t **dirents,
+                              const apr_array_header_t *paths,
+                              svn_revnum_t revision,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  if (session->vtable->stat_many)
+    return svn_error_trace(session->vtable->stat_many(session, dirents,
+                                                      paths, revision,
+                                                      result_pool,
+                                                      scratch_pool));
+
+  /* The RA layer has no better way than asking for one path at a time. */
+  *dirents = apr_hash_make(result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(session->vtable->stat(session, path, revision, &dirent,
+                                    iterpool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path),
+                      svn_dirent_dup(dirent, result_pool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *svn_ra_get_props_many(svn_ra_session_t *session,
+                                   apr_hash_t **props,
+                                   const apr_array_header_t *paths,
+                                   svn_revnum_t revision,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  if (session->vtable->get_props_many)
+    return svn_error_trace(session->vtable->get_props_many(session, props,
+                                                           paths, revision,
+                                                           result_pool,
+                                                           scratch_pool));
+
+  /* All paths must be looked at in the same revision. */
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(session->vtable->get_latest_revnum(session, &revision,
+                                               scratch_pool));
+
+  *props = apr_hash_make(result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_node_kind_t kind;
+      apr_hash_t *path_props;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(session->vtable->check_path(session, path, revision, &kind,
+                                          iterpool));
+      if (kind == svn_node_file)
+        SVN_ERR(session->vtable->get_file(session, path, revision, NULL,
+                                          NULL, &path_props, result_pool));
+      else if (kind == svn_node_dir)
+        SVN_ERR(session->vtable->get_dir(session, NULL, NULL, &path_props,
+                                         path, revision, 0, result_pool));
+      else
+        return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                 _("Path '%s' not found in revision %ld"),
+                                 path, revision);
+
+      svn_hash_sets(*props, apr_pstrdup(result_pool, path), path_props);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_get_uuid2(svn_ra_session_t *session,
                               const char **uuid,
                               apr_pool_t *pool)
@@ -342,6 +342,24 @@ typedef struct svn_ra__vtable_t {
     void *replay_baton,
     apr_pool_t *scratch_pool);
 
+  /* See svn_ra_stat_many().  May be NULL, in which case svn_ra_stat()
+     gets called for every path. */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            apr_hash_t **dirents,
+                            const apr_array_header_t *paths,
+                            svn_revnum_t revision,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra_get_props_many().  May be NULL, in which case the
+     properties get fetched one path at a time. */
+  svn_error_t *(*get_props_many)(svn_ra_session_t *session,
+                                 apr_hash_t **props,
+                                 const apr_array_header_t *paths,
+                                 svn_revnum_t revision,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 } svn_ra__vtable_t;
 
 /* The RA session object. */
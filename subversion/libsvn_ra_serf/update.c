@@ -901,7 +901,7 @@ headers_fetch(serf_bucket_t *headers,
       serf_bucket_headers_setn(headers, SVN_DAV_DELTA_BASE_HEADER,
                                fetch_ctx->info->delta_base);
       serf_bucket_headers_setn(headers, "Accept-Encoding",
-                               "svndiff1;q=0.9,svndiff;q=0.8");
+                               "svndiff2;q=0.95,svndiff1;q=0.9,svndiff;q=0.8");
     }
   else if (fetch_ctx->sess->using_compression)
     {
@@ -2804,12 +2804,12 @@ setup_update_report_headers(serf_bucket_t *headers,
   if (report->sess->using_compression)
     {
       serf_bucket_headers_setn(headers, "Accept-Encoding",
-                               "gzip,svndiff1;q=0.9,svndiff;q=0.8");
+                               "gzip,svndiff2;q=0.95,svndiff1;q=0.9,svndiff;q=0.8");
     }
   else
     {
       serf_bucket_headers_setn(headers, "Accept-Encoding",
-                               "svndiff1;q=0.9,svndiff;q=0.8");
+                               "svndiff2;q=0.95,svndiff1;q=0.9,svndiff;q=0.8");
     }
 
   return SVN_NO_ERROR;
@@ -712,19 +712,25 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwwww)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
+                                  SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
                                   SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  SVN_RA_SVN_CAP_COMPRESSED_STREAM,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
   SVN_ERR(handle_auth_request(sess, pool));
 
+  /* If the server agreed, everything from here on is compressed. */
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESSED_STREAM))
+    SVN_ERR(svn_ra_svn__enable_compression(conn, pool));
+
   /* This is where the security layer would go into effect if we
    * supported security layers, which is a ways off. */
 
@@ -1843,16 +1849,17 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
-static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
-                                const char *path, svn_revnum_t rev,
-                                svn_dirent_t **dirent, apr_pool_t *pool)
+/* Read the response to a "stat" command from SESS_BATON's connection
+ * and set *DIRENT accordingly, allocated in POOL.
+ */
+static svn_error_t *read_stat_response(svn_dirent_t **dirent,
+                                       svn_ra_svn__session_baton_t *sess_baton,
+                                       apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
   apr_array_header_t *list = NULL;
   svn_dirent_t *the_dirent;
 
-  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
   SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
                                  N_("'stat' not implemented")));
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
@@ -1886,6 +1893,266 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
+                                const char *path, svn_revnum_t rev,
+                                svn_dirent_t **dirent, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+
+  SVN_ERR(svn_ra_svn__write_cmd_stat(sess_baton->conn, pool, path, rev));
+  return svn_error_trace(read_stat_response(dirent, sess_baton, pool));
+}
+
+/* Callback type used by pipeline_path_commands() to send the command for
+ * PATH, the IDX-th element of the path list, or to read its response.
+ * BATON is the caller's baton.  Use POOL for temporary allocations.
+ */
+typedef svn_error_t *(*path_command_func_t)(svn_ra_svn__session_baton_t *sess,
+                                            int idx,
+                                            const char *path,
+                                            void *baton,
+                                            apr_pool_t *pool);
+
+/* Issue one command for each element of PATHS on SESS's connection by
+ * calling SEND_COMMAND and read the responses in the same order by
+ * calling READ_RESPONSE.  If the server supports pipelining, keep several
+ * commands in flight, so that the latency is paid only once per batch
+ * instead of once per path.  Otherwise, wait for each response before
+ * sending the next command.
+ *
+ * If a response reports an error, read and discard the responses to the
+ * commands that are still in flight, keeping the connection usable, and
+ * return that error.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *pipeline_path_commands(svn_ra_svn__session_baton_t *sess,
+                                           const apr_array_header_t *paths,
+                                           path_command_func_t send_command,
+                                           path_command_func_t read_response,
+                                           void *baton,
+                                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t pipelining
+    = svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_PIPELINING);
+  apr_size_t in_flight_size = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  int sent = 0;
+  int received;
+
+  for (received = 0; received < paths->nelts; received++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, received, const char *);
+
+      svn_pool_clear(iterpool);
+
+      /* Top up the commands in flight.  The responses will be read
+         when we wait for the first of them. */
+      while (sent < paths->nelts
+             && (sent == received
+                 || (pipelining
+                     && sent - received < SVN_RA_SVN__MAX_PIPELINED_COMMANDS
+                     && in_flight_size < SVN_RA_SVN__MAX_PIPELINED_SIZE)))
+        {
+          const char *next = APR_ARRAY_IDX(paths, sent, const char *);
+
+          SVN_ERR(send_command(sess, sent, next, baton, iterpool));
+          in_flight_size += strlen(next);
+          sent++;
+        }
+
+      err = read_response(sess, received, path, baton, iterpool);
+      in_flight_size -= strlen(path);
+      if (err)
+        break;
+    }
+
+  /* Skip the responses to the commands sent after the failed one.  A
+     command that the server refused, e.g. due to authz, gets a single
+     failure response instead of the auth request.  There is no command
+     response to read after that. */
+  if (err)
+    for (received++; received < sent; received++)
+      {
+        svn_error_t *skip_err;
+
+        svn_pool_clear(iterpool);
+        skip_err = handle_auth_request(sess, iterpool);
+        if (skip_err)
+          svn_error_clear(skip_err);
+        else
+          svn_error_clear(svn_ra_svn__read_cmd_response(sess->conn,
+                                                        iterpool, ""));
+      }
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
+/* Baton for the stat_many callbacks. */
+typedef struct stat_many_baton_t
+{
+  svn_revnum_t revision;
+  apr_hash_t *dirents;
+  apr_pool_t *result_pool;
+} stat_many_baton_t;
+
+/* Send a "stat" command for PATH.  Implements path_command_func_t. */
+static svn_error_t *send_stat(svn_ra_svn__session_baton_t *sess,
+                              int idx,
+                              const char *path,
+                              void *baton,
+                              apr_pool_t *pool)
+{
+  stat_many_baton_t *b = baton;
+
+  return svn_error_trace(svn_ra_svn__write_cmd_stat(sess->conn, pool, path,
+                                                    b->revision));
+}
+
+/* Read the response to a "stat" command for PATH and add the dirent to
+ * BATON's hash.  Implements path_command_func_t. */
+static svn_error_t *read_stat(svn_ra_svn__session_baton_t *sess,
+                              int idx,
+                              const char *path,
+                              void *baton,
+                              apr_pool_t *pool)
+{
+  stat_many_baton_t *b = baton;
+  svn_dirent_t *dirent;
+
+  SVN_ERR(read_stat_response(&dirent, sess, b->result_pool));
+  if (dirent)
+    svn_hash_sets(b->dirents, apr_pstrdup(b->result_pool, path), dirent);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_stat_many(svn_ra_session_t *session,
+                                     apr_hash_t **dirents,
+                                     const apr_array_header_t *paths,
+                                     svn_revnum_t revision,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  stat_many_baton_t b;
+
+  b.revision = revision;
+  b.dirents = apr_hash_make(result_pool);
+  b.result_pool = result_pool;
+
+  SVN_ERR(pipeline_path_commands(session->priv, paths, send_stat, read_stat,
+                                 &b, scratch_pool));
+
+  *dirents = b.dirents;
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the get_props_many callbacks. */
+typedef struct get_props_many_baton_t
+{
+  svn_revnum_t revision;
+
+  /* The node kind of each path, indexed like the path list. */
+  svn_node_kind_t *kinds;
+
+  apr_hash_t *props;
+  apr_pool_t *result_pool;
+} get_props_many_baton_t;
+
+/* Send a "get-file" or "get-dir" command that asks for the properties of
+ * PATH only.  Implements path_command_func_t. */
+static svn_error_t *send_get_props(svn_ra_svn__session_baton_t *sess,
+                                   int idx,
+                                   const char *path,
+                                   void *baton,
+                                   apr_pool_t *pool)
+{
+  get_props_many_baton_t *b = baton;
+
+  if (b->kinds[idx] == svn_node_file)
+    SVN_ERR(svn_ra_svn__write_cmd_get_file(sess->conn, pool, path,
+                                           b->revision, TRUE, FALSE));
+  else
+    SVN_ERR(svn_ra_svn__write_tuple(sess->conn, pool, "w(c(?r)bb())",
+                                    "get-dir", path, b->revision,
+                                    TRUE, FALSE));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the response to the command sent by send_get_props() and add the
+ * properties to BATON's hash.  Implements path_command_func_t. */
+static svn_error_t *read_get_props(svn_ra_svn__session_baton_t *sess,
+                                   int idx,
+                                   const char *path,
+                                   void *baton,
+                                   apr_pool_t *pool)
+{
+  get_props_many_baton_t *b = baton;
+  apr_array_header_t *proplist, *dirlist;
+  const char *expected_digest;
+  svn_revnum_t rev;
+  apr_hash_t *props;
+
+  SVN_ERR(handle_auth_request(sess, pool));
+  if (b->kinds[idx] == svn_node_file)
+    SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, pool, "(?c)rl",
+                                          &expected_digest, &rev,
+                                          &proplist));
+  else
+    SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, pool, "rll",
+                                          &rev, &proplist, &dirlist));
+
+  SVN_ERR(svn_ra_svn__parse_proplist(proplist, b->result_pool, &props));
+  svn_hash_sets(b->props, apr_pstrdup(b->result_pool, path), props);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_get_props_many(svn_ra_session_t *session,
+                                          apr_hash_t **props,
+                                          const apr_array_header_t *paths,
+                                          svn_revnum_t revision,
+                                          apr_pool_t *result_pool,
+                                          apr_pool_t *scratch_pool)
+{
+  get_props_many_baton_t b;
+  apr_hash_t *dirents;
+  int i;
+
+  /* The kinds must be determined in the same revision as the props. */
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(ra_svn_get_latest_rev(session, &revision, scratch_pool));
+
+  /* We need to know the kinds to pick the right commands. */
+  SVN_ERR(ra_svn_stat_many(session, &dirents, paths, revision,
+                           scratch_pool, scratch_pool));
+
+  b.revision = revision;
+  b.kinds = apr_palloc(scratch_pool, paths->nelts * sizeof(*b.kinds));
+  b.props = apr_hash_make(result_pool);
+  b.result_pool = result_pool;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent = svn_hash_gets(dirents, path);
+
+      if (! dirent)
+        return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                 _("Path '%s' not found in revision %ld"),
+                                 path, revision);
+
+      b.kinds[i] = dirent->kind;
+    }
+
+  SVN_ERR(pipeline_path_commands(session->priv, paths, send_get_props,
+                                 read_get_props, &b, scratch_pool));
+
+  *props = b.props;
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *ra_svn_get_locations(svn_ra_session_t *session,
                                          apr_hash_t **locations,
@@ -2840,7 +3107,11 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_replay_range,
   ra_svn_get_deleted_rev,
   ra_svn_register_editor_shim_callbacks,
-  ra_svn_get_inherited_props
+  ra_svn_get_inherited_props,
+  NULL /* get_commit_ev2 */,
+  NULL /* replay_range_ev2 */,
+  ra_svn_stat_many,
+  ra_svn_get_props_many
 };
 
 svn_error_t *
@@ -70,6 +70,12 @@
  */
 #define ITEM_NESTING_LIMIT 64
 
+/* svn_ra_svn__has_command() buffers at most this much of a command that
+ * does not fit into the read buffer.  Larger commands are handed to the
+ * parser incomplete.
+ */
+#define MAX_BUFFERED_COMMAND (64 * SVN_RA_SVN__READBUF_SIZE)
+
 /* Return the APR socket timeout to be used for the connection depending
  * on whether there is a blockage handler or zero copy has been activated. */
 static apr_interval_time_t
@@ -101,6 +107,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn3(apr_socket_t *sock,
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf;
   conn->write_pos = 0;
+  conn->backlog = NULL;
   conn->written_since_error_check = 0;
   conn->error_check_interval = error_check_interval;
   conn->may_check_for_error = error_check_interval == 0;
@@ -109,6 +116,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn3(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->stream_compressed = FALSE;
   conn->pool = pool;
 
   if (sock != NULL)
@@ -168,6 +176,22 @@ svn_ra_svn_compression_level(svn_ra_svn_conn_t *conn)
   return conn->compression_level;
 }
 
+int
+svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
+{
+  /* Compressing the deltas again would be a waste of time. */
+  if (conn->compression_level <= 0 || conn->stream_compressed)
+    return 0;
+
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
+    return 2;
+
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
+    return 1;
+
+  return 0;
+}
+
 apr_size_t
 svn_ra_svn_zero_copy_limit(svn_ra_svn_conn_t *conn)
 {
@@ -189,6 +213,13 @@ svn_ra_svn__set_block_handler(svn_ra_svn_conn_t *conn,
   svn_ra_svn__stream_timeout(conn->stream, get_timeout(conn));
 }
 
+void
+svn_ra_svn__set_read_timeout(svn_ra_svn_conn_t *conn,
+                             apr_interval_time_t timeout)
+{
+  svn_ra_svn__stream_read_timeout(conn->stream, timeout);
+}
+
 svn_boolean_t svn_ra_svn__input_waiting(svn_ra_svn_conn_t *conn,
                                         apr_pool_t *pool)
 {
@@ -325,6 +356,25 @@ static char *readbuf_drain(svn_ra_svn_conn_t *conn, char *data, char *end)
   return data + copylen;
 }
 
+/* Read up to *LEN bytes into DATA, taking them from the backlog of CONN
+ * if it has one or from its stream otherwise.  Set *LEN to the number of
+ * bytes actually read. */
+static svn_error_t *stream_input(svn_ra_svn_conn_t *conn, char *data,
+                                 apr_size_t *len)
+{
+  if (conn->backlog && conn->backlog->len)
+    {
+      if (*len > conn->backlog->len)
+        *len = conn->backlog->len;
+      memcpy(data, conn->backlog->data, *len);
+      svn_stringbuf_remove(conn->backlog, 0, *len);
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_read(conn->stream, data, len));
+}
+
 /* Read data from socket or input file as appropriate. */
 static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
                                   apr_size_t *len, apr_pool_t *pool)
@@ -334,7 +384,7 @@ static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
   if (session && session->callbacks && session->callbacks->cancel_func)
     SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-  SVN_ERR(svn_ra_svn__stream_read(conn->stream, data, len));
+  SVN_ERR(stream_input(conn, data, len));
   if (*len == 0)
     return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
 
@@ -364,7 +414,7 @@ static svn_error_t *readbuf_skip(svn_ra_svn_conn_t *conn, apr_uint64_t len)
       break;
 
     buflen = sizeof(conn->read_buf);
-    SVN_ERR(svn_ra_svn__stream_read(conn->stream, conn->read_buf, &buflen));
+    SVN_ERR(stream_input(conn, conn->read_buf, &buflen));
     if (buflen == 0)
       return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
 
@@ -542,6 +592,47 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_file_string(svn_ra_svn_conn_t *conn,
+                              apr_pool_t *pool,
+                              apr_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t len)
+{
+  SVN_ERR(write_number(conn, pool, len, ':'));
+
+  if (svn_ra_svn__stream_can_sendfile(conn->stream))
+    {
+      /* The string header must go out before the file contents. */
+      SVN_ERR(writebuf_flush(conn, pool));
+      SVN_ERR(svn_ra_svn__stream_sendfile(conn->stream, file, offset, len));
+
+      conn->written_since_error_check += len;
+      conn->may_check_for_error
+        = conn->written_since_error_check >= conn->error_check_interval;
+    }
+  else
+    {
+      /* Copy the data through the write buffer, one buffer at a time. */
+      char *buffer = apr_palloc(pool, sizeof(conn->write_buf));
+
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      while (len > 0)
+        {
+          apr_size_t count = len < sizeof(conn->write_buf)
+                           ? len
+                           : sizeof(conn->write_buf);
+
+          SVN_ERR(svn_io_file_read_full2(file, buffer, count, NULL, NULL,
+                                         pool));
+          SVN_ERR(writebuf_write(conn, pool, buffer, count));
+          len -= count;
+        }
+    }
+
+  return writebuf_writechar(conn, pool, ' ');
+}
+
 svn_error_t *
 svn_ra_svn__write_word(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
@@ -637,6 +728,37 @@ svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *pool)
+{
+  if (conn->stream_compressed)
+    return SVN_NO_ERROR;
+
+  /* Everything written up to now must go out uncompressed. */
+  SVN_ERR(writebuf_flush(conn, pool));
+
+  /* The other side may only switch after our last uncompressed message,
+     so it cannot have sent much yet. */
+  if (conn->backlog && conn->backlog->len)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected data before switching to "
+                              "compression"));
+
+  /* Data that the other side sent after switching may already be in our
+     read buffer.  Hand it to the decompressor. */
+  SVN_ERR(svn_ra_svn__stream_compressed(&conn->stream, conn->stream,
+                                        conn->read_ptr,
+                                        conn->read_end - conn->read_ptr,
+                                        conn->compression_level,
+                                        conn->pool));
+  conn->read_ptr = conn->read_buf;
+  conn->read_end = conn->read_buf;
+  conn->stream_compressed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* --- WRITING TUPLES --- */
 
 static svn_error_t *
@@ -1513,20 +1635,20 @@ svn_ra_svn__read_cmd_response(svn_ra_svn_conn_t *conn,
                            status);
 }
 
-static svn_error_t *
+svn_error_t *
 svn_ra_svn__handle_command(svn_boolean_t *terminate,
                            apr_hash_t *cmd_hash,
                            void *baton,
                            svn_ra_svn_conn_t *conn,
                            svn_boolean_t error_on_disconnect,
-                           apr_pool_t *iterpool)
+                           apr_pool_t *pool)
 {
   const char *cmdname;
   svn_error_t *err, *write_err;
   apr_array_header_t *params;
   const svn_ra_svn_cmd_entry_t *command;
 
-  err = svn_ra_svn__read_tuple(conn, iterpool, "wl", &cmdname, &params);
+  err = svn_ra_svn__read_tuple(conn, pool, "wl", &cmdname, &params);
   if (err)
     {
       if (!error_on_disconnect
@@ -1541,7 +1663,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   command = svn_hash_gets(cmd_hash, cmdname);
 
   if (command)
-    err = (*command->handler)(conn, iterpool, params, baton);
+    err = (*command->handler)(conn, pool, params, baton);
   else
     {
       err = svn_error_createf(SVN_ERR_RA_SVN_UNKNOWN_CMD, NULL,
@@ -1552,7 +1674,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
     {
       write_err = svn_ra_svn__write_cmd_failure(
-                      conn, iterpool,
+                      conn, pool,
                       svn_ra_svn__locate_real_error_child(err));
       svn_error_clear(err);
       if (write_err)
@@ -1565,6 +1687,187 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if the data between P and END starts with a complete
+ * protocol item, i.e. a word, number, string or list including all its
+ * sub-items plus the whitespace that terminates it.  Leading whitespace
+ * is skipped.  Malformed data counts as complete as the parser will
+ * report it as such anyway.
+ */
+static svn_boolean_t
+is_complete_item(const char *p, const char *end)
+{
+  int level = 0;
+
+  while (p < end && svn_iswhitespace(*p))
+    p++;
+
+  while (p < end)
+    {
+      if (*p == '(')
+        {
+          level++;
+          p++;
+        }
+      else if (*p == ')')
+        {
+          if (--level < 0)
+            return TRUE;
+          p++;
+        }
+      else if (svn_ctype_isdigit(*p))
+        {
+          apr_uint64_t len = 0;
+
+          for (; p < end && svn_ctype_isdigit(*p); p++)
+            len = len * 10 + (*p - '0');
+          if (p == end)
+            return FALSE;
+
+          /* Skip the contents of strings, which may contain anything. */
+          if (*p == ':')
+            {
+              if (len >= (apr_uint64_t)(end - p))
+                return FALSE;
+              p += len + 1;
+            }
+        }
+      else if (svn_ctype_isalpha(*p))
+        {
+          while (p < end && (svn_ctype_isalnum(*p) || *p == '-'))
+            p++;
+        }
+      else if (svn_iswhitespace(*p))
+        {
+          p++;
+        }
+      else
+        {
+          return TRUE;
+        }
+
+      /* The parser needs to see the whitespace after the item. */
+      if (level == 0)
+        return p < end;
+    }
+
+  return FALSE;
+}
+
+/* Append whatever input is available from the stream of CONN without
+ * blocking to its backlog, but stop once the backlog contains a complete
+ * protocol item or MAX_BUFFERED_COMMAND bytes.  Set *TERMINATED if the
+ * other side closed the connection.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+fill_backlog(svn_boolean_t *terminated,
+             svn_ra_svn_conn_t *conn,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *backlog = conn->backlog;
+
+  while (   !is_complete_item(backlog->data, backlog->data + backlog->len)
+         && backlog->len < MAX_BUFFERED_COMMAND
+         && svn_ra_svn__stream_pending(conn->stream))
+    {
+      apr_size_t len = SVN_RA_SVN__READBUF_SIZE;
+      svn_error_t *err;
+
+      svn_stringbuf_ensure(backlog, backlog->len + len);
+      err = svn_ra_svn__stream_read(conn->stream,
+                                    backlog->data + backlog->len, &len);
+      if (err && err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED)
+        {
+          svn_error_clear(err);
+          *terminated = TRUE;
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
+
+      backlog->len += len;
+      backlog->data[backlog->len] = '\0';
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__has_command(svn_boolean_t *has_command,
+                        svn_boolean_t *terminated,
+                        svn_ra_svn_conn_t *conn,
+                        apr_pool_t *pool)
+{
+  *has_command = FALSE;
+  *terminated = FALSE;
+
+  SVN_ERR(writebuf_flush(conn, pool));
+
+  /* As long as there is no backlog, commands are collected in the read
+     buffer. */
+  while (   !(conn->backlog && conn->backlog->len)
+         && !is_complete_item(conn->read_ptr, conn->read_end))
+    {
+      apr_size_t len;
+      svn_error_t *err;
+
+      /* Move the partial command to the start of the buffer. */
+      if (conn->read_ptr != conn->read_buf)
+        {
+          memmove(conn->read_buf, conn->read_ptr,
+                  conn->read_end - conn->read_ptr);
+          conn->read_end -= conn->read_ptr - conn->read_buf;
+          conn->read_ptr = conn->read_buf;
+        }
+
+      /* A command larger than our buffer continues in the backlog. */
+      len = conn->read_buf + sizeof(conn->read_buf) - conn->read_end;
+      if (len == 0)
+        break;
+
+      if (!svn_ra_svn__stream_pending(conn->stream))
+        return SVN_NO_ERROR;
+
+      err = readbuf_input(conn, conn->read_end, &len, pool);
+      if (err && err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED)
+        {
+          svn_error_clear(err);
+          *terminated = TRUE;
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
+
+      conn->read_end += len;
+    }
+
+  if (is_complete_item(conn->read_ptr, conn->read_end))
+    {
+      *has_command = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* The next command is incomplete and either larger than the read
+     buffer or it continues in the backlog.  Collect all of it in the
+     backlog, so we don't have to wait for the rest while parsing. */
+  if (!conn->backlog)
+    conn->backlog = svn_stringbuf_create_ensure(2 * sizeof(conn->read_buf),
+                                                conn->pool);
+
+  svn_stringbuf_insert(conn->backlog, 0, conn->read_ptr,
+                       conn->read_end - conn->read_ptr);
+  conn->read_ptr = conn->read_buf;
+  conn->read_end = conn->read_buf;
+
+  SVN_ERR(fill_backlog(terminated, conn, pool));
+
+  /* Commands too large to be buffered will be read while parsing them. */
+  *has_command = !*terminated
+              && (conn->backlog->len >= MAX_BUFFERED_COMMAND
+                  || is_complete_item(conn->backlog->data,
+                                      conn->backlog->data
+                                        + conn->backlog->len));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__handle_commands2(svn_ra_svn_conn_t *conn,
                              apr_pool_t *pool,
@@ -67,6 +67,14 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
 #define SVN_RA_SVN__READBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 #define SVN_RA_SVN__WRITEBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 
+/* Limits for the number of commands and the total length of their path
+ * arguments that the client sends ahead of the responses when the server
+ * supports pipelining.  They keep the unread request data well below the
+ * usual socket buffer sizes, so client and server never both block while
+ * writing to each other. */
+#define SVN_RA_SVN__MAX_PIPELINED_COMMANDS 32
+#define SVN_RA_SVN__MAX_PIPELINED_SIZE (2 * SVN_RA_SVN__PAGE_SIZE)
+
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 
@@ -81,6 +89,11 @@ struct svn_ra_svn_conn_st {
   char *read_end;
   apr_size_t write_pos;
 
+  /* Input that has been read from STREAM ahead of the parser because it
+     did not fit into READ_BUF.  It follows the data in READ_BUF and gets
+     consumed before reading from STREAM again.  NULL until needed. */
+  svn_stringbuf_t *backlog;
+
   svn_ra_svn__stream_t *stream;
   svn_ra_svn__session_baton_t *session;
 #ifdef SVN_HAVE_SASL
@@ -109,6 +122,9 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* Whether STREAM compresses everything sent over the wire. */
+  svn_boolean_t stream_compressed;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -185,6 +201,20 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(void *baton,
                                                 ra_svn_pending_fn_t pending_cb,
                                                 apr_pool_t *pool);
 
+/* Set *COMPRESSED to a stream that compresses everything written to it
+ * with zlib at COMPRESSION_LEVEL before passing it on to STREAM and that
+ * decompresses everything read from STREAM.  The LEN bytes at DATA have
+ * already been read from STREAM and will be decompressed first.  Every
+ * write is flushed through the compressor, so the other side can always
+ * decompress all data received so far.  Allocate the result in POOL.
+ */
+svn_error_t *svn_ra_svn__stream_compressed(svn_ra_svn__stream_t **compressed,
+                                           svn_ra_svn__stream_t *stream,
+                                           const char *data,
+                                           apr_size_t len,
+                                           int compression_level,
+                                           apr_pool_t *pool);
+
 /* Write *LEN bytes from DATA to STREAM, returning the number of bytes
  * written in *LEN.
  */
@@ -208,9 +238,26 @@ svn_error_t *svn_ra_svn__read_command_only(svn_ra_svn_conn_t *conn,
 void svn_ra_svn__stream_timeout(svn_ra_svn__stream_t *stream,
                                 apr_interval_time_t interval);
 
+/* Limit the time that reads from STREAM may wait for the other side to
+ * send data to INTERVAL.  Negative values, the default, mean no limit.
+ * Writes are not affected.  Only streams backed by a socket support this.
+ */
+void svn_ra_svn__stream_read_timeout(svn_ra_svn__stream_t *stream,
+                                     apr_interval_time_t interval);
+
 /* Return whether or not there is data pending on STREAM. */
 svn_boolean_t svn_ra_svn__stream_pending(svn_ra_svn__stream_t *stream);
 
+/* Return whether svn_ra_svn__stream_sendfile() can be used with STREAM. */
+svn_boolean_t svn_ra_svn__stream_can_sendfile(svn_ra_svn__stream_t *stream);
+
+/* Send LEN bytes starting at OFFSET in FILE to STREAM using sendfile().
+ * STREAM must support that, see svn_ra_svn__stream_can_sendfile(). */
+svn_error_t *svn_ra_svn__stream_sendfile(svn_ra_svn__stream_t *stream,
+                                         apr_file_t *file,
+                                         apr_off_t offset,
+                                         apr_size_t len);
+
 /* Respond to an auth request and perform authentication.  Use the Cyrus
  * SASL library for mechanism negotiation and for creating authentication
  * tokens. */
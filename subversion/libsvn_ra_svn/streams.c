@@ -27,6 +27,8 @@
 #include <apr_network_io.h>
 #include <apr_poll.h>
 
+#include <zlib.h>
+
 #include "svn_types.h"
 #include "svn_error.h"
 #include "svn_pools.h"
@@ -40,11 +42,21 @@ struct svn_ra_svn__stream_st {
   void *baton;
   ra_svn_pending_fn_t pending_fn;
   ra_svn_timeout_fn_t timeout_fn;
+
+  /* Sets the limit for blocking reads.  NULL if not supported. */
+  ra_svn_timeout_fn_t read_timeout_fn;
+
+  /* The socket written to by STREAM, if data can be sent to it directly.
+     NULL otherwise. */
+  apr_socket_t *sock;
 };
 
 typedef struct sock_baton_t {
   apr_socket_t *sock;
   apr_pool_t *pool;
+
+  /* Socket timeout to use while waiting for data to read. */
+  apr_interval_time_t read_timeout;
 } sock_baton_t;
 
 typedef struct file_baton_t {
@@ -53,6 +65,40 @@ typedef struct file_baton_t {
   apr_pool_t *pool;
 } file_baton_t;
 
+typedef struct compressed_baton_t {
+  /* The stream carrying the compressed data. */
+  svn_ra_svn__stream_t *stream;
+
+  /* Compressor for the outgoing and decompressor for the incoming data. */
+  z_stream deflater;
+  z_stream inflater;
+
+  /* Compressed data read from STREAM.  The part not yet decompressed is
+     given by the inflater's NEXT_IN and AVAIL_IN. */
+  char *read_buf;
+
+  /* Set if the last inflate() call filled the caller's buffer, i.e. if
+     the decompressor may still hold output. */
+  svn_boolean_t inflate_pending;
+
+  /* Data decompressed while checking for pending input but not read yet.
+     The unread part is INFLATED[INFLATED_POS .. INFLATED_LEN - 1]. */
+  char *inflated;
+  apr_size_t inflated_pos;
+  apr_size_t inflated_len;
+
+  /* Error encountered while checking for pending input.  It will be
+     returned by the next read. */
+  svn_error_t *pending_err;
+
+  /* Compressed data that still has to be written to STREAM. */
+  svn_stringbuf_t *write_buf;
+  apr_size_t write_pos;
+} compressed_baton_t;
+
+/* Size of the buffer for compressed data read from the wrapped stream. */
+#define COMPRESSED_READBUF_SIZE SVN_RA_SVN__READBUF_SIZE
+
 /* Returns TRUE if PFD has pending data, FALSE otherwise. */
 static svn_boolean_t pending(apr_pollfd_t *pfd, apr_pool_t *pool)
 {
@@ -143,13 +189,13 @@ sock_read_cb(void *baton, char *buffer, apr_size_t *len)
   if (status)
     return svn_error_wrap_apr(status, _("Can't get socket timeout"));
 
-  /* Always block on read.
+  /* Always block on read, up to the read timeout.
    * During pipelining, we set the timeout to 0 for some write
    * operations so that we can try them without blocking. If APR had
    * separate timeouts for read and write, we would only set the
    * write timeout, but it doesn't. So here, we revert back to blocking.
    */
-  apr_socket_timeout_set(b->sock, -1);
+  apr_socket_timeout_set(b->sock, b->read_timeout);
   status = apr_socket_recv(b->sock, buffer, len);
   apr_socket_timeout_set(b->sock, interval);
 
@@ -179,6 +225,14 @@ sock_timeout_cb(void *baton, apr_interval_time_t interval)
   apr_socket_timeout_set(b->sock, interval);
 }
 
+/* Implements ra_svn_timeout_fn_t */
+static void
+sock_read_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  sock_baton_t *b = baton;
+  b->read_timeout = interval;
+}
+
 /* Implements ra_svn_pending_fn_t */
 static svn_boolean_t
 sock_pending_cb(void *baton)
@@ -198,12 +252,269 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(pool, sizeof(*b));
 
+  svn_ra_svn__stream_t *s;
+
   b->sock = sock;
   b->pool = pool;
+  b->read_timeout = -1;
 
-  return svn_ra_svn__stream_create(b, sock_read_cb, sock_write_cb,
-                                   sock_timeout_cb, sock_pending_cb,
-                                   pool);
+  s = svn_ra_svn__stream_create(b, sock_read_cb, sock_write_cb,
+                                sock_timeout_cb, sock_pending_cb, pool);
+  s->read_timeout_fn = sock_read_timeout_cb;
+  s->sock = sock;
+
+  return s;
+}
+
+/* Functions to implement a zlib compressed svn_ra_svn__stream_t on top of
+   another svn_ra_svn__stream_t. */
+
+/* Return an error describing the zlib error code ZERR for the zlib stream
+   ZSTREAM. */
+static svn_error_t *
+zlib_error(int zerr, z_stream *zstream)
+{
+  return svn_error_createf(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                           _("Compression of connection data failed: %s"),
+                           zstream->msg ? zstream->msg : zError(zerr));
+}
+
+/* Decompress data from B into BUFFER, which can hold *LEN bytes, and set
+   *LEN to the number of bytes returned.  Read from the wrapped stream as
+   needed.  Unless BLOCK is set, don't read from it without data pending
+   there, i.e. return 0 bytes instead of waiting for more input. */
+static svn_error_t *
+inflate_data(compressed_baton_t *b,
+             char *buffer,
+             apr_size_t *len,
+             svn_boolean_t block)
+{
+  /* Large reads are fine to be served partially. */
+  uInt wanted = (uInt)(*len > SVN_RA_SVN__READBUF_SIZE
+                       ? SVN_RA_SVN__READBUF_SIZE
+                       : *len);
+
+  b->inflater.next_out = (Bytef *)buffer;
+  b->inflater.avail_out = wanted;
+
+  /* The sender flushes the compressor after every write, but neither
+     does that align with our reads nor does every chunk of compressed
+     data produce output.  So, read until we have something to return. */
+  while (b->inflater.avail_out == wanted)
+    {
+      int zerr;
+
+      if (b->inflater.avail_in == 0 && !b->inflate_pending)
+        {
+          apr_size_t read_len = COMPRESSED_READBUF_SIZE;
+
+          if (!block && !svn_ra_svn__stream_pending(b->stream))
+            break;
+
+          SVN_ERR(svn_ra_svn__stream_read(b->stream, b->read_buf,
+                                          &read_len));
+          b->inflater.next_in = (Bytef *)b->read_buf;
+          b->inflater.avail_in = (uInt)read_len;
+        }
+
+      zerr = inflate(&b->inflater, Z_SYNC_FLUSH);
+      if (zerr == Z_BUF_ERROR)
+        {
+          /* The decompressor needs more input. */
+          b->inflate_pending = FALSE;
+          continue;
+        }
+      if (zerr != Z_OK)
+        return zlib_error(zerr, &b->inflater);
+
+      b->inflate_pending = (b->inflater.avail_out == 0);
+    }
+
+  *len = wanted - b->inflater.avail_out;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t */
+static svn_error_t *
+compressed_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+
+  /* Serve whatever the last pending check left for us first. */
+  if (b->inflated_pos < b->inflated_len)
+    {
+      if (*len > b->inflated_len - b->inflated_pos)
+        *len = b->inflated_len - b->inflated_pos;
+
+      memcpy(buffer, b->inflated + b->inflated_pos, *len);
+      b->inflated_pos += *len;
+      return SVN_NO_ERROR;
+    }
+
+  if (b->pending_err)
+    {
+      svn_error_t *err = b->pending_err;
+      b->pending_err = SVN_NO_ERROR;
+      return err;
+    }
+
+  return inflate_data(b, buffer, len, TRUE);
+}
+
+/* Implements svn_write_fn_t */
+static svn_error_t *
+compressed_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+
+  /* Unless we are still trying to send the data from the previous call,
+     which was made with the same arguments, compress BUFFER. */
+  if (b->write_pos == b->write_buf->len)
+    {
+      svn_stringbuf_setempty(b->write_buf);
+      b->write_pos = 0;
+
+      b->deflater.next_in = (Bytef *)buffer;
+      b->deflater.avail_in = (uInt)*len;
+
+      /* Flush the compressor, so the receiver can process every message
+         as soon as it arrives. */
+      do
+        {
+          int zerr;
+
+          svn_stringbuf_ensure(b->write_buf,
+                               b->write_buf->len + SVN_RA_SVN__PAGE_SIZE);
+          b->deflater.next_out
+            = (Bytef *)b->write_buf->data + b->write_buf->len;
+          b->deflater.avail_out
+            = (uInt)(b->write_buf->blocksize - b->write_buf->len - 1);
+
+          zerr = deflate(&b->deflater, Z_SYNC_FLUSH);
+          if (zerr != Z_OK && zerr != Z_BUF_ERROR)
+            return zlib_error(zerr, &b->deflater);
+
+          b->write_buf->len = (char *)b->deflater.next_out
+                            - b->write_buf->data;
+        }
+      while (b->deflater.avail_out == 0);
+    }
+
+  while (b->write_pos < b->write_buf->len)
+    {
+      apr_size_t count = b->write_buf->len - b->write_pos;
+
+      SVN_ERR(svn_ra_svn__stream_write(b->stream,
+                                       b->write_buf->data + b->write_pos,
+                                       &count));
+      if (count == 0)
+        {
+          /* The remainder will be written during the next call to this
+             function, which will have the same arguments. */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+
+      b->write_pos += count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t */
+static void
+compressed_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compressed_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements ra_svn_timeout_fn_t */
+static void
+compressed_read_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compressed_baton_t *b = baton;
+  svn_ra_svn__stream_read_timeout(b->stream, interval);
+}
+
+/* Implements ra_svn_pending_fn_t */
+static svn_boolean_t
+compressed_pending_cb(void *baton)
+{
+  compressed_baton_t *b = baton;
+  apr_size_t len = SVN_RA_SVN__READBUF_SIZE;
+
+  if (b->inflated_pos < b->inflated_len || b->pending_err)
+    return TRUE;
+
+  /* Compressed input is not necessarily enough to produce any output.
+     So, the only way to tell whether a read would block is to decompress
+     as much as we can get without blocking and keep the result. */
+  b->pending_err = inflate_data(b, b->inflated, &len, FALSE);
+  b->inflated_pos = 0;
+  b->inflated_len = b->pending_err ? 0 : len;
+
+  return b->inflated_len > 0 || b->pending_err;
+}
+
+/* Pool cleanup function releasing the zlib state and any unreported
+   error of the compressed_baton_t DATA. */
+static apr_status_t
+compressed_cleanup(void *data)
+{
+  compressed_baton_t *b = data;
+
+  deflateEnd(&b->deflater);
+  inflateEnd(&b->inflater);
+  svn_error_clear(b->pending_err);
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t **compressed,
+                              svn_ra_svn__stream_t *stream,
+                              const char *data,
+                              apr_size_t len,
+                              int compression_level,
+                              apr_pool_t *pool)
+{
+  compressed_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  int zerr;
+
+  SVN_ERR_ASSERT(len <= COMPRESSED_READBUF_SIZE);
+
+  b->stream = stream;
+  b->read_buf = apr_palloc(pool, COMPRESSED_READBUF_SIZE);
+  b->inflated = apr_palloc(pool, SVN_RA_SVN__READBUF_SIZE);
+  b->write_buf = svn_stringbuf_create_ensure(SVN_RA_SVN__WRITEBUF_SIZE,
+                                             pool);
+
+  zerr = deflateInit(&b->deflater, compression_level);
+  if (zerr != Z_OK)
+    return zlib_error(zerr, &b->deflater);
+
+  zerr = inflateInit(&b->inflater);
+  if (zerr != Z_OK)
+    {
+      deflateEnd(&b->deflater);
+      return zlib_error(zerr, &b->inflater);
+    }
+
+  apr_pool_cleanup_register(pool, b, compressed_cleanup,
+                            apr_pool_cleanup_null);
+
+  /* DATA has already been received but belongs to the compressed part. */
+  memcpy(b->read_buf, data, len);
+  b->inflater.next_in = (Bytef *)b->read_buf;
+  b->inflater.avail_in = (uInt)len;
+
+  *compressed = svn_ra_svn__stream_create(b, compressed_read_cb,
+                                          compressed_write_cb,
+                                          compressed_timeout_cb,
+                                          compressed_pending_cb, pool);
+  (*compressed)->read_timeout_fn = compressed_read_timeout_cb;
+  return SVN_NO_ERROR;
 }
 
 svn_ra_svn__stream_t *
@@ -224,6 +535,8 @@ svn_ra_svn__stream_create(void *baton,
   s->baton = baton;
   s->timeout_fn = timeout_cb;
   s->pending_fn = pending_cb;
+  s->read_timeout_fn = NULL;
+  s->sock = NULL;
   return s;
 }
 
@@ -248,8 +561,68 @@ svn_ra_svn__stream_timeout(svn_ra_svn__stream_t *stream,
   stream->timeout_fn(stream->baton, interval);
 }
 
+void
+svn_ra_svn__stream_read_timeout(svn_ra_svn__stream_t *stream,
+                                apr_interval_time_t interval)
+{
+  if (stream->read_timeout_fn)
+    stream->read_timeout_fn(stream->baton, interval);
+}
+
 svn_boolean_t
 svn_ra_svn__stream_pending(svn_ra_svn__stream_t *stream)
 {
   return stream->pending_fn(stream->baton);
 }
+
+svn_boolean_t
+svn_ra_svn__stream_can_sendfile(svn_ra_svn__stream_t *stream)
+{
+#if APR_HAS_SENDFILE
+  return stream->sock != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+svn_error_t *
+svn_ra_svn__stream_sendfile(svn_ra_svn__stream_t *stream,
+                            apr_file_t *file,
+                            apr_off_t offset,
+                            apr_size_t len)
+{
+#if APR_HAS_SENDFILE
+  apr_status_t status = APR_SUCCESS;
+  apr_interval_time_t interval;
+
+  SVN_ERR_ASSERT(stream->sock);
+
+  status = apr_socket_timeout_get(stream->sock, &interval);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get socket timeout"));
+
+  /* Always block, just like sock_read_cb. */
+  apr_socket_timeout_set(stream->sock, -1);
+  while (len > 0 && status == APR_SUCCESS)
+    {
+      apr_off_t file_offset = offset;
+      apr_size_t count = len;
+
+      status = apr_socket_sendfile(stream->sock, file, NULL, &file_offset,
+                                   &count, 0);
+      if (status == APR_SUCCESS && count == 0)
+        status = APR_EOF;
+
+      offset += count;
+      len -= count;
+    }
+  apr_socket_timeout_set(stream->sock, interval);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+#endif
+}
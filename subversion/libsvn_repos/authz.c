@@ -36,12 +36,18 @@
 #include "svn_config.h"
 #include "svn_ctype.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
 #include "repos.h"
 
 
 /*** Structures. ***/
 
+/* Maximum number of compiled rule sets that we keep per authz object.
+   Once that limit has been reached, all of them will be discarded and
+   recompiled on demand. */
+#define AUTHZ_MAX_COMPILED_RULES 1000
+
 /* Information for the config enumerators called during authz
    lookup. */
 struct authz_lookup_baton {
@@ -51,24 +57,55 @@ struct authz_lookup_baton {
   /* The user to authorize. */
   const char *user;
 
+  /* The names of all groups that contain USER and of all aliases that
+     refer to USER.  The values are irrelevant.  Unused for anonymous
+     lookups. */
+  apr_hash_t *user_groups;
+  apr_hash_t *user_aliases;
+
   /* Explicitly granted rights. */
   svn_repos_authz_access_t allow;
   /* Explicitly denied rights. */
   svn_repos_authz_access_t deny;
+};
+
+/* One path segment in the tree of rules compiled for a given user and
+   repository. */
+typedef struct authz_rule_node_t
+{
+  /* Rights explicitly granted and denied to the user by the
+     repository-specific section for this path. */
+  svn_repos_authz_access_t repos_allow;
+  svn_repos_authz_access_t repos_deny;
+
+  /* Rights explicitly granted and denied to the user by the
+     pan-repository section for this path. */
+  svn_repos_authz_access_t allow;
+  svn_repos_authz_access_t deny;
 
-  /* The rights required by the caller of the lookup. */
-  svn_repos_authz_access_t required_access;
+  /* Rights that are denied to the user by any section, repository-specific
+     or not, for this path or any path below it. */
+  svn_repos_authz_access_t subtree_deny;
 
-  /* The following are used exclusively in recursive lookups. */
+  /* Sub-nodes (authz_rule_node_t *) keyed by path segment.  NULL if
+     there are no rules below this path. */
+  apr_hash_t *children;
+} authz_rule_node_t;
 
-  /* The path in the repository (an fspath) to authorize. */
-  const char *repos_path;
-  /* repos_path prefixed by the repository name and a colon. */
-  const char *qualified_repos_path;
+/* All sections of the authz configuration that apply to a given user
+   and repository, compiled into a tree of path segments.  A lookup
+   merely needs to walk down that tree, the user's group memberships
+   and the section rules have already been resolved. */
+typedef struct authz_rules_t
+{
+  /* The rules for the repository root. */
+  authz_rule_node_t *root;
 
-  /* Whether, at the end of a recursive lookup, access is granted. */
-  svn_boolean_t access;
-};
+  /* Bit number ACCESS (a combination of svn_authz_read and
+     svn_authz_write) is set if any section grants all of ACCESS to the
+     user. */
+  unsigned int any_access;
+} authz_rules_t;
 
 /* Information for the config enumeration functions called during the
    validation process. */
@@ -78,11 +115,21 @@ struct authz_validate_baton {
                            enumerator, if any. */
 };
 
-/* Currently this structure is just a wrapper around a svn_config_t.
-   Please update authz_pool if you modify this structure. */
+/* The authz configuration along with the rules compiled from it. */
 struct svn_authz_t
 {
+  /* The parsed authz file. */
   svn_config_t *cfg;
+
+  /* Compiled rules (authz_rules_t *) keyed by repository name and user,
+     see authz_get_rules().  The hash and its contents are allocated in
+     RULES_POOL. */
+  apr_hash_t *rules;
+  apr_pool_t *rules_pool;
+
+  /* Serializes access to RULES.  Authz objects may be shared between
+     threads through the authz pool. */
+  svn_mutex__t *mutex;
 };
 
 
@@ -242,11 +289,9 @@ authz_line_applies_to_user(const char *rule_match_string,
    * a user, alias or group rule.
    */
   if (rule_match_string[0] == '@')
-    return authz_group_contains_user(
-      b->config, &rule_match_string[1], b->user, pool);
+    return svn_hash_gets(b->user_groups, &rule_match_string[1]) != NULL;
   else if (rule_match_string[0] == '&')
-    return authz_alias_is_user(
-      b->config, &rule_match_string[1], b->user, pool);
+    return svn_hash_gets(b->user_aliases, &rule_match_string[1]) != NULL;
   else
     return (strcmp(b->user, rule_match_string) == 0);
 }
@@ -280,201 +325,463 @@ authz_parse_line(const char *name, const char *value,
 }
 
 
-/* Return TRUE iff the access rules in SECTION_NAME apply to PATH_SPEC
- * (which is a repository name, colon, and repository fspath, such as
- * "myrepos:/trunk/foo").
+/* Callback to record in the authz_lookup_baton whether the user is a
+ * member of the group NAME.  Implements svn_config_enumerator2_t.
  */
 static svn_boolean_t
-is_applicable_section(const char *path_spec,
-                      const char *section_name)
+authz_collect_user_group(const char *name, const char *value,
+                         void *baton, apr_pool_t *pool)
 {
-  apr_size_t path_spec_len = strlen(path_spec);
+  struct authz_lookup_baton *b = baton;
+
+  if (authz_group_contains_user(b->config, name, b->user, pool))
+    svn_hash_sets(b->user_groups, name, "");
 
-  return ((strncmp(path_spec, section_name, path_spec_len) == 0)
-          && (path_spec[path_spec_len - 1] == '/'
-              || section_name[path_spec_len] == '/'
-              || section_name[path_spec_len] == '\0'));
+  return TRUE;
 }
 
 
-/* Callback to parse a section and update the authz_baton if the
- * section denies access to the subtree the baton describes.
+/* Callback to record in the authz_lookup_baton whether the alias NAME
+ * refers to the user.  Implements svn_config_enumerator2_t.
  */
 static svn_boolean_t
-authz_parse_section(const char *section_name, void *baton, apr_pool_t *pool)
+authz_collect_user_alias(const char *name, const char *value,
+                         void *baton, apr_pool_t *pool)
 {
   struct authz_lookup_baton *b = baton;
-  svn_boolean_t conclusive;
 
-  /* Does the section apply to us? */
-  if (!is_applicable_section(b->qualified_repos_path, section_name)
-      && !is_applicable_section(b->repos_path, section_name))
-    return TRUE;
+  if (strcmp(value, b->user) == 0)
+    svn_hash_sets(b->user_aliases, name, "");
 
-  /* Work out what this section grants. */
-  b->allow = b->deny = 0;
-  svn_config_enumerate2(b->config, section_name,
-                        authz_parse_line, b, pool);
+  return TRUE;
+}
+
+
+/* Information for the section enumerator called while compiling the
+   rules for a user. */
+struct authz_compile_baton {
+  /* The user and their group memberships. */
+  struct authz_lookup_baton lookup;
+
+  /* The repository the rules are being compiled for. */
+  const char *repos_name;
 
-  /* Has the section explicitly determined an access? */
-  conclusive = authz_access_is_determined(b->allow, b->deny,
-                                          b->required_access);
+  /* The rules compiled so far, allocated in RESULT_POOL. */
+  authz_rules_t *rules;
+  apr_pool_t *result_pool;
+};
+
+
+/* Return the sub-node of NODE for the path segment given by the first
+ * LEN bytes of SEGMENT.  If it does not exist yet, create it in
+ * RESULT_POOL.
+ */
+static authz_rule_node_t *
+authz_ensure_child_node(authz_rule_node_t *node,
+                        const char *segment,
+                        apr_size_t len,
+                        apr_pool_t *result_pool)
+{
+  authz_rule_node_t *child;
+
+  if (!node->children)
+    node->children = apr_hash_make(result_pool);
 
-  /* Is access granted OR inconclusive? */
-  b->access = authz_access_is_granted(b->allow, b->deny,
-                                      b->required_access)
-    || !conclusive;
+  child = apr_hash_get(node->children, segment, len);
+  if (!child)
+    {
+      child = apr_pcalloc(result_pool, sizeof(*child));
+      apr_hash_set(node->children,
+                   apr_pstrmemdup(result_pool, segment, len), len, child);
+    }
 
-  /* As long as access isn't conclusively denied, carry on. */
-  return b->access;
+  return child;
 }
 
 
-/* Validate access to the given user for the given path.  This
- * function checks rules for exactly the given path, and first tries
- * to access a section specific to the given repository before falling
- * back to pan-repository rules.
- *
- * Update *access_granted to inform the caller of the outcome of the
- * lookup.  Return a boolean indicating whether the access rights were
- * successfully determined.
+/* Callback to add the rules in SECTION_NAME that apply to the user to
+ * the tree in the authz_compile_baton.  Implements
+ * svn_config_section_enumerator2_t.
  */
 static svn_boolean_t
-authz_get_path_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
-                      svn_repos_authz_access_t required_access,
-                      svn_boolean_t *access_granted,
+authz_compile_section(const char *section_name, void *baton,
                       apr_pool_t *pool)
 {
-  const char *qualified_path;
-  struct authz_lookup_baton baton = { 0 };
+  struct authz_compile_baton *cb = baton;
+  struct authz_lookup_baton *b = &cb->lookup;
+  const char *path = section_name;
+  svn_boolean_t repos_specific = FALSE;
+  svn_repos_authz_access_t denied;
+  authz_rule_node_t *node;
+  int access;
+
+  /* Pan-repository sections are named after the path, repository-specific
+     ones get the repository name and a colon prepended.  Everything else,
+     like the "groups" section or the rules for other repositories, does
+     not concern us. */
+  if (section_name[0] != '/')
+    {
+      apr_size_t len = strlen(cb->repos_name);
 
-  baton.config = cfg;
-  baton.user = user;
+      if (strncmp(section_name, cb->repos_name, len) != 0
+          || section_name[len] != ':' || section_name[len + 1] != '/')
+        return TRUE;
 
-  /* Try to locate a repository-specific block first. */
-  qualified_path = apr_pstrcat(pool, repos_name, ":", path, SVN_VA_NULL);
-  svn_config_enumerate2(cfg, qualified_path,
-                        authz_parse_line, &baton, pool);
+      path = &section_name[len + 1];
+      repos_specific = TRUE;
+    }
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
+  /* Work out what this section grants. */
+  b->allow = b->deny = svn_authz_none;
+  svn_config_enumerate2(b->config, section_name,
+                        authz_parse_line, b, pool);
 
-  /* If the first test has determined access, stop now. */
-  if (authz_access_is_determined(baton.allow, baton.deny,
-                                 required_access))
+  /* Sections without any rule for this user don't determine anything. */
+  if (b->allow == svn_authz_none && b->deny == svn_authz_none)
     return TRUE;
 
-  /* No repository specific rule, try pan-repository rules. */
-  svn_config_enumerate2(cfg, path, authz_parse_line, &baton, pool);
+  for (access = svn_authz_read;
+       access <= (svn_authz_read | svn_authz_write);
+       ++access)
+    if ((b->allow & access) == access)
+      cb->rules->any_access |= 1 << access;
+
+  /* Every applicable line either grants or denies each right, so this
+     is what the section conclusively denies. */
+  denied = b->deny & ~b->allow;
+
+  /* Find the node for PATH, which is canonical as we validated the
+     section names. */
+  node = cb->rules->root;
+  node->subtree_deny |= denied;
+  while (path[0] == '/' && path[1] != '\0')
+    {
+      const char *segment = path + 1;
+      apr_size_t len = strcspn(segment, "/");
+
+      node = authz_ensure_child_node(node, segment, len, cb->result_pool);
+      node->subtree_deny |= denied;
+      path = segment + len;
+    }
+
+  if (repos_specific)
+    {
+      node->repos_allow = b->allow;
+      node->repos_deny = b->deny;
+    }
+  else
+    {
+      node->allow = b->allow;
+      node->deny = b->deny;
+    }
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
-  return authz_access_is_determined(baton.allow, baton.deny,
-                                    required_access);
+  return TRUE;
 }
 
 
-/* Validate access to the given user for the subtree starting at the
- * given path.  This function walks the whole authz file in search of
- * rules applying to paths in the requested subtree which deny the
- * requested access.
- *
- * As soon as one is found, or else when the whole ACL file has been
- * searched, return the updated authorization status.
+/* Compile the rules in CFG that apply to USER in repository REPOS_NAME
+ * and return them in *RULES_P, allocated in RESULT_POOL.  USER may be
+ * NULL for anonymous access.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static void
+authz_compile_rules(authz_rules_t **rules_p,
+                    svn_config_t *cfg,
+                    const char *repos_name,
+                    const char *user,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  struct authz_compile_baton baton = { { 0 } };
+
+  baton.lookup.config = cfg;
+  baton.lookup.user = user;
+  baton.repos_name = repos_name;
+  baton.rules = apr_pcalloc(result_pool, sizeof(*baton.rules));
+  baton.rules->root = apr_pcalloc(result_pool, sizeof(*baton.rules->root));
+  baton.result_pool = result_pool;
+
+  /* Resolve groups and aliases once instead of for every rule. */
+  if (user)
+    {
+      baton.lookup.user_groups = apr_hash_make(scratch_pool);
+      baton.lookup.user_aliases = apr_hash_make(scratch_pool);
+
+      svn_config_enumerate2(cfg, "groups", authz_collect_user_group,
+                            &baton.lookup, scratch_pool);
+      svn_config_enumerate2(cfg, "aliases", authz_collect_user_alias,
+                            &baton.lookup, scratch_pool);
+    }
+
+  svn_config_enumerate_sections2(cfg, authz_compile_section,
+                                 &baton, scratch_pool);
+
+  *rules_p = baton.rules;
+}
+
+
+/* Set *RULES_P to the rules of AUTHZ compiled for USER in repository
+ * REPOS_NAME, compiling them first if they are not cached yet.  The
+ * caller must hold AUTHZ's mutex.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+authz_get_rules(const authz_rules_t **rules_p,
+                svn_authz_t *authz,
+                const char *repos_name,
+                const char *user,
+                apr_pool_t *scratch_pool)
+{
+  /* Prefix the repository name by its length and mark anonymous access
+     to make the key unambiguous. */
+  const char *key = apr_psprintf(scratch_pool, "%c%" APR_SIZE_T_FMT ":%s%s",
+                                 user ? 'u' : 'a', strlen(repos_name),
+                                 repos_name, user ? user : "");
+  authz_rules_t *rules = svn_hash_gets(authz->rules, key);
+
+  if (!rules)
+    {
+      if (apr_hash_count(authz->rules) >= AUTHZ_MAX_COMPILED_RULES)
+        {
+          svn_pool_clear(authz->rules_pool);
+          authz->rules = apr_hash_make(authz->rules_pool);
+        }
+
+      authz_compile_rules(&rules, authz->cfg, repos_name, user,
+                          authz->rules_pool, scratch_pool);
+      svn_hash_sets(authz->rules, apr_pstrdup(authz->rules_pool, key),
+                    rules);
+    }
+
+  *rules_p = rules;
+  return SVN_NO_ERROR;
+}
+
+
+/* Update *ACCESS_GRANTED if the rules in NODE determine the
+ * REQUIRED_ACCESS.  Repository-specific rules take precedence over
+ * pan-repository rules for the same path.
+ */
+static void
+authz_node_update_access(svn_boolean_t *access_granted,
+                         const authz_rule_node_t *node,
+                         svn_repos_authz_access_t required_access)
+{
+  svn_repos_authz_access_t allow = node->repos_allow;
+  svn_repos_authz_access_t deny = node->repos_deny;
+
+  if (!authz_access_is_determined(allow, deny, required_access))
+    {
+      allow |= node->allow;
+      deny |= node->deny;
+    }
+
+  if (authz_access_is_determined(allow, deny, required_access))
+    *access_granted = authz_access_is_granted(allow, deny, required_access);
+}
+
+
+/* Walk down from *NODE_P along the path segments in the first LEN bytes
+ * of PATH, each of which is preceded by a '/', and update
+ * *ACCESS_GRANTED with the rules of every node on the way.  Set *NODE_P
+ * to the node for the last segment or to NULL if there are no rules for
+ * it nor for anything below it.
+ */
+static void
+authz_rules_walk(const authz_rule_node_t **node_p,
+                 svn_boolean_t *access_granted,
+                 const char *path,
+                 apr_size_t len,
+                 svn_repos_authz_access_t required_access)
+{
+  const authz_rule_node_t *node = *node_p;
+  const char *end = path + len;
+
+  while (node && path < end)
+    {
+      const char *segment = path + 1;
+      const char *next = memchr(segment, '/', end - segment);
+
+      if (!next)
+        next = end;
+
+      node = node->children
+           ? apr_hash_get(node->children, segment, next - segment)
+           : NULL;
+      if (node)
+        authz_node_update_access(access_granted, node, required_access);
+
+      path = next;
+    }
+
+  *node_p = node;
+}
+
+
+/* Return the REQUIRED_ACCESS to the path that NODE stands for, given
+ * that its rules and those of its parents resulted in ACCESS_GRANTED.
+ * For recursive access, no rule at or below the path may deny the
+ * access.  NODE may be NULL if there are no such rules.
  */
 static svn_boolean_t
-authz_get_tree_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
-                      svn_repos_authz_access_t required_access,
-                      apr_pool_t *pool)
+authz_rules_finish(const authz_rule_node_t *node,
+                   svn_boolean_t access_granted,
+                   svn_repos_authz_access_t required_access)
 {
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.repos_path = path;
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":", path, SVN_VA_NULL);
-  /* Default to access granted if no rules say otherwise. */
-  baton.access = TRUE;
-
-  svn_config_enumerate_sections2(cfg, authz_parse_section,
-                                 &baton, pool);
+  if (node && access_granted && (required_access & svn_authz_recursive))
+    return !(node->subtree_deny & required_access);
 
-  return baton.access;
+  return access_granted;
 }
 
 
-/* Callback to parse sections of the configuration file, looking for
-   any kind of granted access.  Implements the
-   svn_config_section_enumerator2_t interface. */
+/* Return TRUE if RULES grant REQUIRED_ACCESS to PATH, a canonical
+ * fspath.  The rules of the nearest path, starting with PATH itself and
+ * walking up to the root, that determine the access decide; without
+ * any, access is denied.
+ */
 static svn_boolean_t
-authz_get_any_access_parser_cb(const char *section_name, void *baton,
-                               apr_pool_t *pool)
+authz_rules_check_access(const authz_rules_t *rules,
+                         const char *path,
+                         svn_repos_authz_access_t required_access)
 {
-  struct authz_lookup_baton *b = baton;
+  const authz_rule_node_t *node = rules->root;
+  svn_boolean_t access_granted = FALSE;
+
+  /* Treat the root as the empty path, so that every segment of PATH is
+     preceded by a '/'. */
+  authz_node_update_access(&access_granted, node, required_access);
+  authz_rules_walk(&node, &access_granted, path,
+                   path[1] ? strlen(path) : 0, required_access);
+
+  return authz_rules_finish(node, access_granted, required_access);
+}
+
+
+/* Like authz_rules_check_access() but set ACCESS_GRANTED[i] for the
+ * i-th element of PATHS, an array of const char * fspaths.  Consecutive
+ * paths within the same directory share the walk down to that directory.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+authz_rules_check_access_many(svn_boolean_t *access_granted,
+                              const authz_rules_t *rules,
+                              const apr_array_header_t *paths,
+                              svn_repos_authz_access_t required_access,
+                              apr_pool_t *scratch_pool)
+{
+  const char *parent = NULL;
+  apr_size_t parent_len = 0;
+  const authz_rule_node_t *parent_node = NULL;
+  svn_boolean_t parent_granted = FALSE;
+  int i;
 
-  /* Does the section apply to the query? */
-  if (section_name[0] == '/'
-      || strncmp(section_name, b->qualified_repos_path,
-                 strlen(b->qualified_repos_path)) == 0)
+  for (i = 0; i < paths->nelts; ++i)
     {
-      b->allow = b->deny = svn_authz_none;
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const authz_rule_node_t *node;
+      svn_boolean_t granted;
+      apr_size_t len;
+      apr_size_t dir_len;
+
+      if (!svn_fspath__is_canonical(path))
+        path = svn_fspath__canonicalize(path, scratch_pool);
+
+      len = path[1] ? strlen(path) : 0;
+      dir_len = strrchr(path, '/') - path;
+
+      if (!parent || dir_len != parent_len
+          || memcmp(parent, path, dir_len) != 0)
+        {
+          parent = path;
+          parent_len = dir_len;
+          parent_node = rules->root;
+          parent_granted = FALSE;
+
+          authz_node_update_access(&parent_granted, parent_node,
+                                   required_access);
+          authz_rules_walk(&parent_node, &parent_granted, path, dir_len,
+                           required_access);
+        }
 
-      svn_config_enumerate2(b->config, section_name,
-                            authz_parse_line, baton, pool);
-      b->access = authz_access_is_granted(b->allow, b->deny,
-                                          b->required_access);
+      node = parent_node;
+      granted = parent_granted;
+      authz_rules_walk(&node, &granted, path + dir_len, len - dir_len,
+                       required_access);
 
-      /* Continue as long as we don't find a determined, granted access. */
-      return !(b->access
-               && authz_access_is_determined(b->allow, b->deny,
-                                             b->required_access));
+      access_granted[i] = authz_rules_finish(node, granted, required_access);
     }
 
-  return TRUE;
+  return SVN_NO_ERROR;
 }
 
 
-/* Walk through the authz CFG to check if USER has the REQUIRED_ACCESS
- * to any path within the REPOSITORY.  Return TRUE if so.  Use POOL
- * for temporary allocations. */
+/* Return TRUE if RULES grant REQUIRED_ACCESS to any path within the
+ * repository.
+ */
 static svn_boolean_t
-authz_get_any_access(svn_config_t *cfg, const char *repos_name,
-                     const char *user,
-                     svn_repos_authz_access_t required_access,
-                     apr_pool_t *pool)
+authz_rules_any_access(const authz_rules_t *rules,
+                       svn_repos_authz_access_t required_access)
 {
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.access = FALSE; /* Deny access by default. */
-  baton.repos_path = "/";
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":/", SVN_VA_NULL);
-
-  /* We could have used svn_config_enumerate2 for "repos_name:/".
-   * However, this requires access for root explicitly (which the user
-   * may not always have). So we end up enumerating the sections in
-   * the authz CFG and stop on the first match with some access for
-   * this user. */
-  svn_config_enumerate_sections2(cfg, authz_get_any_access_parser_cb,
-                                 &baton, pool);
+  int access = required_access & (svn_authz_read | svn_authz_write);
 
-  /* If walking the configuration was inconclusive, deny access. */
-  if (!authz_access_is_determined(baton.allow,
-                                  baton.deny, baton.required_access))
-    return FALSE;
+  return access != svn_authz_none && (rules->any_access & (1 << access));
+}
+
+
+/* Determine whether USER has the REQUIRED_ACCESS to PATH (a canonical
+ * fspath or NULL for "anywhere") in repository REPOS_NAME according to
+ * AUTHZ and return the result in *ACCESS_GRANTED.  The caller must hold
+ * AUTHZ's mutex.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+authz_check_access(svn_boolean_t *access_granted,
+                   svn_authz_t *authz,
+                   const char *repos_name,
+                   const char *path,
+                   const char *user,
+                   svn_repos_authz_access_t required_access,
+                   apr_pool_t *scratch_pool)
+{
+  const authz_rules_t *rules;
+
+  SVN_ERR(authz_get_rules(&rules, authz, repos_name, user, scratch_pool));
+
+  if (path)
+    *access_granted = authz_rules_check_access(rules, path,
+                                               required_access);
+  else
+    *access_granted = authz_rules_any_access(rules, required_access);
 
-  return baton.access;
+  return SVN_NO_ERROR;
 }
 
 
-
+/* Like authz_check_access() but for all fspaths in PATHS at once, see
+ * svn_repos__authz_check_access_many().  The caller must hold AUTHZ's
+ * mutex.
+ */
+static svn_error_t *
+authz_check_access_many(svn_boolean_t *access_granted,
+                        svn_authz_t *authz,
+                        const char *repos_name,
+                        const apr_array_header_t *paths,
+                        const char *user,
+                        svn_repos_authz_access_t required_access,
+                        apr_pool_t *scratch_pool)
+{
+  const authz_rules_t *rules;
+
+  SVN_ERR(authz_get_rules(&rules, authz, repos_name, user, scratch_pool));
+
+  return svn_error_trace(authz_rules_check_access_many(access_granted, rules,
+                                                       paths,
+                                                       required_access,
+                                                       scratch_pool));
+}
+
+
+
 /*** Validating the authz file. ***/
 
 /* Check for errors in GROUP's definition of CFG.  The errors
@@ -930,21 +1237,39 @@ authz_copy_groups(svn_authz_t *authz, svn_config_t *groups_cfg,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos__authz_create(svn_authz_t **authz_p, svn_config_t *cfg,
+                        svn_boolean_t thread_safe, apr_pool_t *pool)
+{
+  svn_authz_t *authz = apr_pcalloc(pool, sizeof(*authz));
+
+  authz->cfg = cfg;
+  authz->rules_pool = svn_pool_create(pool);
+  authz->rules = apr_hash_make(authz->rules_pool);
+  SVN_ERR(svn_mutex__init(&authz->mutex, thread_safe, pool));
+
+  *authz_p = authz;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos__authz_read(svn_authz_t **authz_p, const char *path,
                       const char *groups_path, svn_boolean_t must_exist,
                       svn_boolean_t accept_urls, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_authz_t *authz;
+  svn_config_t *cfg;
 
   /* Load the authz file */
   if (accept_urls)
-    SVN_ERR(svn_repos__retrieve_config(&authz->cfg, path, must_exist, TRUE,
+    SVN_ERR(svn_repos__retrieve_config(&cfg, path, must_exist, TRUE,
                                        pool));
   else
-    SVN_ERR(svn_config_read3(&authz->cfg, path, must_exist, TRUE, TRUE,
+    SVN_ERR(svn_config_read3(&cfg, path, must_exist, TRUE, TRUE,
                              pool));
 
+  SVN_ERR(svn_repos__authz_create(&authz, cfg, TRUE, pool));
+
   if (groups_path)
     {
       svn_config_t *groups_cfg;
@@ -994,10 +1319,12 @@ svn_error_t *
 svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
                       svn_stream_t *groups_stream, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_authz_t *authz;
+  svn_config_t *cfg;
 
   /* Parse the authz stream */
-  SVN_ERR(svn_config_parse(&authz->cfg, stream, TRUE, TRUE, pool));
+  SVN_ERR(svn_config_parse(&cfg, stream, TRUE, TRUE, pool));
+  SVN_ERR(svn_repos__authz_create(&authz, cfg, TRUE, pool));
 
   if (groups_stream)
     {
@@ -1024,51 +1351,123 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool)
 {
-  const char *current_path;
-
   if (!repos_name)
     repos_name = "";
 
-  /* If PATH is NULL, check if the user has *any* access. */
-  if (!path)
+  /* A NULL PATH checks whether the user has *any* access. */
+  if (path)
     {
-      *access_granted = authz_get_any_access(authz->cfg, repos_name,
-                                             user, required_access, pool);
-      return SVN_NO_ERROR;
+      /* Sanity check. */
+      SVN_ERR_ASSERT(path[0] == '/');
+
+      path = svn_fspath__canonicalize(path, pool);
     }
 
-  /* Sanity check. */
-  SVN_ERR_ASSERT(path[0] == '/');
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       authz_check_access(access_granted, authz, repos_name,
+                                          path, user, required_access,
+                                          pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__authz_check_access_many(svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const apr_array_header_t *paths,
+                                  const char *user,
+                                  svn_repos_authz_access_t required_access,
+                                  svn_boolean_t *access_granted,
+                                  apr_pool_t *scratch_pool)
+{
+  if (!repos_name)
+    repos_name = "";
+
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       authz_check_access_many(access_granted, authz,
+                                               repos_name, paths, user,
+                                               required_access,
+                                               scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 
-  /* Determine the granted access for the requested path. */
-  path = svn_fspath__canonicalize(path, pool);
-  current_path = path;
+/*** Batched read authorization. ***/
 
-  while (!authz_get_path_access(authz->cfg, repos_name,
-                                current_path, user,
-                                required_access,
-                                access_granted,
-                                pool))
+/* Baton for authz_read_many_wrapper(). */
+typedef struct authz_read_many_baton_t
+{
+  svn_repos_authz_func_t read_func;
+  svn_repos__authz_read_many_func_t read_many_func;
+  void *read_baton;
+} authz_read_many_baton_t;
+
+/* Check a single PATH in ROOT through the READ_FUNC in BATON, an
+ * authz_read_many_baton_t.  Implements svn_repos_authz_func_t.
+ */
+static svn_error_t *
+authz_read_many_wrapper(svn_boolean_t *allowed,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        void *baton,
+                        apr_pool_t *pool)
+{
+  authz_read_many_baton_t *b = baton;
+
+  return svn_error_trace(b->read_func(allowed, root, path, b->read_baton,
+                                      pool));
+}
+
+void
+svn_repos__authz_read_many_wrap(svn_repos_authz_func_t *authz_read_func,
+                                void **authz_read_baton,
+                                svn_repos_authz_func_t read_func,
+                                svn_repos__authz_read_many_func_t read_many_func,
+                                void *read_baton,
+                                apr_pool_t *result_pool)
+{
+  authz_read_many_baton_t *b = apr_palloc(result_pool, sizeof(*b));
+
+  b->read_func = read_func;
+  b->read_many_func = read_many_func;
+  b->read_baton = read_baton;
+
+  *authz_read_func = authz_read_many_wrapper;
+  *authz_read_baton = b;
+}
+
+svn_error_t *
+svn_repos__authz_read_many(svn_boolean_t *allowed,
+                           svn_fs_root_t *root,
+                           const apr_array_header_t *paths,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Let the callback check all paths at once, if it can. */
+  if (authz_read_func == authz_read_many_wrapper)
     {
-      /* Stop if the loop hits the repository root with no
-         results. */
-      if (current_path[0] == '/' && current_path[1] == '\0')
-        {
-          /* Deny access by default. */
-          *access_granted = FALSE;
-          return SVN_NO_ERROR;
-        }
+      authz_read_many_baton_t *b = authz_read_baton;
 
-      /* Work back to the parent path. */
-      current_path = svn_fspath__dirname(current_path, pool);
+      return svn_error_trace(b->read_many_func(allowed, root, paths,
+                                               b->read_baton,
+                                               scratch_pool));
     }
 
-  /* If the caller requested recursive access, we need to walk through
-     the entire authz config to see whether any child paths are denied
-     to the requested user. */
-  if (*access_granted && (required_access & svn_authz_recursive))
-    *access_granted = authz_get_tree_access(authz->cfg, repos_name, path,
-                                            user, required_access, pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(authz_read_func(&allowed[i], root,
+                              APR_ARRAY_IDX(paths, i, const char *),
+                              authz_read_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
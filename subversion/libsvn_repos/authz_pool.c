@@ -40,13 +40,6 @@
 #include "repos.h"
 #include <apr_poll.h>
 
-/* Currently this structure is just a wrapper around a svn_config_t.
- */
-struct svn_authz_t
-{
-  svn_config_t *cfg;
-};
-
 /* The wrapper object structure that we store in the object pool.  It
  * combines the authz with the underlying config structures and their
  * identifying keys.
@@ -78,6 +71,9 @@ struct svn_repos__authz_pool_t
 
   /* factory and storage of (shared) configuration objects */
   svn_repos__config_pool_t *config_pool;
+
+  /* whether the authz objects may be used by multiple threads */
+  svn_boolean_t thread_safe;
 };
 
 /* Return a combination of AUTHZ_KEY and GROUPS_KEY, allocated in POOL.
@@ -138,6 +134,7 @@ svn_repos__authz_pool_create(svn_repos__authz_pool_t **authz_pool,
   result = apr_pcalloc(svn_object_pool__pool(object_pool), sizeof(*result));
   result->object_pool = object_pool;
   result->config_pool = config_pool;
+  result->thread_safe = thread_safe;
 
   *authz_pool = result;
   return SVN_NO_ERROR;
@@ -195,14 +192,11 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
       return SVN_NO_ERROR;
     }
 
-  authz_ref->authz = apr_palloc(authz_ref_pool, sizeof(*authz_ref->authz));
-  authz_ref->authz->cfg = authz_ref->authz_cfg;
-
   if (groups_path)
     {
       /* Easy out: we prohibit local groups in the authz file when global
          groups are being used. */
-      if (svn_config_has_section(authz_ref->authz->cfg,
+      if (svn_config_has_section(authz_ref->authz_cfg,
                                  SVN_CONFIG_SECTION_GROUPS))
         return svn_error_createf(SVN_ERR_AUTHZ_INVALID_CONFIG, NULL,
                                  "Error reading authz file '%s' with "
@@ -213,11 +207,14 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
 
       /* We simply need to add the [Groups] section to the authz config.
        */
-      svn_config__shallow_replace_section(authz_ref->authz->cfg,
+      svn_config__shallow_replace_section(authz_ref->authz_cfg,
                                           authz_ref->groups_cfg,
                                           SVN_CONFIG_SECTION_GROUPS);
     }
 
+  SVN_ERR(svn_repos__authz_create(&authz_ref->authz, authz_ref->authz_cfg,
+                                  authz_pool->thread_safe, authz_ref_pool));
+
   /* Make sure there are no errors in the configuration. */
   SVN_ERR(svn_repos__authz_validate(authz_ref->authz, authz_ref_pool));
 
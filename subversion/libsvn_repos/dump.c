@@ -21,10 +21,15 @@
  */
 
 
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
+
 #include "svn_private_config.h"
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_fs.h"
+#include "svn_cache_config.h"
 #include "svn_hash.h"
 #include "svn_iter.h"
 #include "svn_repos.h"
@@ -39,6 +44,7 @@
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_subr_private.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1512,23 +1518,514 @@ write_revision_record(svn_stream_t *stream,
 }
 
 
+/* Write revision REV of FS to STREAM, i.e. its revision record followed
+   by the nodes changed in it.  START_REV, INCREMENTAL and USE_DELTAS are
+   as for svn_repos_dump_fs4.  Set *FOUND_OLD_REFERENCE and
+   *FOUND_OLD_MERGEINFO when encountering references to revisions older
+   than START_REV; they will never be reset to FALSE.  Send warnings to
+   NOTIFY_FUNC with NOTIFY_BATON and check CANCEL_FUNC with CANCEL_BATON
+   before starting.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+dump_one_revision(svn_stream_t *stream,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  svn_revnum_t start_rev,
+                  svn_boolean_t incremental,
+                  svn_boolean_t use_deltas,
+                  svn_boolean_t *found_old_reference,
+                  svn_boolean_t *found_old_mergeinfo,
+                  svn_repos_notify_func_t notify_func,
+                  void *notify_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Check for cancellation. */
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, fs, rev, scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties. */
+  if (rev == 0)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE,
+                          NULL, scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   NULL,
+                                   NULL,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                NULL, NULL, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Notifications sent by a worker thread, to be delivered later from
+   the main thread. */
+typedef struct collected_notifications_t
+{
+  /* Notifications in the order they were sent.
+     Elements are svn_repos_notify_t *.  May be NULL. */
+  apr_array_header_t *notifications;
+
+  /* Root pool containing NOTIFICATIONS.  May be NULL. */
+  apr_pool_t *pool;
+} collected_notifications_t;
+
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+   collected_notifications_t in BATON. */
+static void
+collect_notification(void *baton,
+                     const svn_repos_notify_t *notify,
+                     apr_pool_t *scratch_pool)
+{
+  collected_notifications_t *collected = baton;
+  svn_repos_notify_t *copy;
+
+  if (collected->pool == NULL)
+    {
+      collected->pool = svn_pool_create(NULL);
+      collected->notifications
+        = apr_array_make(collected->pool, 1, sizeof(svn_repos_notify_t *));
+    }
+
+  copy = apr_pmemdup(collected->pool, notify, sizeof(*notify));
+  copy->warning_str = apr_pstrdup(collected->pool, notify->warning_str);
+  copy->path = apr_pstrdup(collected->pool, notify->path);
+  copy->err = NULL;
+
+  APR_ARRAY_PUSH(collected->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Send all notifications in COLLECTED to NOTIFY_FUNC with NOTIFY_BATON,
+   if that is not NULL.  Use SCRATCH_POOL for temporary allocations. */
+static void
+send_collected_notifications(const collected_notifications_t *collected,
+                             svn_repos_notify_func_t notify_func,
+                             void *notify_baton,
+                             apr_pool_t *scratch_pool)
+{
+  int i;
+
+  if (notify_func && collected->notifications)
+    for (i = 0; i < collected->notifications->nelts; ++i)
+      notify_func(notify_baton,
+                  APR_ARRAY_IDX(collected->notifications, i,
+                                svn_repos_notify_t *),
+                  scratch_pool);
+}
+
+/* Release all memory held by COLLECTED and reset it. */
+static void
+clear_collected_notifications(collected_notifications_t *collected)
+{
+  if (collected->pool)
+    svn_pool_destroy(collected->pool);
+
+  collected->notifications = NULL;
+  collected->pool = NULL;
+}
+
+/* Number of revisions per worker thread that may be dumped ahead of
+   the oldest revision not written to the output stream, yet. */
+#define DUMP_WINDOW_PER_JOB 4
+
+/* Amount of dump data per revision to keep in memory before spilling
+   the remainder to a temporary file. */
+#define DUMP_BUFFER_SIZE (1024 * 1024)
+
+/* Outcome of dumping a single revision in a worker thread. */
+typedef struct dump_result_t
+{
+  /* Dump data of the revision.  May be NULL. */
+  svn_spillbuf_t *buffer;
+
+  /* Warnings sent while dumping the revision. */
+  collected_notifications_t notifications;
+
+  /* References to revisions older than the dump range encountered? */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+
+  /* Error returned by dump_one_revision, if any. */
+  svn_error_t *err;
+
+  /* Root pool containing BUFFER.  May be NULL. */
+  apr_pool_t *pool;
+
+  /* Set once the revision has been dumped. */
+  svn_boolean_t done;
+} dump_result_t;
+
+/* State shared between the thread calling svn_repos_dump_fs4 and its
+   worker threads.  Unless noted otherwise, all members are protected by
+   MUTEX. */
+typedef struct dump_jobs_t
+{
+  /* Repository and FS configuration to open in each worker thread.
+     Read-only. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+
+  /* Revision range and dump options.  Read-only. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+
+  /* Notification and cancellation support.  Read-only. */
+  svn_boolean_t collect_notifications;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Next revision to hand out to a worker. */
+  svn_revnum_t next_rev;
+
+  /* Oldest revision not written to the output stream, yet. */
+  svn_revnum_t first_pending;
+
+  /* If set, workers must not pick up any further revisions. */
+  svn_boolean_t stop;
+
+  /* Number of workers still running. */
+  int active_workers;
+
+  /* First error encountered while setting up a worker, if any. */
+  svn_error_t *setup_err;
+
+  /* Ring buffer of WINDOW_SIZE results, indexed by revision. */
+  dump_result_t *results;
+  int window_size;
+
+  /* Serializes access to the above and signals any change in state. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} dump_jobs_t;
+
+/* Worker thread function.  Dump revisions handed out by the dump_jobs_t
+   in DATA into their respective result buffers until there are no more
+   left or some revision failed. */
+static void * APR_THREAD_FUNC
+dump_worker(apr_thread_t *tid, void *data)
+{
+  dump_jobs_t *jobs = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_repos_t *repos = NULL;
+  svn_error_t *err;
+
+  /* Each worker needs its own FS object as those are not thread-safe. */
+  err = svn_repos_open2(&repos, jobs->repos_path, jobs->fs_config, pool);
+
+  apr_thread_mutex_lock(jobs->mutex);
+  if (err)
+    {
+      jobs->stop = TRUE;
+      if (jobs->setup_err)
+        svn_error_clear(err);
+      else
+        jobs->setup_err = err;
+    }
+
+  while (!jobs->stop && jobs->next_rev <= jobs->end_rev)
+    {
+      svn_revnum_t rev;
+      dump_result_t *result;
+      svn_stream_t *stream;
+
+      /* Don't get too far ahead of the revisions written so far. */
+      if (jobs->next_rev - jobs->first_pending >= jobs->window_size)
+        {
+          apr_thread_cond_wait(jobs->changed, jobs->mutex);
+          continue;
+        }
+
+      rev = jobs->next_rev++;
+      result = &jobs->results[rev % jobs->window_size];
+      apr_thread_mutex_unlock(jobs->mutex);
+
+      svn_pool_clear(iterpool);
+      result->pool = svn_pool_create(NULL);
+      result->buffer = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                            DUMP_BUFFER_SIZE,
+                                            result->pool);
+      stream = svn_stream__from_spillbuf(result->buffer, result->pool);
+      err = dump_one_revision(stream, svn_repos_fs(repos), rev,
+                              jobs->start_rev, jobs->incremental,
+                              jobs->use_deltas,
+                              &result->found_old_reference,
+                              &result->found_old_mergeinfo,
+                              jobs->collect_notifications
+                                ? collect_notification
+                                : NULL,
+                              &result->notifications,
+                              jobs->cancel_func, jobs->cancel_baton,
+                              iterpool);
+
+      apr_thread_mutex_lock(jobs->mutex);
+      result->err = err;
+      result->done = TRUE;
+
+      /* The dump will end with this revision.  Don't waste time on
+         later ones. */
+      if (err)
+        jobs->stop = TRUE;
+
+      apr_thread_cond_broadcast(jobs->changed);
+    }
+
+  --jobs->active_workers;
+  apr_thread_cond_broadcast(jobs->changed);
+  apr_thread_mutex_unlock(jobs->mutex);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Release all resources held by RESULT and mark it as unused. */
+static void
+clear_dump_result(dump_result_t *result)
+{
+  svn_error_clear(result->err);
+  clear_collected_notifications(&result->notifications);
+  if (result->pool)
+    svn_pool_destroy(result->pool);
+
+  memset(result, 0, sizeof(*result));
+}
+
+/* Copy the contents of BUFFER to STREAM.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+write_dump_buffer(svn_stream_t *stream,
+                  svn_spillbuf_t *buffer,
+                  apr_pool_t *scratch_pool)
+{
+  while (TRUE)
+    {
+      const char *data;
+      apr_size_t len;
+
+      SVN_ERR(svn_spillbuf__read(&data, &len, buffer, scratch_pool));
+      if (data == NULL)
+        break;
+
+      SVN_ERR(svn_stream_write(stream, data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump revisions START_REV to END_REV in REPOS to STREAM using JOB_COUNT
+   worker threads.  The output and the notifications sent to NOTIFY_FUNC
+   with NOTIFY_BATON are exactly the same as the single-threaded code in
+   svn_repos_dump_fs4 would produce.  Set *FOUND_OLD_REFERENCE and
+   *FOUND_OLD_MERGEINFO as dump_one_revision does.  INCREMENTAL,
+   USE_DELTAS, CANCEL_FUNC and CANCEL_BATON are as for svn_repos_dump_fs4.
+   Use POOL for allocations. */
+static svn_error_t *
+dump_revisions_concurrently(svn_stream_t *stream,
+                            svn_repos_t *repos,
+                            svn_revnum_t start_rev,
+                            svn_revnum_t end_rev,
+                            svn_boolean_t incremental,
+                            svn_boolean_t use_deltas,
+                            int job_count,
+                            svn_boolean_t *found_old_reference,
+                            svn_boolean_t *found_old_mergeinfo,
+                            svn_repos_notify_func_t notify_func,
+                            void *notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool)
+{
+  dump_jobs_t jobs = { 0 };
+  apr_thread_t **threads;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_repos_notify_t *notify = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  svn_revnum_t rev;
+  int thread_count = 0;
+  int i;
+
+  if (job_count > end_rev - start_rev + 1)
+    job_count = (int)(end_rev - start_rev + 1);
+
+  jobs.repos_path = svn_repos_path(repos, pool);
+  jobs.fs_config = svn_fs_config(svn_repos_fs(repos), pool);
+  jobs.start_rev = start_rev;
+  jobs.end_rev = end_rev;
+  jobs.incremental = incremental;
+  jobs.use_deltas = use_deltas;
+  jobs.collect_notifications = notify_func != NULL;
+  jobs.cancel_func = cancel_func;
+  jobs.cancel_baton = cancel_baton;
+  jobs.next_rev = start_rev;
+  jobs.first_pending = start_rev;
+  jobs.window_size = job_count * DUMP_WINDOW_PER_JOB;
+  jobs.results = apr_pcalloc(pool, jobs.window_size * sizeof(*jobs.results));
+
+  status = apr_thread_mutex_create(&jobs.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&jobs.changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create dump lock"));
+
+  if (notify_func)
+    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end, pool);
+
+  /* Start the workers. */
+  threads = apr_pcalloc(pool, job_count * sizeof(*threads));
+  apr_thread_mutex_lock(jobs.mutex);
+  for (i = 0; i < job_count; ++i)
+    {
+      status = apr_thread_create(&threads[i], NULL, dump_worker, &jobs,
+                                 pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create dump thread"));
+          jobs.stop = TRUE;
+          break;
+        }
+
+      ++thread_count;
+      ++jobs.active_workers;
+    }
+
+  /* Write results in revision order. */
+  for (rev = start_rev; !err && rev <= end_rev; ++rev)
+    {
+      dump_result_t *result = &jobs.results[rev % jobs.window_size];
+
+      while (!result->done && jobs.active_workers > 0)
+        apr_thread_cond_wait(jobs.changed, jobs.mutex);
+
+      /* All workers quit prematurely? */
+      if (!result->done)
+        break;
+
+      apr_thread_mutex_unlock(jobs.mutex);
+      svn_pool_clear(iterpool);
+
+      send_collected_notifications(&result->notifications, notify_func,
+                                   notify_baton, iterpool);
+
+      /* A failed revision has still been dumped up to the point of
+         failure.  Write that part, too, just as the serial dump would
+         have done before returning the error. */
+      err = write_dump_buffer(stream, result->buffer, iterpool);
+      if (result->err)
+        {
+          err = svn_error_compose_create(result->err, err);
+          result->err = SVN_NO_ERROR;
+        }
+      else if (!err)
+        {
+          *found_old_reference |= result->found_old_reference;
+          *found_old_mergeinfo |= result->found_old_mergeinfo;
+        }
+
+      if (!err && notify_func)
+        {
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+
+      clear_dump_result(result);
+
+      apr_thread_mutex_lock(jobs.mutex);
+      jobs.first_pending = rev + 1;
+      apr_thread_cond_broadcast(jobs.changed);
+    }
+
+  /* Stop and wait for all workers. */
+  jobs.stop = TRUE;
+  apr_thread_cond_broadcast(jobs.changed);
+  apr_thread_mutex_unlock(jobs.mutex);
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+
+  /* Drop results that we did not write. */
+  for (i = 0; i < jobs.window_size; ++i)
+    clear_dump_result(&jobs.results[i]);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_compose_create(err, jobs.setup_err);
+}
+
+#endif /* APR_HAS_THREADS */
 
 /* The main dumper. */
 svn_error_t *
-svn_repos_dump_fs3(svn_repos_t *repos,
+svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_stream_t *stream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
                    svn_boolean_t incremental,
                    svn_boolean_t use_deltas,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *subpool = svn_pool_create(pool);
@@ -1584,72 +2081,31 @@ svn_repos_dump_fs3(svn_repos_t *repos,
     notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
                                      pool);
 
+  /* Concurrent dumps require thread-safe caches. */
+  if (svn_cache_config_get()->single_threaded)
+    jobs = 1;
+
+#if APR_HAS_THREADS
+  if (jobs > 1 && start_rev < end_rev)
+    SVN_ERR(dump_revisions_concurrently(stream, repos, start_rev, end_rev,
+                                        incremental, use_deltas, jobs,
+                                        &found_old_reference,
+                                        &found_old_mergeinfo,
+                                        notify_func, notify_baton,
+                                        cancel_func, cancel_baton, pool));
+  else
+#endif
   /* Main loop:  we're going to dump revision REV.  */
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(subpool);
 
-      /* Check for cancellation. */
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
-
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, fs, rev, subpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties. */
-      if (rev == 0)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE,
-                              NULL, subpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, subpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, subpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       NULL,
-                                       NULL,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       subpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    NULL, NULL, subpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, subpool));
-        }
+      SVN_ERR(dump_one_revision(stream, fs, rev, start_rev, incremental,
+                                use_deltas, &found_old_reference,
+                                &found_old_mergeinfo,
+                                notify_func, notify_baton,
+                                cancel_func, cancel_baton, subpool));
 
-    loop_end:
       if (notify_func)
         {
           notify->revision = rev;
@@ -1921,11 +2377,320 @@ deserialize_node_kind(void **out,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Number of revisions per worker thread that may be verified ahead of
+   the oldest revision whose results have not been reported, yet. */
+#define VERIFY_WINDOW_PER_JOB 16
+
+/* Outcome of verifying a single revision in a worker thread. */
+typedef struct verify_result_t
+{
+  /* Notifications sent while verifying the revision. */
+  collected_notifications_t notifications;
+
+  /* Error returned by verify_one_revision, if any. */
+  svn_error_t *err;
+
+  /* Set once the revision has been verified. */
+  svn_boolean_t done;
+} verify_result_t;
+
+/* State shared between the thread calling svn_repos_verify_fs3 and its
+   worker threads.  Unless noted otherwise, all members are protected by
+   MUTEX. */
+typedef struct verify_jobs_t
+{
+  /* Repository and FS configuration to open in each worker thread.
+     Read-only. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+
+  /* Key prefix of the verified dirents cache or NULL.  Read-only. */
+  const char *dirents_cache_prefix;
+
+  /* Revision range to verify.  Read-only. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Notification and cancellation support.  Read-only. */
+  svn_boolean_t collect_notifications;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Next revision to hand out to a worker. */
+  svn_revnum_t next_rev;
+
+  /* Oldest revision whose results have not been reported, yet. */
+  svn_revnum_t first_pending;
+
+  /* If set, workers must not pick up any further revisions. */
+  svn_boolean_t stop;
+
+  /* Number of workers still running. */
+  int active_workers;
+
+  /* First error encountered while setting up a worker, if any. */
+  svn_error_t *setup_err;
+
+  /* Ring buffer of WINDOW_SIZE results, indexed by revision. */
+  verify_result_t *results;
+  int window_size;
+
+  /* Serializes access to the above and signals any change in state. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} verify_jobs_t;
+
+/* Open a repository and dirents cache as described by JOBS and allocate
+   them in POOL.  Return them in *REPOS and *DIRENTS_CACHE. */
+static svn_error_t *
+open_verify_worker(svn_repos_t **repos,
+                   svn_cache__t **dirents_cache,
+                   verify_jobs_t *jobs,
+                   apr_pool_t *pool)
+{
+  *dirents_cache = NULL;
+
+  SVN_ERR(svn_repos_open2(repos, jobs->repos_path, jobs->fs_config, pool));
+  if (jobs->dirents_cache_prefix)
+    SVN_ERR(svn_cache__create_membuffer_cache
+                                 (dirents_cache,
+                                  svn_cache__get_global_membuffer_cache(),
+                                  serialize_node_kind,
+                                  deserialize_node_kind,
+                                  APR_HASH_KEY_STRING,
+                                  jobs->dirents_cache_prefix,
+                                  SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                  FALSE,
+                                  pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Worker thread function.  Verify revisions handed out by the
+   verify_jobs_t in DATA until there are no more left. */
+static void * APR_THREAD_FUNC
+verify_worker(apr_thread_t *tid, void *data)
+{
+  verify_jobs_t *jobs = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_repos_t *repos = NULL;
+  svn_cache__t *dirents_cache = NULL;
+  svn_error_t *err;
+
+  /* Each worker needs its own FS object as those are not thread-safe. */
+  err = open_verify_worker(&repos, &dirents_cache, jobs, pool);
+
+  apr_thread_mutex_lock(jobs->mutex);
+  if (err)
+    {
+      jobs->stop = TRUE;
+      if (jobs->setup_err)
+        svn_error_clear(err);
+      else
+        jobs->setup_err = err;
+    }
+
+  while (!jobs->stop && jobs->next_rev <= jobs->end_rev)
+    {
+      svn_revnum_t rev;
+      verify_result_t *result;
+
+      /* Don't get too far ahead of the revisions reported so far. */
+      if (jobs->next_rev - jobs->first_pending >= jobs->window_size)
+        {
+          apr_thread_cond_wait(jobs->changed, jobs->mutex);
+          continue;
+        }
+
+      rev = jobs->next_rev++;
+      result = &jobs->results[rev % jobs->window_size];
+      apr_thread_mutex_unlock(jobs->mutex);
+
+      svn_pool_clear(iterpool);
+      err = verify_one_revision(svn_repos_fs(repos), rev,
+                                jobs->collect_notifications
+                                  ? collect_notification
+                                  : NULL,
+                                &result->notifications, jobs->start_rev,
+                                jobs->cancel_func, jobs->cancel_baton,
+                                dirents_cache, iterpool);
+
+      apr_thread_mutex_lock(jobs->mutex);
+      result->err = err;
+      result->done = TRUE;
+      apr_thread_cond_broadcast(jobs->changed);
+    }
+
+  --jobs->active_workers;
+  apr_thread_cond_broadcast(jobs->changed);
+  apr_thread_mutex_unlock(jobs->mutex);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Release all resources held by RESULT and mark it as unused. */
+static void
+clear_verify_result(verify_result_t *result)
+{
+  svn_error_clear(result->err);
+  clear_collected_notifications(&result->notifications);
+
+  memset(result, 0, sizeof(*result));
+}
+
+/* Verify revisions START_REV to END_REV in REPOS using JOB_COUNT worker
+   threads.  Report results through NOTIFY_FUNC and NOTIFY_BATON in
+   revision order, exactly like the single-threaded code in
+   svn_repos_verify_fs3 would do, and set *FOUND_CORRUPTION if any of
+   the revisions failed to verify.  KEEP_GOING, CANCEL_FUNC and
+   CANCEL_BATON are as for svn_repos_verify_fs3.  Worker threads will use
+   DIRENTS_CACHE_PREFIX for their verified dirents caches, if not NULL.
+   Use POOL for allocations. */
+static svn_error_t *
+verify_revisions_concurrently(svn_boolean_t *found_corruption,
+                              svn_repos_t *repos,
+                              svn_revnum_t start_rev,
+                              svn_revnum_t end_rev,
+                              svn_boolean_t keep_going,
+                              int job_count,
+                              svn_repos_notify_func_t notify_func,
+                              void *notify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              const char *dirents_cache_prefix,
+                              apr_pool_t *pool)
+{
+  verify_jobs_t jobs = { 0 };
+  apr_thread_t **threads;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_repos_notify_t *notify = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  svn_revnum_t rev;
+  int thread_count = 0;
+  int i;
+
+  if (job_count > end_rev - start_rev + 1)
+    job_count = (int)(end_rev - start_rev + 1);
+
+  jobs.repos_path = svn_repos_path(repos, pool);
+  jobs.fs_config = svn_fs_config(svn_repos_fs(repos), pool);
+  jobs.dirents_cache_prefix = dirents_cache_prefix;
+  jobs.start_rev = start_rev;
+  jobs.end_rev = end_rev;
+  jobs.collect_notifications = notify_func != NULL;
+  jobs.cancel_func = cancel_func;
+  jobs.cancel_baton = cancel_baton;
+  jobs.next_rev = start_rev;
+  jobs.first_pending = start_rev;
+  jobs.window_size = job_count * VERIFY_WINDOW_PER_JOB;
+  jobs.results = apr_pcalloc(pool, jobs.window_size * sizeof(*jobs.results));
+
+  status = apr_thread_mutex_create(&jobs.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&jobs.changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create verification lock"));
+
+  if (notify_func)
+    notify = svn_repos_notify_create(svn_repos_notify_verify_rev_end, pool);
+
+  /* Start the workers. */
+  threads = apr_pcalloc(pool, job_count * sizeof(*threads));
+  apr_thread_mutex_lock(jobs.mutex);
+  for (i = 0; i < job_count; ++i)
+    {
+      status = apr_thread_create(&threads[i], NULL, verify_worker, &jobs,
+                                 pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't create verification thread"));
+          jobs.stop = TRUE;
+          break;
+        }
+
+      ++thread_count;
+      ++jobs.active_workers;
+    }
+
+  /* Report results in revision order. */
+  for (rev = start_rev; !err && rev <= end_rev; ++rev)
+    {
+      verify_result_t *result = &jobs.results[rev % jobs.window_size];
+      svn_boolean_t failed;
+
+      while (!result->done && jobs.active_workers > 0)
+        apr_thread_cond_wait(jobs.changed, jobs.mutex);
+
+      /* All workers quit prematurely? */
+      if (!result->done)
+        break;
+
+      apr_thread_mutex_unlock(jobs.mutex);
+      svn_pool_clear(iterpool);
+
+      send_collected_notifications(&result->notifications, notify_func,
+                                   notify_baton, iterpool);
+
+      failed = result->err != SVN_NO_ERROR;
+      if (failed)
+        {
+          *found_corruption = TRUE;
+          notify_verification_error(rev, result->err, notify_func,
+                                    notify_baton, iterpool);
+        }
+      else if (notify_func)
+        {
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+
+      clear_verify_result(result);
+
+      apr_thread_mutex_lock(jobs.mutex);
+      jobs.first_pending = rev + 1;
+      apr_thread_cond_broadcast(jobs.changed);
+
+      if (failed && !keep_going)
+        break;
+    }
+
+  /* Stop and wait for all workers. */
+  jobs.stop = TRUE;
+  apr_thread_cond_broadcast(jobs.changed);
+  apr_thread_mutex_unlock(jobs.mutex);
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+
+  /* Drop results that we did not report. */
+  for (i = 0; i < jobs.window_size; ++i)
+    clear_verify_result(&jobs.results[i]);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_compose_create(err, jobs.setup_err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t keep_going,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_cancel_func_t cancel_func,
@@ -1942,6 +2707,7 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_error_t *err;
   svn_boolean_t found_corruption = FALSE;
   svn_cache__t *verified_dirents_cache = NULL;
+  const char *dirents_cache_prefix = NULL;
 
   /* Determine the current youngest revision of the filesystem. */
   SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
@@ -2004,17 +2770,33 @@ svn_repos_verify_fs3(svn_repos_t *repos,
     }
 
   if (svn_cache__get_global_membuffer_cache())
-    SVN_ERR(svn_cache__create_membuffer_cache
+    {
+      dirents_cache_prefix = svn_uuid_generate(pool);
+      SVN_ERR(svn_cache__create_membuffer_cache
                                  (&verified_dirents_cache,
                                   svn_cache__get_global_membuffer_cache(),
                                   serialize_node_kind,
                                   deserialize_node_kind,
                                   APR_HASH_KEY_STRING,
-                                  svn_uuid_generate(pool),
+                                  dirents_cache_prefix,
                                   SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
                                   FALSE,
                                   pool));
+    }
 
+  /* Concurrent verification requires thread-safe caches. */
+  if (svn_cache_config_get()->single_threaded)
+    jobs = 1;
+
+#if APR_HAS_THREADS
+  if (jobs > 1 && start_rev < end_rev)
+    SVN_ERR(verify_revisions_concurrently(&found_corruption, repos,
+                                          start_rev, end_rev, keep_going,
+                                          jobs, notify_func, notify_baton,
+                                          cancel_func, cancel_baton,
+                                          dirents_cache_prefix, pool));
+  else
+#endif
   for (rev = start_rev; rev <= end_rev; rev++)
     {
       svn_pool_clear(iterpool);
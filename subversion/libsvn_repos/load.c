@@ -38,6 +38,9 @@
 #include "svn_ctype.h"
 
 #include <apr_lib.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_mergeinfo_private.h"
@@ -682,3 +685,724 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   svn_pool_destroy(nodepool);
   return SVN_NO_ERROR;
 }
+
+
+
+/*----------------------------------------------------------------------*/
+
+/** The pipelined parser **/
+
+#if APR_HAS_THREADS
+
+/* The parser thread hands records over to the calling thread in
+   batches of about this many bytes. */
+#define PIPELINE_BATCH_SIZE (256 * 1024)
+
+/* Maximum number of batches waiting to be processed by the calling
+   thread.  The parser thread blocks until there is room again. */
+#define PIPELINE_MAX_BATCHES 32
+
+/* Type of a parser callback recorded by the parser thread. */
+typedef enum pipeline_event_kind_t
+{
+  pipeline_magic_header_record,
+  pipeline_uuid_record,
+  pipeline_new_revision_record,
+  pipeline_new_node_record,
+  pipeline_set_revision_property,
+  pipeline_set_node_property,
+  pipeline_delete_node_property,
+  pipeline_remove_node_props,
+  pipeline_set_fulltext,
+  pipeline_write_fulltext,
+  pipeline_close_fulltext,
+  pipeline_apply_textdelta,
+  pipeline_textdelta_window,
+  pipeline_close_node,
+  pipeline_close_revision
+} pipeline_event_kind_t;
+
+/* A parser callback recorded by the parser thread, including copies of
+   its parameters.  Which members are used depends on KIND. */
+typedef struct pipeline_event_t
+{
+  pipeline_event_kind_t kind;
+
+  /* Dumpfile format version. */
+  int version;
+
+  /* Header names ==> header values of a revision or node record. */
+  apr_hash_t *headers;
+
+  /* UUID or property name. */
+  const char *name;
+
+  /* Property value. */
+  const svn_string_t *value;
+
+  /* Chunk of fulltext. */
+  const char *data;
+  apr_size_t len;
+
+  /* Delta window.  NULL at the end of the delta. */
+  svn_txdelta_window_t *window;
+} pipeline_event_t;
+
+/* A sequence of parser callbacks. */
+typedef struct pipeline_batch_t
+{
+  /* Elements are pipeline_event_t. */
+  apr_array_header_t *events;
+
+  /* Approximate amount of memory used by EVENTS. */
+  apr_size_t size;
+
+  /* Root pool containing this batch. */
+  apr_pool_t *pool;
+
+  /* Next batch in the queue. */
+  struct pipeline_batch_t *next;
+} pipeline_batch_t;
+
+/* State shared between the parser thread and the calling thread.
+   Unless noted otherwise, all members are protected by MUTEX. */
+typedef struct pipeline_t
+{
+  /* Parser parameters.  Read-only. */
+  svn_stream_t *stream;
+  svn_boolean_t deltas_are_text;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Batch being filled by the parser thread.  Only used by that thread. */
+  pipeline_batch_t *current;
+
+  /* Stream passed to the parser for all fulltexts.  Only used by the
+     parser thread. */
+  svn_stream_t *fulltext_stream;
+
+  /* Queue of batches to be processed by the calling thread. */
+  pipeline_batch_t *first;
+  pipeline_batch_t *last;
+  int queued;
+
+  /* Set once the parser thread has queued its last batch. */
+  svn_boolean_t finished;
+
+  /* Error returned by the parser, if any.  Valid once FINISHED is set. */
+  svn_error_t *parser_err;
+
+  /* Set by the calling thread to make the parser thread quit. */
+  svn_boolean_t stop;
+
+  /* Serializes access to the above and signals any change in state. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} pipeline_t;
+
+/* Append the current batch of PIPELINE to the queue, waiting for the
+   calling thread to catch up if necessary. */
+static svn_error_t *
+queue_current_batch(pipeline_t *pipeline)
+{
+  pipeline_batch_t *batch = pipeline->current;
+  if (batch == NULL)
+    return SVN_NO_ERROR;
+
+  pipeline->current = NULL;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  while (!pipeline->stop && pipeline->queued >= PIPELINE_MAX_BATCHES)
+    apr_thread_cond_wait(pipeline->changed, pipeline->mutex);
+
+  if (pipeline->stop)
+    {
+      apr_thread_mutex_unlock(pipeline->mutex);
+      svn_pool_destroy(batch->pool);
+      return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  if (pipeline->last)
+    pipeline->last->next = batch;
+  else
+    pipeline->first = batch;
+
+  pipeline->last = batch;
+  ++pipeline->queued;
+
+  apr_thread_cond_broadcast(pipeline->changed);
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new event of type KIND, appended to the current batch in
+   PIPELINE.  The event will be allocated in the batch's pool, which is
+   also returned in *POOL. */
+static pipeline_event_t *
+add_event(apr_pool_t **pool,
+          pipeline_t *pipeline,
+          pipeline_event_kind_t kind)
+{
+  pipeline_event_t *event;
+
+  if (pipeline->current == NULL)
+    {
+      apr_pool_t *batch_pool = svn_pool_create(NULL);
+      pipeline_batch_t *batch = apr_pcalloc(batch_pool, sizeof(*batch));
+
+      batch->pool = batch_pool;
+      batch->events = apr_array_make(batch_pool, 64,
+                                     sizeof(pipeline_event_t));
+      pipeline->current = batch;
+    }
+
+  event = apr_array_push(pipeline->current->events);
+  memset(event, 0, sizeof(*event));
+  event->kind = kind;
+
+  *pool = pipeline->current->pool;
+  return event;
+}
+
+/* Account for SIZE more bytes in the current batch of PIPELINE and hand
+   it over to the calling thread once it is large enough. */
+static svn_error_t *
+event_added(pipeline_t *pipeline,
+            apr_size_t size)
+{
+  pipeline->current->size += size + sizeof(pipeline_event_t);
+  if (pipeline->current->size >= PIPELINE_BATCH_SIZE)
+    SVN_ERR(queue_current_batch(pipeline));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a copy of the const char * ==> const char * hash HEADERS,
+   allocated in POOL. */
+static apr_hash_t *
+copy_headers(apr_hash_t *headers,
+             apr_pool_t *pool)
+{
+  apr_hash_t *copy = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, headers); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(copy,
+                  apr_pstrdup(pool, svn__apr_hash_index_key(hi)),
+                  apr_pstrdup(pool, svn__apr_hash_index_val(hi)));
+
+  return copy;
+}
+
+/* The parser vtable used in the parser thread.  The parse baton as well
+   as all record batons are the pipeline_t.  The callbacks simply record
+   the calls in the current batch. */
+
+static svn_error_t *
+pipeline_magic_header_record_func(int version,
+                                  void *parse_baton,
+                                  apr_pool_t *pool)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, parse_baton,
+                                      pipeline_magic_header_record);
+  event->version = version;
+
+  return svn_error_trace(event_added(parse_baton, 0));
+}
+
+static svn_error_t *
+pipeline_uuid_record_func(const char *uuid,
+                          void *parse_baton,
+                          apr_pool_t *pool)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, parse_baton,
+                                      pipeline_uuid_record);
+  event->name = apr_pstrdup(batch_pool, uuid);
+
+  return svn_error_trace(event_added(parse_baton, strlen(uuid)));
+}
+
+static svn_error_t *
+pipeline_new_revision_record_func(void **revision_baton,
+                                  apr_hash_t *headers,
+                                  void *parse_baton,
+                                  apr_pool_t *pool)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, parse_baton,
+                                      pipeline_new_revision_record);
+  event->headers = copy_headers(headers, batch_pool);
+
+  *revision_baton = parse_baton;
+  return svn_error_trace(event_added(parse_baton, 0));
+}
+
+static svn_error_t *
+pipeline_new_node_record_func(void **node_baton,
+                              apr_hash_t *headers,
+                              void *revision_baton,
+                              apr_pool_t *pool)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, revision_baton,
+                                      pipeline_new_node_record);
+  event->headers = copy_headers(headers, batch_pool);
+
+  *node_baton = revision_baton;
+  return svn_error_trace(event_added(revision_baton, 0));
+}
+
+static svn_error_t *
+pipeline_set_revision_property_func(void *revision_baton,
+                                    const char *name,
+                                    const svn_string_t *value)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, revision_baton,
+                                      pipeline_set_revision_property);
+  event->name = apr_pstrdup(batch_pool, name);
+  event->value = value ? svn_string_dup(value, batch_pool) : NULL;
+
+  return svn_error_trace(event_added(revision_baton,
+                                     value ? value->len : 0));
+}
+
+static svn_error_t *
+pipeline_set_node_property_func(void *node_baton,
+                                const char *name,
+                                const svn_string_t *value)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, node_baton,
+                                      pipeline_set_node_property);
+  event->name = apr_pstrdup(batch_pool, name);
+  event->value = value ? svn_string_dup(value, batch_pool) : NULL;
+
+  return svn_error_trace(event_added(node_baton, value ? value->len : 0));
+}
+
+static svn_error_t *
+pipeline_delete_node_property_func(void *node_baton,
+                                   const char *name)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, node_baton,
+                                      pipeline_delete_node_property);
+  event->name = apr_pstrdup(batch_pool, name);
+
+  return svn_error_trace(event_added(node_baton, 0));
+}
+
+static svn_error_t *
+pipeline_remove_node_props_func(void *node_baton)
+{
+  apr_pool_t *batch_pool;
+  add_event(&batch_pool, node_baton, pipeline_remove_node_props);
+
+  return svn_error_trace(event_added(node_baton, 0));
+}
+
+/* Implements svn_write_fn_t for pipeline_t's FULLTEXT_STREAM. */
+static svn_error_t *
+pipeline_write_fulltext_func(void *baton,
+                             const char *data,
+                             apr_size_t *len)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, baton,
+                                      pipeline_write_fulltext);
+  event->data = apr_pmemdup(batch_pool, data, *len);
+  event->len = *len;
+
+  return svn_error_trace(event_added(baton, *len));
+}
+
+/* Implements svn_close_fn_t for pipeline_t's FULLTEXT_STREAM. */
+static svn_error_t *
+pipeline_close_fulltext_func(void *baton)
+{
+  apr_pool_t *batch_pool;
+  add_event(&batch_pool, baton, pipeline_close_fulltext);
+
+  return svn_error_trace(event_added(baton, 0));
+}
+
+static svn_error_t *
+pipeline_set_fulltext_func(svn_stream_t **stream,
+                           void *node_baton)
+{
+  pipeline_t *pipeline = node_baton;
+  apr_pool_t *batch_pool;
+  add_event(&batch_pool, pipeline, pipeline_set_fulltext);
+
+  /* We don't know yet whether the text will actually be used.
+     Hand it over to the calling thread in any case. */
+  *stream = pipeline->fulltext_stream;
+  return svn_error_trace(event_added(pipeline, 0));
+}
+
+/* Implements svn_txdelta_window_handler_t for the pipeline_t in BATON. */
+static svn_error_t *
+pipeline_textdelta_window_func(svn_txdelta_window_t *window,
+                               void *baton)
+{
+  apr_pool_t *batch_pool;
+  pipeline_event_t *event = add_event(&batch_pool, baton,
+                                      pipeline_textdelta_window);
+  apr_size_t size = 0;
+
+  if (window)
+    {
+      event->window = svn_txdelta_window_dup(window, batch_pool);
+      size = window->num_ops * sizeof(*window->ops)
+           + (window->new_data ? window->new_data->len : 0);
+    }
+
+  return svn_error_trace(event_added(baton, size));
+}
+
+static svn_error_t *
+pipeline_apply_textdelta_func(svn_txdelta_window_handler_t *handler,
+                              void **handler_baton,
+                              void *node_baton)
+{
+  apr_pool_t *batch_pool;
+  add_event(&batch_pool, node_baton, pipeline_apply_textdelta);
+
+  /* The svndiff data will be parsed in this thread and only the
+     resulting windows be handed over to the calling thread. */
+  *handler = pipeline_textdelta_window_func;
+  *handler_baton = node_baton;
+  return svn_error_trace(event_added(node_baton, 0));
+}
+
+static svn_error_t *
+pipeline_close_node_func(void *node_baton)
+{
+  apr_pool_t *batch_pool;
+  add_event(&batch_pool, node_baton, pipeline_close_node);
+
+  return svn_error_trace(event_added(node_baton, 0));
+}
+
+static svn_error_t *
+pipeline_close_revision_func(void *revision_baton)
+{
+  apr_pool_t *batch_pool;
+  add_event(&batch_pool, revision_baton, pipeline_close_revision);
+
+  return svn_error_trace(event_added(revision_baton, 0));
+}
+
+/* Parser thread function.  Parse the dumpstream described by the
+   pipeline_t in DATA and queue the results for the calling thread. */
+static void * APR_THREAD_FUNC
+pipeline_parser(apr_thread_t *tid, void *data)
+{
+  pipeline_t *pipeline = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_repos_parse_fns3_t *parse_fns = apr_pcalloc(pool, sizeof(*parse_fns));
+  svn_error_t *err;
+
+  parse_fns->magic_header_record = pipeline_magic_header_record_func;
+  parse_fns->uuid_record = pipeline_uuid_record_func;
+  parse_fns->new_revision_record = pipeline_new_revision_record_func;
+  parse_fns->new_node_record = pipeline_new_node_record_func;
+  parse_fns->set_revision_property = pipeline_set_revision_property_func;
+  parse_fns->set_node_property = pipeline_set_node_property_func;
+  parse_fns->delete_node_property = pipeline_delete_node_property_func;
+  parse_fns->remove_node_props = pipeline_remove_node_props_func;
+  parse_fns->set_fulltext = pipeline_set_fulltext_func;
+  parse_fns->apply_textdelta = pipeline_apply_textdelta_func;
+  parse_fns->close_node = pipeline_close_node_func;
+  parse_fns->close_revision = pipeline_close_revision_func;
+
+  pipeline->fulltext_stream = svn_stream_create(pipeline, pool);
+  svn_stream_set_write(pipeline->fulltext_stream,
+                       pipeline_write_fulltext_func);
+  svn_stream_set_close(pipeline->fulltext_stream,
+                       pipeline_close_fulltext_func);
+
+  err = svn_repos_parse_dumpstream3(pipeline->stream, parse_fns, pipeline,
+                                    pipeline->deltas_are_text,
+                                    pipeline->cancel_func,
+                                    pipeline->cancel_baton, pool);
+  /* Hand over everything parsed before an error as well.  The serial
+     parser would have invoked those callbacks before failing, too. */
+  err = svn_error_compose_create(err, queue_current_batch(pipeline));
+
+  if (pipeline->current)
+    {
+      svn_pool_destroy(pipeline->current->pool);
+      pipeline->current = NULL;
+    }
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  pipeline->parser_err = err;
+  pipeline->finished = TRUE;
+  apr_thread_cond_broadcast(pipeline->changed);
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* State of the calling thread while replaying the recorded parser
+   callbacks, mirroring the variables in svn_repos_parse_dumpstream3. */
+typedef struct replay_baton_t
+{
+  const svn_repos_parse_fns3_t *parse_fns;
+  void *parse_baton;
+
+  void *rev_baton;
+  void *node_baton;
+  svn_boolean_t found_node;
+
+  /* Fulltext target or delta window handler of the current record. */
+  svn_stream_t *text_stream;
+  svn_txdelta_window_handler_t window_handler;
+  void *window_baton;
+
+  apr_pool_t *pool;
+  apr_pool_t *revpool;
+  apr_pool_t *nodepool;
+} replay_baton_t;
+
+/* Call the parser callbacks in RB as recorded in BATCH. */
+static svn_error_t *
+replay_batch(replay_baton_t *rb,
+             pipeline_batch_t *batch)
+{
+  const svn_repos_parse_fns3_t *parse_fns = rb->parse_fns;
+  int i;
+
+  for (i = 0; i < batch->events->nelts; ++i)
+    {
+      pipeline_event_t *event = &APR_ARRAY_IDX(batch->events, i,
+                                               pipeline_event_t);
+      void *record_baton = rb->found_node ? rb->node_baton : rb->rev_baton;
+      apr_size_t len;
+
+      switch (event->kind)
+        {
+          case pipeline_magic_header_record:
+            if (parse_fns->magic_header_record != NULL)
+              SVN_ERR(parse_fns->magic_header_record(event->version,
+                                                     rb->parse_baton,
+                                                     rb->pool));
+            break;
+
+          case pipeline_uuid_record:
+            SVN_ERR(parse_fns->uuid_record(apr_pstrdup(rb->pool,
+                                                       event->name),
+                                           rb->parse_baton, rb->pool));
+            break;
+
+          case pipeline_new_revision_record:
+            SVN_ERR(parse_fns->new_revision_record
+                      (&rb->rev_baton,
+                       copy_headers(event->headers, rb->revpool),
+                       rb->parse_baton, rb->revpool));
+            break;
+
+          case pipeline_new_node_record:
+            SVN_ERR(parse_fns->new_node_record
+                      (&rb->node_baton,
+                       copy_headers(event->headers, rb->nodepool),
+                       rb->rev_baton, rb->nodepool));
+            rb->found_node = TRUE;
+            break;
+
+          case pipeline_set_revision_property:
+            SVN_ERR(parse_fns->set_revision_property(rb->rev_baton,
+                                                     event->name,
+                                                     event->value));
+            break;
+
+          case pipeline_set_node_property:
+            SVN_ERR(parse_fns->set_node_property(rb->node_baton,
+                                                 event->name,
+                                                 event->value));
+            break;
+
+          case pipeline_delete_node_property:
+            /* See parse_property_block. */
+            if (!parse_fns->delete_node_property)
+              return stream_malformed();
+
+            SVN_ERR(parse_fns->delete_node_property(rb->node_baton,
+                                                    event->name));
+            break;
+
+          case pipeline_remove_node_props:
+            SVN_ERR(parse_fns->remove_node_props(rb->node_baton));
+            break;
+
+          case pipeline_set_fulltext:
+            SVN_ERR(parse_fns->set_fulltext(&rb->text_stream,
+                                            record_baton));
+            break;
+
+          case pipeline_write_fulltext:
+            if (rb->text_stream)
+              {
+                len = event->len;
+                SVN_ERR(svn_stream_write(rb->text_stream, event->data,
+                                         &len));
+                if (len != event->len)
+                  return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF,
+                                          NULL,
+                                          _("Unexpected EOF writing "
+                                            "contents"));
+              }
+            break;
+
+          case pipeline_close_fulltext:
+            if (rb->text_stream)
+              SVN_ERR(svn_stream_close(rb->text_stream));
+            rb->text_stream = NULL;
+            break;
+
+          case pipeline_apply_textdelta:
+            SVN_ERR(parse_fns->apply_textdelta(&rb->window_handler,
+                                               &rb->window_baton,
+                                               record_baton));
+            break;
+
+          case pipeline_textdelta_window:
+            if (rb->window_handler)
+              SVN_ERR(rb->window_handler(event->window, rb->window_baton));
+            if (event->window == NULL)
+              rb->window_handler = NULL;
+            break;
+
+          case pipeline_close_node:
+            SVN_ERR(parse_fns->close_node(rb->node_baton));
+            svn_pool_clear(rb->nodepool);
+            rb->node_baton = NULL;
+            rb->found_node = FALSE;
+            break;
+
+          case pipeline_close_revision:
+            SVN_ERR(parse_fns->close_revision(rb->rev_baton));
+            svn_pool_clear(rb->revpool);
+            rb->rev_baton = NULL;
+            break;
+
+          default:
+            SVN_ERR_MALFUNCTION();
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  pipeline_t pipeline = { 0 };
+  replay_baton_t rb = { 0 };
+  apr_thread_t *thread;
+  apr_status_t status;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  pipeline.stream = stream;
+  pipeline.deltas_are_text = deltas_are_text;
+  pipeline.cancel_func = cancel_func;
+  pipeline.cancel_baton = cancel_baton;
+
+  status = apr_thread_mutex_create(&pipeline.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&pipeline.changed, pool);
+  if (!status)
+    status = apr_thread_create(&thread, NULL, pipeline_parser, &pipeline,
+                               pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create parser thread"));
+
+  rb.parse_fns = parse_fns;
+  rb.parse_baton = parse_baton;
+  rb.pool = pool;
+  rb.revpool = svn_pool_create(pool);
+  rb.nodepool = svn_pool_create(pool);
+
+  /* Replay the parser callbacks in the order they were recorded. */
+  while (!err)
+    {
+      pipeline_batch_t *batch;
+
+      apr_thread_mutex_lock(pipeline.mutex);
+      while (pipeline.first == NULL && !pipeline.finished)
+        apr_thread_cond_wait(pipeline.changed, pipeline.mutex);
+
+      batch = pipeline.first;
+      if (batch)
+        {
+          pipeline.first = batch->next;
+          if (pipeline.first == NULL)
+            pipeline.last = NULL;
+          --pipeline.queued;
+          apr_thread_cond_broadcast(pipeline.changed);
+        }
+      apr_thread_mutex_unlock(pipeline.mutex);
+
+      /* Parser finished and everything has been processed? */
+      if (batch == NULL)
+        break;
+
+      err = replay_batch(&rb, batch);
+      svn_pool_destroy(batch->pool);
+    }
+
+  /* Stop the parser, if it is still running. */
+  apr_thread_mutex_lock(pipeline.mutex);
+  pipeline.stop = TRUE;
+  apr_thread_cond_broadcast(pipeline.changed);
+  apr_thread_mutex_unlock(pipeline.mutex);
+
+  apr_thread_join(&status, thread);
+
+  /* Drop whatever we did not process. */
+  while (pipeline.first)
+    {
+      pipeline_batch_t *batch = pipeline.first;
+      pipeline.first = batch->next;
+      svn_pool_destroy(batch->pool);
+    }
+
+  svn_pool_destroy(rb.revpool);
+  svn_pool_destroy(rb.nodepool);
+
+  /* A parser error is only relevant if we processed all the data
+     that got parsed before it.  Otherwise, it is likely a consequence
+     of us stopping the parser. */
+  if (err)
+    {
+      svn_error_clear(pipeline.parser_err);
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(pipeline.parser_err);
+#else
+  return svn_error_trace(svn_repos_parse_dumpstream3(stream, parse_fns,
+                                                     parse_baton,
+                                                     deltas_are_text,
+                                                     cancel_func,
+                                                     cancel_baton, pool));
+#endif
+}
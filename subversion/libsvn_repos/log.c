@@ -295,6 +295,54 @@ turn_unique_copies_into_moves(apr_hash_t *changes,
     }
 }
 
+/* Set *UNREADABLE to the set of changed paths in CHANGES, a hash as
+ * returned by svn_fs_paths_changed2() for ROOT, that may not be read
+ * according to AUTHZ_READ_FUNC and AUTHZ_READ_BATON.  The paths are
+ * checked all at once, which is much cheaper than individual lookups
+ * for callbacks that support it.
+ *
+ * *UNREADABLE will be allocated in RESULT_POOL and share its keys with
+ * CHANGES.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+find_unreadable_changes(apr_hash_t **unreadable,
+                        svn_fs_root_t *root,
+                        apr_hash_t *changes,
+                        svn_repos_authz_func_t authz_read_func,
+                        void *authz_read_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sorted_changes;
+  apr_array_header_t *paths;
+  svn_boolean_t *readable;
+  int i;
+
+  sorted_changes = svn_sort__hash(changes, svn_sort_compare_items_as_paths,
+                                  scratch_pool);
+  paths = apr_array_make(scratch_pool, sorted_changes->nelts,
+                         sizeof(const char *));
+  for (i = 0; i < sorted_changes->nelts; ++i)
+    APR_ARRAY_PUSH(paths, const char *)
+      = APR_ARRAY_IDX(sorted_changes, i, svn_sort__item_t).key;
+
+  readable = apr_palloc(scratch_pool, paths->nelts * sizeof(*readable));
+  SVN_ERR(svn_repos__authz_read_many(readable, root, paths,
+                                     authz_read_func, authz_read_baton,
+                                     scratch_pool));
+
+  *unreadable = apr_hash_make(result_pool);
+  for (i = 0; i < sorted_changes->nelts; ++i)
+    if (! readable[i])
+      {
+        const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_changes, i,
+                                                      svn_sort__item_t);
+        apr_hash_set(*unreadable, item->key, item->klen, "");
+      }
+
+  return SVN_NO_ERROR;
+}
+
 /* Store as keys in CHANGED the paths of all node in ROOT that show a
  * significant change.  "Significant" means that the text or
  * properties of the node were changed, or that the node was added or
@@ -333,6 +381,7 @@ detect_changed(apr_hash_t **changed,
                apr_pool_t *pool)
 {
   apr_hash_t *changes = prefetched_changes;
+  apr_hash_t *unreadable = NULL;
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
   svn_boolean_t found_readable = FALSE;
@@ -349,6 +398,15 @@ detect_changed(apr_hash_t **changed,
 
   subpool = svn_pool_create(pool);
 
+  /* Check the readability of all changed paths in one go. */
+  if (authz_read_func)
+    {
+      SVN_ERR(find_unreadable_changes(&unreadable, root, changes,
+                                      authz_read_func, authz_read_baton,
+                                      pool, subpool));
+      svn_pool_clear(subpool);
+    }
+
   for (hi = apr_hash_first(pool, changes); hi; hi = apr_hash_next(hi))
     {
       /* NOTE:  Much of this loop is going to look quite similar to
@@ -366,17 +424,10 @@ detect_changed(apr_hash_t **changed,
       apr_hash_this(hi, (const void **)&path, &path_len, (void **)&change);
 
       /* Skip path if unreadable. */
-      if (authz_read_func)
+      if (unreadable && apr_hash_get(unreadable, path, path_len))
         {
-          svn_boolean_t readable;
-          SVN_ERR(authz_read_func(&readable,
-                                  root, path,
-                                  authz_read_baton, subpool));
-          if (! readable)
-            {
-              found_unreadable = TRUE;
-              continue;
-            }
+          found_unreadable = TRUE;
+          continue;
         }
 
       /* At least one changed-path was readable. */
@@ -754,6 +754,35 @@ check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Set *ALLOWED to an array of flags, allocated in POOL, that tell for
+   each of the ENTRIES (svn_fs_dirent_t *) of directory B->t_root/DIR_PATH
+   whether the user is authorized to view it.  Check all entries at
+   once. */
+static svn_error_t *
+check_auth_many(report_baton_t *b, svn_boolean_t **allowed,
+                const char *dir_path, const apr_array_header_t *entries,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, entries->nelts,
+                                             sizeof(const char *));
+  int i;
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const svn_fs_dirent_t *entry
+        = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      APR_ARRAY_PUSH(paths, const char *)
+        = svn_fspath__join(dir_path, entry->name, pool);
+    }
+
+  *allowed = apr_palloc(pool, entries->nelts * sizeof(**allowed));
+  return svn_error_trace(svn_repos__authz_read_many(*allowed, b->t_root,
+                                                    paths,
+                                                    b->authz_read_func,
+                                                    b->authz_read_baton,
+                                                    pool));
+}
+
 /* Create a dirent in *ENTRY for the given ROOT and PATH.  We use this to
    replace the source or target dirent when a report pathinfo tells us to
    change paths or revisions. */
@@ -907,6 +936,10 @@ add_file_smartly(report_baton_t *b,
    source and target entries as appropriate based on the report
    information.
 
+   T_READABLE tells whether the user is authorized to view T_PATH, if
+   the caller determined that already.  Otherwise, it is
+   svn_tristate_unknown.
+
    WC_DEPTH and REQUESTED_DEPTH are propagated to delta_dirs() if
    necessary.  Refer to delta_dirs' docstring to find out what
    should happen for various combinations of WC_DEPTH/REQUESTED_DEPTH. */
@@ -914,7 +947,8 @@ static svn_error_t *
 update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
              const svn_fs_dirent_t *s_entry, const char *t_path,
              const svn_fs_dirent_t *t_entry, void *dir_baton,
-             const char *e_path, path_info_t *info, svn_depth_t wc_depth,
+             const char *e_path, path_info_t *info,
+             svn_tristate_t t_readable, svn_depth_t wc_depth,
              svn_depth_t requested_depth, apr_pool_t *pool)
 {
   svn_fs_root_t *s_root;
@@ -1015,7 +1049,11 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     return svn_error_trace(skip_path_info(b, e_path));
 
   /* Check if the user is authorized to find out about the target. */
-  SVN_ERR(check_auth(b, &allowed, t_path, pool));
+  if (t_readable == svn_tristate_unknown)
+    SVN_ERR(check_auth(b, &allowed, t_path, pool));
+  else
+    allowed = (t_readable == svn_tristate_true);
+
   if (!allowed)
     {
       if (t_entry->kind == svn_node_dir)
@@ -1144,6 +1182,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
   apr_array_header_t *t_ordered_entries = NULL;
+  svn_boolean_t *t_allowed = NULL;
   int i;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
@@ -1216,6 +1255,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                  || (info && info->depth == svn_depth_exclude)))
             SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, t_fullpath,
                                  t_entry, dir_baton, e_fullpath, info,
+                                 svn_tristate_unknown,
                                  info ? info->depth
                                       : DEPTH_BELOW_HERE(wc_depth),
                                  DEPTH_BELOW_HERE(requested_depth), subpool));
@@ -1279,12 +1319,21 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, pool));
+
+      /* Without a source directory, every target entry gets sent and
+         needs to be authorized.  Find out which of them the user may see,
+         all in one go.  Otherwise, only changed entries get checked. */
+      if (b->authz_read_func && !s_entries && t_ordered_entries->nelts)
+        SVN_ERR(check_auth_many(b, &t_allowed, t_path, t_ordered_entries,
+                                pool));
+
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
              = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
           const svn_fs_dirent_t *s_entry;
           const char *s_fullpath, *t_fullpath, *e_fullpath;
+          svn_tristate_t t_readable;
 
           svn_pool_clear(subpool);
 
@@ -1318,8 +1367,15 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
           e_fullpath = svn_relpath_join(e_path, t_entry->name, subpool);
           t_fullpath = svn_fspath__join(t_path, t_entry->name, subpool);
 
+          if (t_allowed)
+            t_readable = t_allowed[i] ? svn_tristate_true
+                                      : svn_tristate_false;
+          else
+            t_readable = svn_tristate_unknown;
+
           SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, t_fullpath,
                                t_entry, dir_baton, e_fullpath, NULL,
+                               t_readable,
                                DEPTH_BELOW_HERE(wc_depth),
                                DEPTH_BELOW_HERE(requested_depth),
                                subpool));
@@ -1386,7 +1442,8 @@ drive(report_baton_t *b, svn_revnum_t s_rev, path_info_t *info,
   else
     SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, b->t_path,
                          t_entry, root_baton, b->s_operand, info,
-                         info->depth, b->requested_depth, pool));
+                         svn_tristate_unknown, info->depth,
+                         b->requested_depth, pool));
 
   return svn_error_trace(b->editor->close_directory(root_baton, pool));
 }
@@ -27,6 +27,7 @@
 #include <apr_hash.h>
 
 #include "svn_fs.h"
+#include "svn_config.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -364,6 +365,17 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
 
 /*** Authz Functions ***/
 
+/* Create an authz object for the authz configuration CFG and return it
+   in *AUTHZ_P, allocated in POOL.  The rules in CFG will be compiled
+   per user and repository on demand.  If THREAD_SAFE is set, the
+   result may be used by multiple threads concurrently.  CFG must not
+   be modified once the authz object is in use. */
+svn_error_t *
+svn_repos__authz_create(svn_authz_t **authz_p,
+                        svn_config_t *cfg,
+                        svn_boolean_t thread_safe,
+                        apr_pool_t *pool);
+
 /* Read authz configuration data from PATH into *AUTHZ_P, allocated
    in POOL.  If GROUPS_PATH is set, use the global groups parsed from it.
 
@@ -382,11 +394,47 @@ svn_repos__authz_read(svn_authz_t **authz_p,
                       svn_boolean_t accept_urls,
                       apr_pool_t *pool);
 
+/* Set ALLOWED[i] to TRUE if the i-th fspath in PATHS, an array of
+   const char *, may be read in ROOT according to AUTHZ_READ_FUNC and
+   AUTHZ_READ_BATON.  If these have been created by
+   svn_repos__authz_read_many_wrap(), check all paths with a single call.
+   Otherwise, call AUTHZ_READ_FUNC for every path.  Parents must come
+   before their children in PATHS and entries of the same directory
+   should be adjacent as far as possible, e.g. by sorting PATHS with
+   svn_sort_compare_paths().  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__authz_read_many(svn_boolean_t *allowed,
+                           svn_fs_root_t *root,
+                           const apr_array_header_t *paths,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           apr_pool_t *scratch_pool);
+
 /* Walk the configuration in AUTHZ looking for any errors. */
 svn_error_t *
 svn_repos__authz_validate(svn_authz_t *authz,
                           apr_pool_t *pool);
 
+
+/*** Dumpstream Parsing ***/
+
+/* Like svn_repos_parse_dumpstream3 but read and parse STREAM in a
+   separate thread, queueing the parsed records such that PARSE_FNS
+   get called from the calling thread while the next records are being
+   parsed.  CANCEL_FUNC will be called from the parser thread.
+
+   If threads are not supported, this is the same as
+   svn_repos_parse_dumpstream3. */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
 
 /*** Utility Functions ***/
 
@@ -24,6 +24,8 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_global_mutex.h>
+#include <apr_shm.h>
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
@@ -114,6 +116,21 @@
  * to scale well despite that bottleneck, we simply segment the cache into
  * a number of independent caches (segments). Items will be multiplexed based
  * on their hash key.
+ *
+ * Optionally, all segments may be placed in an anonymous shared memory
+ * region.  All processes forked from the creating process after the cache
+ * has been created will then share the same cache contents.  Since the
+ * directory only uses offsets and indexes, the only pointers in the shared
+ * data are the segment buffer and lock references, which are identical in
+ * all forked processes.  Access is serialized across processes with one
+ * global mutex per segment.
+ *
+ * Where the compiler supports it, lookups will first be attempted without
+ * taking the segment lock at all.  Every writer increments a per-segment
+ * sequence counter before and after modifying the segment.  A reader
+ * remembers the counter value, copies the item and then checks whether
+ * the counter has changed in the meantime.  Only if it did, the lookup
+ * will be repeated under the read lock.
  */
 
 /* For more efficient copy operations, let's align all data items properly.
@@ -156,6 +173,15 @@
  */
 #define NO_INDEX APR_UINT32_MAX
 
+/* Lock-free reads require acquire / release memory ordering, which the
+ * APR atomics API does not provide.  Enable them only for compilers that
+ * offer the respective intrinsics.  The consistency checks performed in
+ * SVN_DEBUG_CACHE_MEMBUFFER mode require the segment lock.
+ */
+#if defined(__ATOMIC_ACQUIRE) && !defined(SVN_DEBUG_CACHE_MEMBUFFER)
+#define OPTIMISTIC_READS
+#endif
+
 /* To save space in our group structure, we only use 32 bit size values
  * and, therefore, limit the size of each entry to just below 4GB.
  * Supporting larger items is not a good idea as the data transfer
@@ -565,6 +591,13 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_hits;
 
+  /* Write sequence counter.  Will be incremented before and after each
+   * modification done under the write lock, i.e. an odd value indicates
+   * an ongoing write.  Lock-free readers use this to detect concurrent
+   * modifications.
+   */
+  apr_uint32_t write_sequence;
+
 #if APR_HAS_THREADS
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -572,12 +605,23 @@ struct svn_membuffer_t
    */
   apr_thread_rwlock_t *lock;
 
+#endif
+
+#if APR_HAS_SHARED_MEMORY
+  /* A lock for inter-process (and inter-thread) synchronization to the
+   * cache, or NULL if this segment lives in process-private memory.  APR
+   * does not provide cross-process reader / writer locks, so readers will
+   * get exclusive access to the segment as well.  If this is set, LOCK
+   * will be NULL.
+   */
+  apr_global_mutex_t *shared_lock;
+#endif
+
   /* If set, write access will wait until they get exclusive access.
    * Otherwise, they will become no-ops if the segment is currently
    * read-locked.
    */
   svn_boolean_t allow_blocking_writes;
-#endif
 };
 
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
@@ -593,6 +637,16 @@ struct svn_membuffer_t
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+#if APR_HAS_SHARED_MEMORY
+  if (cache->shared_lock)
+    {
+      apr_status_t status = apr_global_mutex_lock(cache->shared_lock);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
 #if APR_HAS_THREADS
   if (cache->lock)
   {
@@ -609,6 +663,31 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+#if APR_HAS_SHARED_MEMORY
+  if (cache->shared_lock)
+    {
+      apr_status_t status;
+      if (cache->allow_blocking_writes)
+        {
+          status = apr_global_mutex_lock(cache->shared_lock);
+        }
+      else
+        {
+          status = apr_global_mutex_trylock(cache->shared_lock);
+          if (SVN_LOCK_IS_BUSY(status))
+            {
+              *success = FALSE;
+              status = APR_SUCCESS;
+            }
+        }
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't write-lock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
 #if APR_HAS_THREADS
   if (cache->lock)
     {
@@ -641,12 +720,21 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+  apr_status_t status = APR_SUCCESS;
+
+#if APR_HAS_SHARED_MEMORY
+  if (cache->shared_lock)
+    status = apr_global_mutex_lock(cache->shared_lock);
+  else
+#endif
 #if APR_HAS_THREADS
-  apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
+    status = apr_thread_rwlock_wrlock(cache->lock);
+#endif
+
   if (status)
     return svn_error_wrap_apr(status,
                               _("Can't write-lock cache mutex"));
-#endif
+
   return SVN_NO_ERROR;
 }
 
@@ -656,6 +744,19 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+#if APR_HAS_SHARED_MEMORY
+  if (cache->shared_lock)
+    {
+      apr_status_t status = apr_global_mutex_unlock(cache->shared_lock);
+      if (err)
+        return err;
+
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
 #if APR_HAS_THREADS
   if (cache->lock)
   {
@@ -670,6 +771,33 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
   return err;
 }
 
+/* Signal lock-free readers that CACHE is about to be modified.
+ * The caller must hold the write lock.
+ */
+static APR_INLINE void
+begin_write(svn_membuffer_t *cache)
+{
+#ifdef OPTIMISTIC_READS
+  /* make the sequence odd before any of the modifications becomes
+   * visible to other threads */
+  __atomic_store_n(&cache->write_sequence, cache->write_sequence + 1,
+                   __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+}
+
+/* Signal lock-free readers that the modification of CACHE is complete.
+ * The caller must hold the write lock.
+ */
+static APR_INLINE void
+end_write(svn_membuffer_t *cache)
+{
+#ifdef OPTIMISTIC_READS
+  __atomic_store_n(&cache->write_sequence, cache->write_sequence + 1,
+                   __ATOMIC_RELEASE);
+#endif
+}
+
 /* If supported, guard the execution of EXPR with a read lock to cache.
  * Macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
@@ -692,6 +820,7 @@ do {                                        \
 #define WITH_WRITE_LOCK(cache, expr)                            \
 do {                                                            \
   svn_boolean_t got_lock = TRUE;                                \
+  svn_error_t *write_err;                                       \
   SVN_ERR(write_lock_cache(cache, &got_lock));                  \
   if (!got_lock)                                                \
     {                                                           \
@@ -702,7 +831,10 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  begin_write(cache);                                           \
+  write_err = (expr);                                           \
+  end_write(cache);                                             \
+  SVN_ERR(unlock_cache(cache, write_err));                      \
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -963,7 +1095,7 @@ drop_entry(svn_membuffer_t *cache, entry_t *entry)
   /* update global cache usage counters
    */
   cache->used_entries--;
-  cache->hit_count -= entry->hit_count;
+  cache->hit_count -= MIN(cache->hit_count, entry->hit_count);
   cache->data_used -= entry->size;
 
   /* extend the insertion window, if the entry happens to border it
@@ -1097,7 +1229,9 @@ let_entry_age(svn_membuffer_t *cache, entry_t *entry)
 {
   apr_uint32_t hits_removed = (entry->hit_count + 1) >> 1;
 
-  cache->hit_count -= hits_removed;
+  /* Lock-free readers don't synchronize their statistics updates.
+   * Thus, the total may be slightly off and we must not underflow. */
+  cache->hit_count -= MIN(cache->hit_count, hits_removed);
   entry->hit_count -= hits_removed;
 }
 
@@ -1577,6 +1711,23 @@ static void* secure_aligned_alloc(apr_pool_t *pool,
   return memory;
 }
 
+/* Return the next SIZE bytes from the shared memory section starting at
+ * *NEXT and advance *NEXT accordingly.  Zero the memory if ZERO is set.
+ * The result will be aligned to ITEM_ALIGNMENT if *NEXT was aligned.
+ */
+static void *
+shared_aligned_alloc(char **next,
+                     apr_size_t size,
+                     svn_boolean_t zero)
+{
+  void *memory = *next;
+  *next += ALIGN_VALUE(size);
+  if (zero)
+    memset(memory, 0, size);
+
+  return memory;
+}
+
 svn_error_t *
 svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t total_size,
@@ -1584,9 +1735,11 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t segment_count,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_boolean_t shared_memory,
                                   apr_pool_t *pool)
 {
   svn_membuffer_t *c;
+  char *shared_next = NULL;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1648,9 +1801,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1701,6 +1851,41 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  if (shared_memory)
+    {
+#if APR_HAS_SHARED_MEMORY
+      /* Place the segment headers and all segment buffers in a single
+       * anonymous shared memory region.  It will be inherited by all
+       * processes forked from this one. */
+      apr_shm_t *shm;
+      apr_status_t status;
+      apr_size_t shm_size
+        = ALIGN_VALUE(segment_count * sizeof(*c))
+        + segment_count * (  ALIGN_VALUE(group_count * sizeof(entry_group_t))
+                           + ALIGN_VALUE(group_init_size)
+                           + (apr_size_t)ALIGN_VALUE(data_size));
+
+      status = apr_shm_create(&shm, shm_size, NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory cache"));
+
+      shared_next = apr_shm_baseaddr_get(shm);
+      c = shared_aligned_alloc(&shared_next, segment_count * sizeof(*c),
+                               FALSE);
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                              _("Shared memory caches are not supported "
+                                "on this platform"));
+#endif
+    }
+  else
+    {
+      /* allocate cache as an array of segments / cache objects */
+      c = apr_palloc(pool, segment_count * sizeof(*c));
+    }
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
@@ -1712,12 +1897,18 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].first_spare_group = NO_INDEX;
       c[seg].max_spare_used = 0;
 
-      c[seg].directory = apr_pcalloc(pool,
-                                     group_count * sizeof(entry_group_t));
+      c[seg].directory
+        = shared_next
+        ? shared_aligned_alloc(&shared_next,
+                               group_count * sizeof(entry_group_t), TRUE)
+        : apr_pcalloc(pool, group_count * sizeof(entry_group_t));
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized
+        = shared_next
+        ? shared_aligned_alloc(&shared_next, group_init_size, TRUE)
+        : apr_pcalloc(pool, group_init_size);
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -1737,7 +1928,10 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.size = data_size - c[seg].l1.size;
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
-      c[seg].data = secure_aligned_alloc(pool, (apr_size_t)data_size, FALSE);
+      c[seg].data
+        = shared_next
+        ? shared_aligned_alloc(&shared_next, (apr_size_t)data_size, FALSE)
+        : secure_aligned_alloc(pool, (apr_size_t)data_size, FALSE);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -1746,6 +1940,7 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
+      c[seg].write_sequence = 0;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
@@ -1763,18 +1958,34 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
        * thread-safe.
        */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_safe && !shared_memory)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
           if (status)
             return svn_error_wrap_apr(status, _("Can't create cache mutex"));
         }
+#endif
+
+#if APR_HAS_SHARED_MEMORY
+      /* Shared segments always need a lock because they will be accessed
+       * by multiple processes.  The global mutex also serializes access
+       * between threads of the same process.
+       */
+      c[seg].shared_lock = NULL;
+      if (shared_memory)
+        {
+          apr_status_t status =
+              apr_global_mutex_create(&(c[seg].shared_lock), NULL,
+                                      APR_LOCK_DEFAULT, pool);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't create cache mutex"));
+        }
+#endif
 
       /* Select the behavior of write operations.
        */
       c[seg].allow_blocking_writes = allow_blocking_writes;
-#endif
     }
 
   /* done here
@@ -1783,6 +1994,32 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_child_init(svn_membuffer_t *cache,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_SHARED_MEMORY
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  /* Some lock mechanisms (e.g. flock) must be re-opened in every child.
+   * APR only updates the process-private mutex object here; the segment
+   * headers in shared memory keep pointing to it.
+   */
+  for (seg = 0; seg < segment_count; ++seg)
+    if (cache[seg].shared_lock)
+      {
+        apr_status_t status
+          = apr_global_mutex_child_init(&cache[seg].shared_lock, NULL, pool);
+        if (status)
+          return svn_error_wrap_apr(status,
+                                    _("Can't re-open cache mutex"));
+      }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND and set *FOUND accordingly.
  *
@@ -2026,6 +2263,133 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+#ifdef OPTIMISTIC_READS
+
+/* Lock-free variant of find_entry with FIND_EMPTY not set.  Since CACHE
+ * may get modified concurrently, all values read from the directory
+ * will be checked before being used for addressing.  The result is only
+ * valid if the write sequence did not change in the meantime.
+ */
+static entry_t *
+find_entry_optimistic(svn_membuffer_t *cache,
+                      apr_uint32_t group_index,
+                      const apr_uint64_t to_find[2])
+{
+  entry_group_t *group = &cache->directory[group_index];
+  apr_uint32_t total_group_count
+    = cache->group_count + cache->spare_group_count;
+  apr_uint32_t chain_length = 1;
+  apr_size_t i;
+
+  if (! is_group_initialized(cache, group_index))
+    return NULL;
+
+  while (1)
+    {
+      apr_uint32_t used = group->header.used;
+      apr_uint32_t next;
+
+      if (used > GROUP_SIZE)
+        return NULL;
+
+      for (i = 0; i < used; ++i)
+        if (   to_find[0] == group->entries[i].key[0]
+            && to_find[1] == group->entries[i].key[1])
+          return &group->entries[i];
+
+      /* end of chain (or a corrupted one)? */
+      next = group->header.next;
+      if (   next == NO_INDEX
+          || next >= total_group_count
+          || ++chain_length > MAX_GROUP_CHAIN_LENGTH)
+        return NULL;
+
+      group = &cache->directory[next];
+    }
+}
+
+#endif
+
+/* Try to look up the item identified by TO_FIND in group GROUP_INDEX of
+ * CACHE without acquiring the segment lock.  Return TRUE and set *BUFFER
+ * and *ITEM_SIZE as membuffer_cache_get_internal would do, if there was
+ * no concurrent modification of CACHE.  Otherwise, return FALSE and the
+ * caller will have to retry under the lock.
+ * Allocations will be done in RESULT_POOL.
+ */
+static svn_boolean_t
+membuffer_cache_get_optimistic(svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               entry_key_t to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               apr_pool_t *result_pool)
+{
+#ifdef OPTIMISTIC_READS
+  entry_t *entry;
+  apr_uint32_t sequence
+    = __atomic_load_n(&cache->write_sequence, __ATOMIC_ACQUIRE);
+
+  /* Some writer is currently active. Don't bother trying. */
+  if (sequence & 1)
+    return FALSE;
+
+  entry = find_entry_optimistic(cache, group_index, to_find);
+  if (entry == NULL)
+    {
+      *buffer = NULL;
+      *item_size = 0;
+    }
+  else
+    {
+      /* Read the item location exactly once and never access memory
+       * outside the data buffer, even if ENTRY is being modified. */
+      apr_uint64_t offset = entry->offset;
+      apr_uint32_t entry_size = entry->size;
+      apr_size_t size = ALIGN_VALUE(entry_size);
+
+      if (   entry_size > cache->max_entry_size
+          || offset + size > cache->l2.start_offset + cache->l2.size)
+        return FALSE;
+
+      *buffer = ALIGN_POINTER(apr_palloc(result_pool,
+                                         size + ITEM_ALIGNMENT-1));
+      memcpy(*buffer, (const char*)cache->data + offset, size);
+      *item_size = entry_size;
+    }
+
+  /* Count the hit before validating the sequence.  Hot items must keep
+   * gaining priority or eviction would drop them from L1 instead of
+   * promoting them to L2.  ENTRY always points into the directory, so
+   * the increment is safe even if a writer moved or reused that slot.
+   * In that case, the check below fails and we retry under the lock,
+   * leaving at most one stray hit on some other entry.
+   */
+  if (entry)
+    __atomic_fetch_add(&entry->hit_count, 1, __ATOMIC_ACQ_REL);
+
+  /* Was any of the data read above modified? */
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (sequence != __atomic_load_n(&cache->write_sequence, __ATOMIC_RELAXED))
+    return FALSE;
+
+  /* update the remaining statistics.
+   * Just like under the shared read lock, concurrent readers update these,
+   * hence the atomic increments.
+   */
+  __atomic_fetch_add(&cache->total_reads, 1, __ATOMIC_RELAXED);
+  if (entry)
+    {
+      __atomic_fetch_add(&cache->hit_count, 1, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&cache->total_hits, 1, __ATOMIC_RELAXED);
+    }
+
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
 /* Look for the *ITEM identified by KEY. If no item has been stored
  * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
  * re-construct the proper object from the serialized data.
@@ -2046,14 +2410,16 @@ membuffer_cache_get(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+  if (!membuffer_cache_get_optimistic(cache, group_index, key,
+                                      &buffer, &size, result_pool))
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_get_internal(cache,
+                                                group_index,
+                                                key,
+                                                &buffer,
+                                                &size,
+                                                DEBUG_CACHE_MEMBUFFER_TAG
+                                                result_pool));
 
   /* re-construct the original data object from its serialized form.
    */
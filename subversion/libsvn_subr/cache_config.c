@@ -63,6 +63,12 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* Whether the global membuffer cache shall be allocated in shared memory.
+ * Use process-private memory by default.  Pre-fork servers may share a
+ * single cache between all worker processes by setting this.
+ */
+static svn_boolean_t cache_shared_memory = FALSE;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,6 +126,7 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
           0,
           ! svn_cache_config_get()->single_threaded,
           FALSE,
+          cache_shared_memory,
           pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
@@ -172,3 +179,30 @@ svn_cache_config_set(const svn_cache_config_t *settings)
   cache_settings = *settings;
 }
 
+void
+svn_cache__set_global_membuffer_shared(svn_boolean_t shared)
+{
+  cache_shared_memory = shared;
+}
+
+svn_boolean_t
+svn_cache__get_global_membuffer_shared(void)
+{
+  return cache_shared_memory;
+}
+
+svn_error_t *
+svn_cache__global_membuffer_child_init(apr_pool_t *pool)
+{
+  svn_membuffer_t *cache;
+
+  /* Don't create a process-private cache as a side-effect. */
+  if (! cache_shared_memory)
+    return SVN_NO_ERROR;
+
+  cache = svn_cache__get_global_membuffer_cache();
+  if (cache)
+    SVN_ERR(svn_cache__membuffer_cache_child_init(cache, pool));
+
+  return SVN_NO_ERROR;
+}
@@ -26,10 +26,16 @@
 
 #include <apr_md5.h>
 #include <apr_sha1.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
 
 #include "svn_checksum.h"
 #include "svn_error.h"
 #include "svn_ctype.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
 
 #include "sha1.h"
 #include "md5.h"
@@ -320,7 +326,7 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
+  svn_sha1__ctx_t sha1_ctx;
 
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
@@ -332,9 +338,9 @@ svn_checksum(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        svn_sha1__init(&sha1_ctx);
+        svn_sha1__update(&sha1_ctx, data, len);
+        svn_sha1__final((unsigned char *)(*checksum)->digest, &sha1_ctx);
         break;
 
       default:
@@ -387,8 +393,8 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = apr_palloc(pool, sizeof(svn_sha1__ctx_t));
+        svn_sha1__init(ctx->apr_ctx);
         break;
 
       default:
@@ -410,7 +416,7 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       default:
@@ -435,7 +441,7 @@ svn_checksum_final(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       default:
@@ -446,6 +452,336 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+/* Feed data to the checksum contexts in slices of this size, small
+   enough to still be in the L1 cache when the second context gets it. */
+#define UPDATE_SLICE_SIZE 0x2000
+
+svn_error_t *
+svn_checksum__update2(svn_checksum_ctx_t *ctx1,
+                      svn_checksum_ctx_t *ctx2,
+                      const void *data,
+                      apr_size_t len)
+{
+  const char *p = data;
+
+  while (len > 0)
+    {
+      apr_size_t slice = len < UPDATE_SLICE_SIZE ? len : UPDATE_SLICE_SIZE;
+
+      SVN_ERR(svn_checksum_update(ctx1, p, slice));
+      SVN_ERR(svn_checksum_update(ctx2, p, slice));
+
+      p += slice;
+      len -= slice;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* The data written to a svn_checksum__update2_stream() gets copied into
+   a ring of PIPELINE_QUEUE_LENGTH blocks of PIPELINE_BLOCK_SIZE bytes
+   each.  Once a block is full, it gets queued for the checksum thread.
+   If all blocks are in use, the writer waits for the checksum thread to
+   catch up. */
+#define PIPELINE_BLOCK_SIZE 0x40000
+#define PIPELINE_QUEUE_LENGTH 8
+
+/* State shared between the writer and the checksum thread.  Unless
+   noted otherwise, all members are protected by MUTEX. */
+typedef struct checksum_pipeline_t
+{
+  /* Checksum contexts to update.  Only to be used by the checksum thread
+     while it is running. */
+  svn_checksum_ctx_t *ctx1;
+  svn_checksum_ctx_t *ctx2;
+
+  /* Ring of data blocks and the number of bytes in them.  Read-only
+     except for the block being filled, which is owned by the writer. */
+  char *blocks[PIPELINE_QUEUE_LENGTH];
+  apr_size_t lengths[PIPELINE_QUEUE_LENGTH];
+
+  /* The oldest block queued and the number of blocks queued. */
+  int first;
+  int count;
+
+  /* Number of bytes already in the block being filled.  Only used by the
+     writer. */
+  apr_size_t fill;
+
+  /* Set by the writer when no further blocks will be queued. */
+  svn_boolean_t finished;
+
+  /* Set by the writer if the checksum thread shall quit immediately. */
+  svn_boolean_t abandon;
+
+  /* Error returned by the checksum calculation. */
+  svn_error_t *err;
+
+  /* The checksum thread, NULL if not running.  Only used by the writer. */
+  apr_thread_t *thread;
+
+  /* Root pool used for the checksum thread.  Only used by the writer. */
+  apr_pool_t *thread_pool;
+
+  /* Serializes access to the above and signals any change in state. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} checksum_pipeline_t;
+
+/* Checksum thread function.  Feed the blocks queued in the
+   checksum_pipeline_t DATA into its checksum contexts until the writer
+   declares the pipeline finished. */
+static void * APR_THREAD_FUNC
+checksum_worker(apr_thread_t *tid, void *data)
+{
+  checksum_pipeline_t *pipeline = data;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  while (!pipeline->abandon && (pipeline->count || !pipeline->finished))
+    {
+      const char *block;
+      apr_size_t len;
+      svn_error_t *err;
+
+      if (pipeline->count == 0)
+        {
+          apr_thread_cond_wait(pipeline->changed, pipeline->mutex);
+          continue;
+        }
+
+      block = pipeline->blocks[pipeline->first];
+      len = pipeline->lengths[pipeline->first];
+      apr_thread_mutex_unlock(pipeline->mutex);
+
+      err = svn_checksum__update2(pipeline->ctx1, pipeline->ctx2,
+                                  block, len);
+
+      apr_thread_mutex_lock(pipeline->mutex);
+      if (err)
+        {
+          pipeline->err = err;
+          pipeline->abandon = TRUE;
+        }
+
+      pipeline->first = (pipeline->first + 1) % PIPELINE_QUEUE_LENGTH;
+      --pipeline->count;
+      apr_thread_cond_broadcast(pipeline->changed);
+    }
+
+  apr_thread_mutex_unlock(pipeline->mutex);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Queue the block being filled in PIPELINE, if it is not empty.  Wait
+   until a new block can be filled. */
+static void
+pipeline_push(checksum_pipeline_t *pipeline)
+{
+  int next;
+
+  if (pipeline->fill == 0)
+    return;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+
+  next = (pipeline->first + pipeline->count) % PIPELINE_QUEUE_LENGTH;
+  pipeline->lengths[next] = pipeline->fill;
+  ++pipeline->count;
+  apr_thread_cond_broadcast(pipeline->changed);
+
+  while (pipeline->count == PIPELINE_QUEUE_LENGTH && !pipeline->abandon)
+    apr_thread_cond_wait(pipeline->changed, pipeline->mutex);
+
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  pipeline->fill = 0;
+}
+
+/* Stop the checksum thread of PIPELINE, without waiting for it to process
+   the queued data if ABANDON is set.  Return the checksum error, if any. */
+static svn_error_t *
+pipeline_stop(checksum_pipeline_t *pipeline,
+              svn_boolean_t abandon)
+{
+  apr_status_t retval;
+  svn_error_t *err;
+
+  if (pipeline->thread == NULL)
+    return SVN_NO_ERROR;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  pipeline->finished = TRUE;
+  pipeline->abandon |= abandon;
+  apr_thread_cond_broadcast(pipeline->changed);
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  apr_thread_join(&retval, pipeline->thread);
+  pipeline->thread = NULL;
+  svn_pool_destroy(pipeline->thread_pool);
+
+  err = pipeline->err;
+  pipeline->err = SVN_NO_ERROR;
+
+  return err;
+}
+
+/* Pool cleanup function making sure that the checksum thread of the
+   checksum_pipeline_t DATA does not outlive the blocks it reads. */
+static apr_status_t
+pipeline_cleanup(void *data)
+{
+  svn_error_clear(pipeline_stop(data, TRUE));
+  return APR_SUCCESS;
+}
+
+/* Start a checksum thread updating CTX1 and CTX2 and return the pipeline
+   feeding it in *PIPELINE_P.  Set *PIPELINE_P to NULL if that is not
+   possible.  Allocate the pipeline in POOL.  The thread will be stopped
+   when POOL gets cleared. */
+static void
+pipeline_start(checksum_pipeline_t **pipeline_p,
+               svn_checksum_ctx_t *ctx1,
+               svn_checksum_ctx_t *ctx2,
+               apr_pool_t *pool)
+{
+  checksum_pipeline_t *pipeline = apr_pcalloc(pool, sizeof(*pipeline));
+  apr_status_t status;
+  int i;
+
+  *pipeline_p = NULL;
+
+  pipeline->ctx1 = ctx1;
+  pipeline->ctx2 = ctx2;
+
+  status = apr_thread_mutex_create(&pipeline->mutex,
+                                   APR_THREAD_MUTEX_DEFAULT, pool);
+  if (!status)
+    status = apr_thread_cond_create(&pipeline->changed, pool);
+  if (status)
+    return;
+
+  for (i = 0; i < PIPELINE_QUEUE_LENGTH; ++i)
+    pipeline->blocks[i] = apr_palloc(pool, PIPELINE_BLOCK_SIZE);
+
+  /* The thread must not allocate from our allocator. */
+  pipeline->thread_pool = svn_pool_create(NULL);
+  status = apr_thread_create(&pipeline->thread, NULL, checksum_worker,
+                             pipeline, pipeline->thread_pool);
+  if (status)
+    {
+      svn_pool_destroy(pipeline->thread_pool);
+      return;
+    }
+
+  apr_pool_cleanup_register(pool, pipeline, pipeline_cleanup,
+                            apr_pool_cleanup_null);
+  *pipeline_p = pipeline;
+}
+
+/* Implements svn_write_fn_t.  Queue the *LEN bytes of DATA for
+   checksumming in the checksum_pipeline_t BATON. */
+static svn_error_t *
+pipeline_write(void *baton,
+               const char *data,
+               apr_size_t *len)
+{
+  checksum_pipeline_t *pipeline = baton;
+  apr_size_t remaining = *len;
+
+  while (remaining)
+    {
+      int current;
+      apr_size_t to_copy = MIN(remaining,
+                               PIPELINE_BLOCK_SIZE - pipeline->fill);
+
+      /* PIPELINE->FIRST and ->COUNT may change concurrently but the
+         block being filled may not. */
+      apr_thread_mutex_lock(pipeline->mutex);
+      current = (pipeline->first + pipeline->count) % PIPELINE_QUEUE_LENGTH;
+      apr_thread_mutex_unlock(pipeline->mutex);
+
+      memcpy(pipeline->blocks[current] + pipeline->fill, data, to_copy);
+      pipeline->fill += to_copy;
+      data += to_copy;
+      remaining -= to_copy;
+
+      if (pipeline->fill == PIPELINE_BLOCK_SIZE)
+        pipeline_push(pipeline);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Queue any remaining data in the
+   checksum_pipeline_t BATON and wait for the checksum thread to process
+   it.  After that, the checksum contexts are complete. */
+static svn_error_t *
+pipeline_close(void *baton)
+{
+  checksum_pipeline_t *pipeline = baton;
+
+  pipeline_push(pipeline);
+  return svn_error_trace(pipeline_stop(pipeline, FALSE));
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Baton type used by update2_write. */
+typedef struct update2_baton_t
+{
+  svn_checksum_ctx_t *ctx1;
+  svn_checksum_ctx_t *ctx2;
+} update2_baton_t;
+
+/* Implements svn_write_fn_t.  Update both checksum contexts in the
+   update2_baton_t BATON with the *LEN bytes of DATA. */
+static svn_error_t *
+update2_write(void *baton,
+              const char *data,
+              apr_size_t *len)
+{
+  update2_baton_t *b = baton;
+  return svn_error_trace(svn_checksum__update2(b->ctx1, b->ctx2, data,
+                                               *len));
+}
+
+svn_stream_t *
+svn_checksum__update2_stream(svn_checksum_ctx_t *ctx1,
+                             svn_checksum_ctx_t *ctx2,
+                             apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  update2_baton_t *baton;
+
+#if APR_HAS_THREADS
+  checksum_pipeline_t *pipeline;
+
+  pipeline_start(&pipeline, ctx1, ctx2, pool);
+  if (pipeline)
+    {
+      stream = svn_stream_create(pipeline, pool);
+      svn_stream_set_write(stream, pipeline_write);
+      svn_stream_set_close(stream, pipeline_close);
+
+      return stream;
+    }
+#endif
+
+  /* No thread available.  Update the checksums in the writer's thread. */
+  baton = apr_palloc(pool, sizeof(*baton));
+  baton->ctx1 = ctx1;
+  baton->ctx2 = ctx2;
+
+  stream = svn_stream_create(baton, pool);
+  svn_stream_set_write(stream, update2_write);
+
+  return stream;
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
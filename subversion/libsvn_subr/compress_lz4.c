@@ -0,0 +1,366 @@
+/*
+ * compress_lz4.c:  fast LZ77 compression using the LZ4 block format
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include "svn_sorts.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* This is a small, self-contained implementation of the LZ4 block format
+ * (see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+ * It trades compression ratio for speed: there is no entropy coding and
+ * decompression is little more than a sequence of memcpy calls.
+ *
+ * A block is a sequence of "sequences", each consisting of
+ *
+ *   - a token byte: the upper 4 bits give the number of literals,
+ *     the lower 4 bits give the match length minus MIN_MATCH,
+ *   - optional extra literal length bytes (if the nibble is 15),
+ *   - the literals,
+ *   - the 16 bit little-endian match distance,
+ *   - optional extra match length bytes (if the nibble is 15).
+ *
+ * The last sequence contains literals only.
+ */
+
+/* Shortest match we will encode. */
+#define MIN_MATCH 4
+
+/* The last LAST_LITERALS bytes of the input are always literals and
+   no match may start within the last MF_LIMIT bytes. */
+#define LAST_LITERALS 5
+#define MF_LIMIT 12
+
+/* Largest match distance that can be encoded. */
+#define MAX_DISTANCE 0xffff
+
+/* Number of bits in the hash values used to find matches.  The hash
+   table will take 4 << HASH_BITS bytes on the stack. */
+#define HASH_BITS 12
+
+/* Start skipping input faster after this many unsuccessful attempts to
+   find a match.  That makes incompressible data cheap to process. */
+#define SKIP_TRIGGER 6
+
+/* Return the 4 bytes at P as a 32 bit number in machine byte order. */
+static APR_INLINE apr_uint32_t
+read32(const unsigned char *p)
+{
+  apr_uint32_t value;
+  memcpy(&value, p, sizeof(value));
+
+  return value;
+}
+
+/* Return the hash table index for the 4 bytes given in VALUE. */
+static APR_INLINE apr_size_t
+hash_value(apr_uint32_t value)
+{
+  return (apr_size_t)((value * 2654435761U) >> (32 - HASH_BITS));
+}
+
+/* Write the extra length bytes for LEN - 15 to OUT and return the
+   position after them. */
+static unsigned char *
+write_length(unsigned char *out,
+             apr_size_t len)
+{
+  for (len -= 15; len >= 255; len -= 255)
+    *out++ = 255;
+
+  *out++ = (unsigned char)len;
+  return out;
+}
+
+/* Write a sequence of LITERAL_LEN bytes at LITERALS, followed by a match
+   of MATCH_LEN bytes at DISTANCE, to OUT and return the position after
+   it.  If MATCH_LEN is 0, write the final, literals-only sequence. */
+static unsigned char *
+write_sequence(unsigned char *out,
+               const unsigned char *literals,
+               apr_size_t literal_len,
+               apr_size_t distance,
+               apr_size_t match_len)
+{
+  unsigned char *token = out++;
+
+  *token = (unsigned char)(MIN(literal_len, 15) << 4);
+  if (literal_len >= 15)
+    out = write_length(out, literal_len);
+
+  memcpy(out, literals, literal_len);
+  out += literal_len;
+
+  if (match_len)
+    {
+      match_len -= MIN_MATCH;
+
+      *out++ = (unsigned char)(distance & 0xff);
+      *out++ = (unsigned char)(distance >> 8);
+
+      *token |= (unsigned char)MIN(match_len, 15);
+      if (match_len >= 15)
+        out = write_length(out, match_len);
+    }
+
+  return out;
+}
+
+/* Compress the LEN bytes at IN into OUT and return the number of bytes
+   written.  OUT must provide at least LZ4_BOUND(LEN) bytes. */
+#define LZ4_BOUND(LEN) ((LEN) + (LEN) / 255 + 16)
+
+static apr_size_t
+compress_block(unsigned char *out,
+               const unsigned char *in,
+               apr_size_t len)
+{
+  apr_uint32_t table[1 << HASH_BITS];
+  const unsigned char *ip = in;
+  const unsigned char *anchor = in;
+  const unsigned char *end = in + len;
+  unsigned char *op = out;
+
+  if (len > MF_LIMIT)
+    {
+      const unsigned char *match_limit = end - MF_LIMIT;
+      const unsigned char *match_end_limit = end - LAST_LITERALS;
+      apr_size_t misses = 0;
+
+      memset(table, 0, sizeof(table));
+      while (ip <= match_limit)
+        {
+          apr_uint32_t value = read32(ip);
+          apr_size_t hash = hash_value(value);
+          const unsigned char *ref = in + table[hash];
+          apr_size_t match_len;
+
+          table[hash] = (apr_uint32_t)(ip - in);
+
+          /* Stale or colliding table entries are simply no match. */
+          if (   ref >= ip
+              || ip - ref > MAX_DISTANCE
+              || read32(ref) != value)
+            {
+              ip += 1 + (misses++ >> SKIP_TRIGGER);
+              continue;
+            }
+
+          /* Extend the match forward and backward as far as possible. */
+          match_len = MIN_MATCH;
+          while (   ip + match_len < match_end_limit
+                 && ip[match_len] == ref[match_len])
+            ++match_len;
+
+          while (ip > anchor && ref > in && ip[-1] == ref[-1])
+            {
+              --ip;
+              --ref;
+              ++match_len;
+            }
+
+          op = write_sequence(op, anchor, ip - anchor, ip - ref, match_len);
+          ip += match_len;
+          anchor = ip;
+          misses = 0;
+        }
+    }
+
+  op = write_sequence(op, anchor, end - anchor, 0, 0);
+  return op - out;
+}
+
+/* Read extra length bytes from *IN, not going beyond END, and add them
+   to *LEN.  Return FALSE if the input is corrupt. */
+static svn_boolean_t
+read_length(apr_size_t *len,
+            const unsigned char **in,
+            const unsigned char *end)
+{
+  const unsigned char *p = *in;
+  unsigned char c;
+
+  do
+    {
+      if (p >= end)
+        return FALSE;
+
+      c = *p++;
+      *len += c;
+    }
+  while (c == 255);
+
+  *in = p;
+  return TRUE;
+}
+
+/* Decompress the IN_LEN bytes at IN into the OUT_LEN bytes at OUT.
+   Return FALSE if the input is corrupt or does not expand to exactly
+   OUT_LEN bytes. */
+static svn_boolean_t
+decompress_block(unsigned char *out,
+                 apr_size_t out_len,
+                 const unsigned char *in,
+                 apr_size_t in_len)
+{
+  const unsigned char *ip = in;
+  const unsigned char *in_end = in + in_len;
+  unsigned char *op = out;
+  unsigned char *out_end = out + out_len;
+
+  while (TRUE)
+    {
+      apr_size_t literal_len, match_len, distance;
+      unsigned char token;
+      const unsigned char *ref;
+
+      if (ip >= in_end)
+        return FALSE;
+
+      token = *ip++;
+
+      /* Copy the literals. */
+      literal_len = token >> 4;
+      if (literal_len == 15 && !read_length(&literal_len, &ip, in_end))
+        return FALSE;
+
+      if (   literal_len > (apr_size_t)(in_end - ip)
+          || literal_len > (apr_size_t)(out_end - op))
+        return FALSE;
+
+      memcpy(op, ip, literal_len);
+      op += literal_len;
+      ip += literal_len;
+
+      /* The last sequence has no match part. */
+      if (ip == in_end)
+        break;
+
+      /* Copy the match. */
+      if (in_end - ip < 2)
+        return FALSE;
+
+      distance = ip[0] + ((apr_size_t)ip[1] << 8);
+      ip += 2;
+      if (distance == 0 || distance > (apr_size_t)(op - out))
+        return FALSE;
+
+      match_len = token & 15;
+      if (match_len == 15 && !read_length(&match_len, &ip, in_end))
+        return FALSE;
+
+      match_len += MIN_MATCH;
+      if (match_len > (apr_size_t)(out_end - op))
+        return FALSE;
+
+      ref = op - distance;
+      if (distance >= match_len)
+        {
+          memcpy(op, ref, match_len);
+          op += match_len;
+        }
+      else
+        {
+          /* Overlapping copy, i.e. a repeating pattern. */
+          unsigned char *match_end = op + match_len;
+          while (op < match_end)
+            *op++ = *ref++;
+        }
+    }
+
+  return op == out_end;
+}
+
+svn_error_t *
+svn__compress_lz4(svn_stringbuf_t *in,
+                  svn_stringbuf_t *out)
+{
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN], *p;
+  apr_size_t prefix_len;
+  apr_size_t compressed_len;
+
+  svn_stringbuf_setempty(out);
+  p = svn__encode_uint(buf, (apr_uint64_t)in->len);
+  svn_stringbuf_appendbytes(out, (const char *)buf, p - buf);
+  prefix_len = out->len;
+
+  svn_stringbuf_ensure(out, prefix_len + LZ4_BOUND(in->len));
+  compressed_len = compress_block((unsigned char *)out->data + prefix_len,
+                                  (const unsigned char *)in->data,
+                                  in->len);
+
+  /* Compression didn't help :(, just append the original text */
+  if (compressed_len >= in->len)
+    {
+      out->len = prefix_len;
+      svn_stringbuf_appendbytes(out, in->data, in->len);
+    }
+  else
+    {
+      out->len = prefix_len + compressed_len;
+      out->data[out->len] = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn__decompress_lz4(svn_stringbuf_t *in,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit)
+{
+  const unsigned char *p = (const unsigned char *)in->data;
+  const unsigned char *end = p + in->len;
+  apr_uint64_t size;
+  apr_size_t len;
+
+  /* First thing in the string is the original length.  */
+  p = svn__decode_uint(&size, p, end);
+  len = (apr_size_t)size;
+  if (p == NULL || len != size)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed: "
+                              "no size"));
+  if (len > limit)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed: "
+                              "size too large"));
+
+  svn_stringbuf_ensure(out, len);
+
+  /* Data that did not compress well has been stored verbatim. */
+  if ((apr_size_t)(end - p) == len)
+    memcpy(out->data, p, len);
+  else if (!decompress_block((unsigned char *)out->data, len, p, end - p))
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed: "
+                              "corrupt data"));
+
+  out->data[len] = 0;
+  out->len = len;
+
+  return SVN_NO_ERROR;
+}
@@ -30,9 +30,32 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+#if SVN__SSE2_ENABLED
+#include <emmintrin.h>
+#endif
+
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
+#if SVN__SSE2_ENABLED
+
+  /* Test 16 bytes at a time.  The exact position within the chunk that
+   * contains the first \r or \n is determined by the loops below. */
+  const __m128i r_mask = _mm_set1_epi8('\r');
+  const __m128i n_mask = _mm_set1_epi8('\n');
+
+  for (; len >= sizeof(__m128i)
+       ; buf += sizeof(__m128i), len -= sizeof(__m128i))
+  {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+    __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, r_mask),
+                                 _mm_cmpeq_epi8(chunk, n_mask));
+    if (_mm_movemask_epi8(found))
+      break;
+  }
+
+#endif
+
 #if !SVN_UNALIGNED_ACCESS_IS_OK
 
   /* On some systems, we need to make sure that BUF is properly aligned
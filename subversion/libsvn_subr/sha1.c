@@ -21,10 +21,35 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include <apr_sha1.h>
 
 #include "sha1.h"
 
+/* The SHA instructions are only available on x86 and need a compiler
+ * that allows us to use them in selected functions without enabling
+ * them for the whole build.  Whether the CPU supports them gets
+ * determined at runtime.  Define SVN_DISABLE_SHA1_HW to always use
+ * APR's implementation.
+ */
+#if !defined(SVN_DISABLE_SHA1_HW) \
+    && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) \
+        ? (__clang_major__ > 3 \
+           || (__clang_major__ == 3 && __clang_minor__ >= 8)) \
+        : (defined(__GNUC__) \
+           && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SVN_SHA1__HW_ENABLED 1
+#else
+#define SVN_SHA1__HW_ENABLED 0
+#endif
+
+#if SVN_SHA1__HW_ENABLED
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 
 
 /* The SHA1 digest for the empty string. */
@@ -80,3 +105,340 @@ svn_sha1__digests_match(const unsigned char d1[], const unsigned char d2[])
           || (memcmp(d2, zeros, APR_SHA1_DIGESTSIZE) == 0)
           || (memcmp(d1, d2, APR_SHA1_DIGESTSIZE) == 0));
 }
+
+
+#if SVN_SHA1__HW_ENABLED
+
+/* Return TRUE if the CPU supports the SHA instructions as well as the
+ * SSSE3 and SSE4.1 instructions used alongside them.
+ */
+static svn_boolean_t
+sha1_hw_available(void)
+{
+  /* -1 means "not determined, yet".  Concurrent first calls will all
+     come to the same result, so no synchronization is needed. */
+  static volatile int available = -1;
+
+  if (available < 0)
+    {
+      unsigned int eax, ebx, ecx, edx;
+      int result = 0;
+
+      if (__get_cpuid_max(0, NULL) >= 7)
+        {
+          __cpuid(1, eax, ebx, ecx, edx);
+          if ((ecx & (1 << 9)) && (ecx & (1 << 19)))
+            {
+              __cpuid_count(7, 0, eax, ebx, ecx, edx);
+              result = (ebx >> 29) & 1;
+            }
+        }
+
+      available = result;
+    }
+
+  return available != 0;
+}
+
+/* Process the COUNT 64 byte blocks at DATA and update STATE accordingly.
+ * This follows the sample code given in Intel's description of the SHA
+ * extensions.
+ */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void
+sha1_hw_blocks(apr_uint32_t state[5],
+               const unsigned char *data,
+               apr_size_t count)
+{
+  __m128i abcd, abcd_save, e0, e0_save, e1;
+  __m128i msg0, msg1, msg2, msg3;
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607LL,
+                                      0x08090a0b0c0d0e0fLL);
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count > 0; --count, data += 64)
+    {
+      abcd_save = abcd;
+      e0_save = e0;
+
+      /* Rounds 0-3 */
+      msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)),
+                              mask);
+      e0 = _mm_add_epi32(e0, msg0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+      /* Rounds 4-7 */
+      msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)),
+                              mask);
+      e1 = _mm_sha1nexte_epu32(e1, msg1);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+      /* Rounds 8-11 */
+      msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)),
+                              mask);
+      e0 = _mm_sha1nexte_epu32(e0, msg2);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      /* Rounds 12-15 */
+      msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)),
+                              mask);
+      e1 = _mm_sha1nexte_epu32(e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      /* Rounds 16-19 */
+      e0 = _mm_sha1nexte_epu32(e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      /* Rounds 20-23 */
+      e1 = _mm_sha1nexte_epu32(e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      /* Rounds 24-27 */
+      e0 = _mm_sha1nexte_epu32(e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      /* Rounds 28-31 */
+      e1 = _mm_sha1nexte_epu32(e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      /* Rounds 32-35 */
+      e0 = _mm_sha1nexte_epu32(e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      /* Rounds 36-39 */
+      e1 = _mm_sha1nexte_epu32(e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      /* Rounds 40-43 */
+      e0 = _mm_sha1nexte_epu32(e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      /* Rounds 44-47 */
+      e1 = _mm_sha1nexte_epu32(e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      /* Rounds 48-51 */
+      e0 = _mm_sha1nexte_epu32(e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      /* Rounds 52-55 */
+      e1 = _mm_sha1nexte_epu32(e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      /* Rounds 56-59 */
+      e0 = _mm_sha1nexte_epu32(e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      /* Rounds 60-63 */
+      e1 = _mm_sha1nexte_epu32(e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      /* Rounds 64-67 */
+      e0 = _mm_sha1nexte_epu32(e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      /* Rounds 68-71 */
+      e1 = _mm_sha1nexte_epu32(e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      /* Rounds 72-75 */
+      e0 = _mm_sha1nexte_epu32(e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+      /* Rounds 76-79 */
+      e1 = _mm_sha1nexte_epu32(e1, msg3);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+      e0 = _mm_sha1nexte_epu32(e0, e0_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#endif /* SVN_SHA1__HW_ENABLED */
+
+void
+svn_sha1__init(svn_sha1__ctx_t *ctx)
+{
+#if SVN_SHA1__HW_ENABLED
+  ctx->use_hw = sha1_hw_available();
+#else
+  ctx->use_hw = FALSE;
+#endif
+
+  if (ctx->use_hw)
+    {
+      ctx->state[0] = 0x67452301;
+      ctx->state[1] = 0xefcdab89;
+      ctx->state[2] = 0x98badcfe;
+      ctx->state[3] = 0x10325476;
+      ctx->state[4] = 0xc3d2e1f0;
+      ctx->length = 0;
+    }
+  else
+    {
+      apr_sha1_init(&ctx->apr_ctx);
+    }
+}
+
+void
+svn_sha1__update(svn_sha1__ctx_t *ctx,
+                 const void *data,
+                 apr_size_t len)
+{
+#if SVN_SHA1__HW_ENABLED
+  if (ctx->use_hw)
+    {
+      const unsigned char *p = data;
+      apr_size_t used = (apr_size_t)(ctx->length % 64);
+
+      ctx->length += len;
+
+      /* Complete a partial block from a previous call first. */
+      if (used)
+        {
+          apr_size_t to_copy = 64 - used < len ? 64 - used : len;
+          memcpy(ctx->buffer + used, p, to_copy);
+          p += to_copy;
+          len -= to_copy;
+
+          if (used + to_copy < 64)
+            return;
+
+          sha1_hw_blocks(ctx->state, ctx->buffer, 1);
+        }
+
+      /* Process all complete blocks directly from DATA. */
+      sha1_hw_blocks(ctx->state, p, len / 64);
+      p += len - len % 64;
+      len %= 64;
+
+      memcpy(ctx->buffer, p, len);
+      return;
+    }
+#endif
+
+  /* APR's interface is limited to 4GB per call. */
+  while (len > APR_UINT32_MAX)
+    {
+      apr_sha1_update(&ctx->apr_ctx, data, APR_UINT32_MAX);
+      data = (const char *)data + APR_UINT32_MAX;
+      len -= APR_UINT32_MAX;
+    }
+
+  apr_sha1_update(&ctx->apr_ctx, data, (unsigned int)len);
+}
+
+void
+svn_sha1__final(unsigned char digest[],
+                svn_sha1__ctx_t *ctx)
+{
+#if SVN_SHA1__HW_ENABLED
+  if (ctx->use_hw)
+    {
+      apr_uint64_t bits = ctx->length * 8;
+      apr_size_t used = (apr_size_t)(ctx->length % 64);
+      int i;
+
+      /* Append the 0x80 terminator, zero-pad up to the length field
+         and store the number of bits big-endian in the last 8 bytes. */
+      ctx->buffer[used++] = 0x80;
+      if (used > 56)
+        {
+          memset(ctx->buffer + used, 0, 64 - used);
+          sha1_hw_blocks(ctx->state, ctx->buffer, 1);
+          used = 0;
+        }
+
+      memset(ctx->buffer + used, 0, 56 - used);
+      for (i = 0; i < 8; ++i)
+        ctx->buffer[63 - i] = (unsigned char)(bits >> (8 * i));
+
+      sha1_hw_blocks(ctx->state, ctx->buffer, 1);
+
+      for (i = 0; i < 5; ++i)
+        {
+          digest[4 * i]     = (unsigned char)(ctx->state[i] >> 24);
+          digest[4 * i + 1] = (unsigned char)(ctx->state[i] >> 16);
+          digest[4 * i + 2] = (unsigned char)(ctx->state[i] >> 8);
+          digest[4 * i + 3] = (unsigned char)(ctx->state[i]);
+        }
+
+      return;
+    }
+#endif
+
+  apr_sha1_final(digest, &ctx->apr_ctx);
+}
@@ -25,6 +25,7 @@
 #define SVN_LIBSVN_SUBR_SHA1_H
 
 #include <apr_pools.h>
+#include <apr_sha1.h>
 #include "svn_types.h"
 
 #ifdef __cplusplus
@@ -63,6 +64,44 @@ svn_boolean_t
 svn_sha1__digests_match(const unsigned char d1[],
                         const unsigned char d2[]);
 
+
+/* Incremental SHA1 calculation.  Uses the CPU's SHA instructions where
+ * available and falls back to APR's implementation otherwise.  The
+ * members are private to sha1.c.
+ */
+typedef struct svn_sha1__ctx_t
+{
+  /* If TRUE, the state below is being used instead of APR_CTX. */
+  svn_boolean_t use_hw;
+
+  /* Hash state, total number of bytes processed so far and the
+     incomplete block not processed, yet. */
+  apr_uint32_t state[5];
+  apr_uint64_t length;
+  unsigned char buffer[64];
+
+  /* Used if USE_HW is FALSE. */
+  apr_sha1_ctx_t apr_ctx;
+} svn_sha1__ctx_t;
+
+/* Initialize CTX for a new SHA1 calculation. */
+void
+svn_sha1__init(svn_sha1__ctx_t *ctx);
+
+/* Add the LEN bytes at DATA to the SHA1 calculation in CTX. */
+void
+svn_sha1__update(svn_sha1__ctx_t *ctx,
+                 const void *data,
+                 apr_size_t len);
+
+/* Finish the SHA1 calculation in CTX and write the result to DIGEST,
+ * which must be APR_SHA1_DIGESTSIZE bytes long.  CTX must be initialized
+ * again before it can be reused.
+ */
+void
+svn_sha1__final(unsigned char digest[],
+                svn_sha1__ctx_t *ctx);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
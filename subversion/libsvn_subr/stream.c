@@ -1179,6 +1179,12 @@ struct checksum_stream_baton
   svn_checksum_ctx_t *read_ctx, *write_ctx;
   svn_checksum_t **read_checksum;  /* Output value. */
   svn_checksum_t **write_checksum;  /* Output value. */
+
+  /* Second checksum calculated over the same data.  NULL if unused. */
+  svn_checksum_ctx_t *read_ctx2, *write_ctx2;
+  svn_checksum_t **read_checksum2;  /* Output value. */
+  svn_checksum_t **write_checksum2;  /* Output value. */
+
   svn_stream_t *proxy;
 
   /* True if more data should be read when closing the stream. */
@@ -1188,6 +1194,25 @@ struct checksum_stream_baton
   apr_pool_t *pool;
 };
 
+/* Update the checksum contexts CTX and CTX2 with the LEN bytes at DATA.
+   Either context may be NULL. */
+static svn_error_t *
+update_checksums(svn_checksum_ctx_t *ctx,
+                 svn_checksum_ctx_t *ctx2,
+                 const char *data,
+                 apr_size_t len)
+{
+  if (ctx && ctx2)
+    return svn_error_trace(svn_checksum__update2(ctx, ctx2, data, len));
+
+  if (ctx)
+    SVN_ERR(svn_checksum_update(ctx, data, len));
+  if (ctx2)
+    SVN_ERR(svn_checksum_update(ctx2, data, len));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 read_handler_checksum(void *baton, char *buffer, apr_size_t *len)
 {
@@ -1196,8 +1221,7 @@ read_handler_checksum(void *baton, char *buffer, apr_size_t *len)
 
   SVN_ERR(svn_stream_read(btn->proxy, buffer, len));
 
-  if (btn->read_checksum)
-    SVN_ERR(svn_checksum_update(btn->read_ctx, buffer, *len));
+  SVN_ERR(update_checksums(btn->read_ctx, btn->read_ctx2, buffer, *len));
 
   if (saved_len != *len)
     btn->read_more = FALSE;
@@ -1211,8 +1235,8 @@ write_handler_checksum(void *baton, const char *buffer, apr_size_t *len)
 {
   struct checksum_stream_baton *btn = baton;
 
-  if (btn->write_checksum && *len > 0)
-    SVN_ERR(svn_checksum_update(btn->write_ctx, buffer, *len));
+  if (*len > 0)
+    SVN_ERR(update_checksums(btn->write_ctx, btn->write_ctx2, buffer, *len));
 
   return svn_error_trace(svn_stream_write(btn->proxy, buffer, len));
 }
@@ -1243,6 +1267,14 @@ close_handler_checksum(void *baton)
   if (btn->write_ctx)
     SVN_ERR(svn_checksum_final(btn->write_checksum, btn->write_ctx, btn->pool));
 
+  if (btn->read_ctx2)
+    SVN_ERR(svn_checksum_final(btn->read_checksum2, btn->read_ctx2,
+                               btn->pool));
+
+  if (btn->write_ctx2)
+    SVN_ERR(svn_checksum_final(btn->write_checksum2, btn->write_ctx2,
+                               btn->pool));
+
   return svn_error_trace(svn_stream_close(btn->proxy));
 }
 
@@ -1274,6 +1306,51 @@ svn_stream_checksummed2(svn_stream_t *stream,
 
   baton->read_checksum = read_checksum;
   baton->write_checksum = write_checksum;
+  baton->read_ctx2 = NULL;
+  baton->write_ctx2 = NULL;
+  baton->read_checksum2 = NULL;
+  baton->write_checksum2 = NULL;
+  baton->proxy = stream;
+  baton->read_more = read_all;
+  baton->pool = pool;
+
+  s = svn_stream_create(baton, pool);
+  svn_stream_set_read(s, read_handler_checksum);
+  svn_stream_set_write(s, write_handler_checksum);
+  svn_stream_set_close(s, close_handler_checksum);
+  return s;
+}
+
+svn_stream_t *
+svn_stream__checksummed_md5_sha1(svn_stream_t *stream,
+                                 svn_checksum_t **read_md5_checksum,
+                                 svn_checksum_t **read_sha1_checksum,
+                                 svn_checksum_t **write_md5_checksum,
+                                 svn_checksum_t **write_sha1_checksum,
+                                 svn_boolean_t read_all,
+                                 apr_pool_t *pool)
+{
+  svn_stream_t *s;
+  struct checksum_stream_baton *baton;
+
+  if (   read_md5_checksum == NULL && read_sha1_checksum == NULL
+      && write_md5_checksum == NULL && write_sha1_checksum == NULL)
+    return stream;
+
+  baton = apr_pcalloc(pool, sizeof(*baton));
+  if (read_md5_checksum)
+    baton->read_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  if (read_sha1_checksum)
+    baton->read_ctx2 = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  if (write_md5_checksum)
+    baton->write_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  if (write_sha1_checksum)
+    baton->write_ctx2 = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+
+  baton->read_checksum = read_md5_checksum;
+  baton->read_checksum2 = read_sha1_checksum;
+  baton->write_checksum = write_md5_checksum;
+  baton->write_checksum2 = write_sha1_checksum;
   baton->proxy = stream;
   baton->read_more = read_all;
   baton->pool = pool;
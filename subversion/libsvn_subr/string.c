@@ -34,6 +34,10 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_string_private.h"
 
+#if SVN__SSE2_ENABLED
+#include <emmintrin.h>
+#endif
+
 #include "svn_private_config.h"
 
 
@@ -1418,6 +1422,20 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#if SVN__SSE2_ENABLED
+
+  /* Compare 16 bytes at a time.  The remainder and the position of the
+   * first mismatch within that chunk are handled by the loops below. */
+  for (; pos + sizeof(__m128i) <= max_len; pos += sizeof(__m128i))
+    {
+      __m128i chunk_a = _mm_loadu_si128((const __m128i *)(a + pos));
+      __m128i chunk_b = _mm_loadu_si128((const __m128i *)(b + pos));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) != 0xffff)
+        break;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1446,6 +1464,21 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#if SVN__SSE2_ENABLED
+
+  /* Compare 16 bytes at a time, see svn_cstring__match_length. */
+  for (; pos + sizeof(__m128i) <= max_len; pos += sizeof(__m128i))
+    {
+      __m128i chunk_a
+        = _mm_loadu_si128((const __m128i *)(a - pos - sizeof(__m128i)));
+      __m128i chunk_b
+        = _mm_loadu_si128((const __m128i *)(b - pos - sizeof(__m128i)));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) != 0xffff)
+        break;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1454,7 +1487,7 @@ svn_cstring__reverse_match_length(const char *a,
    * because A and B will probably have different alignment. So, skipping
    * the first few chars until alignment is reached is not an option.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
+  for (pos += sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
     if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
       break;
 
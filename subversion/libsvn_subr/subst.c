@@ -50,6 +50,11 @@
 
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
+#include "private/svn_dep_compat.h"
+
+#if SVN__SSE2_ENABLED
+#include <emmintrin.h>
+#endif
 
 /**
  * The textual elements of a detranslated special file.  One of these
@@ -1124,6 +1129,33 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
+#if SVN__SSE2_ENABLED
+                  /* Skip 16 bytes at a time as long as they contain
+                     neither a '$' nor, if we translate EOLs, any of
+                     '\r' and '\n'.  Without EOL translation, simply
+                     search for '$' three times. */
+                  const __m128i dollar_mask = _mm_set1_epi8('$');
+                  const __m128i r_mask = _mm_set1_epi8(b->eol_str ? '\r'
+                                                                  : '$');
+                  const __m128i n_mask = _mm_set1_epi8(b->eol_str ? '\n'
+                                                                  : '$');
+
+                  while ((p + len + sizeof(__m128i)) <= end)
+                    {
+                      __m128i chunk
+                        = _mm_loadu_si128((const __m128i *)(p + len));
+                      __m128i found
+                        = _mm_or_si128(_mm_cmpeq_epi8(chunk, dollar_mask),
+                                       _mm_or_si128(
+                                         _mm_cmpeq_epi8(chunk, r_mask),
+                                         _mm_cmpeq_epi8(chunk, n_mask)));
+                      if (_mm_movemask_epi8(found))
+                        break;
+
+                      len += sizeof(__m128i);
+                    }
+#endif
+
                   /* Check 4 bytes at once to allow for efficient pipelining
                     and to reduce loop condition overhead. */
                   while ((p + len + 4) <= end)
@@ -60,6 +60,10 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+#if SVN__SSE2_ENABLED
+#include <emmintrin.h>
+#endif
+
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x00-0x7f */
@@ -258,6 +262,19 @@ static const char machine [9][14] = {
 static const char *
 first_non_fsm_start_char(const char *data, apr_size_t max_len)
 {
+#if SVN__SSE2_ENABLED
+
+  /* Test 16 bytes at a time.  The movemask collects the top bit of each
+   * byte, i.e. it is non-zero for chunks that contain non-ASCII chars.
+   * The exact position of the first one is determined by the loops below.
+   */
+  for (; max_len >= sizeof(__m128i)
+       ; data += sizeof(__m128i), max_len -= sizeof(__m128i))
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)data)))
+      break;
+
+#endif
+
 #if !SVN_UNALIGNED_ACCESS_IS_OK
 
   /* On some systems, we need to make sure that buf is properly aligned
@@ -298,12 +315,18 @@ first_non_fsm_start_char(const char *data, apr_size_t max_len)
 static const char *
 first_non_fsm_start_char_cstring(const char *data)
 {
+#if SVN__SSE2_ENABLED
+  const apr_uintptr_t alignment = sizeof(__m128i);
+#else
+  const apr_uintptr_t alignment = sizeof(apr_uintptr_t);
+#endif
+
   /* We need to make sure that BUF is properly aligned for chunky data
    * access because we don't know the string's length. Unaligned chunk
    * read access beyond the NUL terminator could therefore result in a
    * segfault.
    */
-  for (; (apr_uintptr_t)data & (sizeof(apr_uintptr_t)-1); ++data)
+  for (; (apr_uintptr_t)data & (alignment-1); ++data)
     if (*data == 0 || (unsigned char)*data >= 0x80)
       return data;
 
@@ -315,6 +338,21 @@ first_non_fsm_start_char_cstring(const char *data)
      to be.  However memory checking tools such as valgrind and GCC
      4.8's address santitizer will object so this bit of code can be
      disabled at compile time. */
+#if SVN__SSE2_ENABLED
+  {
+    /* Aligned 16 byte chunks never cross a page boundary.  Setting the
+       top bit for all NULs makes the movemask catch both. */
+    const __m128i zero = _mm_setzero_si128();
+    for (; ; data += sizeof(__m128i))
+      {
+        __m128i chunk = _mm_load_si128((const __m128i *)data);
+        if (_mm_movemask_epi8(_mm_or_si128(chunk,
+                                           _mm_cmpeq_epi8(chunk, zero))))
+          break;
+      }
+  }
+#endif
+
   for (; ; data += sizeof(apr_uintptr_t))
     {
       /* Check for non-ASCII chars: */
@@ -351,7 +389,13 @@ svn_utf__last_valid(const char *data, apr_size_t len)
       int category = octet_category[octet];
       state = machine[state][category];
       if (state == FSM_START)
-        start = data;
+        {
+          /* Skip any ASCII following the multi-byte char. */
+          data = first_non_fsm_start_char(data, end - data);
+          start = data;
+        }
+      else if (state == FSM_ERROR)
+        break;
     }
   return start;
 }
@@ -371,6 +415,10 @@ svn_utf__cstring_is_valid(const char *data)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+      if (state == FSM_START)
+        data = first_non_fsm_start_char_cstring(data);
+      else if (state == FSM_ERROR)
+        return FALSE;
     }
   return state == FSM_START;
 }
@@ -391,6 +439,10 @@ svn_utf__is_valid(const char *data, apr_size_t len)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+      if (state == FSM_START)
+        data = first_non_fsm_start_char(data, end - data);
+      else if (state == FSM_ERROR)
+        return FALSE;
     }
   return state == FSM_START;
 }
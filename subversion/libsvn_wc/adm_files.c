@@ -45,6 +45,7 @@
 #include "entries.h"
 #include "lock.h"
 
+#include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
 
 
@@ -315,12 +316,9 @@ svn_wc__open_writable_base(svn_stream_t **stream,
                                  temp_dir_abspath,
                                  svn_io_file_del_none,
                                  result_pool, scratch_pool));
-  if (md5_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
-                                      svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
-                                      svn_checksum_sha1, FALSE, result_pool);
+  *stream = svn_stream__checksummed_md5_sha1(*stream, NULL, NULL,
+                                             md5_checksum, sha1_checksum,
+                                             FALSE, result_pool);
 
   return SVN_NO_ERROR;
 }
@@ -41,6 +41,7 @@
 
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
 #include "private/svn_token.h"
 
 /* WC-1.0 administrative area extensions */
@@ -1045,13 +1046,11 @@ migrate_text_bases(apr_hash_t **text_bases_info,
         SVN_ERR(svn_stream_open_readonly(&read_stream, text_base_path,
                                            iterpool, iterpool));
 
-        read_stream = svn_stream_checksummed2(read_stream, &md5_checksum,
-                                              NULL, svn_checksum_md5,
-                                              TRUE, iterpool);
-
-        read_stream = svn_stream_checksummed2(read_stream, &sha1_checksum,
-                                              NULL, svn_checksum_sha1,
-                                              TRUE, iterpool);
+        read_stream = svn_stream__checksummed_md5_sha1(read_stream,
+                                                       &md5_checksum,
+                                                       &sha1_checksum,
+                                                       NULL, NULL,
+                                                       TRUE, iterpool);
 
         /* This calculates the hash, creates a copy and closes the stream */
         SVN_ERR(svn_stream_copy3(read_stream, result_stream,
@@ -47,6 +47,7 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 
 #ifdef APLOG_USE_MODULE
@@ -808,6 +809,77 @@ subreq_bypass(request_rec *r,
   return status;
 }
 
+/*
+ * This function is used as a provider to allow mod_dav_svn to check the
+ * read access to many paths at once, e.g. all changed paths of a revision.
+ */
+static int
+subreq_bypass_many(request_rec *r,
+                   const apr_array_header_t *repos_paths,
+                   const char *repos_name,
+                   svn_boolean_t *allowed)
+{
+  svn_error_t *svn_err;
+  svn_authz_t *access_conf;
+  authz_svn_config_rec *conf;
+  const char *username_to_authorize;
+  apr_pool_t *scratch_pool;
+  int status = OK;
+  int i;
+
+  memset(allowed, 0, repos_paths->nelts * sizeof(*allowed));
+  if (repos_paths->nelts == 0)
+    return OK;
+
+  scratch_pool = svn_pool_create(r->pool);
+  conf = ap_get_module_config(r->per_dir_config,
+                              &authz_svn_module);
+  username_to_authorize = get_username_to_authorize(r, conf, scratch_pool);
+
+  /* If configured properly, this should never be true, but just in case. */
+  if (!conf->anonymous
+      || (! (conf->access_file || conf->repo_relative_access_file)))
+    {
+      log_access_verdict(APLOG_MARK, r, 0,
+                         APR_ARRAY_IDX(repos_paths, 0, const char *), NULL);
+      status = HTTP_FORBIDDEN;
+    }
+
+  /* Retrieve authorization file */
+  if (status == OK)
+    {
+      access_conf = get_access_conf(r, conf, scratch_pool);
+      if (access_conf == NULL)
+        status = HTTP_FORBIDDEN;
+    }
+
+  if (status == OK)
+    {
+      svn_err = svn_repos__authz_check_access_many(access_conf, repos_name,
+                                                   repos_paths,
+                                                   username_to_authorize,
+                                                   svn_authz_read, allowed,
+                                                   scratch_pool);
+      if (svn_err)
+        {
+          log_svn_error(APLOG_MARK, r,
+                        "Failed to perform access control:",
+                        svn_err, scratch_pool);
+          memset(allowed, 0, repos_paths->nelts * sizeof(*allowed));
+          status = HTTP_FORBIDDEN;
+        }
+    }
+
+  if (status == OK)
+    for (i = 0; i < repos_paths->nelts; ++i)
+      log_access_verdict(APLOG_MARK, r, allowed[i],
+                         APR_ARRAY_IDX(repos_paths, i, const char *), NULL);
+
+  svn_pool_destroy(scratch_pool);
+
+  return status;
+}
+
 /*
  * Hooks
  */
@@ -959,6 +1031,11 @@ register_hooks(apr_pool_t *p)
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER,
                        (void*)subreq_bypass);
+  ap_register_provider(p,
+                       AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
+                       AUTHZ_SVN__SUBREQ_BYPASS_MANY_PROV_NAME,
+                       AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER,
+                       (void*)subreq_bypass_many);
 }
 
 module AP_MODULE_DECLARE_DATA authz_svn_module =
@@ -29,6 +29,7 @@
 #include "svn_path.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 #include "mod_authz_svn.h"
 #include "dav_svn.h"
@@ -234,6 +235,68 @@ dav_svn__authz_read_func(dav_svn__authz_read_baton *baton)
 }
 
 
+/* This function implements 'svn_repos__authz_read_many_func_t'.
+
+   Like authz_read() but for all PATHS at once.  If ROOT is a revision
+   root, ask mod_authz_svn directly for all PATHS.  Otherwise, fall back
+   to authz_read() for every path.  Set the elements of ALLOWED
+   accordingly.
+
+   BATON must be a pointer to a dav_svn__authz_read_baton.
+   Use POOL for for any temporary allocation.
+*/
+static svn_error_t *
+authz_read_many(svn_boolean_t *allowed,
+                svn_fs_root_t *root,
+                const apr_array_header_t *paths,
+                void *baton,
+                apr_pool_t *pool)
+{
+  dav_svn__authz_read_baton *arb = baton;
+  authz_svn__subreq_bypass_many_func_t allow_read_bypass_many;
+  apr_pool_t *iterpool;
+  int i;
+
+  allow_read_bypass_many = dav_svn__get_pathauthz_bypass_many(arb->r);
+  if (allow_read_bypass_many && !svn_fs_is_txn_root(root))
+    {
+      /* The result is already in ALLOWED.  As in dav_svn__allow_read(),
+         failures deny access. */
+      allow_read_bypass_many(arb->r, paths, arb->repos->repo_basename,
+                             allowed);
+      return SVN_NO_ERROR;
+    }
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(authz_read(&allowed[i], root,
+                         APR_ARRAY_IDX(paths, i, const char *),
+                         baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+void
+dav_svn__authz_read_many_func(svn_repos_authz_func_t *authz_read_func,
+                              void **authz_read_baton,
+                              dav_svn__authz_read_baton *baton,
+                              apr_pool_t *pool)
+{
+  *authz_read_func = dav_svn__authz_read_func(baton);
+  *authz_read_baton = baton;
+
+  if (*authz_read_func)
+    svn_repos__authz_read_many_wrap(authz_read_func, authz_read_baton,
+                                    authz_read, authz_read_many, baton,
+                                    pool);
+}
+
+
 svn_boolean_t
 dav_svn__allow_read_resource(const dav_resource *resource,
                              svn_revnum_t rev,
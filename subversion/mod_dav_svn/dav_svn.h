@@ -331,6 +331,13 @@ svn_boolean_t dav_svn__get_revprop_cache_flag(request_rec *r);
  */
 authz_svn__subreq_bypass_func_t dav_svn__get_pathauthz_bypass(request_rec *r);
 
+/* for the repository referred to by this request, are subrequests bypassed
+ * and can many paths be checked at once?
+ * A function pointer if yes, NULL if not.
+ */
+authz_svn__subreq_bypass_many_func_t
+dav_svn__get_pathauthz_bypass_many(request_rec *r);
+
 /* for the repository referred to by this request, is a GET of
    SVNParentPath allowed? */
 svn_boolean_t dav_svn__get_list_parentpath_flag(request_rec *r);
@@ -775,6 +782,17 @@ dav_svn__allow_list_repos(request_rec *r,
 svn_repos_authz_func_t
 dav_svn__authz_read_func(dav_svn__authz_read_baton *baton);
 
+/* Like dav_svn__authz_read_func() but return the read authorization
+   function in *AUTHZ_READ_FUNC and its baton in *AUTHZ_READ_BATON.
+   If mod_authz_svn is being bypassed, the function will check many
+   paths at once where libsvn_repos needs that, e.g. for the changed
+   paths in a log.  Allocate the baton in POOL. */
+void
+dav_svn__authz_read_many_func(svn_repos_authz_func_t *authz_read_func,
+                              void **authz_read_baton,
+                              dav_svn__authz_read_baton *baton,
+                              apr_pool_t *pool);
+
 
 /*** util.c ***/
 
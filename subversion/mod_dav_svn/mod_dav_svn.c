@@ -44,6 +44,7 @@
 
 #include "private/svn_fspath.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_cache.h"
 
 #include "dav_svn.h"
 #include "mod_authz_svn.h"
@@ -118,6 +119,9 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* The authz_svn provider for bypassing path authz for many paths at once. */
+static authz_svn__subreq_bypass_many_func_t pathauthz_bypass_many_func = NULL;
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -139,9 +143,29 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* A cache shared between worker processes must exist before httpd
+   * forks them. */
+  if (svn_cache__get_global_membuffer_shared())
+    svn_cache__get_global_membuffer_cache();
+
   return OK;
 }
 
+/* Implements the #child_init hook.  Attach the new worker process to the
+ * shared in-memory cache, if any. */
+static void
+init_child(apr_pool_t *p, server_rec *s)
+{
+  svn_error_t *serr = svn_cache__global_membuffer_child_init(p);
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_ERR, serr->apr_err, s,
+                   "mod_dav_svn: error attaching to the shared cache: '%s'",
+                   serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+}
+
 static int
 init_dso(apr_pool_t *pconf, apr_pool_t *plog, apr_pool_t *ptemp)
 {
@@ -417,6 +441,13 @@ SVNPathAuthz_cmd(cmd_parms *cmd, void *config, const char *arg1)
                                AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                                AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER);
         }
+      if (pathauthz_bypass_many_func == NULL)
+        {
+          pathauthz_bypass_many_func =
+            ap_lookup_provider(AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
+                               AUTHZ_SVN__SUBREQ_BYPASS_MANY_PROV_NAME,
+                               AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER);
+        }
     }
   else if (apr_strnatcasecmp("on", arg1) == 0)
     {
@@ -563,6 +594,14 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheShared_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__set_global_membuffer_shared(arg);
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -880,6 +919,20 @@ dav_svn__get_pathauthz_bypass(request_rec *r)
   return NULL;
 }
 
+/* Function pointer if we should use the batched bypass directly to
+ * mod_authz_svn.  NULL otherwise. */
+authz_svn__subreq_bypass_many_func_t
+dav_svn__get_pathauthz_bypass_many(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  if (conf->path_authz_method == CONF_PATHAUTHZ_BYPASS)
+    return pathauthz_bypass_many_func;
+  return NULL;
+}
+
 
 svn_boolean_t
 dav_svn__get_list_parentpath_flag(request_rec *r)
@@ -1278,6 +1331,12 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 deactivates "
                 "the cache)."),
   /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheShared", SVNInMemoryCacheShared_cmd, NULL,
+               RSRC_CONF,
+               "places Subversion's in-memory object cache in shared memory "
+               "such that all worker processes use a single cache of the "
+               "size given by SVNInMemoryCacheSize (default is Off)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
@@ -1318,6 +1377,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(init_child, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
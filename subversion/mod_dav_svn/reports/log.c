@@ -303,6 +303,8 @@ dav_svn__log_report(const dav_resource *resource,
   apr_xml_elem *child;
   struct log_receiver_baton lrb;
   dav_svn__authz_read_baton arb;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
   const dav_svn_repos *repos = resource->info->repos;
   const char *target = NULL;
   int limit = 0;
@@ -444,6 +446,8 @@ dav_svn__log_report(const dav_resource *resource,
   /* Build authz read baton */
   arb.r = resource->info->r;
   arb.repos = resource->info->repos;
+  dav_svn__authz_read_many_func(&authz_read_func, &authz_read_baton, &arb,
+                                resource->pool);
 
   /* Build log receiver baton */
   lrb.bb = apr_brigade_create(resource->pool,  /* not the subpool! */
@@ -469,8 +473,8 @@ dav_svn__log_report(const dav_resource *resource,
                              include_merged_revisions,
                              move_behavior,
                              revprops,
-                             dav_svn__authz_read_func(&arb),
-                             &arb,
+                             authz_read_func,
+                             authz_read_baton,
                              log_receiver,
                              &lrb,
                              resource->pool);
@@ -991,11 +991,15 @@ dav_svn__update_report(const dav_resource *resource,
   svn_boolean_t ignore_ancestry = FALSE;
   svn_boolean_t send_copyfrom_args = FALSE;
   dav_svn__authz_read_baton arb;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
   apr_pool_t *subpool = svn_pool_create(resource->pool);
 
   /* Construct the authz read check baton. */
   arb.r = resource->info->r;
   arb.repos = repos;
+  dav_svn__authz_read_many_func(&authz_read_func, &authz_read_baton, &arb,
+                                resource->pool);
 
   if ((resource->info->restype != DAV_SVN_RESTYPE_VCC)
       && (resource->info->restype != DAV_SVN_RESTYPE_ME))
@@ -1288,8 +1292,7 @@ dav_svn__update_report(const dav_resource *resource,
                                       ignore_ancestry,
                                       send_copyfrom_args,
                                       editor, &uc,
-                                      dav_svn__authz_read_func(&arb),
-                                      &arb,
+                                      authz_read_func, authz_read_baton,
                                       0,  /* disable zero-copy for now */
                                       resource->pool)))
     {
@@ -1695,7 +1695,12 @@ negotiate_encoding_prefs(request_rec *r, int *svndiff_version)
     {
       struct accept_rec rec = APR_ARRAY_IDX(encoding_prefs, i,
                                             struct accept_rec);
-      if (strcmp(rec.name, "svndiff1") == 0)
+      if (strcmp(rec.name, "svndiff2") == 0)
+        {
+          *svndiff_version = 2;
+          break;
+        }
+      else if (strcmp(rec.name, "svndiff1") == 0)
         {
           *svndiff_version = 1;
           break;
@@ -3090,6 +3095,49 @@ close_filter(void *baton)
 }
 
 
+/* Pass the LENGTH bytes starting at OFFSET in FILE to the OUTPUT filter,
+   followed by an EOS bucket.  FILE must remain open for as long as POOL
+   exists. */
+static dav_error *
+deliver_file_buckets(ap_filter_t *output,
+                     apr_file_t *file,
+                     apr_off_t offset,
+                     svn_filesize_t length,
+                     apr_pool_t *pool)
+{
+  apr_bucket_brigade *bb;
+  apr_bucket *bkt;
+  apr_status_t status;
+
+  bb = apr_brigade_create(pool, output->c->bucket_alloc);
+
+  /* Split large files into multiple buckets, just like httpd's default
+     handler does. */
+  while (length > 0)
+    {
+      apr_size_t chunk = length > AP_MAX_SENDFILE
+                       ? AP_MAX_SENDFILE
+                       : (apr_size_t)length;
+
+      bkt = apr_bucket_file_create(file, offset, chunk, pool,
+                                   output->c->bucket_alloc);
+      APR_BRIGADE_INSERT_TAIL(bb, bkt);
+
+      offset += chunk;
+      length -= chunk;
+    }
+
+  bkt = apr_bucket_eos_create(output->c->bucket_alloc);
+  APR_BRIGADE_INSERT_TAIL(bb, bkt);
+  if ((status = ap_pass_brigade(output, bb)) != APR_SUCCESS)
+    /* ### what to do with status; and that HTTP code... */
+    return dav_svn__new_error(pool, HTTP_INTERNAL_SERVER_ERROR, 0,
+                              "Could not write data to filter.");
+
+  return NULL;
+}
+
+
 static dav_error *
 deliver(const dav_resource *resource, ap_filter_t *output)
 {
@@ -3548,6 +3596,30 @@ deliver(const dav_resource *resource, ap_filter_t *output)
       svn_stream_t *stream;
       char *block;
 
+      /* Without keywords substitution, uncompressed fulltexts can be
+         handed to the output filters as file buckets, allowing httpd to
+         use sendfile(). */
+      if (! resource->info->keyword_subst)
+        {
+          apr_file_t *file;
+          apr_off_t offset;
+          svn_filesize_t length;
+
+          serr = svn_fs_file_fulltext_location(&file, &offset, &length,
+                                               resource->info->root.root,
+                                               resource->info->repos_path,
+                                               resource->pool,
+                                               resource->pool);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not locate the file contents",
+                                        resource->pool);
+
+          if (file)
+            return deliver_file_buckets(output, file, offset, length,
+                                        resource->pool);
+        }
+
       serr = svn_fs_file_contents(&stream,
                                   resource->info->root.root,
                                   resource->info->repos_path,
@@ -207,7 +207,11 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                             "
                        "  --ignore-eol-style: Ignore changes in EOL style\n"
                        "                             "
-                       "  -p, --show-c-function: Show C function name")},
+                       "  -p, --show-c-function: Show C function name\n"
+                       "                             "
+                       "  --histogram: Use a faster diff algorithm for\n"
+                       "                             "
+                       "    large files with many changes")},
   {"targets",       opt_targets, 1,
                     N_("pass contents of file ARG as additional args")},
   {"depth",         opt_depth, 1,
@@ -185,7 +185,11 @@ static const apr_getopt_option_t options_table[] =
       "                             "
       "  --ignore-eol-style: Ignore changes in EOL style\n"
       "                             "
-      "  -p, --show-c-function: Show C function name")},
+      "  -p, --show-c-function: Show C function name\n"
+      "                             "
+      "  --histogram: Use a faster diff algorithm for\n"
+      "                             "
+      "    large files with many changes")},
 
   {"quiet",             'q', 0,
    N_("no progress (only errors) to stderr")},
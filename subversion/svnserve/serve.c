@@ -55,6 +55,7 @@
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_atomic.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -63,6 +64,11 @@
 #include "server.h"
 #include "logger.h"
 
+/* Maximum size of the strings that get-file uses to send file contents
+   directly from the repository.  The client holds a whole string in
+   memory, so keep it moderate. */
+#define FULLTEXT_CHUNK_SIZE 0x100000
+
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
   svn_revnum_t *new_rev;
@@ -415,6 +421,31 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
     }
 }
 
+/* Return the name of the user described in B as used for authz
+   purposes, i.e. after applying any username case normalization that
+   might be requested.  Return NULL for anonymous access. */
+static const char *get_authz_user(server_baton_t *b)
+{
+  repository_t *repository = b->repository;
+  client_info_t *client_info = b->client_info;
+
+  /* If we have a username, and we've not yet used it + any username
+     case normalization that might be requested to determine "the
+     username we used for authz purposes", do so now. */
+  if (client_info->user && (! client_info->authz_user))
+    {
+      char *authz_user = apr_pstrdup(b->pool, client_info->user);
+      if (repository->username_case == CASE_FORCE_UPPER)
+        convert_case(authz_user, TRUE);
+      else if (repository->username_case == CASE_FORCE_LOWER)
+        convert_case(authz_user, FALSE);
+
+      client_info->authz_user = authz_user;
+    }
+
+  return client_info->authz_user;
+}
+
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
@@ -426,7 +457,6 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
                                        apr_pool_t *pool)
 {
   repository_t *repository = b->repository;
-  client_info_t *client_info = b->client_info;
 
   /* If authz cannot be performed, grant access.  This is NOT the same
      as the default policy when authz is performed on a path with no
@@ -447,23 +477,9 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   if (path)
     path = svn_fspath__canonicalize(path, pool);
 
-  /* If we have a username, and we've not yet used it + any username
-     case normalization that might be requested to determine "the
-     username we used for authz purposes", do so now. */
-  if (client_info->user && (! client_info->authz_user))
-    {
-      char *authz_user = apr_pstrdup(b->pool, client_info->user);
-      if (repository->username_case == CASE_FORCE_UPPER)
-        convert_case(authz_user, TRUE);
-      else if (repository->username_case == CASE_FORCE_LOWER)
-        convert_case(authz_user, FALSE);
-
-      client_info->authz_user = authz_user;
-    }
-
   SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
                                        repository->authz_repos_name,
-                                       path, client_info->authz_user,
+                                       path, get_authz_user(b),
                                        required, allowed, pool));
   if (!*allowed)
     SVN_ERR(log_authz_denied(path, required, b, pool));
@@ -487,6 +503,34 @@ static svn_error_t *authz_check_access_cb(svn_boolean_t *allowed,
                             sb->server, pool);
 }
 
+/* Set ALLOWED[i] to TRUE if the i-th path in PATHS is readable by the
+ * user described in BATON.  Use POOL for temporary allocations only.
+ * ROOT is not used.  Implements the svn_repos__authz_read_many_func_t
+ * interface.
+ */
+static svn_error_t *authz_check_access_many_cb(svn_boolean_t *allowed,
+                                               svn_fs_root_t *root,
+                                               const apr_array_header_t *paths,
+                                               void *baton,
+                                               apr_pool_t *pool)
+{
+  authz_baton_t *sb = baton;
+  server_baton_t *b = sb->server;
+  int i;
+
+  SVN_ERR(svn_repos__authz_check_access_many(b->repository->authzdb,
+                                             b->repository->authz_repos_name,
+                                             paths, get_authz_user(b),
+                                             svn_authz_read, allowed, pool));
+
+  for (i = 0; i < paths->nelts; ++i)
+    if (!allowed[i])
+      SVN_ERR(log_authz_denied(APR_ARRAY_IDX(paths, i, const char *),
+                               svn_authz_read, b, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* If authz is enabled in the specified BATON, return a read authorization
    function. Otherwise, return NULL. */
 static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
@@ -496,6 +540,25 @@ static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
   return NULL;
 }
 
+/* Like authz_check_access_cb_func() but return the read authorization
+   function in *AUTHZ_READ_FUNC and its baton for AB in *AUTHZ_READ_BATON.
+   The function will check many paths at once where libsvn_repos needs
+   that.  Allocate the baton in POOL. */
+static void authz_check_access_many_cb_func(
+  svn_repos_authz_func_t *authz_read_func,
+  void **authz_read_baton,
+  authz_baton_t *ab,
+  apr_pool_t *pool)
+{
+  *authz_read_func = authz_check_access_cb_func(ab->server);
+  *authz_read_baton = ab;
+
+  if (*authz_read_func)
+    svn_repos__authz_read_many_wrap(authz_read_func, authz_read_baton,
+                                    authz_check_access_cb,
+                                    authz_check_access_many_cb, ab, pool);
+}
+
 /* Set *ALLOWED to TRUE if the REQUIRED access to PATH is granted,
  * according to the state in BATON.  Use POOL for temporary
  * allocations only.  ROOT is not used.  Implements the
@@ -764,6 +827,19 @@ static svn_boolean_t lookup_access(apr_pool_t *pool,
   return FALSE;
 }
 
+/* Return TRUE if the client described by B can still obtain the
+ * REQUIRED blanket access by authenticating, i.e. if must_have_access()
+ * may start an authentication exchange in the middle of a command.
+ */
+static svn_boolean_t can_authenticate(server_baton_t *b,
+                                      enum access_type required)
+{
+  return b->client_info->user == NULL
+      && b->repository->auth_access >= required
+      && (b->client_info->tunnel_user || b->repository->pwdb
+          || b->repository->use_sasl);
+}
+
 /* Check that the client has the REQUIRED access by consulting the
  * authentication and authorization states stored in BATON.  If the
  * client does not have the required access credentials, attempt to
@@ -803,10 +879,7 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
      requiring a username because we need one to be able to check
      authz configuration again with a different user credentials than
      the first time round. */
-  if (b->client_info->user == NULL
-      && b->repository->auth_access >= req
-      && (b->client_info->tunnel_user || b->repository->pwdb
-          || b->repository->use_sasl))
+  if (can_authenticate(b, req))
     SVN_ERR(auth_request(conn, pool, b, req, TRUE));
 
   /* Now that an authentication has been done get the new take of
@@ -960,9 +1033,13 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
   report_driver_baton_t rb;
   svn_error_t *err;
   authz_baton_t ab;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
 
   ab.server = b;
   ab.conn = conn;
+  authz_check_access_many_cb_func(&authz_read_func, &authz_read_baton, &ab,
+                                  pool);
 
   /* Make an svn_repos report baton.  Tell it to drive the network editor
    * when the report is complete. */
@@ -973,8 +1050,8 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       tgt_path, text_deltas, depth,
                                       ignore_ancestry, send_copyfrom_args,
                                       editor, edit_baton,
-                                      authz_check_access_cb_func(b),
-                                      &ab, svn_ra_svn_zero_copy_limit(conn),
+                                      authz_read_func, authz_read_baton,
+                                      svn_ra_svn_zero_copy_limit(conn),
                                       pool));
 
   rb.sb = b;
@@ -1509,6 +1586,9 @@ static svn_error_t *get_file(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   svn_revnum_t rev;
   svn_fs_root_t *root;
   svn_stream_t *contents;
+  apr_file_t *fulltext_file = NULL;
+  apr_off_t fulltext_offset;
+  svn_filesize_t fulltext_length;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
   svn_string_t write_str;
@@ -1552,7 +1632,17 @@ static svn_error_t *get_file(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
     SVN_CMD_ERR(get_props(&props, &inherited_props, &ab, root, full_path,
                           pool));
   if (want_contents)
-    SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    {
+      /* Send uncompressed fulltexts directly from the repository file,
+         if possible. */
+      SVN_CMD_ERR(svn_fs_file_fulltext_location(&fulltext_file,
+                                                &fulltext_offset,
+                                                &fulltext_length,
+                                                root, full_path,
+                                                pool, pool));
+      if (!fulltext_file)
+        SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    }
 
   /* Send successful command response with revision and props. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((?c)r(!", "success",
@@ -1582,7 +1672,25 @@ static svn_error_t *get_file(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
 
   /* Now send the file's contents. */
-  if (want_contents)
+  if (want_contents && fulltext_file)
+    {
+      while (fulltext_length > 0)
+        {
+          apr_size_t chunk = fulltext_length < FULLTEXT_CHUNK_SIZE
+                           ? (apr_size_t)fulltext_length
+                           : FULLTEXT_CHUNK_SIZE;
+
+          SVN_ERR(svn_ra_svn__write_file_string(conn, pool, fulltext_file,
+                                                fulltext_offset, chunk));
+          fulltext_offset += chunk;
+          fulltext_length -= chunk;
+        }
+
+      SVN_ERR(svn_io_file_close(fulltext_file, pool));
+      SVN_ERR(svn_ra_svn__write_cstring(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+  else if (want_contents)
     {
       err = SVN_NO_ERROR;
       while (1)
@@ -2189,9 +2297,13 @@ static svn_error_t *log_cmd(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   svn_move_behavior_t move_behavior;
   log_baton_t lb;
   authz_baton_t ab;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
 
   ab.server = b;
   ab.conn = conn;
+  authz_check_access_many_cb_func(&authz_read_func, &authz_read_baton, &ab,
+                                  pool);
 
   SVN_ERR(svn_ra_svn__parse_tuple(params, pool, "l(?r)(?r)bb?n?Bwl?n", &paths,
                                   &start_rev, &end_rev, &send_changed_paths,
@@ -2277,8 +2389,8 @@ static svn_error_t *log_cmd(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                             end_rev, (int) limit, send_changed_paths,
                             strict_node, include_merged_revisions,
                             move_behavior, revprops,
-                            authz_check_access_cb_func(b),
-                            &ab, log_receiver, &lb, pool);
+                            authz_read_func, authz_read_baton,
+                            log_receiver, &lb, pool);
 
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
@@ -2593,15 +2705,13 @@ static svn_error_t *file_rev_handler(void *baton, const char *path,
       svn_stream_set_write(stream, svndiff_handler);
       svn_stream_set_close(stream, svndiff_close_handler);
 
-      /* If the connection does not support SVNDIFF1 or if we don't want to use
-       * compression, use the non-compressing "version 0" implementation */
-      if (   svn_ra_svn_compression_level(frb->conn) > 0
-          && svn_ra_svn_has_capability(frb->conn, SVN_RA_SVN_CAP_SVNDIFF1))
-        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 1,
-                                svn_ra_svn_compression_level(frb->conn), pool);
-      else
-        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 0,
-                                svn_ra_svn_compression_level(frb->conn), pool);
+      /* Use the fastest compressing svndiff version that the client
+       * supports.  If the connection does not support SVNDIFF1 or if we
+       * don't want to use compression, use the non-compressing
+       * "version 0" implementation */
+      svn_txdelta_to_svndiff3(d_handler, d_baton, stream,
+                              svn_ra_svn__svndiff_version(frb->conn),
+                              svn_ra_svn_compression_level(frb->conn), pool);
     }
   else
     SVN_ERR(svn_ra_svn__write_cstring(frb->conn, pool, ""));
@@ -3554,40 +3664,41 @@ get_client_info(svn_ra_svn_conn_t *conn,
   return client_info;
 }
 
-svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
-                   apr_pool_t *pool)
-{
-  svn_error_t *err, *io_err;
-  apr_uint64_t ver;
-  const char *uuid, *client_url, *ra_client_string, *client_string;
-  apr_array_header_t *caplist, *cap_words;
-  server_baton_t b = { 0 };
-  repository_t repository = { 0 };
-  fs_warning_baton_t warn_baton;
-  svn_stringbuf_t *cap_log = svn_stringbuf_create_empty(pool);
+/* The main_commands indexed by their names, for serve_command().
+   Allocated in a global pool. */
+static apr_hash_t *main_command_table = NULL;
+static volatile svn_atomic_t main_command_table_state = 0;
 
-  repository.username_case = params->username_case;
-  repository.base = params->base;
-  repository.pwdb = NULL;
-  repository.authzdb = NULL;
-  repository.realm = NULL;
-  repository.use_sasl = FALSE;
+/* Fill main_command_table.  Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+init_main_command_table(void *baton, apr_pool_t *pool)
+{
+  const svn_ra_svn_cmd_entry_t *command;
+  apr_pool_t *table_pool = svn_pool_create(NULL);
 
-  b.read_only = params->read_only;
-  b.pool = pool;
-  b.vhost = params->vhost;
+  main_command_table = apr_hash_make(table_pool);
+  for (command = main_commands; command->cmdname; command++)
+    svn_hash_sets(main_command_table, command->cmdname, command);
 
-  b.repository = &repository;
-  b.logger = params->logger;
-  b.client_info = get_client_info(conn, params, pool);
+  return SVN_NO_ERROR;
+}
 
+svn_error_t *serve_greeting(svn_ra_svn_conn_t *conn, serve_params_t *params,
+                            apr_pool_t *pool)
+{
   /* Send greeting.  We don't support version 1 any more, so we can
    * send an empty mechlist. */
   if (params->compression_level > 0)
-    SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, "nn()(wwwwwwwwwww)",
+    SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool,
+                                           "nn()(www?wwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
+                                           SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                           params->compress_stream
+                                             ? SVN_RA_SVN_CAP_COMPRESSED_STREAM
+                                             : NULL,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                            SVN_RA_SVN_CAP_COMMIT_REVPROPS,
                                            SVN_RA_SVN_CAP_DEPTH,
@@ -3613,6 +3724,40 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE
                                            ));
 
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *serve_open(server_baton_t **baton, svn_ra_svn_conn_t *conn,
+                        serve_params_t *params, apr_pool_t *pool)
+{
+  svn_error_t *err, *io_err;
+  apr_uint64_t ver;
+  const char *uuid, *client_url, *ra_client_string, *client_string;
+  apr_array_header_t *caplist, *cap_words;
+  server_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  repository_t *repository = apr_pcalloc(pool, sizeof(*repository));
+  fs_warning_baton_t *warn_baton = apr_pcalloc(pool, sizeof(*warn_baton));
+  svn_stringbuf_t *cap_log = svn_stringbuf_create_empty(pool);
+
+  *baton = NULL;
+  SVN_ERR(svn_atomic__init_once(&main_command_table_state,
+                                init_main_command_table, NULL, pool));
+
+  repository->username_case = params->username_case;
+  repository->base = params->base;
+  repository->pwdb = NULL;
+  repository->authzdb = NULL;
+  repository->realm = NULL;
+  repository->use_sasl = FALSE;
+
+  b->read_only = params->read_only;
+  b->pool = pool;
+  b->vhost = params->vhost;
+
+  b->repository = repository;
+  b->logger = params->logger;
+  b->client_info = get_client_info(conn, params, pool);
+
   /* Read client response, which we assume to be in version 2 format:
    * version, capability list, and client URL; then we do an auth
    * request. */
@@ -3662,38 +3807,44 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
   }
 
   err = handle_config_error(find_repos(client_url, params->root,
-                                       b.vhost, b.read_only,
-                                       params->cfg, b.repository,
+                                       b->vhost, b->read_only,
+                                       params->cfg, b->repository,
                                        cap_words, params->config_pool,
                                        params->authz_pool, params->repos_pool,
                                        pool),
-                            &b);
+                            b);
   if (!err)
     {
-      if (repository.anon_access == NO_ACCESS
-          && (repository.auth_access == NO_ACCESS
-              || (!b.client_info->tunnel_user && !repository.pwdb
-                  && !repository.use_sasl)))
+      if (repository->anon_access == NO_ACCESS
+          && (repository->auth_access == NO_ACCESS
+              || (!b->client_info->tunnel_user && !repository->pwdb
+                  && !repository->use_sasl)))
         err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
                                    "No access allowed to this repository",
-                                   &b);
+                                   b);
     }
   if (!err)
     {
-      SVN_ERR(auth_request(conn, pool, &b, READ_ACCESS, FALSE));
-      if (current_access(&b) == NO_ACCESS)
+      SVN_ERR(auth_request(conn, pool, b, READ_ACCESS, FALSE));
+      if (current_access(b) == NO_ACCESS)
         err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
-                                   "Not authorized for access", &b);
+                                   "Not authorized for access", b);
     }
   if (err)
     {
-      log_error(err, &b);
+      log_error(err, b);
       io_err = svn_ra_svn__write_cmd_failure(conn, pool, err);
       svn_error_clear(err);
       SVN_ERR(io_err);
       return svn_ra_svn__flush(conn, pool);
     }
 
+  /* The client switches to compression right after a successful
+     authentication exchange, so must we. */
+  if (params->compression_level > 0 && params->compress_stream
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESSED_STREAM))
+    SVN_ERR(svn_ra_svn__enable_compression(conn, pool));
+
   /* Log the open. */
   if (ra_client_string == NULL || ra_client_string[0] == '\0')
     ra_client_string = "-";
@@ -3703,18 +3854,18 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
     client_string = "-";
   else
     client_string = svn_path_uri_encode(client_string, pool);
-  SVN_ERR(log_command(&b, conn, pool,
+  SVN_ERR(log_command(b, conn, pool,
                       "open %" APR_UINT64_T_FMT " cap=(%s) %s %s %s",
                       ver, cap_log->data,
-                      svn_path_uri_encode(b.repository->fs_path->data, pool),
+                      svn_path_uri_encode(b->repository->fs_path->data, pool),
                       ra_client_string, client_string));
 
-  warn_baton.server = &b;
-  warn_baton.conn = conn;
-  warn_baton.pool = svn_pool_create(pool);
-  svn_fs_set_warning_func(b.repository->fs, fs_warning_func, &warn_baton);
+  warn_baton->server = b;
+  warn_baton->conn = conn;
+  warn_baton->pool = svn_pool_create(pool);
+  svn_fs_set_warning_func(b->repository->fs, fs_warning_func, warn_baton);
 
-  SVN_ERR(svn_fs_get_uuid(b.repository->fs, &uuid, pool));
+  SVN_ERR(svn_fs_get_uuid(b->repository->fs, &uuid, pool));
 
   /* We can't claim mergeinfo capability until we know whether the
      repository supports mergeinfo (i.e., is not a 1.4 repository),
@@ -3724,14 +3875,21 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
      the client has sent the url. */
   {
     svn_boolean_t supports_mergeinfo;
-    SVN_ERR(svn_repos_has_capability(repository.repos, &supports_mergeinfo,
+    SVN_ERR(svn_repos_has_capability(repository->repos, &supports_mergeinfo,
                                      SVN_REPOS_CAPABILITY_MERGEINFO, pool));
 
     SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(cc(!",
                                     "success", uuid,
-                                    b.repository->repos_url));
+                                    b->repository->repos_url));
     if (supports_mergeinfo)
       SVN_ERR(svn_ra_svn__write_word(conn, pool, SVN_RA_SVN_CAP_MERGEINFO));
+
+    /* A pipelining client sends further commands before reading our
+       responses, so it can't take part in an authentication exchange
+       in the middle of a read command.  Only invite pipelining if no
+       such exchange can happen on this connection. */
+    if (! can_authenticate(b, READ_ACCESS))
+      SVN_ERR(svn_ra_svn__write_word(conn, pool, SVN_RA_SVN_CAP_PIPELINING));
     SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
   }
 
@@ -3743,10 +3901,33 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
     callbacks->fetch_base_func = fetch_base_func;
     callbacks->fetch_props_func = fetch_props_func;
     callbacks->fetch_kind_func = fetch_kind_func;
-    callbacks->fetch_baton = &b;
+    callbacks->fetch_baton = b;
 
     SVN_ERR(svn_ra_svn__set_shim_callbacks(conn, callbacks));
   }
 
-  return svn_ra_svn__handle_commands2(conn, pool, main_commands, &b, FALSE);
+  *baton = b;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *serve_command(svn_boolean_t *terminate, server_baton_t *baton,
+                           svn_ra_svn_conn_t *conn, apr_pool_t *pool)
+{
+  return svn_error_trace(svn_ra_svn__handle_command(terminate,
+                                                    main_command_table,
+                                                    baton, conn, FALSE,
+                                                    pool));
+}
+
+svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
+                   apr_pool_t *pool)
+{
+  server_baton_t *b;
+
+  SVN_ERR(serve_greeting(conn, params, pool));
+  SVN_ERR(serve_open(&b, conn, params, pool));
+  if (!b)
+    return SVN_NO_ERROR;
+
+  return svn_ra_svn__handle_commands2(conn, pool, main_commands, b, FALSE);
 }
@@ -136,6 +136,10 @@ typedef struct serve_params_t {
      Defaults to SVN_DELTA_COMPRESSION_LEVEL_DEFAULT. */
   int compression_level;
 
+  /* Offer clients to compress the whole protocol stream instead of only
+     the svndiff data.  Ignored if COMPRESSION_LEVEL is 0. */
+  svn_boolean_t compress_stream;
+
   /* Item size up to which we use the zero-copy code path to transmit
      them over the network.  0 disables that code path. */
   apr_size_t zero_copy_limit;
@@ -158,6 +162,29 @@ client_info_t * get_client_info(svn_ra_svn_conn_t *conn,
 svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
                    apr_pool_t *pool);
 
+/* Send the server's greeting, which starts the handshake of serve(), to
+ * the client on CONN according to PARAMS.  This does not wait for the
+ * client.  Use POOL for temporary allocations.
+ */
+svn_error_t *serve_greeting(svn_ra_svn_conn_t *conn, serve_params_t *params,
+                            apr_pool_t *pool);
+
+/* Complete the handshake of serve() on CONN according to PARAMS after
+ * serve_greeting() and return the state of the session in *BATON,
+ * allocated in POOL.  If the session could not be established, e.g.
+ * because the client may not access the repository, set *BATON to NULL.
+ * The connection should be closed then.
+ */
+svn_error_t *serve_open(server_baton_t **baton, svn_ra_svn_conn_t *conn,
+                        serve_params_t *params, apr_pool_t *pool);
+
+/* Read a single command from CONN and execute it within the session
+ * BATON returned by serve_open().  Set *TERMINATE to TRUE if the session
+ * has ended.  Use POOL for all temporary allocations.
+ */
+svn_error_t *serve_command(svn_boolean_t *terminate, server_baton_t *baton,
+                           svn_ra_svn_conn_t *conn, apr_pool_t *pool);
+
 /* Initialize the Cyrus SASL library. POOL is used for allocations. */
 svn_error_t *cyrus_init(apr_pool_t *pool);
 
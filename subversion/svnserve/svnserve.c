@@ -57,11 +57,14 @@
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_cache.h"
+#include "private/svn_ra_svn_private.h"
 
 /* Alas! old APR-Utils don't provide thread pools */
 #if APR_HAS_THREADS
 #  if APR_VERSION_AT_LEAST(1,3,0)
 #    include <apr_thread_pool.h>
+#    include <apr_poll.h>
 #    define HAVE_THREADPOOLS 1
 #    define THREAD_ERROR_MSG _("Can't push task")
 #  else
@@ -86,6 +89,7 @@
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
   connection_mode_thread, /* Create a thread per connection */
+  connection_mode_event,  /* Multiplex all connections in an event loop */
   connection_mode_single  /* One connection at a time in this process */
 };
 
@@ -120,6 +124,11 @@ enum run_mode {
 
 #endif
 
+/* The event loop needs a thread pool to execute the commands. */
+#if HAVE_THREADPOOLS
+#define CONNECTION_HAVE_EVENT_OPTION
+#endif
+
 /* Parameters for the worker thread pool used in threaded mode. */
 
 /* Have at least this many worker threads (even if there are no requests
@@ -155,6 +164,24 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Size of the pollset used in event mode.
+ *
+ * With epoll and similar mechanisms, this only limits the number of
+ * events that get processed per wake-up of the event loop.  Other
+ * implementations, e.g. those based on poll(), cannot handle more
+ * concurrent connections than this.
+ */
+#define EVENT_POLLSET_SIZE 1024
+
+/* Number of microseconds that a worker thread waits in event mode for the
+ * client to send data, e.g. during authentication or while it is reading
+ * a large command.  If that time passes, the connection gets closed.
+ * This limits how long a stalled client can keep a thread from serving
+ * other connections.  Sending responses is not limited, so slow clients
+ * can still download large amounts of data.
+ */
+#define EVENT_READ_TIMEOUT (60 * APR_USEC_PER_SEC)
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -217,6 +244,10 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_SINGLE_CONN     268
 #define SVNSERVE_OPT_CLIENT_SPEED    269
 #define SVNSERVE_OPT_VIRTUAL_HOST    270
+#define SVNSERVE_OPT_CACHE_SHARED    271
+#define SVNSERVE_OPT_EVENT_LOOP      272
+#define SVNSERVE_OPT_COMPRESS_STREAM 273
+#define SVNSERVE_OPT_MAX_THREADS     274
 
 static const apr_getopt_option_t svnserve__options[] =
   {
@@ -271,6 +302,10 @@ static const apr_getopt_option_t svnserve__options[] =
         "[0 .. no compression, 5 .. default, \n"
         "                             "
         " 9 .. maximum compression]")},
+    {"compress-stream",  SVNSERVE_OPT_COMPRESS_STREAM, 0,
+     N_("offer clients to compress all network traffic\n"
+        "                             "
+        "instead of only file deltas.  Useful on slow links.")},
     {"memory-cache-size", 'M', 1,
      N_("size of the extra in-memory cache in MB used to\n"
         "                             "
@@ -281,6 +316,14 @@ static const apr_getopt_option_t svnserve__options[] =
         "threaded mode.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"memory-cache-shared", SVNSERVE_OPT_CACHE_SHARED, 0,
+     N_("share a single in-memory cache between all\n"
+        "                             "
+        "processes instead of using one cache per process.\n"
+        "                             "
+        "The cache size given with -M applies to the total.\n"
+        "                             "
+        "[mode: daemon, fork]")},
     {"cache-txdeltas", SVNSERVE_OPT_CACHE_TXDELTAS, 1,
      N_("enable or disable caching of deltas between older\n"
         "                             "
@@ -316,6 +359,24 @@ static const apr_getopt_option_t svnserve__options[] =
      * ### this option never exists when --service exists. */
     {"threads",          'T', 0, N_("use threads instead of fork "
                                     "[mode: daemon]")},
+#endif
+#ifdef CONNECTION_HAVE_EVENT_OPTION
+    {"event-loop",       SVNSERVE_OPT_EVENT_LOOP, 0,
+     N_("wait for requests on all connections in a single\n"
+        "                             "
+        "event loop and handle them in a pool of threads.\n"
+        "                             "
+        "Idle connections don't tie up any thread.\n"
+        "                             "
+        "[mode: daemon]")},
+#endif
+#if HAVE_THREADPOOLS
+    {"max-threads",      SVNSERVE_OPT_MAX_THREADS, 1,
+     N_("maximum number of worker threads.  Further\n"
+        "                             "
+        "connections or requests get queued.\n"
+        "                             "
+        "[mode: daemon with -T or --event-loop]")},
 #endif
     {"foreground",        SVNSERVE_OPT_FOREGROUND, 0,
      N_("run in foreground (useful for debugging)\n"
@@ -480,18 +541,16 @@ release_shared_pool(struct shared_pool_t *shared)
 }
 #endif
 
-/* Wrapper around serve() that takes a socket instead of a connection.
- * This is to off-load work from the main thread in threaded and fork modes.
+/* Return a new connection for the client socket USOCK configured
+ * according to PARAMS.  Allocate it in POOL.
  */
-static svn_error_t *
-serve_socket(apr_socket_t *usock,
-             serve_params_t *params,
-             apr_pool_t *pool)
+static svn_ra_svn_conn_t *
+create_connection(apr_socket_t *usock,
+                  serve_params_t *params,
+                  apr_pool_t *pool)
 {
   apr_status_t status;
-  svn_ra_svn_conn_t *conn;
-  svn_error_t *err;
-  
+
   /* Enable TCP keep-alives on the socket so we time out when
    * the connection breaks due to network-layer problems.
    * If the peer has dropped the connection due to a network partition
@@ -507,11 +566,23 @@ serve_socket(apr_socket_t *usock,
     }
 
   /* create the connection, configure ports etc. */
-  conn = svn_ra_svn_create_conn3(usock, NULL, NULL,
+  return svn_ra_svn_create_conn3(usock, NULL, NULL,
                                  params->compression_level,
                                  params->zero_copy_limit,
                                  params->error_check_interval,
                                  pool);
+}
+
+/* Wrapper around serve() that takes a socket instead of a connection.
+ * This is to off-load work from the main thread in threaded and fork modes.
+ */
+static svn_error_t *
+serve_socket(apr_socket_t *usock,
+             serve_params_t *params,
+             apr_pool_t *pool)
+{
+  svn_ra_svn_conn_t *conn = create_connection(usock, params, pool);
+  svn_error_t *err;
 
   /* process the actual request and log errors */
   err = serve(conn, params, pool);
@@ -551,6 +622,321 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 }
 #endif
 
+#ifdef CONNECTION_HAVE_EVENT_OPTION
+/* Shared state of the event loop in event mode. */
+typedef struct event_loop_t {
+  /* The listening socket and all idle client connections. */
+  apr_pollset_t *pollset;
+
+  /* Executes the commands received on the client connections. */
+  apr_thread_pool_t *threads;
+
+  /* Take connection pools from here and put them back after use. */
+  svn_root_pools__t *socket_pools;
+
+  /* How to serve the connections. */
+  serve_params_t *params;
+} event_loop_t;
+
+/* A client connection in event mode.  At any time, it is either idle
+ * and waiting in the pollset or being served by exactly one thread.
+ */
+typedef struct event_connection_t {
+  /* Entry for this connection in the pollset.  CLIENT_DATA points back
+     to this structure. */
+  apr_pollfd_t pfd;
+
+  svn_ra_svn_conn_t *conn;
+
+  /* The session state.  NULL until the handshake has been completed. */
+  server_baton_t *baton;
+
+  event_loop_t *loop;
+
+  /* Root pool for everything above, taken from LOOP->SOCKET_POOLS. */
+  apr_pool_t *pool;
+} event_connection_t;
+
+/* Close CONNECTION and release all its memory. */
+static void
+close_event_connection(event_connection_t *connection)
+{
+  apr_socket_close(connection->pfd.desc.s);
+  svn_root_pools__release_pool(connection->pool,
+                               connection->loop->socket_pools);
+}
+
+/* Log ERR for CONNECTION and clear it.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static void
+log_event_connection_error(event_connection_t *connection,
+                           svn_error_t *err,
+                           apr_pool_t *scratch_pool)
+{
+  serve_params_t *params = connection->loop->params;
+
+  logger__log_error(params->logger, err, NULL,
+                    get_client_info(connection->conn, params, scratch_pool));
+  svn_error_clear(err);
+}
+
+/* Put CONNECTION back into the pollset until more data arrives.  If that
+ * fails, close it.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+park_event_connection(event_connection_t *connection,
+                      apr_pool_t *scratch_pool)
+{
+  apr_status_t status = apr_pollset_add(connection->loop->pollset,
+                                        &connection->pfd);
+  if (status)
+    {
+      log_event_connection_error(connection,
+                                 svn_error_wrap_apr(status,
+                                   _("Can't add connection to pollset")),
+                                 scratch_pool);
+      close_event_connection(connection);
+    }
+}
+
+/* Serve the event_connection_t DATA in a worker thread.  Complete the
+ * handshake if that has not happened, yet.  Then, execute all commands
+ * that have been received completely.  Finally, either close the
+ * connection or put it back into the pollset.
+ */
+static void * APR_THREAD_FUNC
+serve_event_connection(apr_thread_t *tid, void *data)
+{
+  event_connection_t *connection = data;
+  apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+  svn_boolean_t has_command = TRUE;
+  svn_boolean_t terminate = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!connection->baton)
+    {
+      /* Session state must survive between commands. */
+      err = serve_open(&connection->baton, connection->conn,
+                       connection->loop->params, connection->pool);
+      terminate = !connection->baton;
+      if (!err && !terminate)
+        err = svn_ra_svn__has_command(&has_command, &terminate,
+                                      connection->conn, pool);
+    }
+
+  while (!err && !terminate && has_command)
+    {
+      svn_pool_clear(pool);
+      err = serve_command(&terminate, connection->baton, connection->conn,
+                          pool);
+      if (!err && !terminate)
+        err = svn_ra_svn__has_command(&has_command, &terminate,
+                                      connection->conn, pool);
+    }
+
+  if (err)
+    {
+      log_event_connection_error(connection, err, pool);
+      terminate = TRUE;
+    }
+
+  if (terminate)
+    close_event_connection(connection);
+  else
+    park_event_connection(connection, pool);
+
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  return NULL;
+}
+
+/* Have a thread of LOOP serve CONNECTION.
+ */
+static svn_error_t *
+dispatch_event_connection(event_connection_t *connection)
+{
+  apr_status_t status = apr_thread_pool_push(connection->loop->threads,
+                                             serve_event_connection,
+                                             connection, 0, NULL);
+  if (status)
+    return svn_error_wrap_apr(status, THREAD_ERROR_MSG);
+
+  return SVN_NO_ERROR;
+}
+
+/* Accept a new client connection on the listening socket SOCK of LOOP,
+ * greet the client and wait for its response in the pollset.  The rest
+ * of the handshake happens in a worker thread once the response has been
+ * received.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+accept_event_connection(event_loop_t *loop,
+                        apr_socket_t *sock,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *socket_pool = svn_root_pools__acquire_pool(loop->socket_pools);
+  event_connection_t *connection;
+  apr_socket_t *usock;
+  apr_status_t status;
+  svn_error_t *err;
+
+  status = apr_socket_accept(&usock, sock, socket_pool);
+  if (APR_STATUS_IS_EINTR(status)
+      || APR_STATUS_IS_ECONNABORTED(status)
+      || APR_STATUS_IS_ECONNRESET(status))
+    {
+      svn_root_pools__release_pool(socket_pool, loop->socket_pools);
+      return SVN_NO_ERROR;
+    }
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't accept client connection"));
+
+  connection = apr_pcalloc(socket_pool, sizeof(*connection));
+  connection->pfd.p = socket_pool;
+  connection->pfd.desc_type = APR_POLL_SOCKET;
+  connection->pfd.reqevents = APR_POLLIN;
+  connection->pfd.desc.s = usock;
+  connection->pfd.client_data = connection;
+  connection->conn = create_connection(usock, loop->params, socket_pool);
+  connection->loop = loop;
+  connection->pool = socket_pool;
+
+  /* Never let a worker wait for the client indefinitely. */
+  svn_ra_svn__set_read_timeout(connection->conn, EVENT_READ_TIMEOUT);
+
+  /* The greeting fits easily into the empty socket buffer. */
+  err = serve_greeting(connection->conn, loop->params, scratch_pool);
+  if (!err)
+    err = svn_ra_svn__flush(connection->conn, scratch_pool);
+
+  if (err)
+    {
+      log_event_connection_error(connection, err, scratch_pool);
+      close_event_connection(connection);
+    }
+  else
+    {
+      park_event_connection(connection, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* CONNECTION has become readable.  Read whatever data is available and
+ * hand the connection to a worker thread once it contains a complete
+ * command.  Errors only affect CONNECTION, so they get logged and the
+ * connection gets closed.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+check_event_connection(event_connection_t *connection,
+                       apr_pool_t *scratch_pool)
+{
+  svn_boolean_t has_command;
+  svn_boolean_t terminated;
+  svn_error_t *err;
+
+  /* The pollset is level-triggered, so keep the connection out of it
+     while it is not idle. */
+  apr_pollset_remove(connection->loop->pollset, &connection->pfd);
+
+  err = svn_ra_svn__has_command(&has_command, &terminated, connection->conn,
+                                scratch_pool);
+  if (!err && !terminated && has_command)
+    {
+      /* The connection is not in the pollset anymore, so it would leak
+         if no thread could take it. */
+      err = dispatch_event_connection(connection);
+      if (!err)
+        return;
+    }
+
+  if (err)
+    {
+      log_event_connection_error(connection, err, scratch_pool);
+      terminated = TRUE;
+    }
+
+  if (terminated)
+    close_event_connection(connection);
+  else
+    park_event_connection(connection, scratch_pool);
+}
+
+/* Serve all client connections made to the listening socket SOCK in a
+ * single event loop, according to PARAMS.  Commands get executed by
+ * THREADS.  Neither idle connections nor clients that have yet to
+ * respond to the greeting occupy any thread.  Take
+ * connection pools from SOCKET_POOLS.  Use POOL for the loop's own
+ * allocations.  This only returns in case of a fatal error.
+ */
+static svn_error_t *
+serve_events(apr_socket_t *sock,
+             serve_params_t *params,
+             apr_thread_pool_t *threads,
+             svn_root_pools__t *socket_pools,
+             apr_pool_t *pool)
+{
+  event_loop_t loop;
+  apr_pollfd_t listener = { 0 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t status;
+
+  /* Worker threads add the connections back to the pollset. */
+  status = apr_pollset_create(&loop.pollset, EVENT_POLLSET_SIZE, pool,
+                              APR_POLLSET_THREADSAFE);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create pollset"));
+
+  loop.threads = threads;
+  loop.socket_pools = socket_pools;
+  loop.params = params;
+
+  /* The listening socket is the only one without client data. */
+  listener.p = pool;
+  listener.desc_type = APR_POLL_SOCKET;
+  listener.reqevents = APR_POLLIN;
+  listener.desc.s = sock;
+  listener.client_data = NULL;
+
+  status = apr_pollset_add(loop.pollset, &listener);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't add socket to pollset"));
+
+  while (1)
+    {
+      const apr_pollfd_t *events;
+      apr_int32_t count;
+      int i;
+
+#ifdef WIN32
+      if (winservice_is_stopping())
+        return SVN_NO_ERROR;
+#endif
+
+      svn_pool_clear(iterpool);
+
+      status = apr_pollset_poll(loop.pollset, -1, &count, &events);
+      if (APR_STATUS_IS_EINTR(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll client connections"));
+
+      for (i = 0; i < count; ++i)
+        {
+          event_connection_t *connection = events[i].client_data;
+
+          if (connection)
+            check_event_connection(connection, iterpool);
+          else
+            SVN_ERR(accept_event_connection(&loop, sock, iterpool));
+        }
+    }
+
+  /* NOTREACHED */
+}
+#endif
+
 /* Write the PID of the current process as a decimal number, followed by a
    newline to the file FILENAME, using POOL for temporary allocations. */
 static svn_error_t *write_pid_file(const char *filename, apr_pool_t *pool)
@@ -615,6 +1001,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   struct serve_thread_t *thread_data;
 #if HAVE_THREADPOOLS
   apr_thread_pool_t *threads;
+  apr_size_t max_threads = THREADPOOL_MAX_SIZE;
 #else
   apr_threadattr_t *tattr;
   apr_thread_t *tid;
@@ -626,6 +1013,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_fulltexts = TRUE;
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
+  svn_boolean_t cache_shared = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -662,6 +1050,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.base = NULL;
   params.cfg = NULL;
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+  params.compress_stream = FALSE;
   params.logger = NULL;
   params.config_pool = NULL;
   params.authz_pool = NULL;
@@ -793,6 +1182,26 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           handling_opt_count++;
           break;
 
+        case SVNSERVE_OPT_EVENT_LOOP:
+          handling_mode = connection_mode_event;
+          handling_opt_count++;
+          break;
+
+#if HAVE_THREADPOOLS
+        case SVNSERVE_OPT_MAX_THREADS:
+          {
+            apr_uint64_t val;
+
+            err = svn_cstring_strtoui64(&val, arg, 1, APR_INT32_MAX, 10);
+            if (err)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                       _("Invalid number of threads '%s'"),
+                                       arg);
+            max_threads = (apr_size_t)val;
+          }
+          break;
+#endif
+
         case 'c':
           params.compression_level = atoi(arg);
           if (params.compression_level < SVN_DELTA_COMPRESSION_LEVEL_NONE)
@@ -801,10 +1210,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_MAX;
           break;
 
+        case SVNSERVE_OPT_COMPRESS_STREAM:
+          params.compress_stream = TRUE;
+          break;
+
         case 'M':
           params.memory_cache_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_CACHE_SHARED:
+          cache_shared = TRUE;
+          break;
+
         case SVNSERVE_OPT_CACHE_TXDELTAS:
           cache_txdeltas = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -901,15 +1318,31 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   if (handling_opt_count > 1)
     {
       svn_error_clear(svn_cmdline_fputs(
-                      _("You may only specify one of -T or --single-thread\n"),
+                      _("You may only specify one of -T, --event-loop "
+                        "or --single-thread\n"),
                       stderr, pool));
       usage(argv[0], pool);
       *exit_code = EXIT_FAILURE;
       return SVN_NO_ERROR;
     }
 
+  /* The shared cache lives in memory inherited by forked workers.
+   * It would silently be process-private in all other modes. */
+  if (cache_shared
+      && (run_mode != run_mode_daemon
+          || handling_mode != connection_mode_fork))
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("Option --memory-cache-shared is only valid in "
+                        "daemon mode with one process per connection.\n"),
+                      stderr, pool));
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
   /* construct object pools */
-  is_multi_threaded = handling_mode == connection_mode_thread;
+  is_multi_threaded = handling_mode == connection_mode_thread
+                   || handling_mode == connection_mode_event;
   fs_config = apr_hash_make(pool);
   svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS,
                 cache_txdeltas ? "1" :"0");
@@ -1152,7 +1585,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       settings.cache_size = params.memory_cache_size;
 
     settings.single_threaded = TRUE;
-    if (handling_mode == connection_mode_thread)
+    if (is_multi_threaded)
       {
 #if APR_HAS_THREADS
         settings.single_threaded = FALSE;
@@ -1167,6 +1600,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* A shared cache must be created before the first fork. */
+    if (cache_shared)
+      {
+        svn_cache__set_global_membuffer_shared(TRUE);
+        svn_cache__get_global_membuffer_cache();
+      }
   }
 
   /* we use (and recycle) separate pools for sockets (many small ones)
@@ -1178,12 +1618,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
 
 #if HAVE_THREADPOOLS
-  if (handling_mode == connection_mode_thread)
+  if (is_multi_threaded)
     {
       /* create the thread pool */
       status = apr_thread_pool_create(&threads,
                                       THREADPOOL_MIN_SIZE,
-                                      THREADPOOL_MAX_SIZE,
+                                      max_threads,
                                       pool);
       if (status)
         {
@@ -1199,6 +1639,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 #endif
 
+#ifdef CONNECTION_HAVE_EVENT_OPTION
+  if (handling_mode == connection_mode_event
+      && run_mode != run_mode_listen_once)
+    return svn_error_trace(serve_events(sock, &params, threads,
+                                        socket_pools, pool));
+#endif
+
   while (1)
     {
       apr_pool_t *socket_pool;
@@ -1256,6 +1703,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           if (status == APR_INCHILD)
             {
               apr_socket_close(sock);
+              err = svn_cache__global_membuffer_child_init(socket_pool);
+              if (err)
+                {
+                  logger__log_error(params.logger, err, NULL, NULL);
+                  svn_error_clear(err);
+                  apr_socket_close(usock);
+                  return SVN_NO_ERROR;
+                }
               svn_error_clear(serve_socket(usock, &params, socket_pool));
               apr_socket_close(usock);
               return SVN_NO_ERROR;
@@ -1311,6 +1766,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
           break;
 
+        case connection_mode_event:
+          /* serve_events() handles all connections in this mode, except
+             in listen-once mode, which never gets here. */
+          SVN_ERR_MALFUNCTION();
+
         case connection_mode_single:
           /* Serve one connection at a time. */
           svn_error_clear(serve_socket(usock, &params, socket_pool));
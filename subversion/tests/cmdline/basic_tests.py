@@ -3077,6 +3077,42 @@ def basic_youngest(sbox):
                                            'youngest', path)
 
 
+def rm_and_cp_urls_existence_checks(sbox):
+  "check all targets of remote rm and cp up front"
+
+  sbox.build(create_wc=False)
+  repo_url = sbox.repo_url
+
+  # Removing several URLs fails if any of them is missing...
+  svntest.actions.run_and_verify_svn(None, None,
+                                     ".*URL '.*/A/missing' does not exist",
+                                     'rm', '-m', 'log_msg',
+                                     repo_url + '/A/B', repo_url + '/A/missing',
+                                     repo_url + '/A/C')
+
+  # ... and so does copying several URLs if any of the destinations exists.
+  svntest.actions.run_and_verify_svn(None, None,
+                                     ".*Path '.*/A/D/H' already exists",
+                                     'cp', '-m', 'log_msg',
+                                     repo_url + '/A/B', repo_url + '/A/D/H',
+                                     repo_url + '/A/D')
+
+  # Neither of them committed anything.
+  svntest.actions.run_and_verify_svn(None, ["1\n"], [],
+                                     'youngest', repo_url)
+
+  # With all checks passing, both succeed.
+  svntest.actions.run_and_verify_svn(None, None, [],
+                                     'rm', '-m', 'log_msg',
+                                     repo_url + '/A/B', repo_url + '/A/C')
+  svntest.actions.run_and_verify_svn(None, None, [],
+                                     'cp', '-m', 'log_msg',
+                                     repo_url + '/A/mu', repo_url + '/iota',
+                                     repo_url + '/A/D')
+  svntest.actions.run_and_verify_svn(None, ["3\n"], [],
+                                     'youngest', repo_url)
+
+
 ########################################################################
 # Run the tests
 
@@ -3146,6 +3182,7 @@ test_list = [ None,
               delete_conflicts_one_of_many,
               peg_rev_on_non_existent_wc_path,
               basic_youngest,
+              rm_and_cp_urls_existence_checks,
              ]
 
 if __name__ == '__main__':
@@ -272,7 +272,7 @@ def set_changed_path_list(filename, changes):
 
 #----------------------------------------------------------------------
 
-def test_create(sbox):
+def test_create(sbox, minor_version=None):
   "'svnadmin create'"
 
 
@@ -282,7 +282,7 @@ def test_create(sbox):
   svntest.main.safe_rmtree(repo_dir, 1)
   svntest.main.safe_rmtree(wc_dir)
 
-  svntest.main.create_repos(repo_dir)
+  svntest.main.create_repos(repo_dir, minor_version)
 
   svntest.actions.run_and_verify_svn("Creating rev 0 checkout",
                                      ["Checked out revision 0.\n"], [],
@@ -634,7 +634,9 @@ def verify_incremental_fsfs(sbox):
   """svnadmin verify detects corruption dump can't"""
 
   # setup a repo with a directory 'c:hi'
-  sbox.build(create_wc = False)
+  # This test modifies rev files at known physical offsets, so make sure
+  # the repository uses physical addressing.
+  sbox.build(create_wc = False, minor_version = 8)
   repo_url = sbox.repo_url
   E_url = sbox.repo_url + '/A/B/E'
 
@@ -1458,7 +1460,8 @@ def verify_non_utf8_paths(sbox):
   "svnadmin verify with non-UTF-8 paths"
 
   dumpfile = clean_dumpfile()
-  test_create(sbox)
+  # The rev file edits below rely on physical addressing.
+  test_create(sbox, minor_version = 8)
 
   # Load the dumpstream
   load_and_verify_dumpstream(sbox, [], [], dumpfile_revisions, False,
@@ -1868,7 +1871,8 @@ def recover_old(sbox):
 def verify_keep_going(sbox):
   "svnadmin verify --keep-going test"
 
-  sbox.build(create_wc = False)
+  # Corrupting r2 below requires a physically addressed rev file.
+  sbox.build(create_wc = False, minor_version = 8)
   repo_url = sbox.repo_url
   B_url = sbox.repo_url + '/B'
   C_url = sbox.repo_url + '/C'
@@ -1925,11 +1929,129 @@ def verify_keep_going(sbox):
                                    None, errput, None, "svnadmin: E165011:.*"):
     raise svntest.Failure
 
+def build_jobs_repos(sbox, minor_version=None):
+  """Build the greek tree repository in SBOX and add five more revisions
+  to it, each adding a directory, changing the text of A/mu and setting a
+  property on iota.  Used by the tests of svnadmin's --jobs option."""
+
+  sbox.build(minor_version=minor_version)
+
+  for i in range(5):
+    sbox.simple_mkdir('dir%d' % i)
+    sbox.simple_append('A/mu', 'line %d\n' % i)
+    sbox.simple_propset('prop', 'val%d' % i, 'iota')
+    sbox.simple_commit()
+
+def run_and_compare_jobs(subcommand, repo_dir, *args):
+  """Run 'svnadmin SUBCOMMAND' on REPO_DIR with ARGS, first serially and
+  then with --jobs 3.  Raise a failure unless the second run reports the
+  same exit code, output and errors as the first one."""
+
+  expected = svntest.main.run_svnadmin(subcommand, repo_dir, *args)
+  actual = svntest.main.run_svnadmin(subcommand, "--jobs", "3", repo_dir,
+                                     *args)
+
+  if expected[0] != actual[0]:
+    raise svntest.Failure("'svnadmin %s --jobs' exited with %d instead of %d"
+                          % (subcommand, actual[0], expected[0]))
+
+  if svntest.verify.verify_outputs("Unexpected output of "
+                                   "'svnadmin %s --jobs'." % subcommand,
+                                   actual[1], actual[2],
+                                   expected[1], expected[2]):
+    raise svntest.Failure
+
+def verify_jobs(sbox):
+  "svnadmin verify --jobs"
+
+  build_jobs_repos(sbox)
+
+  # Concurrent verification must report the same results in the same order.
+  run_and_compare_jobs("verify", sbox.repo_dir)
+
+def dump_jobs(sbox):
+  "svnadmin dump --jobs"
+
+  build_jobs_repos(sbox)
+
+  # Concurrent dumps must produce the same dump data and feedback.
+  run_and_compare_jobs("dump", sbox.repo_dir)
+  run_and_compare_jobs("dump", sbox.repo_dir, '--incremental', '-r', '2:HEAD')
+
+def load_and_compare_jobs(sbox, dump):
+  """Load DUMP into two new, empty repositories in SBOX, first serially and
+  then with --jobs 2.  Raise a failure unless the second load reports the
+  same results as the first one and both repositories end up the same.
+  Return the dump of the repository loaded with --jobs."""
+
+  results = []
+  dumps = []
+  for name, args in [('load', []), ('load-jobs', ['--jobs', '2'])]:
+    load_dir, load_url = sbox.add_repo_path(name)
+    svntest.main.create_repos(load_dir)
+    results.append(svntest.main.run_command_stdin(
+                     svntest.main.svnadmin_binary, 1, 0, True, dump,
+                     'load', load_dir, *args))
+    dumps.append(svntest.actions.run_and_verify_dump(load_dir, deltas=True))
+
+  expected, actual = results
+  if expected[0] != actual[0]:
+    raise svntest.Failure("'svnadmin load --jobs' exited with %d instead "
+                          "of %d" % (actual[0], expected[0]))
+
+  if svntest.verify.verify_outputs("Unexpected output of "
+                                   "'svnadmin load --jobs'.",
+                                   actual[1], actual[2],
+                                   expected[1], expected[2]):
+    raise svntest.Failure
+
+  if svntest.verify.verify_outputs("Unexpected dump of the loaded repository.",
+                                   dumps[1], [], dumps[0], []):
+    raise svntest.Failure
+
+  return dumps[1]
+
+def load_jobs(sbox):
+  "svnadmin load --jobs"
+
+  build_jobs_repos(sbox)
+  dump = svntest.actions.run_and_verify_dump(sbox.repo_dir, deltas=True)
+
+  # Parsing the dumpstream in a separate thread must not change the result.
+  if svntest.verify.verify_outputs("Unexpected dump of the loaded repository.",
+                                   load_and_compare_jobs(sbox, dump),
+                                   [], dump, []):
+    raise svntest.Failure
+
+  # Cut the dumpstream off in the middle of r4's first node header.  The
+  # parser thread will fail while earlier revisions are still queued.
+  rev4 = dump.index('Revision-number: 4\n')
+  node = rev4 + [line.startswith('Node-path: ')
+                 for line in dump[rev4:]].index(True)
+  load_and_compare_jobs(sbox, dump[:node + 1])
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def jobs_corrupt_revision(sbox):
+  "svnadmin verify and dump --jobs with a bad rev"
+
+  # Corrupting a revision below requires a physically addressed rev file.
+  build_jobs_repos(sbox, minor_version=8)
+  fp = open(fsfs_file(sbox.repo_dir, 'revs', '4'), 'a')
+  fp.write("""inserting junk to corrupt the rev""")
+  fp.close()
+
+  # The worker handling r4 fails while others may have already processed
+  # later revisions.  Errors must still be reported as in a serial run.
+  run_and_compare_jobs("verify", sbox.repo_dir)
+  run_and_compare_jobs("verify", sbox.repo_dir, "--keep-going")
+  run_and_compare_jobs("dump", sbox.repo_dir)
+
 @SkipUnless(svntest.main.is_fs_type_fsfs)
 def verify_invalid_path_changes(sbox):
   "detect invalid changed path list entries"
 
-  sbox.build(create_wc = False)
+  # Rewriting the changed path lists needs physical addressing.
+  sbox.build(create_wc = False, minor_version = 8)
   repo_url = sbox.repo_url
 
   # Create a number of revisions each adding a single path
@@ -2075,6 +2197,10 @@ test_list = [ None,
               recover_old,
               verify_keep_going,
               verify_invalid_path_changes,
+              verify_jobs,
+              dump_jobs,
+              load_jobs,
+              jobs_corrupt_revision,
              ]
 
 if __name__ == '__main__':
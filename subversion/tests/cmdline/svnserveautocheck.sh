@@ -107,6 +107,10 @@ if [ "$THREADED" != "" ]; then
   SVNSERVE_ARGS="-T"
 fi
 
+if [ "$EVENT_LOOP" != "" ]; then
+  SVNSERVE_ARGS="--event-loop"
+fi
+
 if [ ${CACHE_REVPROPS:+set} ]; then
   SVNSERVE_ARGS="$SVNSERVE_ARGS --cache-revprops on"
 fi
@@ -36,6 +36,7 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "private/svn_delta_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -280,9 +281,11 @@ copy_tempfile(apr_file_t *fp, apr_pool_t *pool)
 
 
 
-/* Implements svn_test_driver_t. */
+/* Run the random delta test, encoding the deltas in svndiff format
+   version SVNDIFF_VERSION. */
 static svn_error_t *
-random_test(apr_pool_t *pool)
+do_random_test(int svndiff_version,
+               apr_pool_t *pool)
 {
   apr_uint32_t seed, maxlen;
   apr_size_t bytes_range;
@@ -329,8 +332,8 @@ random_test(apr_pool_t *pool)
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, 1, i % 10,
-                              delta_pool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                              svndiff_version, i % 10, delta_pool);
 
       /* Make stage 1: create the text delta.  */
       svn_txdelta2(&txdelta_stream,
@@ -357,6 +360,20 @@ random_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_test(apr_pool_t *pool)
+{
+  return do_random_test(1, pool);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_svndiff2_test(apr_pool_t *pool)
+{
+  return do_random_test(2, pool);
+}
+
 
 
 /* (Note: *LAST_SEED is an output parameter.) */
@@ -502,6 +519,182 @@ random_combine_test(apr_pool_t *pool)
   return err;
 }
 
+/* Append LEN random bytes to BUF, using SEED. */
+static void
+append_random_bytes(svn_stringbuf_t *buf,
+                    apr_size_t len,
+                    apr_uint32_t *seed)
+{
+  apr_size_t i;
+  for (i = 0; i < len; ++i)
+    svn_stringbuf_appendbyte(buf, (char)svn_test_rand(seed));
+}
+
+/* Create a large-window delta from SOURCE to TARGET, send it through
+   svndiff encoding and parsing, apply it to SOURCE and verify that the
+   result matches TARGET.  Also verify that the delta contains at most
+   MAX_NEW_DATA bytes of new data.  Use POOL for allocations. */
+static svn_error_t *
+check_large_window_delta(svn_stringbuf_t *source,
+                         svn_stringbuf_t *target,
+                         apr_size_t max_new_data,
+                         apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_txdelta_window_t *window;
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  apr_size_t new_data = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  svn_txdelta_apply(svn_stream_from_stringbuf(source, pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                    TRUE, pool),
+                          1, 0, pool);
+
+  svn_delta__txdelta_large_window(&delta_stream,
+                                  svn_stream_from_stringbuf(source, pool),
+                                  svn_stream_from_stringbuf(source, pool),
+                                  svn_stream_from_stringbuf(target, pool),
+                                  FALSE, pool);
+  do
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream, iterpool));
+      if (window)
+        new_data += window->new_data->len;
+
+      SVN_ERR(handler(window, handler_baton));
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+  SVN_TEST_ASSERT(new_data <= max_new_data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+large_window_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 1234;
+  apr_size_t size = 10 * SVN_DELTA_WINDOW_SIZE;
+  apr_size_t shift = 3 * SVN_DELTA_WINDOW_SIZE + 123;
+  svn_stringbuf_t *source = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *target;
+
+  append_random_bytes(source, size, &seed);
+
+  /* Identical contents. */
+  SVN_ERR(check_large_window_delta(source, source, 0, pool));
+
+  /* Data inserted at the start. */
+  target = svn_stringbuf_create_empty(pool);
+  append_random_bytes(target, shift, &seed);
+  svn_stringbuf_appendstr(target, source);
+  SVN_ERR(check_large_window_delta(source, target,
+                                   shift + SVN_DELTA_WINDOW_SIZE, pool));
+
+  /* Data removed from the start. */
+  target = svn_stringbuf_ncreate(source->data + shift, size - shift, pool);
+  SVN_ERR(check_large_window_delta(source, target,
+                                   SVN_DELTA_WINDOW_SIZE, pool));
+
+  /* Data removed from the middle. */
+  target = svn_stringbuf_ncreate(source->data, size / 4, pool);
+  svn_stringbuf_appendbytes(target, source->data + size / 4 + shift,
+                            size - size / 4 - shift);
+  SVN_ERR(check_large_window_delta(source, target,
+                                   SVN_DELTA_WINDOW_SIZE, pool));
+
+  /* Unrelated contents. */
+  target = svn_stringbuf_create_empty(pool);
+  append_random_bytes(target, size, &seed);
+  SVN_ERR(check_large_window_delta(source, target, 2 * size, pool));
+
+  /* Empty source. */
+  SVN_ERR(check_large_window_delta(svn_stringbuf_create_empty(pool), source,
+                                   2 * size, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Create a delta from SOURCE to TARGET and set *NEW_DATA to the number of
+   bytes of new data in it.  Use POOL for allocations. */
+static svn_error_t *
+count_new_data(apr_size_t *new_data,
+               svn_stringbuf_t *source,
+               svn_stringbuf_t *target,
+               apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+
+  *new_data = 0;
+  svn_txdelta2(&delta_stream, svn_stream_from_stringbuf(source, pool),
+               svn_stream_from_stringbuf(target, pool), FALSE, pool);
+  do
+    {
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream, pool));
+      if (window)
+        *new_data += window->new_data->len;
+    }
+  while (window);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t.  xdelta calculates the checksum of the
+   first block at any position from scratch and updates it incrementally
+   for the following positions.  Unless both agree, moved data will not
+   be found. */
+static svn_error_t *
+unaligned_match_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 4321;
+  apr_size_t size = 20000;
+  svn_stringbuf_t *source = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t shift;
+
+  append_random_bytes(source, size, &seed);
+
+  for (shift = 0; shift < 100; ++shift)
+    {
+      svn_stringbuf_t *target;
+      apr_size_t new_data;
+
+      svn_pool_clear(iterpool);
+
+      /* Data inserted at the start. */
+      target = svn_stringbuf_create_empty(iterpool);
+      append_random_bytes(target, shift, &seed);
+      svn_stringbuf_appendstr(target, source);
+      SVN_ERR(count_new_data(&new_data, source, target, iterpool));
+      SVN_TEST_ASSERT(new_data <= shift);
+
+      /* Data inserted in the middle. */
+      target = svn_stringbuf_ncreate(source->data, size / 2 + shift,
+                                     iterpool);
+      append_random_bytes(target, shift, &seed);
+      svn_stringbuf_appendbytes(target, source->data + size / 2 + shift,
+                                size / 2 - shift);
+      SVN_ERR(count_new_data(&new_data, source, target, iterpool));
+      SVN_TEST_ASSERT(new_data <= shift);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
@@ -519,6 +712,12 @@ struct svn_test_descriptor_t test_funcs[] =
                    "random delta test"),
     SVN_TEST_PASS2(random_combine_test,
                    "random combine delta test"),
+    SVN_TEST_PASS2(random_svndiff2_test,
+                   "random delta test using svndiff2"),
+    SVN_TEST_PASS2(large_window_test,
+                   "large-window delta test"),
+    SVN_TEST_PASS2(unaligned_match_test,
+                   "xdelta matches at unaligned positions"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -0,0 +1,225 @@
+/* xdelta-bench.c -- measure the throughput of text delta generation
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define APR_WANT_STDIO
+#include <apr_want.h>
+
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "svn_ctype.h"
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+/* Size of the generated test data, if no files have been given. */
+#define DEFAULT_SIZE (64 * 1024 * 1024)
+
+/* Return the next value of the pseudo-random number generator *SEED. */
+static apr_uint32_t
+next_random(apr_uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+/* Return SIZE bytes of binary-like data, allocated in POOL. */
+static svn_stringbuf_t *
+generate_source(apr_size_t size,
+                apr_uint32_t *seed,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(size, pool);
+  apr_size_t i;
+
+  /* Mix random data with runs of repeated bytes and text-like sections
+     to resemble typical binary assets. */
+  for (i = 0; i < size; ++i)
+    {
+      apr_uint32_t value = next_random(seed);
+      result->data[i] = (i & 0x1000) ? (char)(value % 64 + ' ')
+                                     : (char)value;
+    }
+
+  result->data[size] = 0;
+  result->len = size;
+
+  return result;
+}
+
+/* Return a copy of SOURCE with a few insertions, deletions and changes,
+   allocated in POOL. */
+static svn_stringbuf_t *
+generate_target(const svn_stringbuf_t *source,
+                apr_uint32_t *seed,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(source->len, pool);
+  apr_size_t pos = 0;
+
+  while (pos < source->len)
+    {
+      apr_size_t len = next_random(seed) % 100000;
+      len = len < source->len - pos ? len : source->len - pos;
+
+      svn_stringbuf_appendbytes(result, source->data + pos, len);
+      pos += len;
+
+      switch (next_random(seed) % 3)
+        {
+          case 0:
+            svn_stringbuf_appendbyte(result, (char)next_random(seed));
+            break;
+
+          case 1:
+            pos += next_random(seed) % 64;
+            break;
+
+          default:
+            svn_stringbuf_appendbyte(result, (char)next_random(seed));
+            ++pos;
+            break;
+        }
+    }
+
+  return result;
+}
+
+/* Return the contents of the file at PATH, allocated in POOL. */
+static svn_stringbuf_t *
+read_file(const char *path,
+          apr_pool_t *pool)
+{
+  svn_stringbuf_t *result;
+  svn_error_t *err = svn_stringbuf_from_file2(&result, path, pool);
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "xdelta-bench: ");
+
+  return result;
+}
+
+/* Compute the delta between SOURCE and TARGET, return the total size of
+   all delta windows in *DELTA_SIZE and the time it took in *DURATION. */
+static void
+run_delta(apr_size_t *delta_size,
+          apr_interval_time_t *duration,
+          svn_stringbuf_t *source,
+          svn_stringbuf_t *target,
+          apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+  apr_pool_t *wpool = svn_pool_create(pool);
+  apr_time_t start = apr_time_now();
+
+  *delta_size = 0;
+  svn_txdelta2(&delta_stream,
+               svn_stream_from_stringbuf(source, pool),
+               svn_stream_from_stringbuf(target, pool),
+               FALSE,
+               pool);
+
+  do
+    {
+      svn_error_t *err;
+
+      svn_pool_clear(wpool);
+      err = svn_txdelta_next_window(&window, delta_stream, wpool);
+      if (err)
+        svn_handle_error2(err, stderr, TRUE, "xdelta-bench: ");
+
+      if (window)
+        *delta_size += window->new_data->len
+                     + window->num_ops * sizeof(*window->ops);
+    }
+  while (window);
+
+  *duration = apr_time_now() - start;
+  svn_pool_destroy(wpool);
+}
+
+int
+main(int argc, char **argv)
+{
+  apr_pool_t *pool;
+  svn_stringbuf_t *source;
+  svn_stringbuf_t *target;
+  int repeat = 3;
+  int i;
+
+  while (argc > 1)
+    {
+      const char *const arg = argv[1];
+      if (arg[0] != '-')
+        break;
+
+      if (svn_ctype_isdigit(arg[1]))
+        repeat = atoi(arg + 1);
+      else
+        break;
+      --argc; ++argv;
+    }
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+
+  if (argc == 1)
+    {
+      apr_uint32_t seed = 0x5eed;
+      source = generate_source(DEFAULT_SIZE, &seed, pool);
+      target = generate_target(source, &seed, pool);
+    }
+  else if (argc == 3)
+    {
+      source = read_file(argv[1], pool);
+      target = read_file(argv[2], pool);
+    }
+  else
+    {
+      fprintf(stderr,
+              "Usage: xdelta-bench [-<repeat>]\n"
+              "   or: xdelta-bench [-<repeat>] <source> <target>\n");
+      exit(1);
+    }
+
+  for (i = 0; i < repeat; ++i)
+    {
+      apr_size_t delta_size;
+      apr_interval_time_t duration;
+      apr_pool_t *iterpool = svn_pool_create(pool);
+
+      run_delta(&delta_size, &duration, source, target, iterpool);
+      printf("%" APR_SIZE_T_FMT " -> %" APR_SIZE_T_FMT " bytes, "
+             "delta %" APR_SIZE_T_FMT " bytes, %.1f ms, %.1f MB/s\n",
+             source->len, target->len, delta_size,
+             duration / 1000.0,
+             duration ? (double)target->len / duration : 0.0);
+
+      svn_pool_destroy(iterpool);
+    }
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
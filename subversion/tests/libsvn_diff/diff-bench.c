@@ -0,0 +1,251 @@
+/* diff-bench.c -- measure the throughput of file diffs and merges
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define APR_WANT_STDIO
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+
+#include <apr_general.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_ctype.h"
+#include "svn_diff.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+/* Number of lines in the generated test data, if no files have been
+   given.  That is a few MB of text. */
+#define DEFAULT_LINES 100000
+
+/* Return the next value of the pseudo-random number generator *SEED. */
+static apr_uint32_t
+next_random(apr_uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+/* Append a line of generated source code with the given NUMBER to TEXT. */
+static void
+append_line(svn_stringbuf_t *text,
+            apr_uint32_t number,
+            apr_uint32_t *seed)
+{
+  switch (next_random(seed) % 4)
+    {
+      case 0:
+        svn_stringbuf_appendcstr(text, "\n");
+        break;
+
+      case 1:
+        svn_stringbuf_appendcstr(text,
+                                 apr_psprintf(text->pool,
+                                              "  /* Entry %u. */\n",
+                                              number));
+        break;
+
+      default:
+        svn_stringbuf_appendcstr(text,
+                                 apr_psprintf(text->pool,
+                                              "  { \"item_%u\", 0x%08x, %u },"
+                                              "\n",
+                                              number, next_random(seed),
+                                              next_random(seed) % 1000));
+        break;
+    }
+}
+
+/* Return LINES lines of generated source code, allocated in POOL.
+   With a CHANGE_RATE of 0, the result depends on SEED only.  Otherwise,
+   every line has a 1 in CHANGE_RATE chance of being replaced by one
+   generated from CHANGE_SEED. */
+static svn_stringbuf_t *
+generate_text(int lines,
+              apr_uint32_t seed,
+              apr_uint32_t change_seed,
+              int change_rate,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < lines; ++i)
+    {
+      apr_uint32_t line_seed = next_random(&seed);
+      if (change_rate && next_random(&change_seed) % change_rate == 0)
+        line_seed = next_random(&change_seed);
+
+      append_line(result, i, &line_seed);
+    }
+
+  return result;
+}
+
+/* Write TEXT to a temporary file that will be removed when POOL gets
+   cleaned up.  Return its path. */
+static const char *
+write_temp_file(svn_stringbuf_t *text,
+                apr_pool_t *pool)
+{
+  const char *path;
+  svn_error_t *err = svn_io_write_unique(&path, NULL, text->data, text->len,
+                                         svn_io_file_del_on_pool_cleanup,
+                                         pool);
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "diff-bench: ");
+
+  return path;
+}
+
+/* Return the size of the file at PATH. */
+static apr_off_t
+file_size(const char *path,
+          apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err = svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool);
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "diff-bench: ");
+
+  return finfo.size;
+}
+
+/* Diff ORIGINAL against MODIFIED or, if LATEST is not NULL, merge all
+   three files using OPTIONS.  Return the time it took in *DURATION. */
+static void
+run_diff(apr_interval_time_t *duration,
+         const char *original,
+         const char *modified,
+         const char *latest,
+         const svn_diff_file_options_t *options,
+         apr_pool_t *pool)
+{
+  svn_diff_t *diff;
+  svn_error_t *err;
+  apr_time_t start = apr_time_now();
+
+  if (latest)
+    err = svn_diff_file_diff3_2(&diff, original, modified, latest, options,
+                                pool);
+  else
+    err = svn_diff_file_diff_2(&diff, original, modified, options, pool);
+
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "diff-bench: ");
+
+  *duration = apr_time_now() - start;
+}
+
+int
+main(int argc, char **argv)
+{
+  apr_pool_t *pool;
+  svn_diff_file_options_t *options;
+  const char *original;
+  const char *modified;
+  const char *latest = NULL;
+  apr_off_t total_size;
+  svn_boolean_t histogram = FALSE;
+  int repeat = 3;
+  int i;
+
+  while (argc > 1)
+    {
+      const char *const arg = argv[1];
+      if (arg[0] != '-')
+        break;
+
+      if (svn_ctype_isdigit(arg[1]))
+        repeat = atoi(arg + 1);
+      else if (strcmp(arg, "--histogram") == 0)
+        histogram = TRUE;
+      else
+        break;
+      --argc; ++argv;
+    }
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+  options = svn_diff_file_options_create(pool);
+  options->histogram = histogram;
+
+  if (argc == 1)
+    {
+      /* MODIFIED and LATEST contain different sparse changes. */
+      original = write_temp_file(generate_text(DEFAULT_LINES, 0x5eed,
+                                               0, 0, pool),
+                                 pool);
+      modified = write_temp_file(generate_text(DEFAULT_LINES, 0x5eed,
+                                               1, 1000, pool),
+                                 pool);
+      latest = write_temp_file(generate_text(DEFAULT_LINES, 0x5eed,
+                                             2, 1000, pool),
+                               pool);
+    }
+  else if (argc == 3 || argc == 4)
+    {
+      original = argv[1];
+      modified = argv[2];
+      if (argc == 4)
+        latest = argv[3];
+    }
+  else
+    {
+      fprintf(stderr,
+              "Usage: diff-bench [-<repeat>] [--histogram]\n"
+              "   or: diff-bench [-<repeat>] [--histogram] <original>"
+              " <modified> [<latest>]\n");
+      exit(1);
+    }
+
+  total_size = file_size(original, pool) + file_size(modified, pool);
+  for (i = 0; i < repeat; ++i)
+    {
+      apr_interval_time_t duration;
+      apr_pool_t *iterpool = svn_pool_create(pool);
+
+      run_diff(&duration, original, modified, NULL, options, iterpool);
+      printf("diff:  %" APR_OFF_T_FMT " bytes, %.1f ms, %.1f MB/s\n",
+             total_size, duration / 1000.0,
+             duration ? (double)total_size / duration : 0.0);
+
+      if (latest)
+        {
+          apr_off_t merge_size = total_size + file_size(latest, iterpool);
+
+          run_diff(&duration, original, modified, latest, options,
+                   iterpool);
+          printf("merge: %" APR_OFF_T_FMT " bytes, %.1f ms, %.1f MB/s\n",
+                 merge_size, duration / 1000.0,
+                 duration ? (double)merge_size / duration : 0.0);
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
@@ -2192,8 +2192,10 @@ test_diff4(apr_pool_t *pool)
 }
 
 
+/* Run trivial merges of random files using OPTIONS. */
 static svn_error_t *
-random_trivial_merge(apr_pool_t *pool)
+do_random_trivial_merge(const svn_diff_file_options_t *options,
+                        apr_pool_t *pool)
 {
   int i;
   apr_pool_t *subpool = svn_pool_create(pool);
@@ -2226,12 +2228,12 @@ random_trivial_merge(apr_pool_t *pool)
 
       SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename1,
                               contents1->data, contents2->data,
-                              contents1->data, contents2->data, NULL,
+                              contents1->data, contents2->data, options,
                               svn_diff_conflict_display_modified_latest,
                               subpool));
       SVN_ERR(three_way_merge(base_filename2, base_filename1, base_filename2,
                               contents2->data, contents1->data,
-                              contents2->data, contents1->data, NULL,
+                              contents2->data, contents1->data, options,
                               svn_diff_conflict_display_modified_latest,
                               subpool));
       svn_pool_clear(subpool);
@@ -2247,9 +2249,11 @@ random_trivial_merge(apr_pool_t *pool)
    for each selected line either adding an additional line, replacing the
    line, or deleting the line.  The two subsets are chosen so that each
    selected line is distinct and no two selected lines are adjacent. This
-   means the two sets of changes should merge without conflict.  */
+   means the two sets of changes should merge without conflict.  Use
+   OPTIONS for the merges. */
 static svn_error_t *
-random_three_way_merge(apr_pool_t *pool)
+do_random_three_way_merge(const svn_diff_file_options_t *options,
+                          apr_pool_t *pool)
 {
   int i;
   apr_pool_t *subpool = svn_pool_create(pool);
@@ -2303,12 +2307,12 @@ random_three_way_merge(apr_pool_t *pool)
 
       SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename3,
                               original->data, modified1->data,
-                              modified2->data, combined->data, NULL,
+                              modified2->data, combined->data, options,
                               svn_diff_conflict_display_modified_latest,
                               subpool));
       SVN_ERR(three_way_merge(base_filename1, base_filename3, base_filename2,
                               original->data, modified2->data,
-                              modified1->data, combined->data, NULL,
+                              modified1->data, combined->data, options,
                               svn_diff_conflict_display_modified_latest,
                               subpool));
 
@@ -2321,6 +2325,36 @@ random_three_way_merge(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+random_trivial_merge(apr_pool_t *pool)
+{
+  return do_random_trivial_merge(NULL, pool);
+}
+
+static svn_error_t *
+random_three_way_merge(apr_pool_t *pool)
+{
+  return do_random_three_way_merge(NULL, pool);
+}
+
+static svn_error_t *
+random_trivial_merge_histogram(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  options->histogram = TRUE;
+
+  return do_random_trivial_merge(options, pool);
+}
+
+static svn_error_t *
+random_three_way_merge_histogram(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  options->histogram = TRUE;
+
+  return do_random_three_way_merge(options, pool);
+}
+
 /* This is similar to random_three_way_merge above, except this time half
    of the original-to-modified1 changes are already present in modified2
    (or, equivalently, half the original-to-modified2 changes are already
@@ -2948,6 +2982,73 @@ two_way_issue_3362_v2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Regression test for the identical prefix scan stopping right at the end
+   of a chunk that is not the last one, and then claiming that one of the
+   files has been read completely.  In that case, the identical suffix was
+   not eliminated, which we detect by its effect on where the ambiguous
+   insertion of a REPEATED_LINE shows up in the diff.
+
+   The second line fills the first chunk up to its very end without any
+   eol, such that the remaining part of the chunk can be scanned in blocks
+   of 16 bytes.  The magic numbers used in this test, 1<<17 and 50, are
+   CHUNK_SIZE and SUFFIX_LINES_TO_KEEP from ../../libsvn_diff/diff_file.c,
+   respectively.
+ */
+#define REPEATED_LINE "repeated\n"
+static svn_error_t *
+test_identical_prefix_at_chunk_end(apr_pool_t *pool)
+{
+  apr_size_t chunk_size = 1 << 17;
+  svn_stringbuf_t *original, *modified;
+  int i;
+
+  original = svn_stringbuf_create_ensure(chunk_size + 1024, pool);
+  svn_stringbuf_appendcstr(original, "0123456789abcde\n");
+  while (original->len < chunk_size)
+    svn_stringbuf_appendbyte(original, 'x');
+  svn_stringbuf_appendcstr(original, "\nline_3\nline_4\nline_5\n");
+
+  modified = svn_stringbuf_dup(original, pool);
+  svn_stringbuf_appendcstr(original, "original\n");
+  svn_stringbuf_appendcstr(modified, "modified\n");
+
+  for (i = 0; i < 100; i++)
+    {
+      svn_stringbuf_appendcstr(original, REPEATED_LINE);
+      svn_stringbuf_appendcstr(modified, REPEATED_LINE);
+    }
+  svn_stringbuf_appendcstr(modified, REPEATED_LINE);
+
+  /* All but SUFFIX_LINES_TO_KEEP of the common REPEATED_LINEs at the end
+     are identical suffix.  The extra line gets inserted right before it. */
+  SVN_ERR(two_way_diff("prefix-chunk-end-original",
+                       "prefix-chunk-end-modified",
+                       original->data, modified->data,
+                       "--- prefix-chunk-end-original" NL
+                       "+++ prefix-chunk-end-modified" NL
+                       "@@ -3,7 +3,7 @@" NL
+                       " line_3\n"
+                       " line_4\n"
+                       " line_5\n"
+                       "-original\n"
+                       "+modified\n"
+                       " " REPEATED_LINE
+                       " " REPEATED_LINE
+                       " " REPEATED_LINE
+                       "@@ -54,6 +54,7 @@" NL
+                       " " REPEATED_LINE
+                       " " REPEATED_LINE
+                       " " REPEATED_LINE
+                       "+" REPEATED_LINE
+                       " " REPEATED_LINE
+                       " " REPEATED_LINE
+                       " " REPEATED_LINE,
+                       NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPEATED_LINE
+
 /* ========================================================================== */
 
 struct svn_test_descriptor_t test_funcs[] =
@@ -2987,5 +3088,11 @@ struct svn_test_descriptor_t test_funcs[] =
                    "2-way issue #3362 test v1"),
     SVN_TEST_PASS2(two_way_issue_3362_v2,
                    "2-way issue #3362 test v2"),
+    SVN_TEST_PASS2(random_trivial_merge_histogram,
+                   "random trivial merge, histogram diff"),
+    SVN_TEST_PASS2(random_three_way_merge_histogram,
+                   "random 3-way merge, histogram diff"),
+    SVN_TEST_PASS2(test_identical_prefix_at_chunk_end,
+                   "identical prefix ends at the end of a chunk"),
     SVN_TEST_NULL
   };
@@ -3793,6 +3793,19 @@ large_file_integrity(const svn_test_opts_t *opts,
 }
 
 
+static svn_error_t *
+huge_file_integrity(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  apr_uint32_t seed = (apr_uint32_t) apr_time_now();
+
+  /* Files of a few MB get their checksums calculated in a separate
+     thread by some backends, so test that. */
+  return file_integrity_helper(0x400001, &seed, opts,
+                               "test-repo-huge-file-integrity", pool);
+}
+
+
 static svn_error_t *
 check_root_revision(const svn_test_opts_t *opts,
                     apr_pool_t *pool)
@@ -5130,6 +5143,8 @@ struct svn_test_descriptor_t test_funcs[] =
                        "create and modify medium file"),
     SVN_TEST_OPTS_PASS(large_file_integrity,
                        "create and modify large file"),
+    SVN_TEST_OPTS_PASS(huge_file_integrity,
+                       "create and modify huge file"),
     SVN_TEST_OPTS_PASS(check_root_revision,
                        "ensure accurate storage of root node"),
     SVN_TEST_OPTS_PASS(test_node_created_rev,
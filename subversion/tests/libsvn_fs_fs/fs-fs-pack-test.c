@@ -23,13 +23,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "../svn_test.h"
 #include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/low_level.h"
+#include "../../libsvn_fs_fs/util.h"
 
 #include "svn_pools.h"
+#include "svn_hash.h"
 #include "svn_props.h"
 #include "svn_fs.h"
+#include "private/svn_atomic.h"
 #include "private/svn_string_private.h"
 
 #include "../svn_test_fs.h"
@@ -63,8 +69,12 @@ write_format(const char *path,
       else
         contents = apr_psprintf(pool,
                                 "%d\n"
-                                "layout linear",
+                                "layout linear\n",
                                 format);
+
+      if (format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
+        contents = apr_pstrcat(pool, contents, "addressing logical\n",
+                               SVN_VA_NULL);
     }
   else
     {
@@ -126,17 +136,17 @@ pack_notify(void *baton,
 
 #define R1_LOG_MSG "Let's serf"
 
-/* Create a packed filesystem in DIR.  Set the shard size to
+/* Create a filesystem in DIR but don't pack it.  Set the shard size to
    SHARD_SIZE and create NUM_REVS number of revisions (in addition to
    r0).  Use POOL for allocations.  After this function successfully
    completes, the filesystem's youngest revision number will be the
    same as NUM_REVS.  */
 static svn_error_t *
-create_packed_filesystem(const char *dir,
-                         const svn_test_opts_t *opts,
-                         int num_revs,
-                         int shard_size,
-                         apr_pool_t *pool)
+create_unpacked_filesystem(const char *dir,
+                           const svn_test_opts_t *opts,
+                           int num_revs,
+                           int shard_size,
+                           apr_pool_t *pool)
 {
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
@@ -144,7 +154,6 @@ create_packed_filesystem(const char *dir,
   const char *conflict;
   svn_revnum_t after_rev;
   apr_pool_t *subpool = svn_pool_create(pool);
-  struct pack_notify_baton pnb;
   apr_pool_t *iterpool;
   int version;
 
@@ -195,10 +204,39 @@ create_packed_filesystem(const char *dir,
   svn_pool_destroy(iterpool);
   svn_pool_destroy(subpool);
 
+  return SVN_NO_ERROR;
+}
+
+/* Like create_unpacked_filesystem but pack the filesystem afterwards.
+   Pack up to JOBS shards concurrently.  */
+static svn_error_t *
+create_packed_filesystem_jobs(const char *dir,
+                              const svn_test_opts_t *opts,
+                              int num_revs,
+                              int shard_size,
+                              int jobs,
+                              apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+
+  SVN_ERR(create_unpacked_filesystem(dir, opts, num_revs, shard_size, pool));
+
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
-  return svn_fs_pack(dir, pack_notify, &pnb, NULL, NULL, pool);
+  return svn_fs_pack2(dir, jobs, pack_notify, &pnb, NULL, NULL, pool);
+}
+
+/* Like create_packed_filesystem_jobs but pack in a single thread. */
+static svn_error_t *
+create_packed_filesystem(const char *dir,
+                         const svn_test_opts_t *opts,
+                         int num_revs,
+                         int shard_size,
+                         apr_pool_t *pool)
+{
+  return create_packed_filesystem_jobs(dir, opts, num_revs, shard_size, 1,
+                                       pool);
 }
 
 /* Create a packed FSFS filesystem for revprop tests at REPO_NAME with
@@ -233,7 +271,7 @@ prepare_revprop_repo(svn_fs_t **fs,
   svn_pool_destroy(subpool);
 
   /* Pack the repository. */
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, 1, NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -289,6 +327,7 @@ pack_filesystem(const svn_test_opts_t *opts,
   char buf[80];
   apr_file_t *file;
   apr_size_t len;
+  int format;
 
   /* Bail (with success) on known-untestable scenarios */
   if ((strcmp(opts->fs_type, "fsfs") != 0)
@@ -297,6 +336,9 @@ pack_filesystem(const svn_test_opts_t *opts,
 
   SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
                                    pool));
+  SVN_ERR(svn_io_read_version_file(&format,
+                                   svn_dirent_join(REPO_NAME, "format", pool),
+                                   pool));
 
   /* Check to see that the pack files exist, and that the rev directories
      don't. */
@@ -312,14 +354,42 @@ pack_filesystem(const svn_test_opts_t *opts,
         return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
                                  "Expected pack file '%s' not found", path);
 
-      path = svn_dirent_join_many(pool, REPO_NAME, "revs",
-                                  apr_psprintf(pool, "%d.pack", i / SHARD_SIZE),
-                                  "manifest", SVN_VA_NULL);
-      SVN_ERR(svn_io_check_path(path, &kind, pool));
-      if (kind != svn_node_file)
-        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
-                                 "Expected manifest file '%s' not found",
-                                 path);
+      /* Logically addressed pack files come with index files instead of
+         a manifest. */
+      if (format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
+        {
+          path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+                                      apr_psprintf(pool, "%d.pack",
+                                                   i / SHARD_SIZE),
+                                      "pack" PATH_EXT_L2P_INDEX, SVN_VA_NULL);
+          SVN_ERR(svn_io_check_path(path, &kind, pool));
+          if (kind != svn_node_file)
+            return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                     "Expected index file '%s' not found",
+                                     path);
+
+          path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+                                      apr_psprintf(pool, "%d.pack",
+                                                   i / SHARD_SIZE),
+                                      "pack" PATH_EXT_P2L_INDEX, SVN_VA_NULL);
+          SVN_ERR(svn_io_check_path(path, &kind, pool));
+          if (kind != svn_node_file)
+            return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                     "Expected index file '%s' not found",
+                                     path);
+        }
+      else
+        {
+          path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+                                      apr_psprintf(pool, "%d.pack",
+                                                   i / SHARD_SIZE),
+                                      "manifest", SVN_VA_NULL);
+          SVN_ERR(svn_io_check_path(path, &kind, pool));
+          if (kind != svn_node_file)
+            return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                     "Expected manifest file '%s' not found",
+                                     path);
+        }
 
       /* This directory should not exist. */
       path = svn_dirent_join_many(pool, REPO_NAME, "revs",
@@ -682,7 +752,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, subpool));
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
   svn_pool_destroy(subpool);
-  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 1, NULL, NULL, NULL, NULL, pool));
   SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
 
   /* Now, delete the youngest revprop file, and recover again.  This
@@ -890,6 +960,1032 @@ get_set_multiple_huge_revprops_packed_fs(const svn_test_opts_t *opts,
 #undef MAX_REV
 #undef SHARD_SIZE
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-pack-concurrently"
+#define SHARD_SIZE 3
+#define MAX_REV 31
+#define JOBS 4
+static svn_error_t *
+pack_filesystem_concurrently(const svn_test_opts_t *opts,
+                             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  const svn_fs_info_placeholder_t *info;
+  const svn_fs_fsfs_info_t *fsfs_info;
+  svn_stream_t *rstream;
+  svn_stringbuf_t *rstring;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 9)))
+    return SVN_NO_ERROR;
+
+  /* The notification callback checks that shards get reported in order. */
+  SVN_ERR(create_packed_filesystem_jobs(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                        JOBS, pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  /* All complete shards must have been packed. */
+  SVN_ERR(svn_fs_info(&info, fs, pool, pool));
+  fsfs_info = (const void *)info;
+  SVN_TEST_ASSERT(fsfs_info->min_unpacked_rev
+                  == ((MAX_REV + 1) / SHARD_SIZE) * SHARD_SIZE);
+
+  /* Contents must be the same as before packing. */
+  iterpool = svn_pool_create(pool);
+  for (i = 1; i < (MAX_REV + 1); i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *sb;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+
+      if (i == 1)
+        sb = svn_stringbuf_create("This is the file 'iota'.\n", iterpool);
+      else
+        sb = svn_stringbuf_create(get_rev_contents(i, iterpool), iterpool);
+
+      if (! svn_stringbuf_compare(rstring, sb))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Bad data in revision %ld.", i);
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+#undef JOBS
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-pack-while-frozen"
+#define SHARD_SIZE 3
+#define MAX_REV 11
+#define JOBS 2
+
+#if APR_HAS_THREADS
+
+/* Baton type used by pack_during_freeze. */
+typedef struct pack_while_frozen_baton_t
+{
+  /* The thread running the pack, if it has been started. */
+  apr_thread_t *thread;
+
+  /* Number of pack notifications received so far. */
+  svn_atomic_t notifications;
+
+  /* Result of the pack. */
+  svn_error_t *err;
+
+  /* Pool to create the pack thread in. */
+  apr_pool_t *pool;
+} pack_while_frozen_baton_t;
+
+/* Implements svn_fs_pack_notify_t.  Counts the notifications in the
+   pack_while_frozen_baton_t BATON. */
+static svn_error_t *
+count_pack_notifications(void *baton,
+                         apr_int64_t shard,
+                         svn_fs_pack_notify_action_t action,
+                         apr_pool_t *pool)
+{
+  pack_while_frozen_baton_t *b = baton;
+  svn_atomic_inc(&b->notifications);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function packing REPO_NAME with JOBS jobs.  DATA is a
+   pack_while_frozen_baton_t. */
+static void *
+APR_THREAD_FUNC pack_thread(apr_thread_t *tid, void *data)
+{
+  pack_while_frozen_baton_t *b = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  b->err = svn_fs_pack2(REPO_NAME, JOBS, count_pack_notifications, b,
+                        NULL, NULL, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Implements svn_fs_freeze_func_t.  Start packing REPO_NAME in another
+   thread and check that it does not touch any shard while we keep the
+   repository frozen.  BATON is a pack_while_frozen_baton_t. */
+static svn_error_t *
+start_pack_while_frozen(void *baton,
+                        apr_pool_t *pool)
+{
+  pack_while_frozen_baton_t *b = baton;
+  const char *revs_dir = svn_dirent_join(REPO_NAME, PATH_REVS_DIR, pool);
+  svn_node_kind_t kind;
+  apr_status_t status;
+
+  status = apr_thread_create(&b->thread, NULL, pack_thread, b, b->pool);
+  if (status)
+    {
+      b->thread = NULL;
+      return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  /* Give the pack plenty of time to get going, if it were not blocked. */
+  apr_sleep(APR_USEC_PER_SEC / 2);
+
+  SVN_TEST_ASSERT(svn_atomic_read(&b->notifications) == 0);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(revs_dir,
+                                            "0" PATH_EXT_PACKED_SHARD,
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(revs_dir, "0", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+static svn_error_t *
+pack_while_frozen(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_fs_t *fs;
+  const svn_fs_info_placeholder_t *info;
+  const svn_fs_fsfs_info_t *fsfs_info;
+  pack_while_frozen_baton_t b = { 0 };
+  svn_error_t *err;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 9)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_unpacked_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                     pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  /* Pack must wait for the freeze to end, including the removal of
+     the non-packed shards. */
+  b.pool = pool;
+  err = svn_fs_freeze(fs, start_pack_while_frozen, &b, pool);
+  if (b.thread)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, b.thread);
+      err = svn_error_compose_create(err, b.err);
+    }
+  SVN_ERR(err);
+
+  /* Once the freeze ended, pack must have completed normally. */
+  SVN_TEST_ASSERT(svn_atomic_read(&b.notifications) > 0);
+  SVN_ERR(svn_fs_info(&info, fs, pool, pool));
+  fsfs_info = (const void *)info;
+  SVN_TEST_ASSERT(fsfs_info->min_unpacked_rev
+                  == ((MAX_REV + 1) / SHARD_SIZE) * SHARD_SIZE);
+#endif
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+#undef JOBS
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-rep-cache-filter"
+#define FILE_COUNT 1100
+#define BIG_SIZE 0x10000
+static svn_error_t *
+rep_sharing_with_filter(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const char *conflict;
+  svn_revnum_t after_rev;
+  svn_stringbuf_t *big;
+  apr_finfo_t finfo;
+  apr_uint32_t seed = 0x1234;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 6)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Some contents that does not compress well. */
+  big = svn_stringbuf_create_ensure(BIG_SIZE, pool);
+  for (i = 0; i < BIG_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(big, (char)(seed >> 16));
+    }
+
+  /* Revision 1: enough new files for the FS to start using the filter,
+     plus one large file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *name;
+
+      svn_pool_clear(iterpool);
+      name = apr_psprintf(iterpool, "file%d", i);
+      SVN_ERR(svn_fs_make_file(txn_root, name, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, name,
+                                          apr_psprintf(iterpool, "%d\n", i),
+                                          iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_make_file(txn_root, "big", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "big", big->data, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
+
+  /* Revision 2: a copy of the large file's contents must be shared,
+     i.e. the filter must have picked up the keys added in r1. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, after_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "big2", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "big2", big->data, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
+
+  SVN_ERR(svn_io_stat(&finfo,
+                      svn_dirent_join_many(pool, REPO_NAME, "revs", "0",
+                                           "2", SVN_VA_NULL),
+                      APR_FINFO_SIZE, pool));
+  SVN_TEST_ASSERT(finfo.size < BIG_SIZE);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef FILE_COUNT
+#undef BIG_SIZE
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-fulltext-checkpoints"
+#define REV_COUNT 32
+#define BIG_SIZE 0x20000
+static svn_error_t *
+fulltext_checkpoints(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t after_rev;
+  svn_stringbuf_t *big;
+  svn_stringbuf_t *expected[REV_COUNT + 1];
+  apr_file_t *file;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_int64_t total_size = 0;
+  apr_uint32_t seed = 0x1234;
+  apr_pool_t *iterpool;
+  const char *config = "[" CONFIG_SECTION_CACHES "]\n"
+                       CONFIG_OPTION_CHECKPOINTS_SIZE " = 1\n";
+  int pass;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return SVN_NO_ERROR;
+
+  /* Limit the checkpoints to 1 MB and re-open the FS to pick that up. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  /* Some text that spans multiple delta windows. */
+  big = svn_stringbuf_create_ensure(BIG_SIZE, pool);
+  for (i = 0; i < BIG_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(big, (char)('a' + (seed >> 16) % 26));
+    }
+
+  /* Give a single file a long deltification history. */
+  iterpool = svn_pool_create(pool);
+  for (i = 1; i <= REV_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i - 1, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == 1)
+        SVN_ERR(svn_fs_make_file(root, "big", iterpool));
+
+      big->data[i * 997] = '*';
+      expected[i] = svn_stringbuf_dup(big, pool);
+      SVN_ERR(svn_test__set_file_contents(root, "big", big->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, iterpool));
+      SVN_TEST_ASSERT(after_rev == i);
+    }
+
+  /* Read all versions twice.  The second pass will find the checkpoints
+     written during the first one. */
+  for (pass = 0; pass < 2; ++pass)
+    for (i = REV_COUNT; i > 0; --i)
+      {
+        svn_stringbuf_t *contents;
+
+        svn_pool_clear(iterpool);
+        SVN_ERR(svn_fs_revision_root(&root, fs, i, iterpool));
+        SVN_ERR(svn_test__get_file_contents(root, "big", &contents,
+                                            iterpool));
+        SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[i]));
+      }
+  svn_pool_destroy(iterpool);
+
+  /* Checkpoints must have been written but stay within the limit. */
+  SVN_ERR(svn_io_get_dirents3(&dirents,
+                              svn_dirent_join(REPO_NAME,
+                                              PATH_CHECKPOINTS_DIR, pool),
+                              FALSE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) > 0);
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const svn_io_dirent2_t *dirent = svn__apr_hash_index_val(hi);
+      total_size += dirent->filesize;
+    }
+  SVN_TEST_ASSERT(total_size <= 0x100000);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef REV_COUNT
+#undef BIG_SIZE
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-fulltext-location"
+#define REV_COUNT 8
+#define BIG_SIZE 0x20000
+static svn_error_t *
+fulltext_location(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t after_rev;
+  svn_stringbuf_t *big;
+  svn_stringbuf_t *expected[REV_COUNT + 1];
+  apr_file_t *file;
+  apr_off_t offset;
+  svn_filesize_t length;
+  apr_uint32_t seed = 0x1234;
+  apr_pool_t *iterpool;
+  const char *config = "[" CONFIG_SECTION_CACHES "]\n"
+                       CONFIG_OPTION_CHECKPOINTS_SIZE " = 16\n";
+  const char *dir;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  int found = 0;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return SVN_NO_ERROR;
+
+  /* File contents are stored as deltas.  Enable checkpoints such that
+     there will be fulltexts to locate. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  big = svn_stringbuf_create_ensure(BIG_SIZE, pool);
+  for (i = 0; i < BIG_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(big, (char)('a' + (seed >> 16) % 26));
+    }
+
+  iterpool = svn_pool_create(pool);
+  for (i = 1; i <= REV_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i - 1, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == 1)
+        SVN_ERR(svn_fs_make_file(root, "big", iterpool));
+
+      big->data[i * 997] = '*';
+      expected[i] = svn_stringbuf_dup(big, pool);
+      SVN_ERR(svn_test__set_file_contents(root, "big", big->data,
+                                          iterpool));
+
+      /* Transaction contents may change and must never be located. */
+      SVN_ERR(svn_fs_file_fulltext_location(&file, &offset, &length,
+                                            root, "big",
+                                            iterpool, iterpool));
+      SVN_TEST_ASSERT(file == NULL);
+
+      SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, iterpool));
+      SVN_TEST_ASSERT(after_rev == i);
+    }
+
+  /* Reading all versions creates checkpoints for some of them.  Where a
+     fulltext can be located, it must match the contents. */
+  for (i = REV_COUNT; i > 0; --i)
+    {
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, i, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "big", &contents,
+                                          iterpool));
+
+      SVN_ERR(svn_fs_file_fulltext_location(&file, &offset, &length,
+                                            root, "big",
+                                            iterpool, iterpool));
+      if (file)
+        {
+          SVN_TEST_ASSERT(length == BIG_SIZE);
+          contents = svn_stringbuf_create_ensure(BIG_SIZE, iterpool);
+          SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, iterpool));
+          SVN_ERR(svn_io_file_read_full2(file, contents->data, BIG_SIZE,
+                                         &contents->len, NULL, iterpool));
+          SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[i]));
+          SVN_ERR(svn_io_file_close(file, iterpool));
+          ++found;
+        }
+    }
+
+  SVN_TEST_ASSERT(found > 0);
+
+  /* Checkpoints that have not been verified against the rep's checksum
+     must never be located, even if they have the right size.  Simulate
+     that by changing the checksum in their footers, which consist of the
+     MD5 digest followed by the 8 byte fulltext length. */
+  dir = svn_dirent_join(REPO_NAME, PATH_CHECKPOINTS_DIR, pool);
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, FALSE, pool, pool));
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const svn_io_dirent2_t *dirent = svn__apr_hash_index_val(hi);
+      apr_off_t md5_offset = dirent->filesize - APR_MD5_DIGESTSIZE - 8;
+      char c;
+
+      SVN_ERR(svn_io_file_open(&file, svn_dirent_join(dir, name, pool),
+                               APR_READ | APR_WRITE, APR_OS_DEFAULT, pool));
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &md5_offset, pool));
+      SVN_ERR(svn_io_file_getc(&c, file, pool));
+      c = (char)~c;
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &md5_offset, pool));
+      SVN_ERR(svn_io_file_putc(c, file, pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
+
+  for (i = REV_COUNT; i > 0; --i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_fulltext_location(&file, &offset, &length,
+                                            root, "big",
+                                            iterpool, iterpool));
+      SVN_TEST_ASSERT(file == NULL);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef REV_COUNT
+#undef BIG_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+/* Create an FSFS repository at REPO_NAME with fulltext checkpoints enabled
+ * and open it with FS_CONFIG.  Commit REV_COUNT versions of a single file
+ * "big" of BIG_SIZE bytes, each one a delta against its predecessor.
+ * Return the FS in *FS_P and the file contents in EXPECTED[1] through
+ * EXPECTED[REV_COUNT].  Allocate everything in POOL.
+ */
+static svn_error_t *
+create_checkpoint_test_repo(svn_fs_t **fs_p,
+                            svn_stringbuf_t **expected,
+                            const char *repo_name,
+                            int rev_count,
+                            apr_size_t big_size,
+                            apr_hash_t *fs_config,
+                            const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t after_rev;
+  svn_stringbuf_t *big;
+  apr_file_t *file;
+  apr_uint32_t seed = 0x1234;
+  apr_pool_t *iterpool;
+  const char *config = "[" CONFIG_SECTION_CACHES "]\n"
+                       CONFIG_OPTION_CHECKPOINTS_SIZE " = 16\n";
+  apr_size_t i;
+  int rev;
+
+  SVN_ERR(svn_test__create_fs(&fs, repo_name, opts, pool));
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(repo_name, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open(&fs, repo_name, fs_config, pool));
+
+  big = svn_stringbuf_create_ensure(big_size, pool);
+  for (i = 0; i < big_size; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(big, (char)('a' + (seed >> 16) % 26));
+    }
+
+  /* With the default settings, the first few versions of a file get
+     stored as linear delta chains. */
+  iterpool = svn_pool_create(pool);
+  for (rev = 1; rev <= rev_count; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (rev == 1)
+        SVN_ERR(svn_fs_make_file(root, "big", iterpool));
+
+      big->data[rev * 997] = '*';
+      expected[rev] = svn_stringbuf_dup(big, pool);
+      SVN_ERR(svn_test__set_file_contents(root, "big", big->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, iterpool));
+      SVN_TEST_ASSERT(after_rev == rev);
+    }
+  svn_pool_destroy(iterpool);
+
+  *fs_p = fs;
+  return SVN_NO_ERROR;
+}
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-fulltext-checkpoint-of-base"
+#define REV_COUNT 10
+#define BASE_REV 6
+#define BIG_SIZE 0x20000
+static svn_error_t *
+fulltext_checkpoint_of_base(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *contents;
+  svn_stringbuf_t *expected[REV_COUNT + 1];
+  apr_hash_t *dirents;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_time_t mtime;
+  const char *dir;
+  const char *path;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return SVN_NO_ERROR;
+
+  /* BASE_REV is part of the delta chain of REV_COUNT.  Cached combined
+     windows would shorten the delta chains, so don't cache any. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS, "0");
+  SVN_ERR(create_checkpoint_test_repo(&fs, expected, REPO_NAME, REV_COUNT,
+                                      BIG_SIZE, fs_config, opts, pool));
+
+  /* Reading BASE_REV leaves a checkpoint for it and no other. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, BASE_REV, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "big", &contents, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[BASE_REV]));
+
+  dir = svn_dirent_join(REPO_NAME, PATH_CHECKPOINTS_DIR, pool);
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, FALSE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+  path = svn_dirent_join(dir,
+                         svn__apr_hash_index_key(apr_hash_first(pool,
+                                                                dirents)),
+                         pool);
+
+  /* Reading REV_COUNT must use that checkpoint in the middle of its delta
+     chain, which marks it as recently used. */
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_from_sec(1000), path,
+                                        pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, REV_COUNT, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "big", &contents, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[REV_COUNT]));
+
+  SVN_ERR(svn_io_file_affected_time(&mtime, path, pool));
+  SVN_TEST_ASSERT(mtime > apr_time_from_sec(1000));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef REV_COUNT
+#undef BASE_REV
+#undef BIG_SIZE
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-damaged-fulltext-checkpoint"
+#define REV_COUNT 8
+#define BASE_REV 6
+#define BIG_SIZE 0x20000
+static svn_error_t *
+damaged_fulltext_checkpoint(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *contents;
+  svn_stringbuf_t *expected[REV_COUNT + 1];
+  apr_file_t *file;
+  apr_hash_t *dirents;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_node_kind_t kind;
+  const svn_io_dirent2_t *dirent;
+  const char *dir;
+  const char *path;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return SVN_NO_ERROR;
+
+  /* Make sure that all reads go through the delta chains. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS, "0");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, "0");
+  SVN_ERR(create_checkpoint_test_repo(&fs, expected, REPO_NAME, REV_COUNT,
+                                      BIG_SIZE, fs_config, opts, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, BASE_REV, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "big", &contents, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[BASE_REV]));
+
+  dir = svn_dirent_join(REPO_NAME, PATH_CHECKPOINTS_DIR, pool);
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, FALSE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+  path = svn_dirent_join(dir,
+                         svn__apr_hash_index_key(apr_hash_first(pool,
+                                                                dirents)),
+                         pool);
+
+  /* Truncate the checkpoint. */
+  SVN_ERR(svn_io_file_open(&file, path, APR_WRITE, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_trunc(file, BIG_SIZE / 2, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Reading a rep that has the damaged checkpoint in its delta chain must
+     ignore and remove that checkpoint. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, REV_COUNT, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "big", &contents, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[REV_COUNT]));
+
+  SVN_ERR(svn_io_check_path(path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Truncate the checkpoint that has just been written for REV_COUNT.
+     Reading that rep again must rebuild it from the delta chain. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, FALSE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+  path = svn_dirent_join(dir,
+                         svn__apr_hash_index_key(apr_hash_first(pool,
+                                                                dirents)),
+                         pool);
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_WRITE, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_trunc(file, BIG_SIZE / 2, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, REV_COUNT, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "big", &contents, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, expected[REV_COUNT]));
+
+  SVN_ERR(svn_io_stat_dirent2(&dirent, path, FALSE, FALSE, pool, pool));
+  SVN_TEST_ASSERT(dirent->filesize > BIG_SIZE);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef REV_COUNT
+#undef BASE_REV
+#undef BIG_SIZE
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-pack-item-order"
+#define SHARD_SIZE 4
+#define MAX_REV 5
+
+/* An item in a rev or pack file together with its contents. */
+typedef struct pack_test_item_t
+{
+  svn_fs_fs__p2l_entry_t entry;
+  svn_stringbuf_t *contents;
+} pack_test_item_t;
+
+/* Return a key that identifies the item ENTRY in hashes.
+ * Allocate the result in POOL. */
+static const char *
+item_key(const svn_fs_fs__p2l_entry_t *entry,
+         apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%ld/%" APR_UINT64_T_FMT,
+                      entry->item.revision, entry->item.number);
+}
+
+/* Walk the p2l index of the rev or pack file at PATH in FS, which
+ * contains REVISION, and return all items in that file as
+ * pack_test_item_t * in *ITEMS, in file order.  Verify that the index
+ * entries cover the whole file without gaps or overlaps.  Allocate the
+ * result in POOL.
+ */
+static svn_error_t *
+read_file_items(apr_array_header_t **items,
+                svn_fs_t *fs,
+                svn_revnum_t revision,
+                const char *path,
+                apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  apr_file_t *file;
+  apr_off_t offset = 0;
+
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool));
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_BINARY,
+                           APR_OS_DEFAULT, pool));
+
+  *items = apr_array_make(pool, 64, sizeof(pack_test_item_t *));
+  while (offset < finfo.size)
+    {
+      apr_array_header_t *entries;
+      apr_off_t cluster_start = offset;
+      int i;
+
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, revision, offset,
+                                          pool));
+      for (i = 0; i < entries->nelts && offset < finfo.size; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+          pack_test_item_t *item;
+          apr_off_t item_offset = entry->offset;
+
+          /* skip the entry that we already saw in the previous cluster */
+          if (entry->offset < offset)
+            continue;
+
+          SVN_TEST_ASSERT(entry->offset == offset);
+          SVN_TEST_ASSERT(entry->offset + entry->size <= finfo.size);
+
+          item = apr_pcalloc(pool, sizeof(*item));
+          item->entry = *entry;
+          item->contents = svn_stringbuf_create_ensure((apr_size_t)entry->size,
+                                                       pool);
+          SVN_ERR(svn_io_file_seek(file, SEEK_SET, &item_offset, pool));
+          SVN_ERR(svn_io_file_read_full2(file, item->contents->data,
+                                         (apr_size_t)entry->size,
+                                         NULL, NULL, pool));
+          item->contents->len = (apr_size_t)entry->size;
+          item->contents->data[entry->size] = '\0';
+
+          APR_ARRAY_PUSH(*items, pack_test_item_t *) = item;
+          offset += entry->size;
+        }
+
+      /* The index must let us make progress. */
+      SVN_TEST_ASSERT(offset > cluster_start);
+    }
+
+  SVN_TEST_ASSERT(offset == finfo.size);
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+/* Return the placement group of an item of TYPE in a log-addressed pack
+ * file.  Groups must appear in ascending order. */
+static int
+item_group(unsigned type)
+{
+  switch (type)
+    {
+      case SVN_FS_FS__ITEM_TYPE_CHANGES:    return 0;
+      case SVN_FS_FS__ITEM_TYPE_FILE_PROPS: return 1;
+      case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:  return 2;
+      default:                              return 3;
+    }
+}
+
+static svn_error_t *
+pack_item_order(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  int format;
+  svn_revnum_t rev;
+  apr_hash_t *unpacked = apr_hash_make(pool);
+  apr_hash_t *placed = apr_hash_make(pool);
+  apr_array_header_t *packed;
+  pack_test_item_t *previous = NULL;
+  pack_test_item_t *previous_unreferenced = NULL;
+  const char *expected_next = NULL;
+  const char *previous_path = NULL;
+  svn_boolean_t in_chain = FALSE;
+  int group = 0;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 9)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_unpacked_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                     pool));
+  SVN_ERR(svn_io_read_version_file(&format,
+                                   svn_dirent_join(REPO_NAME, "format", pool),
+                                   pool));
+  if (format < SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
+    return SVN_NO_ERROR;
+
+  /* Remember all items of the first shard before packing it. */
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  for (rev = 0; rev < SHARD_SIZE; ++rev)
+    {
+      apr_array_header_t *items;
+      SVN_ERR(read_file_items(&items, fs, rev,
+                              svn_fs_fs__path_rev(fs, rev, pool), pool));
+
+      for (i = 0; i < items->nelts; ++i)
+        {
+          pack_test_item_t *item = APR_ARRAY_IDX(items, i,
+                                                 pack_test_item_t *);
+          if (item->entry.type != SVN_FS_FS__ITEM_TYPE_UNUSED)
+            svn_hash_sets(unpacked, item_key(&item->entry, pool), item);
+        }
+    }
+
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(read_file_items(&packed, fs, 0,
+                          svn_fs_fs__path_rev_packed(fs, 0, PATH_PACKED,
+                                                     pool),
+                          pool));
+
+  for (i = 0; i < packed->nelts; ++i)
+    {
+      pack_test_item_t *item = APR_ARRAY_IDX(packed, i, pack_test_item_t *);
+      pack_test_item_t *original;
+      const char *key;
+      apr_off_t offset;
+      apr_size_t k;
+
+      /* Padding must be NULs only and may appear anywhere. */
+      if (item->entry.type == SVN_FS_FS__ITEM_TYPE_UNUSED)
+        {
+          for (k = 0; k < item->contents->len; ++k)
+            SVN_TEST_ASSERT(item->contents->data[k] == 0);
+          continue;
+        }
+
+      /* Each item must be copied exactly once and unmodified. */
+      key = item_key(&item->entry, pool);
+      original = svn_hash_gets(unpacked, key);
+      SVN_TEST_ASSERT(original);
+      SVN_TEST_ASSERT(original->entry.type == item->entry.type);
+      SVN_TEST_ASSERT(svn_stringbuf_compare(original->contents,
+                                            item->contents));
+      svn_hash_sets(unpacked, key, NULL);
+      svn_hash_sets(placed, key, item);
+
+      /* The l2p index must agree with the p2l index. */
+      SVN_ERR(svn_fs_fs__item_offset(&offset, fs, item->entry.item.revision,
+                                     NULL, item->entry.item.number, pool));
+      SVN_TEST_ASSERT(offset == item->entry.offset);
+
+      /* Changes come first, then file props, then dir props.  Within each
+       * of these groups, newer items precede older ones. */
+      SVN_TEST_ASSERT(item_group(item->entry.type) >= group);
+      if (   item_group(item->entry.type) == group && group < 3
+          && previous)
+        SVN_TEST_ASSERT(svn_fs_fs__id_part_compare(&previous->entry.item,
+                                                   &item->entry.item) > 0);
+      group = item_group(item->entry.type);
+      previous = item;
+
+      if (group < 3)
+        continue;
+
+      /* A noderev or a delta base reached through a noderev must be
+       * followed by the data rep resp. delta base it refers to. */
+      if (expected_next)
+        {
+          SVN_TEST_STRING_ASSERT(key, expected_next);
+          in_chain = TRUE;
+        }
+      else
+        {
+          in_chain = FALSE;
+        }
+      expected_next = NULL;
+
+      if (item->entry.type == SVN_FS_FS__ITEM_TYPE_NODEREV)
+        {
+          node_revision_t *noderev;
+          SVN_ERR(svn_fs_fs__read_noderev(&noderev,
+                            svn_stream_from_stringbuf(item->contents, pool),
+                            pool));
+
+          /* Noderevs are placed in reverse path order and before all
+           * reps that no noderev or delta chain referenced. */
+          SVN_TEST_ASSERT(!previous_unreferenced);
+          SVN_TEST_ASSERT(!previous_path
+                          || strcmp(previous_path, noderev->created_path)
+                             >= 0);
+          previous_path = noderev->created_path;
+
+          if (noderev->data_rep)
+            {
+              svn_fs_fs__p2l_entry_t rep;
+              rep.item.revision = noderev->data_rep->revision;
+              rep.item.number = noderev->data_rep->offset;
+              key = item_key(&rep, pool);
+              if (!svn_hash_gets(placed, key))
+                expected_next = key;
+            }
+        }
+      else
+        {
+          SVN_TEST_ASSERT(   item->entry.type == SVN_FS_FS__ITEM_TYPE_FILE_REP
+                          || item->entry.type == SVN_FS_FS__ITEM_TYPE_DIR_REP);
+
+          /* Reps not reached through a noderev come last, in revision
+           * order. */
+          if (!in_chain)
+            {
+              SVN_TEST_ASSERT(!previous_unreferenced
+                              || svn_fs_fs__id_part_compare(
+                                   &previous_unreferenced->entry.item,
+                                   &item->entry.item) < 0);
+              previous_unreferenced = item;
+            }
+          else
+            {
+              svn_fs_fs__rep_header_t *header;
+              SVN_ERR(svn_fs_fs__read_rep_header(&header,
+                            svn_stream_from_stringbuf(item->contents, pool),
+                            pool));
+
+              if (header->type == svn_fs_fs__rep_delta)
+                {
+                  svn_fs_fs__p2l_entry_t base;
+                  base.item.revision = header->base_revision;
+                  base.item.number = header->base_offset;
+                  key = item_key(&base, pool);
+                  if (!svn_hash_gets(placed, key))
+                    expected_next = key;
+                }
+            }
+        }
+    }
+
+  /* Nothing may have been lost. */
+  SVN_TEST_ASSERT(expected_next == NULL);
+  SVN_TEST_ASSERT(apr_hash_count(unpacked) == 0);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -921,5 +2017,21 @@ struct svn_test_descriptor_t test_funcs[] =
                        "test packing with shard size = 1"),
     SVN_TEST_OPTS_PASS(get_set_multiple_huge_revprops_packed_fs,
                        "set multiple huge revprops in packed FSFS"),
+    SVN_TEST_OPTS_PASS(pack_filesystem_concurrently,
+                       "pack FSFS shards concurrently"),
+    SVN_TEST_OPTS_PASS(pack_while_frozen,
+                       "pack FSFS while the repository is frozen"),
+    SVN_TEST_OPTS_PASS(rep_sharing_with_filter,
+                       "rep-sharing with rep-cache filter"),
+    SVN_TEST_OPTS_PASS(fulltext_checkpoints,
+                       "read long delta chains via fulltext checkpoints"),
+    SVN_TEST_OPTS_PASS(fulltext_location,
+                       "locate fulltexts for zero-copy delivery"),
+    SVN_TEST_OPTS_PASS(fulltext_checkpoint_of_base,
+                       "use fulltext checkpoints of delta bases"),
+    SVN_TEST_OPTS_PASS(damaged_fulltext_checkpoint,
+                       "rebuild damaged fulltext checkpoints"),
+    SVN_TEST_OPTS_PASS(pack_item_order,
+                       "item order and indexes of packed FSFS f7 shards"),
     SVN_TEST_NULL
   };
@@ -119,13 +119,14 @@ pack_notify(void *baton,
    SHARD_SIZE and create NUM_REVS number of revisions (in addition to
    r0).  Use POOL for allocations.  After this function successfully
    completes, the filesystem's youngest revision number will be the
-   same as NUM_REVS.  */
+   same as NUM_REVS.  Pack up to JOBS shards concurrently.  */
 static svn_error_t *
-create_packed_filesystem(const char *dir,
-                         const svn_test_opts_t *opts,
-                         int num_revs,
-                         int shard_size,
-                         apr_pool_t *pool)
+create_packed_filesystem_jobs(const char *dir,
+                              const svn_test_opts_t *opts,
+                              int num_revs,
+                              int shard_size,
+                              int jobs,
+                              apr_pool_t *pool)
 {
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
@@ -182,7 +183,19 @@ create_packed_filesystem(const char *dir,
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
-  return svn_fs_pack(dir, pack_notify, &pnb, NULL, NULL, pool);
+  return svn_fs_pack2(dir, jobs, pack_notify, &pnb, NULL, NULL, pool);
+}
+
+/* Like create_packed_filesystem_jobs but pack in a single thread. */
+static svn_error_t *
+create_packed_filesystem(const char *dir,
+                         const svn_test_opts_t *opts,
+                         int num_revs,
+                         int shard_size,
+                         apr_pool_t *pool)
+{
+  return create_packed_filesystem_jobs(dir, opts, num_revs, shard_size, 1,
+                                       pool);
 }
 
 /* Create a packed FSFS filesystem for revprop tests at REPO_NAME with
@@ -217,7 +230,7 @@ prepare_revprop_repo(svn_fs_t **fs,
   svn_pool_destroy(subpool);
 
   /* Pack the repository. */
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, 1, NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -714,7 +727,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, subpool));
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
   svn_pool_destroy(subpool);
-  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 1, NULL, NULL, NULL, NULL, pool));
   SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
 
   /* Now, delete the youngest revprop file, and recover again.  This
@@ -933,6 +946,72 @@ pack_shard_size_one(const svn_test_opts_t *opts,
 #undef REPO_NAME
 #undef SHARD_SIZE
 #undef MAX_REV
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsx-pack-concurrently"
+#define SHARD_SIZE 3
+#define MAX_REV 31
+#define JOBS 4
+static svn_error_t *
+pack_filesystem_concurrently(const svn_test_opts_t *opts,
+                             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  const svn_fs_info_placeholder_t *info;
+  const svn_fs_fsx_info_t *fsx_info;
+  svn_stream_t *rstream;
+  svn_stringbuf_t *rstring;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsx") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 9)))
+    return SVN_NO_ERROR;
+
+  /* The notification callback checks that shards get reported in order. */
+  SVN_ERR(create_packed_filesystem_jobs(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                        JOBS, pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  /* All complete shards must have been packed. */
+  SVN_ERR(svn_fs_info(&info, fs, pool, pool));
+  fsx_info = (const void *)info;
+  SVN_TEST_ASSERT(fsx_info->min_unpacked_rev
+                  == ((MAX_REV + 1) / SHARD_SIZE) * SHARD_SIZE);
+
+  /* Contents must be the same as before packing. */
+  iterpool = svn_pool_create(pool);
+  for (i = 1; i < (MAX_REV + 1); i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *sb;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+
+      if (i == 1)
+        sb = svn_stringbuf_create("This is the file 'iota'.\n", iterpool);
+      else
+        sb = svn_stringbuf_create(get_rev_contents(i, iterpool), iterpool);
+
+      if (! svn_stringbuf_compare(rstring, sb))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Bad data in revision %ld.", i);
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+#undef JOBS
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -964,5 +1043,7 @@ struct svn_test_descriptor_t test_funcs[] =
                        "test representations container"),
     SVN_TEST_OPTS_PASS(pack_shard_size_one,
                        "test packing with shard size = 1"),
+    SVN_TEST_OPTS_PASS(pack_filesystem_concurrently,
+                       "pack FSX shards concurrently"),
     SVN_TEST_NULL
   };
@@ -31,10 +31,15 @@
 
 #include "svn_error.h"
 #include "svn_delta.h"
+#include "svn_hash.h"
+#include "svn_props.h"
 #include "svn_ra.h"
 #include "svn_pools.h"
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
+#include "svn_ra_svn.h"
+
+#include "private/svn_ra_svn_private.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -94,7 +99,30 @@ commit_changes(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Set *SVNSERVE to the absolute path of the svnserve binary in the build
+   tree.  Return SVN_ERR_TEST_FAILED if it does not exist. */
+static svn_error_t *
+find_svnserve(const char **svnserve,
+              apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_dirent_get_absolute(svnserve, "../../svnserve/svnserve",
+                                  pool));
+#ifdef WIN32
+  *svnserve = apr_pstrcat(pool, *svnserve, ".exe", SVN_VA_NULL);
+#endif
+  SVN_ERR(svn_io_check_path(*svnserve, &kind, pool));
+  if (kind != svn_node_file)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Could not find svnserve at %s",
+                             svn_dirent_local_style(*svnserve, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_boolean_t last_tunnel_check;
+static svn_boolean_t tunnel_compress_stream;
 static int tunnel_open_count;
 static void *check_tunnel_baton;
 static void *open_tunnel_context;
@@ -119,20 +147,15 @@ open_tunnel(apr_file_t **request, apr_file_t **response,
   apr_proc_t *proc;
   apr_procattr_t *attr;
   apr_status_t status;
-  const char *args[] = { "svnserve", "-t", "-r", ".", NULL };
+  const char *args[] = { "svnserve", "-t", "-r", ".", NULL, NULL };
   const char *svnserve;
 
   SVN_TEST_ASSERT(tunnel_baton == check_tunnel_baton);
 
-  SVN_ERR(svn_dirent_get_absolute(&svnserve, "../../svnserve/svnserve", pool));
-#ifdef WIN32
-  svnserve = apr_pstrcat(pool, svnserve, ".exe", SVN_VA_NULL);
-#endif
-  SVN_ERR(svn_io_check_path(svnserve, &kind, pool));
-  if (kind != svn_node_file)
-    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
-                             "Could not find svnserve at %s",
-                             svn_dirent_local_style(svnserve, pool));
+  if (tunnel_compress_stream)
+    args[4] = "--compress-stream";
+
+  SVN_ERR(find_svnserve(&svnserve, pool));
 
   status = apr_procattr_create(&attr, pool);
   if (status == APR_SUCCESS)
@@ -176,6 +199,152 @@ close_tunnel(void *tunnel_context, void *tunnel_baton,
   return SVN_NO_ERROR;
 }
 
+/* Set *SOCK to a new TCP socket connected to PORT on the local host.
+   Allocate it in POOL. */
+static svn_error_t *
+connect_socket(apr_socket_t **sock,
+               apr_port_t port,
+               apr_pool_t *pool)
+{
+  apr_sockaddr_t *sa;
+  apr_status_t status;
+
+  status = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, port, 0, pool);
+  if (status == APR_SUCCESS)
+    status = apr_socket_create(sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
+                               pool);
+  if (status == APR_SUCCESS)
+    {
+      status = apr_socket_connect(*sock, sa);
+      if (status)
+        apr_socket_close(*sock);
+    }
+  if (status)
+    return svn_error_wrap_apr(status, "Could not connect to port %d",
+                              (int)port);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SERVER and *CLIENT to the two ends of a new TCP connection on the
+   local host.  Allocate them in POOL. */
+static svn_error_t *
+create_socket_pair(apr_socket_t **server,
+                   apr_socket_t **client,
+                   apr_pool_t *pool)
+{
+  apr_sockaddr_t *sa;
+  apr_socket_t *listener;
+  apr_status_t status;
+
+  status = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, pool);
+  if (status == APR_SUCCESS)
+    status = apr_socket_create(&listener, sa->family, SOCK_STREAM,
+                               APR_PROTO_TCP, pool);
+  if (status == APR_SUCCESS)
+    status = apr_socket_bind(listener, sa);
+  if (status == APR_SUCCESS)
+    status = apr_socket_listen(listener, 1);
+  if (status == APR_SUCCESS)
+    status = apr_socket_addr_get(&sa, APR_LOCAL, listener);
+  if (status)
+    return svn_error_wrap_apr(status, "Could not create listening socket");
+
+  SVN_ERR(connect_socket(client, sa->port, pool));
+
+  status = apr_socket_accept(server, listener, pool);
+  apr_socket_close(listener);
+  if (status)
+    return svn_error_wrap_apr(status, "Could not accept connection");
+
+  return SVN_NO_ERROR;
+}
+
+/* Start svnserve as a daemon in the foreground, serving the current
+   directory on a free port of the local host, with the NULL-terminated
+   list of additional EXTRA_ARGS.  Set *PORT to the port it listens on.
+   The server gets killed when POOL is cleaned up.  Return
+   SVN_ERR_TEST_FAILED if svnserve could not be found or did not start
+   serving. */
+static svn_error_t *
+start_svnserve_daemon(apr_port_t *port,
+                      const char *const *extra_args,
+                      apr_pool_t *pool)
+{
+  apr_proc_t *proc;
+  apr_procattr_t *attr;
+  apr_sockaddr_t *sa;
+  apr_socket_t *sock;
+  apr_status_t status;
+  apr_array_header_t *args = apr_array_make(pool, 16, sizeof(const char *));
+  const char *svnserve;
+  int i;
+
+  SVN_ERR(find_svnserve(&svnserve, pool));
+
+  /* Let the OS pick a port that is not in use. */
+  status = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, pool);
+  if (status == APR_SUCCESS)
+    status = apr_socket_create(&sock, sa->family, SOCK_STREAM,
+                               APR_PROTO_TCP, pool);
+  if (status == APR_SUCCESS)
+    {
+      status = apr_socket_bind(sock, sa);
+      if (status == APR_SUCCESS)
+        status = apr_socket_addr_get(&sa, APR_LOCAL, sock);
+      apr_socket_close(sock);
+    }
+  if (status)
+    return svn_error_wrap_apr(status, "Could not find a free port");
+  *port = sa->port;
+
+  APR_ARRAY_PUSH(args, const char *) = "svnserve";
+  APR_ARRAY_PUSH(args, const char *) = "-d";
+  APR_ARRAY_PUSH(args, const char *) = "--foreground";
+  APR_ARRAY_PUSH(args, const char *) = "--listen-host";
+  APR_ARRAY_PUSH(args, const char *) = "127.0.0.1";
+  APR_ARRAY_PUSH(args, const char *) = "--listen-port";
+  APR_ARRAY_PUSH(args, const char *) = apr_psprintf(pool, "%d", (int)*port);
+  APR_ARRAY_PUSH(args, const char *) = "-r";
+  APR_ARRAY_PUSH(args, const char *) = ".";
+  for (; *extra_args; ++extra_args)
+    APR_ARRAY_PUSH(args, const char *) = *extra_args;
+  APR_ARRAY_PUSH(args, const char *) = NULL;
+
+  status = apr_procattr_create(&attr, pool);
+  if (status == APR_SUCCESS)
+    status = apr_procattr_cmdtype_set(attr, APR_PROGRAM);
+  proc = apr_palloc(pool, sizeof(*proc));
+  if (status == APR_SUCCESS)
+    status = apr_proc_create(proc,
+                             svn_dirent_local_style(svnserve, pool),
+                             (const char *const *)args->elts, NULL, attr,
+                             pool);
+  if (status != APR_SUCCESS)
+    return svn_error_wrap_apr(status, "Could not run svnserve");
+  apr_pool_note_subprocess(pool, proc, APR_KILL_ALWAYS);
+
+  /* Wait for the server to accept connections. */
+  for (i = 0; i < 100; ++i)
+    {
+      svn_error_t *err = connect_socket(&sock, *port, pool);
+      if (!err)
+        {
+          apr_socket_close(sock);
+          return SVN_NO_ERROR;
+        }
+      svn_error_clear(err);
+
+      if (apr_proc_wait(proc, NULL, NULL, APR_NOWAIT) == APR_CHILD_DONE)
+        break;
+
+      apr_sleep(100000);
+    }
+
+  return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                          "svnserve did not start serving");
+}
+
 
 
 
@@ -323,6 +492,491 @@ tunel_callback_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test svn_ra_stat_many() and svn_ra_get_props_many() over ra_svn,
+   where the commands get pipelined. */
+static svn_error_t *
+batch_test(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-batch";
+  svn_repos_t *repos;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  apr_array_header_t *paths = apr_array_make(pool, 3, sizeof(const char *));
+  apr_hash_t *dirents;
+  apr_hash_t *props;
+  svn_dirent_t *dirent;
+  svn_string_t *value;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", repos_name, SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = check_tunnel_baton = &cbtable;
+  SVN_ERR(svn_cmdline_create_auth_baton(&cbtable->auth_baton,
+                                        TRUE  /* non_interactive */,
+                                        "jrandom", "rayjandom",
+                                        NULL,
+                                        TRUE  /* no_auth_cache */,
+                                        FALSE /* trust_server_cert */,
+                                        NULL, NULL, NULL, pool));
+
+  err = svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL, pool);
+  if (err && err->apr_err == SVN_ERR_TEST_FAILED)
+    {
+      svn_handle_error2(err, stderr, FALSE, "svn_tests: ");
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+  SVN_ERR(commit_changes(session, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "B";
+
+  SVN_ERR(svn_ra_stat_many(session, &dirents, paths, 1, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 2);
+  dirent = svn_hash_gets(dirents, "");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  dirent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  SVN_TEST_ASSERT(dirent->created_rev == 1);
+
+  /* All commands of the batch fail.  The connection must stay in sync. */
+  err = svn_ra_stat_many(session, &dirents, paths, 42, pool, pool);
+  SVN_TEST_ASSERT(err != SVN_NO_ERROR);
+  svn_error_clear(err);
+
+  SVN_ERR(svn_ra_stat_many(session, &dirents, paths, 0, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "") != NULL);
+
+  SVN_TEST_ASSERT_ERROR(svn_ra_get_props_many(session, &props, paths,
+                                              SVN_INVALID_REVNUM,
+                                              pool, pool),
+                        SVN_ERR_FS_NOT_FOUND);
+
+  apr_array_pop(paths);
+  SVN_ERR(svn_ra_get_props_many(session, &props, paths, SVN_INVALID_REVNUM,
+                                pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(props) == 2);
+  value = svn_hash_gets(svn_hash_gets(props, "A"),
+                        SVN_PROP_ENTRY_COMMITTED_REV);
+  SVN_TEST_STRING_ASSERT(value ? value->data : NULL, "1");
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that a pipelined batch containing several paths that authz denies
+   fails without leaving responses behind on the connection. */
+static svn_error_t *
+denied_batch_test(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-denied-batch";
+  const char *const args[] = { NULL };
+  svn_repos_t *repos;
+  const char *conf_path;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  apr_hash_t *dirents;
+  apr_hash_t *props;
+  svn_dirent_t *dirent;
+  apr_port_t port;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+
+  /* Anonymous users may read everything but /A and /B.  Without any
+     way to authenticate, the server will announce pipelining. */
+  conf_path = svn_repos_svnserve_conf(repos, pool);
+  SVN_ERR(svn_io_remove_file2(conf_path, TRUE, pool));
+  SVN_ERR(svn_io_file_create(conf_path,
+                             "[general]\n"
+                             "anon-access = read\n"
+                             "authz-db = authz\n",
+                             pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(svn_repos_conf_dir(repos, pool),
+                                             "authz", pool),
+                             "[/]\n"
+                             "* = r\n"
+                             "[/A]\n"
+                             "* =\n"
+                             "[/B]\n"
+                             "* =\n",
+                             pool));
+
+  err = start_svnserve_daemon(&port, args, pool);
+  if (err && err->apr_err == SVN_ERR_TEST_FAILED)
+    {
+      svn_handle_error2(err, stderr, FALSE, "svn_tests: ");
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  url = apr_psprintf(pool, "svn://127.0.0.1:%d/%s", (int)port, repos_name);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_cmdline_create_auth_baton(&cbtable->auth_baton,
+                                        TRUE  /* non_interactive */,
+                                        NULL, NULL, NULL,
+                                        TRUE  /* no_auth_cache */,
+                                        FALSE /* trust_server_cert */,
+                                        NULL, NULL, NULL, pool));
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       pool));
+
+  /* The commands for /A and /B are refused, the ones for the other
+     paths are still in flight when the first error arrives. */
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "B";
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  SVN_TEST_ASSERT_ERROR(svn_ra_stat_many(session, &dirents, paths, 0,
+                                         pool, pool),
+                        SVN_ERR_RA_NOT_AUTHORIZED);
+  SVN_TEST_ASSERT_ERROR(svn_ra_get_props_many(session, &props, paths, 0,
+                                              pool, pool),
+                        SVN_ERR_RA_NOT_AUTHORIZED);
+
+  /* The connection must still be in sync. */
+  SVN_ERR(svn_ra_stat(session, "", 0, &dirent, pool));
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  apr_array_pop(paths);
+  apr_array_pop(paths);
+  apr_array_pop(paths);
+  SVN_ERR(svn_ra_get_props_many(session, &props, paths, 0, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(props) == 1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test an ra_svn session that compresses the whole protocol stream. */
+static svn_error_t *
+compressed_stream_test(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-compressed-stream";
+  svn_repos_t *repos;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  apr_array_header_t *paths = apr_array_make(pool, 2, sizeof(const char *));
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+  svn_revnum_t youngest;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", repos_name, SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = check_tunnel_baton = &cbtable;
+  SVN_ERR(svn_cmdline_create_auth_baton(&cbtable->auth_baton,
+                                        TRUE  /* non_interactive */,
+                                        "jrandom", "rayjandom",
+                                        NULL,
+                                        TRUE  /* no_auth_cache */,
+                                        FALSE /* trust_server_cert */,
+                                        NULL, NULL, NULL, pool));
+
+  tunnel_compress_stream = TRUE;
+  err = svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL, pool);
+  tunnel_compress_stream = FALSE;
+  if (err && err->apr_err == SVN_ERR_TEST_FAILED)
+    {
+      svn_handle_error2(err, stderr, FALSE, "svn_tests: ");
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Exercise an editor drive as well as simple and pipelined commands. */
+  SVN_ERR(commit_changes(session, pool));
+  SVN_ERR(svn_ra_get_latest_revnum(session, &youngest, pool));
+  SVN_TEST_ASSERT(youngest == 1);
+
+  SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, "", 1,
+                          SVN_DIRENT_KIND, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+  dirent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  SVN_ERR(svn_ra_stat_many(session, &dirents, paths, 1, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 2);
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until svn_ra_svn__has_command() reports a complete command on
+   CONN but give up after ATTEMPTS tries, 20ms apart.  Set *HAS_COMMAND
+   accordingly. */
+static svn_error_t *
+wait_for_command(svn_boolean_t *has_command,
+                 svn_ra_svn_conn_t *conn,
+                 int attempts,
+                 apr_pool_t *pool)
+{
+  svn_boolean_t terminated;
+  int i;
+
+  for (i = 0; i < attempts; ++i)
+    {
+      SVN_ERR(svn_ra_svn__has_command(has_command, &terminated, conn,
+                                      pool));
+      SVN_TEST_ASSERT(!terminated);
+      if (*has_command)
+        break;
+
+      apr_sleep(20000);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that svn_ra_svn__has_command() only reports commands that have
+   been received completely, even if they don't fit into the read buffer
+   of the connection. */
+static svn_error_t *
+has_command_test(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  apr_socket_t *server, *client;
+  svn_ra_svn_conn_t *conn;
+  svn_stringbuf_t *data = svn_stringbuf_create("( get-file ( 50000:",
+                                               pool);
+  svn_boolean_t has_command, terminated;
+  const char *cmdname;
+  apr_array_header_t *params;
+  svn_ra_svn_item_t *item;
+  apr_size_t len;
+  apr_size_t split;
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(create_socket_pair(&server, &client, pool));
+  conn = svn_ra_svn_create_conn3(server, NULL, NULL, 0, 0, 0, pool);
+
+  /* A command much larger than the read buffer, followed by a small one. */
+  while (data->len < 50000 + 19)
+    svn_stringbuf_appendbyte(data, 'x');
+  svn_stringbuf_appendcstr(data, " ) ) ( get-latest-rev ( ) ) ");
+  split = data->len - 100;
+
+  /* Nothing to process without any data. */
+  SVN_ERR(svn_ra_svn__has_command(&has_command, &terminated, conn, pool));
+  SVN_TEST_ASSERT(!has_command && !terminated);
+
+  /* The first part of the large command. */
+  len = split;
+  status = apr_socket_send(client, data->data, &len);
+  if (status)
+    return svn_error_wrap_apr(status, "Could not send data");
+  SVN_TEST_ASSERT(len == split);
+
+  SVN_ERR(wait_for_command(&has_command, conn, 10, pool));
+  SVN_TEST_ASSERT(!has_command);
+
+  /* The rest of it plus the next command. */
+  len = data->len - split;
+  status = apr_socket_send(client, data->data + split, &len);
+  if (status)
+    return svn_error_wrap_apr(status, "Could not send data");
+  SVN_TEST_ASSERT(len == data->len - split);
+
+  SVN_ERR(wait_for_command(&has_command, conn, 250, pool));
+  SVN_TEST_ASSERT(has_command);
+
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "wl", &cmdname, &params));
+  SVN_TEST_STRING_ASSERT(cmdname, "get-file");
+  SVN_TEST_ASSERT(params->nelts == 1);
+  item = &APR_ARRAY_IDX(params, 0, svn_ra_svn_item_t);
+  SVN_TEST_ASSERT(item->kind == SVN_RA_SVN_STRING);
+  SVN_TEST_ASSERT(item->u.string->len == 50000);
+
+  /* The second command has been received as well. */
+  SVN_ERR(svn_ra_svn__has_command(&has_command, &terminated, conn, pool));
+  SVN_TEST_ASSERT(has_command && !terminated);
+
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "wl", &cmdname, &params));
+  SVN_TEST_STRING_ASSERT(cmdname, "get-latest-rev");
+  SVN_TEST_ASSERT(params->nelts == 0);
+
+  SVN_ERR(svn_ra_svn__has_command(&has_command, &terminated, conn, pool));
+  SVN_TEST_ASSERT(!has_command && !terminated);
+
+  /* Closing the connection terminates it. */
+  apr_socket_close(client);
+  for (i = 0; i < 250 && !terminated; ++i)
+    {
+      SVN_ERR(svn_ra_svn__has_command(&has_command, &terminated, conn,
+                                      pool));
+      if (!terminated)
+        apr_sleep(20000);
+    }
+  SVN_TEST_ASSERT(terminated && !has_command);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that in svnserve's event loop mode, neither idle sessions nor
+   clients that don't answer the server's greeting occupy a worker
+   thread. */
+static svn_error_t *
+event_loop_test(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-event-loop";
+  const char *const args[] = { "--event-loop", "--max-threads", "1", NULL };
+  svn_repos_t *repos;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *sessions[3];
+  apr_socket_t *silent[3];
+  svn_revnum_t youngest;
+  apr_port_t port;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+
+  err = start_svnserve_daemon(&port, args, pool);
+  if (err && err->apr_err == SVN_ERR_TEST_FAILED)
+    {
+      svn_handle_error2(err, stderr, FALSE, "svn_tests: ");
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  url = apr_psprintf(pool, "svn://127.0.0.1:%d/%s", (int)port, repos_name);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_cmdline_create_auth_baton(&cbtable->auth_baton,
+                                        TRUE  /* non_interactive */,
+                                        "jrandom", "rayjandom",
+                                        NULL,
+                                        TRUE  /* no_auth_cache */,
+                                        FALSE /* trust_server_cert */,
+                                        NULL, NULL, NULL, pool));
+
+  /* Clients that connect but never say anything. */
+  for (i = 0; i < 3; ++i)
+    SVN_ERR(connect_socket(&silent[i], port, pool));
+
+  /* The server has only a single worker thread.  So, each session can
+     only be opened and used if neither the silent clients nor the
+     previous, now idle sessions keep that thread busy. */
+  for (i = 0; i < 3; ++i)
+    {
+      SVN_ERR(svn_ra_open4(&sessions[i], NULL, url, NULL, cbtable, NULL,
+                           NULL, pool));
+      SVN_ERR(svn_ra_get_latest_revnum(sessions[i], &youngest, pool));
+      SVN_TEST_ASSERT(youngest == 0);
+    }
+
+  /* The idle sessions are still being served. */
+  for (i = 0; i < 3; ++i)
+    {
+      SVN_ERR(svn_ra_get_latest_revnum(sessions[i], &youngest, pool));
+      SVN_TEST_ASSERT(youngest == 0);
+    }
+
+  for (i = 0; i < 3; ++i)
+    apr_socket_close(silent[i]);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test stream compression in svnserve's event loop mode, where the server
+   must be able to tell whether a compressed connection has a command to
+   process without blocking. */
+static svn_error_t *
+compressed_event_loop_test(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-compressed-event-loop";
+  const char *const args[] = { "--event-loop", "--compress-stream",
+                               "--max-threads", "1", NULL };
+  svn_repos_t *repos;
+  const char *conf_path;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *sessions[2];
+  apr_array_header_t *paths = apr_array_make(pool, 2, sizeof(const char *));
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+  svn_revnum_t youngest;
+  apr_port_t port;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+
+  /* Anonymous users may commit. */
+  conf_path = svn_repos_svnserve_conf(repos, pool);
+  SVN_ERR(svn_io_remove_file2(conf_path, TRUE, pool));
+  SVN_ERR(svn_io_file_create(conf_path, "[general]\nanon-access = write\n",
+                             pool));
+
+  err = start_svnserve_daemon(&port, args, pool);
+  if (err && err->apr_err == SVN_ERR_TEST_FAILED)
+    {
+      svn_handle_error2(err, stderr, FALSE, "svn_tests: ");
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  url = apr_psprintf(pool, "svn://127.0.0.1:%d/%s", (int)port, repos_name);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_cmdline_create_auth_baton(&cbtable->auth_baton,
+                                        TRUE  /* non_interactive */,
+                                        NULL, NULL, NULL,
+                                        TRUE  /* no_auth_cache */,
+                                        FALSE /* trust_server_cert */,
+                                        NULL, NULL, NULL, pool));
+
+  for (i = 0; i < 2; ++i)
+    SVN_ERR(svn_ra_open4(&sessions[i], NULL, url, NULL, cbtable, NULL,
+                         NULL, pool));
+
+  /* Exercise an editor drive as well as simple and pipelined commands,
+     alternating between the sessions so that each of them goes back to
+     the event loop in between. */
+  SVN_ERR(commit_changes(sessions[0], pool));
+  SVN_ERR(svn_ra_get_latest_revnum(sessions[1], &youngest, pool));
+  SVN_TEST_ASSERT(youngest == 1);
+
+  SVN_ERR(svn_ra_get_dir2(sessions[0], &dirents, NULL, NULL, "", 1,
+                          SVN_DIRENT_KIND, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+  dirent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  SVN_ERR(svn_ra_stat_many(sessions[1], &dirents, paths, 1, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 2);
+
+  SVN_ERR(svn_ra_get_latest_revnum(sessions[0], &youngest, pool));
+  SVN_TEST_ASSERT(youngest == 1);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The test table.  */
@@ -335,5 +989,17 @@ struct svn_test_descriptor_t test_funcs[] =
                        "test ra_svn tunnel callback check"),
     SVN_TEST_OPTS_PASS(tunel_callback_test,
                        "test ra_svn tunnel creation callbacks"),
+    SVN_TEST_OPTS_PASS(batch_test,
+                       "test pipelined ra_svn batch requests"),
+    SVN_TEST_OPTS_PASS(compressed_stream_test,
+                       "test ra_svn stream compression"),
+    SVN_TEST_OPTS_PASS(has_command_test,
+                       "test detection of complete ra_svn commands"),
+    SVN_TEST_OPTS_PASS(event_loop_test,
+                       "test svnserve event loop with stalled clients"),
+    SVN_TEST_OPTS_PASS(compressed_event_loop_test,
+                       "test stream compression in svnserve event loop"),
+    SVN_TEST_OPTS_PASS(denied_batch_test,
+                       "test pipelined ra_svn batch with denied paths"),
     SVN_TEST_NULL
   };
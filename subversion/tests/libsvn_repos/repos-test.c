@@ -1394,6 +1394,207 @@ authz(apr_pool_t *pool)
 }
 
 
+/* Test authz lookups that combine aliases, nested groups, inversions,
+   repository-specific and pan-repository rules at various depths. */
+static svn_error_t *
+authz_rule_tree(apr_pool_t *pool)
+{
+  const char *contents;
+  svn_authz_t *authz_cfg;
+  svn_boolean_t access_granted;
+  int i;
+
+  struct check_access_tests test_set[] = {
+    /* Repository-specific rules take precedence, but only if they apply
+       to the user. */
+    { "/trunk", "greek", "plato", svn_authz_write, TRUE },
+    { "/trunk", "greek", "aristotle", svn_authz_write, FALSE },
+    { "/trunk", "third", "aristotle", svn_authz_write, TRUE },
+    { "/trunk", "other", "aristotle", svn_authz_write, FALSE },
+    /* Rules are inherited from the nearest path with applicable rules. */
+    { "/trunk/x/y", "greek", "socrates", svn_authz_write, TRUE },
+    { "/trunk/secret", "greek", "aristotle", svn_authz_read, FALSE },
+    { "/trunk/secret", "greek", "socrates", svn_authz_read, TRUE },
+    { "/trunk/secret", "greek", "plato", svn_authz_read, TRUE },
+    { "/trunk/secret", "other", "socrates", svn_authz_read, FALSE },
+    { "/trunk2", "greek", "aristotle", svn_authz_write, FALSE },
+    { "/trunk2", "greek", "aristotle", svn_authz_read, TRUE },
+    { "/tags", "greek", "plato", svn_authz_write, TRUE },
+    { "/tags", "greek", "socrates", svn_authz_read, FALSE },
+    /* Recursive lookups consider all rules below the path. */
+    { "/trunk", "greek", "socrates",
+      svn_authz_read | svn_authz_recursive, FALSE },
+    { "/trunk", "third", "socrates",
+      svn_authz_read | svn_authz_recursive, TRUE },
+    { "/trunk", "third", "plato",
+      svn_authz_read | svn_authz_recursive, TRUE },
+    { "/trunk", "third", "aristotle",
+      svn_authz_read | svn_authz_recursive, FALSE },
+    { "/", "greek", NULL, svn_authz_read | svn_authz_recursive, FALSE },
+    { "/", "third", "plato", svn_authz_read | svn_authz_recursive, TRUE },
+    /* Tokens. */
+    { "/branches/b1/x", "greek", NULL, svn_authz_read, FALSE },
+    { "/branches", "greek", NULL, svn_authz_read, TRUE },
+    { "/branches/b1", "greek", "plato", svn_authz_read, TRUE },
+    /* Access anywhere in the repository. */
+    { NULL, "greek", NULL, svn_authz_write, FALSE },
+    { NULL, "greek", "aristotle", svn_authz_write, TRUE },
+    { NULL, "greek", "aristotle",
+      svn_authz_read | svn_authz_write, TRUE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  contents =
+    "[aliases]"                                                              NL
+    "admin = plato"                                                          NL
+    ""                                                                       NL
+    "[groups]"                                                               NL
+    "philosophers = socrates, &admin"                                        NL
+    "thinkers = @philosophers, aristotle"                                    NL
+    ""                                                                       NL
+    "[/]"                                                                    NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[/trunk]"                                                               NL
+    "@thinkers = rw"                                                         NL
+    ""                                                                       NL
+    "[greek:/trunk]"                                                         NL
+    "aristotle = r"                                                          NL
+    ""                                                                       NL
+    "[/trunk/secret]"                                                        NL
+    "~@philosophers ="                                                       NL
+    ""                                                                       NL
+    "[greek:/trunk/secret/deep]"                                             NL
+    "socrates ="                                                             NL
+    ""                                                                       NL
+    "[greek:/tags]"                                                          NL
+    "&admin = rw"                                                            NL
+    "* ="                                                                    NL
+    ""                                                                       NL
+    "[/branches/b1]"                                                         NL
+    "$anonymous ="                                                           NL
+    ""                                                                       NL
+    "[other:/trunk]"                                                         NL
+    "* ="                                                                    NL;
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  /* The second run uses the cached rules. */
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  /* Make the authz object discard its cached rules at least once. */
+  for (i = 0; i < 1100; ++i)
+    {
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek", "/trunk",
+                                           apr_psprintf(pool, "user%d", i),
+                                           svn_authz_read,
+                                           &access_granted, pool));
+      SVN_TEST_ASSERT(access_granted);
+    }
+
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Test that checking many paths at once gives the same results as
+   checking them one by one. */
+static svn_error_t *
+authz_check_many(apr_pool_t *pool)
+{
+  const char *contents;
+  svn_authz_t *authz_cfg;
+  apr_array_header_t *paths;
+  svn_boolean_t *allowed;
+  int i, k, u, a;
+
+  const char *path_list[] = {
+    "/", "/trunk", "/trunk/a", "/trunk/secret", "/trunk/secret/a",
+    "/trunk/secret/deep", "/trunk/secret/deep/a", "/trunk/secret/deep/b",
+    "/trunk/b", "/tags", "/tags/1.0", "/tags/1.0/a", "/branches",
+    "/branches/b1", "/branches/b1/a", "/branches/b2/", "//trunk//secret",
+    "/trunk2/x", "/trunk/secret/a", NULL
+  };
+  const char *repos_list[] = { "greek", "other", NULL };
+  /* NULL tests anonymous access. */
+  const char *user_list[] = { "plato", "socrates", "aristotle", NULL };
+  const int user_count = sizeof(user_list) / sizeof(user_list[0]);
+  svn_repos_authz_access_t access_list[] = {
+    svn_authz_read,
+    svn_authz_write,
+    svn_authz_read | svn_authz_recursive
+  };
+  const int access_count = sizeof(access_list) / sizeof(access_list[0]);
+
+  contents =
+    "[groups]"                                                               NL
+    "philosophers = socrates, plato"                                         NL
+    ""                                                                       NL
+    "[/]"                                                                    NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[/trunk]"                                                               NL
+    "@philosophers = rw"                                                     NL
+    ""                                                                       NL
+    "[/trunk/secret]"                                                        NL
+    "~plato ="                                                               NL
+    ""                                                                       NL
+    "[greek:/trunk/secret/deep]"                                             NL
+    "socrates = r"                                                           NL
+    ""                                                                       NL
+    "[greek:/tags]"                                                          NL
+    "plato = rw"                                                             NL
+    "* ="                                                                    NL
+    ""                                                                       NL
+    "[/branches/b1]"                                                         NL
+    "$anonymous ="                                                           NL;
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  for (i = 0; path_list[i]; ++i)
+    APR_ARRAY_PUSH(paths, const char *) = path_list[i];
+  allowed = apr_palloc(pool, paths->nelts * sizeof(*allowed));
+
+  for (k = 0; repos_list[k]; ++k)
+    for (u = 0; u < user_count; ++u)
+      {
+        const char *user = user_list[u];
+
+        for (a = 0; a < access_count; ++a)
+          {
+            SVN_ERR(svn_repos__authz_check_access_many(authz_cfg,
+                                                       repos_list[k], paths,
+                                                       user, access_list[a],
+                                                       allowed, pool));
+            for (i = 0; i < paths->nelts; ++i)
+              {
+                svn_boolean_t expected;
+
+                SVN_ERR(svn_repos_authz_check_access(authz_cfg,
+                                                     repos_list[k],
+                                                     path_list[i], user,
+                                                     access_list[a],
+                                                     &expected, pool));
+                if (allowed[i] != expected)
+                  return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                           "Batched check of '%s' for user "
+                                           "'%s' in '%s' returned %s",
+                                           path_list[i],
+                                           user ? user : "<anonymous>",
+                                           repos_list[k],
+                                           allowed[i] ? "TRUE" : "FALSE");
+              }
+          }
+      }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Test in-repo authz paths */
 static svn_error_t *
 in_repo_authz(const svn_test_opts_t *opts,
@@ -3562,6 +3763,10 @@ struct svn_test_descriptor_t test_funcs[] =
                        "test removal of defunct locks"),
     SVN_TEST_PASS2(authz,
                    "test authz access control"),
+    SVN_TEST_PASS2(authz_rule_tree,
+                   "test authz rule resolution"),
+    SVN_TEST_PASS2(authz_check_many,
+                   "test batched authz checks"),
     SVN_TEST_OPTS_PASS(in_repo_authz,
                        "test authz stored in the repo"),
     SVN_TEST_OPTS_PASS(in_repo_groups_authz,
@@ -26,8 +26,10 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
+#include "svn_sorts.h"
 
 #include "private/svn_cache.h"
 #include "svn_private_config.h"
@@ -184,7 +186,7 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   svn_membuffer_t *membuffer;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -200,6 +202,303 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            FALSE, TRUE, TRUE, pool));
+
+  /* Create a cache with just one entry. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            pool));
+
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+#if APR_HAS_FORK
+  {
+    svn_boolean_t found;
+    svn_revnum_t forty = 40, *answer;
+    apr_proc_t proc;
+    int exitcode;
+    apr_exit_why_e exitwhy;
+    apr_status_t status = apr_proc_fork(&proc, pool);
+
+    if (status == APR_INCHILD)
+      {
+        /* Writes in the child must become visible to the parent. */
+        svn_error_t *err
+          = svn_cache__membuffer_cache_child_init(membuffer, pool);
+        if (! err)
+          err = svn_cache__set(cache, "forty", &forty, pool);
+        svn_error_clear(err);
+        exit(err ? 1 : 0);
+      }
+    else if (status != APR_INPARENT)
+      return svn_error_wrap_apr(status, "Can't fork");
+
+    status = apr_proc_wait(&proc, &exitcode, &exitwhy, APR_WAIT);
+    if (status != APR_CHILD_DONE)
+      return svn_error_wrap_apr(status, "Can't wait for child");
+    if (exitcode != 0)
+      return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                              "child process failed to write to the cache");
+
+    SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "forty", pool));
+    if (! found)
+      return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                              "cache failed to find entry written by child");
+    if (*answer != 40)
+      return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                               "expected 40 but found '%ld'", *answer);
+  }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of different keys used by the concurrent access test.  That is
+ * far more than the small test cache can hold at a time. */
+#define CONCURRENT_ITEM_COUNT 2000
+
+/* Number of cache operations performed by each test thread. */
+#define CONCURRENT_OPERATIONS 20000
+
+/* Number of lookups performed by each thread of the read benchmark. */
+#define BENCHMARK_LOOKUPS 200000
+
+/* Baton type used by the concurrent access test threads. */
+typedef struct concurrent_baton_t
+{
+  /* the cache to access.  Shared between all threads. */
+  svn_membuffer_t *membuffer;
+
+  /* seed for this thread's pseudo-random key sequence */
+  apr_uint32_t seed;
+
+  /* whether this thread writes to or reads from the cache */
+  svn_boolean_t writer;
+
+  /* number of cache operations to perform */
+  int operations;
+
+  /* error encountered during the cache access, if any */
+  svn_error_t *err;
+} concurrent_baton_t;
+
+/* Perform BATON->OPERATIONS accesses of random items in
+ * BATON->MEMBUFFER using a cache front-end private to this thread.
+ * Writers store values V for key K with V % CONCURRENT_ITEM_COUNT == K.
+ * Readers verify that every value found satisfies that condition.
+ */
+static svn_error_t *
+concurrent_access(concurrent_baton_t *baton,
+                  apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = baton->seed;
+  int i;
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            baton->membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(svn_revnum_t),
+                                            "concurrent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            pool));
+
+  for (i = 0; i < baton->operations; ++i)
+    {
+      svn_revnum_t key, *value;
+      svn_boolean_t found;
+
+      if (i % 1000 == 0)
+        svn_pool_clear(iterpool);
+
+      seed = seed * 1103515245 + 12345;
+      key = (seed >> 8) % CONCURRENT_ITEM_COUNT;
+
+      if (baton->writer)
+        {
+          svn_revnum_t new_value = key + (svn_revnum_t)i
+                                       * CONCURRENT_ITEM_COUNT;
+          SVN_ERR(svn_cache__set(cache, &key, &new_value, iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_cache__get((void **)&value, &found, cache, &key,
+                                 iterpool));
+          if (found && *value % CONCURRENT_ITEM_COUNT != key)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "found value %ld for key %ld",
+                                     *value, key);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running concurrent_access for the concurrent_baton_t
+ * in DATA.
+ */
+static void *
+APR_THREAD_FUNC concurrent_access_thread(apr_thread_t *tid, void *data)
+{
+  concurrent_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  baton->err = concurrent_access(baton, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Maximum number of threads that run_concurrent_access() can start. */
+#define MAX_CONCURRENT_THREADS 16
+
+/* Run THREAD_COUNT threads that each perform OPERATIONS accesses of
+ * random items in MEMBUFFER.  The first WRITER_COUNT of them write to
+ * the cache, the others read from it.  Return once all threads have
+ * finished.  Use POOL for allocations.
+ */
+static svn_error_t *
+run_concurrent_access(svn_membuffer_t *membuffer,
+                      int thread_count,
+                      int writer_count,
+                      int operations,
+                      apr_pool_t *pool)
+{
+  concurrent_baton_t batons[MAX_CONCURRENT_THREADS];
+  apr_thread_t *threads[MAX_CONCURRENT_THREADS];
+  apr_status_t status = APR_SUCCESS;
+  svn_error_t *err = SVN_NO_ERROR;
+  int started;
+  int i;
+
+  SVN_ERR_ASSERT(thread_count <= MAX_CONCURRENT_THREADS);
+
+  for (started = 0; started < thread_count; ++started)
+    {
+      batons[started].membuffer = membuffer;
+      batons[started].seed = started;
+      batons[started].writer = started < writer_count;
+      batons[started].operations = operations;
+      batons[started].err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&threads[started], NULL,
+                                 concurrent_access_thread,
+                                 &batons[started], pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, "Can't create thread");
+          break;
+        }
+    }
+
+  /* Wait for all threads we started, even if we failed to start
+   * some of them, since they still access MEMBUFFER and POOL. */
+  for (i = 0; i < started; ++i)
+    {
+      apr_status_t retval;
+      status = apr_thread_join(&retval, threads[i]);
+      if (status && !err)
+        err = svn_error_wrap_apr(status, "Can't join thread");
+    }
+
+  for (i = 0; i < started; ++i)
+    err = svn_error_compose_create(err, batons[i].err);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+static svn_error_t *
+test_membuffer_cache_concurrent_access(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_membuffer_t *membuffer;
+
+  /* A small thread-safe cache with a single segment.  The writers will
+   * constantly evict and move entries while the readers use the
+   * lock-free lookup path, wherever that is supported. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 0x10000, 0x4000,
+                                            1, TRUE, TRUE, FALSE, pool));
+
+  SVN_ERR(run_concurrent_access(membuffer, 8, 2, CONCURRENT_OPERATIONS,
+                                pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_read_scaling(const svn_test_opts_t *opts,
+                                  apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_revnum_t key;
+  int thread_count;
+
+  /* A thread-safe cache with only a few segments such that the threads
+   * will compete for the same segments.  It is large enough to hold all
+   * items, so all lookups will be hits. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 0x1000000, 0x200000,
+                                            2, TRUE, TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(svn_revnum_t),
+                                            "concurrent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            pool));
+
+  for (key = 0; key < CONCURRENT_ITEM_COUNT; ++key)
+    SVN_ERR(svn_cache__set(cache, &key, &key, pool));
+
+  /* Measure the read throughput for 1, 2, 4, ... threads. */
+  for (thread_count = 1;
+       thread_count <= MAX_CONCURRENT_THREADS;
+       thread_count *= 2)
+    {
+      apr_time_t start = apr_time_now();
+      apr_time_t duration;
+
+      SVN_ERR(run_concurrent_access(membuffer, thread_count, 0,
+                                    BENCHMARK_LOOKUPS, pool));
+
+      duration = MAX(apr_time_now() - start, 1);
+      if (opts->verbose)
+        printf("%2d threads: %10.0f lookups/s\n", thread_count,
+               (double)thread_count * BENCHMARK_LOOKUPS * APR_USEC_PER_SEC
+                 / duration);
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *
 test_memcache_long_key(const svn_test_opts_t *opts,
@@ -270,5 +569,11 @@ struct svn_test_descriptor_t test_funcs[] =
                        "memcache svn_cache with very long keys"),
     SVN_TEST_PASS2(test_membuffer_cache_basic,
                    "basic membuffer svn_cache test"),
+    SVN_TEST_SKIP2(test_membuffer_cache_shared, !APR_HAS_SHARED_MEMORY,
+                   "membuffer svn_cache in shared memory"),
+    SVN_TEST_SKIP2(test_membuffer_cache_concurrent_access, !APR_HAS_THREADS,
+                   "membuffer svn_cache with concurrent writers"),
+    SVN_TEST_OPTS_SKIP(test_membuffer_cache_read_scaling, !APR_HAS_THREADS,
+                       "membuffer svn_cache read throughput scaling"),
     SVN_TEST_NULL
   };
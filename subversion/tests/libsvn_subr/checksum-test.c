@@ -22,12 +22,17 @@
  */
 
 #include <apr_pools.h>
+#include <apr_sha1.h>
 
 #include <zlib.h>
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_adler32.h"
 #include "private/svn_pseudo_md5.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -239,6 +244,255 @@ zlib_expansion_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Verify that the incremental calculation of CHECKSUM's kind over the LEN
+   bytes at DATA gives CHECKSUM, when fed in chunks of CHUNK_SIZE bytes. */
+static svn_error_t *
+verify_incremental(const svn_checksum_t *checksum,
+                   const char *data,
+                   apr_size_t len,
+                   apr_size_t chunk_size,
+                   apr_pool_t *pool)
+{
+  svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(checksum->kind, pool);
+  svn_checksum_t *actual;
+  apr_size_t pos;
+
+  for (pos = 0; pos < len; pos += chunk_size)
+    SVN_ERR(svn_checksum_update(ctx, data + pos,
+                                chunk_size < len - pos ? chunk_size
+                                                       : len - pos));
+
+  SVN_ERR(svn_checksum_final(&actual, ctx, pool));
+  if (!svn_checksum_match(checksum, actual))
+    return svn_error_trace(svn_checksum_mismatch_err(checksum, actual, pool,
+                             "incremental checksum of %d bytes in chunks "
+                             "of %d bytes", (int)len, (int)chunk_size));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksum_vectors(apr_pool_t *pool)
+{
+  /* Test vectors from FIPS 180-2 and RFC 1321. */
+  static const struct
+    {
+      svn_checksum_kind_t kind;
+      const char *data;
+      apr_size_t repeat;
+      const char *hex;
+    } vectors[] =
+    {
+      { svn_checksum_md5, "abc", 1, "900150983cd24fb0d6963f7d28e17f72" },
+      { svn_checksum_md5, "a", 1000000, "7707d6ae4e027c70eea2a935c2296f21" },
+      { svn_checksum_sha1, "abc", 1,
+        "a9993e364706816aba3e25717850c26c9cd0d89d" },
+      { svn_checksum_sha1,
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+        "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+      { svn_checksum_sha1, "a", 1000000,
+        "34aa973cd4c4daa4f61eeb2bdbad27316534016f" }
+    };
+  static const apr_size_t chunk_sizes[] = { 1, 3, 55, 64, 65, 1000, 65536 };
+  const int vector_count = sizeof(vectors) / sizeof(vectors[0]);
+  const int chunk_size_count = sizeof(chunk_sizes) / sizeof(chunk_sizes[0]);
+  int i, k;
+
+  for (i = 0; i < vector_count; ++i)
+    {
+      svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+      svn_checksum_t *expected;
+      svn_checksum_t *actual;
+      apr_size_t r;
+
+      for (r = 0; r < vectors[i].repeat; ++r)
+        svn_stringbuf_appendcstr(data, vectors[i].data);
+
+      SVN_ERR(svn_checksum_parse_hex(&expected, vectors[i].kind,
+                                     vectors[i].hex, pool));
+      SVN_ERR(svn_checksum(&actual, vectors[i].kind, data->data, data->len,
+                           pool));
+      if (!svn_checksum_match(expected, actual))
+        return svn_error_trace(svn_checksum_mismatch_err(expected, actual,
+                                 pool, "checksum of test vector %d", i));
+
+      for (k = 0; k < chunk_size_count; ++k)
+        SVN_ERR(verify_incremental(expected, data->data, data->len,
+                                   chunk_sizes[k], pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sha1_lengths(apr_pool_t *pool)
+{
+  /* Compare our SHA1 results with APR's for all lengths around the
+     block and padding boundaries, using pseudo-random data. */
+  char data[1100];
+  apr_uint32_t seed = 0x5eed;
+  apr_size_t len;
+
+  for (len = 0; len < sizeof(data); ++len)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[len] = (char)(seed >> 16);
+    }
+
+  for (len = 0; len < sizeof(data); ++len)
+    {
+      apr_sha1_ctx_t apr_ctx;
+      svn_checksum_t *expected = svn_checksum_create(svn_checksum_sha1, pool);
+      svn_checksum_t *actual;
+
+      apr_sha1_init(&apr_ctx);
+      apr_sha1_update_binary(&apr_ctx, (const unsigned char *)data,
+                             (unsigned int)len);
+      apr_sha1_final((unsigned char *)expected->digest, &apr_ctx);
+
+      SVN_ERR(svn_checksum(&actual, svn_checksum_sha1, data, len, pool));
+      if (!svn_checksum_match(expected, actual))
+        return svn_error_trace(svn_checksum_mismatch_err(expected, actual,
+                                 pool, "SHA1 of %d bytes", (int)len));
+
+      SVN_ERR(verify_incremental(expected, data, len, 1 + len % 97, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksummed_md5_sha1(apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *copy = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *read_md5, *read_sha1, *write_md5, *write_sha1;
+  svn_checksum_t *expected_md5, *expected_sha1;
+  svn_stream_t *stream;
+  int i;
+
+  /* Large enough to be fed to the checksum contexts in several slices. */
+  for (i = 0; i < 10000; ++i)
+    svn_stringbuf_appendcstr(data, apr_psprintf(pool, "line %d\n", i));
+
+  SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5, data->data,
+                       data->len, pool));
+  SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1, data->data,
+                       data->len, pool));
+
+  /* Write all data through the stream. */
+  stream = svn_stream__checksummed_md5_sha1(
+             svn_stream_from_stringbuf(copy, pool), NULL, NULL,
+             &write_md5, &write_sha1, FALSE, pool);
+  SVN_ERR(svn_stream_write(stream, data->data, &data->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_STRING_ASSERT(copy->data, data->data);
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, write_md5));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, write_sha1));
+
+  /* Reading nothing but draining the stream upon close shall still
+     process all data. */
+  stream = svn_stream__checksummed_md5_sha1(
+             svn_stream_from_stringbuf(data, pool), &read_md5, &read_sha1,
+             NULL, NULL, TRUE, pool);
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, read_md5));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, read_sha1));
+
+  /* Only one of the checksums. */
+  stream = svn_stream__checksummed_md5_sha1(
+             svn_stream_from_stringbuf(data, pool), NULL, &read_sha1,
+             NULL, NULL, TRUE, pool);
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, read_sha1));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_update2_stream(apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_checksum_ctx_t *md5_ctx, *sha1_ctx;
+  svn_checksum_t *expected_md5, *expected_sha1, *md5, *sha1;
+  svn_stream_t *stream;
+  apr_pool_t *subpool;
+  apr_size_t pos;
+  int i;
+
+  /* Large enough to fill the checksum thread's queue several times. */
+  for (i = 0; i < 400000; ++i)
+    svn_stringbuf_appendcstr(data, apr_psprintf(pool, "line %d\n", i));
+
+  SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5, data->data,
+                       data->len, pool));
+  SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1, data->data,
+                       data->len, pool));
+
+  /* Write the data in chunks of varying size that don't line up with
+     any internal block boundaries. */
+  md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  stream = svn_checksum__update2_stream(md5_ctx, sha1_ctx, pool);
+  for (pos = 0, i = 0; pos < data->len; ++i)
+    {
+      apr_size_t len = MIN(data->len - pos,
+                           1 + (apr_size_t)i * 7919 % 100003);
+      SVN_ERR(svn_stream_write(stream, data->data + pos, &len));
+      pos += len;
+    }
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(svn_checksum_final(&md5, md5_ctx, pool));
+  SVN_ERR(svn_checksum_final(&sha1, sha1_ctx, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, md5));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, sha1));
+
+  /* Clearing the pool without closing the stream must stop any checksum
+     thread safely. */
+  subpool = svn_pool_create(pool);
+  md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, subpool);
+  sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, subpool);
+  stream = svn_checksum__update2_stream(md5_ctx, sha1_ctx, subpool);
+  SVN_ERR(svn_stream_write(stream, data->data, &data->len));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare svn__adler32 with zlib's implementation for the short inputs
+   that it handles itself, at all lengths and alignments. */
+static svn_error_t *
+test_adler32_short(apr_pool_t *pool)
+{
+  char data[128];
+  apr_size_t i, offset, len;
+  apr_uint32_t seed = 0x5678;
+
+  for (i = 0; i < sizeof(data); ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = (char)(seed >> 16);
+    }
+
+  for (offset = 0; offset < 16; ++offset)
+    for (len = 0; len <= 100; ++len)
+      {
+        const char *start = data + offset;
+
+        SVN_TEST_ASSERT(svn__adler32(1, start, len)
+                        == adler32(1, (const Bytef *)start, (uInt)len));
+        SVN_TEST_ASSERT(svn__adler32(0x12345678, start, len)
+                        == adler32(0x12345678, (const Bytef *)start,
+                                   (uInt)len));
+      }
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 struct svn_test_descriptor_t test_funcs[] =
   {
@@ -253,5 +507,15 @@ struct svn_test_descriptor_t test_funcs[] =
                    "zero checksum matching"),
     SVN_TEST_OPTS_PASS(zlib_expansion_test,
                        "zlib expansion test (zlib regression)"),
+    SVN_TEST_PASS2(test_checksum_vectors,
+                   "checksum test vectors"),
+    SVN_TEST_PASS2(test_sha1_lengths,
+                   "SHA1 for various data lengths"),
+    SVN_TEST_PASS2(test_checksummed_md5_sha1,
+                   "combined MD5 and SHA1 checksummed stream"),
+    SVN_TEST_PASS2(test_update2_stream,
+                   "MD5 and SHA1 calculated in a separate thread"),
+    SVN_TEST_PASS2(test_adler32_short,
+                   "Adler-32 of short inputs"),
     SVN_TEST_NULL
   };
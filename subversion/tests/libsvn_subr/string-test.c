@@ -40,6 +40,7 @@
 #include "svn_error.h"
 #include "svn_sorts.h"    /* MIN / MAX */
 #include "svn_string.h"   /* This includes <apr_*.h> */
+#include "private/svn_eol_private.h"
 #include "private/svn_string_private.h"
 
 /* A quick way to create error messages.  */
@@ -826,6 +827,74 @@ test_string_matching(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Compare svn_cstring__match_length and svn_cstring__reverse_match_length
+   with a byte-wise comparison for mismatches at all positions and for
+   all alignments relative to the chunks compared at once. */
+static svn_error_t *
+test_string_matching_chunks(apr_pool_t *pool)
+{
+  char a[128];
+  char b[128];
+  apr_size_t i, offset, max_len, mismatch;
+
+  for (i = 0; i < sizeof(a); ++i)
+    a[i] = (char)('a' + i % 26);
+
+  for (offset = 0; offset < 16; ++offset)
+    for (max_len = 0; max_len <= 80; ++max_len)
+      for (mismatch = 0; mismatch <= max_len; ++mismatch)
+        {
+          apr_size_t expected_match = mismatch;
+          apr_size_t expected_rmatch = max_len - mismatch;
+
+          memcpy(b, a, sizeof(b));
+          if (mismatch < max_len)
+            {
+              b[offset + mismatch] = '_';
+              --expected_rmatch;
+            }
+
+          SVN_TEST_ASSERT(svn_cstring__match_length(a + offset, b + offset,
+                                                    max_len)
+                          == expected_match);
+          SVN_TEST_ASSERT(svn_cstring__reverse_match_length(
+                            a + offset + max_len, b + offset + max_len,
+                            max_len)
+                          == expected_rmatch);
+        }
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that svn_eol__find_eol_start finds the first EOL at
+   all positions and for all alignments relative to the chunks scanned
+   at once. */
+static svn_error_t *
+test_find_eol_start_chunks(apr_pool_t *pool)
+{
+  char buf[128];
+  apr_size_t offset, len, eol_pos;
+
+  for (offset = 0; offset < 16; ++offset)
+    for (len = 0; len <= 80; ++len)
+      for (eol_pos = 0; eol_pos <= len; ++eol_pos)
+        {
+          char *start = buf + offset;
+          char *expected = eol_pos < len ? start + eol_pos : NULL;
+
+          memset(buf, 'x', sizeof(buf));
+
+          /* An EOL beyond LEN must not be found. */
+          start[len] = '\n';
+          if (eol_pos < len)
+            start[eol_pos] = eol_pos % 2 ? '\r' : '\n';
+
+          SVN_TEST_ASSERT(svn_eol__find_eol_start(start, len) == expected);
+        }
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -897,5 +966,9 @@ struct svn_test_descriptor_t test_funcs[] =
                    "test string similarity scores"),
     SVN_TEST_PASS2(test_string_matching,
                    "test string matching"),
+    SVN_TEST_PASS2(test_string_matching_chunks,
+                   "test string matching across chunks"),
+    SVN_TEST_PASS2(test_find_eol_start_chunks,
+                   "test EOL scanning across chunks"),
     SVN_TEST_NULL
   };
@@ -0,0 +1,189 @@
+/* translate-bench.c -- measure the throughput of eol and keyword translation
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define APR_WANT_STDIO
+#include <apr_want.h>
+
+#include <apr_general.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_ctype.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_subst.h"
+
+/* Number of lines in the generated test data, if no file has been
+   given.  That is a few MB of text. */
+#define DEFAULT_LINES 100000
+
+/* Return LINES lines of generated source code with LF line endings and
+   an occasional keyword, allocated in POOL. */
+static svn_stringbuf_t *
+generate_text(int lines,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < lines; ++i)
+    {
+      if (i % 100 == 0)
+        svn_stringbuf_appendcstr(result, "/* $Id$ */\n");
+      else if (i % 100 == 50)
+        svn_stringbuf_appendcstr(result, "/* Last changed in $Rev$. */\n");
+      else if (i % 4 == 0)
+        svn_stringbuf_appendcstr(result, "\n");
+      else
+        svn_stringbuf_appendcstr(result,
+                                 apr_psprintf(pool,
+                                              "  { \"item_%d\", 0x%08x, %d },"
+                                              "\n",
+                                              i, i * 2654435761u, i % 1000));
+    }
+
+  return result;
+}
+
+/* Translate TEXT using EOL_STR and KEYWORDS.  Return the size of the
+   result in *TRANSLATED_SIZE and the time it took in *DURATION. */
+static void
+run_translate(apr_size_t *translated_size,
+              apr_interval_time_t *duration,
+              svn_stringbuf_t *text,
+              const char *eol_str,
+              apr_hash_t *keywords,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *translated = svn_stringbuf_create_ensure(text->len * 2,
+                                                            pool);
+  svn_stream_t *stream;
+  svn_error_t *err;
+  apr_size_t len = text->len;
+  apr_time_t start = apr_time_now();
+
+  stream = svn_subst_stream_translated(svn_stream_from_stringbuf(translated,
+                                                                 pool),
+                                       eol_str, TRUE, keywords, TRUE, pool);
+  err = svn_stream_write(stream, text->data, &len);
+  if (!err)
+    err = svn_stream_close(stream);
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "translate-bench: ");
+
+  *duration = apr_time_now() - start;
+  *translated_size = translated->len;
+}
+
+int
+main(int argc, char **argv)
+{
+  apr_pool_t *pool;
+  svn_stringbuf_t *text;
+  apr_hash_t *keywords;
+  svn_error_t *err;
+  int repeat = 3;
+  int i;
+
+  while (argc > 1)
+    {
+      const char *const arg = argv[1];
+      if (arg[0] != '-')
+        break;
+
+      if (svn_ctype_isdigit(arg[1]))
+        repeat = atoi(arg + 1);
+      else
+        break;
+      --argc; ++argv;
+    }
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+
+  if (argc == 1)
+    {
+      text = generate_text(DEFAULT_LINES, pool);
+    }
+  else if (argc == 2)
+    {
+      err = svn_stringbuf_from_file2(&text, argv[1], pool);
+      if (err)
+        svn_handle_error2(err, stderr, TRUE, "translate-bench: ");
+    }
+  else
+    {
+      fprintf(stderr,
+              "Usage: translate-bench [-<repeat>]\n"
+              "   or: translate-bench [-<repeat>] <file>\n");
+      exit(1);
+    }
+
+  err = svn_subst_build_keywords3(&keywords, "Id Rev", "42",
+                                  "http://example.com/repos/trunk/file.c",
+                                  "http://example.com/repos",
+                                  apr_time_now(), "jrandom", pool);
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "translate-bench: ");
+
+  for (i = 0; i < repeat; ++i)
+    {
+      static const struct
+        {
+          const char *name;
+          svn_boolean_t eol;
+          svn_boolean_t keywords;
+        } modes[] =
+        {
+          { "eol:      ", TRUE, FALSE },
+          { "keywords: ", FALSE, TRUE },
+          { "both:     ", TRUE, TRUE }
+        };
+      const int mode_count = sizeof(modes) / sizeof(modes[0]);
+      int k;
+
+      for (k = 0; k < mode_count; ++k)
+        {
+          apr_size_t translated_size;
+          apr_interval_time_t duration;
+          apr_pool_t *iterpool = svn_pool_create(pool);
+
+          run_translate(&translated_size, &duration, text,
+                        modes[k].eol ? "\r\n" : NULL,
+                        modes[k].keywords ? keywords : NULL,
+                        iterpool);
+          printf("%s%" APR_SIZE_T_FMT " -> %" APR_SIZE_T_FMT " bytes, "
+                 "%.1f ms, %.1f MB/s\n",
+                 modes[k].name, text->len, translated_size,
+                 duration / 1000.0,
+                 duration ? (double)text->len / duration : 0.0);
+
+          svn_pool_destroy(iterpool);
+        }
+    }
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
@@ -37,6 +37,7 @@
 #include <string.h>
 #include <apr_general.h>
 #include <apr_file_io.h>
+#include <apr_strings.h>
 
 #include "../svn_test.h"
 
@@ -1265,6 +1266,66 @@ mixed_to_crlf_unexpand_author_date_rev_url(apr_pool_t *pool)
 }
 
 
+
+/** Long runs of characters that need no translation. **/
+
+/* Translate lines with the keyword and the EOLs at all offsets relative
+   to the blocks that the scanner may skip at once. */
+static svn_error_t *
+long_boring_runs(apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_hash_t *keywords = apr_hash_make(pool);
+  int offset;
+
+  apr_hash_set(keywords, "Rev", APR_HASH_KEY_STRING,
+               svn_string_create("42", pool));
+
+  for (offset = 0; offset < 40; ++offset)
+    {
+      svn_stringbuf_t *src = svn_stringbuf_create_empty(iterpool);
+      svn_stringbuf_t *expected_both = svn_stringbuf_create_empty(iterpool);
+      svn_stringbuf_t *expected_kw = svn_stringbuf_create_empty(iterpool);
+      const char *boring = apr_psprintf(iterpool, "%*s", offset + 1, "x");
+      const char *dst;
+      int i;
+
+      /* A keyword, a lone '$' and mixed EOLs, each preceded by
+         OFFSET boring characters. */
+      for (i = 0; i < 3; ++i)
+        {
+          const char *eol = i == 1 ? "\r\n" : "\n";
+
+          svn_stringbuf_appendcstr(src, apr_pstrcat(iterpool,
+                                   boring, "$Rev$", boring, eol,
+                                   boring, "$ ", boring, "\r",
+                                   (char *)NULL));
+          svn_stringbuf_appendcstr(expected_both, apr_pstrcat(iterpool,
+                                   boring, "$Rev: 42 $", boring, "\n",
+                                   boring, "$ ", boring, "\n",
+                                   (char *)NULL));
+          svn_stringbuf_appendcstr(expected_kw, apr_pstrcat(iterpool,
+                                   boring, "$Rev: 42 $", boring, eol,
+                                   boring, "$ ", boring, "\r",
+                                   (char *)NULL));
+        }
+
+      SVN_ERR(svn_subst_translate_cstring2(src->data, &dst, "\n", TRUE,
+                                           keywords, TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(dst, expected_both->data);
+
+      SVN_ERR(svn_subst_translate_cstring2(src->data, &dst, NULL, FALSE,
+                                           keywords, TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(dst, expected_kw->data);
+
+      svn_pool_clear(iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
 
 /* The test table.  */
 
@@ -1360,5 +1421,8 @@ struct svn_test_descriptor_t test_funcs[] =
                    "cr_to_crlf; unexpand rev and url"),
     SVN_TEST_PASS2(mixed_to_crlf_unexpand_author_date_rev_url,
                    "mixed_to_crlf; unexpand author, date, rev, url"),
+    /* Long runs of characters that need no translation. */
+    SVN_TEST_PASS2(long_boring_runs,
+                   "translate long runs of boring characters"),
     SVN_TEST_NULL
   };
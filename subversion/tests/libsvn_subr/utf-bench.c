@@ -0,0 +1,150 @@
+/* utf-bench.c -- measure the throughput of UTF-8 validation
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define APR_WANT_STDIO
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "svn_ctype.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "private/svn_utf_private.h"
+
+/* Size of the generated test data. */
+#define DEFAULT_SIZE (16 * 1024 * 1024)
+
+/* Number of times each validation is run over the data per repetition. */
+#define ITERATIONS 10
+
+/* Return SIZE bytes of text, allocated in POOL.  Every NON_ASCII_RATE-th
+   character will be the multi-byte sequence SEQUENCE.  All others are
+   ASCII. */
+static svn_stringbuf_t *
+generate_text(apr_size_t size,
+              int non_ascii_rate,
+              const char *sequence,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(size, pool);
+  int i;
+
+  for (i = 0; result->len < size; ++i)
+    {
+      if (non_ascii_rate && i % non_ascii_rate == 0)
+        svn_stringbuf_appendcstr(result, sequence);
+      else
+        svn_stringbuf_appendbyte(result, (char)('a' + i % 26));
+    }
+
+  return result;
+}
+
+/* Print the throughput of svn_utf__is_valid, svn_utf__cstring_is_valid
+   and svn_utf__last_valid on TEXT, using NAME as the title. */
+static void
+run_validate(const char *name,
+             const svn_stringbuf_t *text)
+{
+  apr_time_t start;
+  apr_interval_time_t is_valid_time;
+  apr_interval_time_t cstring_time;
+  apr_interval_time_t last_valid_time;
+  double total_size = (double)text->len * ITERATIONS;
+  int valid = 0;
+  int i;
+
+  start = apr_time_now();
+  for (i = 0; i < ITERATIONS; ++i)
+    valid += svn_utf__is_valid(text->data, text->len);
+  is_valid_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < ITERATIONS; ++i)
+    valid += svn_utf__cstring_is_valid(text->data);
+  cstring_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < ITERATIONS; ++i)
+    valid += svn_utf__last_valid(text->data, text->len)
+          == text->data + text->len;
+  last_valid_time = apr_time_now() - start;
+
+  printf("%s: is_valid %.1f MB/s, cstring_is_valid %.1f MB/s, "
+         "last_valid %.1f MB/s%s\n",
+         name,
+         is_valid_time ? total_size / is_valid_time : 0.0,
+         cstring_time ? total_size / cstring_time : 0.0,
+         last_valid_time ? total_size / last_valid_time : 0.0,
+         valid == 3 * ITERATIONS ? "" : " (invalid)");
+}
+
+int
+main(int argc, char **argv)
+{
+  apr_pool_t *pool;
+  svn_stringbuf_t *ascii;
+  svn_stringbuf_t *latin;
+  svn_stringbuf_t *cjk;
+  int repeat = 3;
+  int i;
+
+  while (argc > 1)
+    {
+      const char *const arg = argv[1];
+      if (arg[0] != '-')
+        break;
+
+      if (svn_ctype_isdigit(arg[1]))
+        repeat = atoi(arg + 1);
+      else
+        break;
+      --argc; ++argv;
+    }
+
+  if (argc != 1)
+    {
+      fprintf(stderr, "Usage: utf-bench [-<repeat>]\n");
+      exit(1);
+    }
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+
+  /* Plain ASCII, mostly ASCII with some accented chars and CJK text. */
+  ascii = generate_text(DEFAULT_SIZE, 0, NULL, pool);
+  latin = generate_text(DEFAULT_SIZE, 20, "\xc3\xa9", pool);
+  cjk = generate_text(DEFAULT_SIZE, 1, "\xe6\x96\x87", pool);
+
+  for (i = 0; i < repeat; ++i)
+    {
+      run_validate("ascii", ascii);
+      run_validate("latin", latin);
+      run_validate("cjk  ", cjk);
+    }
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
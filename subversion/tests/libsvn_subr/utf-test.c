@@ -215,6 +215,67 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Check the fast paths for ASCII runs with single valid or invalid
+   multi-byte sequences at all offsets relative to the chunks that the
+   scanner processes at once. */
+static svn_error_t *
+utf_validate_ascii_runs(apr_pool_t *pool)
+{
+  static const struct
+    {
+      const char *sequence;
+      svn_boolean_t valid;
+    } sequences[] =
+    {
+      { "\xc3\xa9", TRUE },
+      { "\xe2\x82\xac", TRUE },
+      { "\xf0\x9f\x98\x80", TRUE },
+      { "\xc3", FALSE },
+      { "\x80", FALSE },
+      { "\xed\xa0\x80", FALSE },
+      { "\xff", FALSE }
+    };
+  const int sequence_count = sizeof(sequences) / sizeof(sequences[0]);
+  int i, offset;
+
+  for (i = 0; i < sequence_count; ++i)
+    for (offset = 0; offset < 70; ++offset)
+      {
+        /* OFFSET ASCII chars, the sequence, then ASCII again.  The
+           trailing ASCII makes a truncated sequence invalid. */
+        char str[100];
+        apr_size_t seq_len = strlen(sequences[i].sequence);
+        apr_size_t len = offset + seq_len + 20;
+        const char *last;
+
+        memset(str, 'a', len);
+        memcpy(str + offset, sequences[i].sequence, seq_len);
+        str[len] = 0;
+
+        last = svn_utf__last_valid(str, len);
+        if (   svn_utf__is_valid(str, len) != sequences[i].valid
+            || svn_utf__cstring_is_valid(str) != sequences[i].valid
+            || last != svn_utf__last_valid2(str, len)
+            || (last == str + len) != sequences[i].valid
+            || (!sequences[i].valid && last != str + offset))
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "sequence %d at offset %d failed",
+                                   i, offset);
+
+        /* Same with two sequences in the data. */
+        memcpy(str + len - seq_len - 1, sequences[i].sequence, seq_len);
+        if (   svn_utf__is_valid(str, len) != sequences[i].valid
+            || svn_utf__cstring_is_valid(str) != sequences[i].valid
+            || svn_utf__last_valid(str, len)
+                 != svn_utf__last_valid2(str, len))
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "sequence %d twice at offset %d failed",
+                                   i, offset);
+      }
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -747,6 +808,8 @@ struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate_ascii_runs,
+                   "test is_valid/last_valid with ASCII runs"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
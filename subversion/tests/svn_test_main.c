@@ -563,6 +563,7 @@ main(int argc, const char *argv[])
           break;
         case verbose_opt:
           verbose_mode = TRUE;
+          opts.verbose = TRUE;
           break;
         case quiet_opt:
           quiet_mode = TRUE;